@@ -341,6 +341,11 @@ man_pages = [
     ('man3/idset_create', 'idset_next', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_create', 'idset_count', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_create', 'idset_equal', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_add', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_subtract', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_union', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_intersect', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_difference', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_encode','idset_encode', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_decode', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_ndecode', 'Convert idset to string and string to idset', [author], 3),
@@ -74,6 +74,96 @@ def job_list(
     return JobListRPC(flux_handle, "job-info.list", payload)
 
 
+class JobListStreamRPC(RPC):
+    """A streaming job-info.list request
+
+    Jobs are returned in pages of at most ``page_size`` jobs. Each page
+    carries a cursor identifying its last job, available as ``cursor``
+    after the page has been fetched, which may be passed to a new
+    request to resume the listing.
+    """
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self.cursor = None
+        self.done = False
+
+    def get_page(self):
+        """Return the next page of jobs, or None at the end of the stream
+
+        This call may block until the next page is available.
+        """
+        if self.done:
+            return None
+        try:
+            resp = self.get()
+        except OSError as exc:
+            if exc.errno == errno.ENODATA:
+                self.done = True
+                return None
+            raise
+        self.cursor = resp["cursor"]
+        self.reset()
+        return resp["jobs"]
+
+    def get_jobs(self):
+        """Return all remaining jobs in the stream as a single list"""
+        jobs = []
+        page = self.get_page()
+        while page is not None:
+            jobs.extend(page)
+            page = self.get_page()
+        return jobs
+
+    def get_jobinfos(self):
+        """Yield a JobInfo object for each job as pages arrive"""
+        page = self.get_page()
+        while page is not None:
+            for job in page:
+                yield JobInfo(job)
+            page = self.get_page()
+
+    def cancel(self):
+        """Stop the stream, which is then terminated by the server"""
+        if not self.done:
+            payload = {"matchtag": self.pimpl.get_matchtag()}
+            RPC(
+                self.flux_handle,
+                "job-info.list-cancel",
+                payload,
+                flags=flux.constants.FLUX_RPC_NORESPONSE,
+            )
+
+
+# pylint: disable=dangerous-default-value
+def job_list_stream(
+    flux_handle,
+    max_entries=1000,
+    attrs=[],
+    userid=os.getuid(),
+    states=0,
+    results=0,
+    page_size=1000,
+    cursor=None,
+):
+    payload = {
+        "max_entries": int(max_entries),
+        "attrs": attrs,
+        "userid": int(userid),
+        "states": states,
+        "results": results,
+        "page_size": int(page_size),
+    }
+    if cursor is not None:
+        payload["cursor"] = cursor
+    return JobListStreamRPC(
+        flux_handle,
+        "job-info.list",
+        payload,
+        flags=flux.constants.FLUX_RPC_STREAMING,
+    )
+
+
 def job_list_inactive(flux_handle, since=0.0, max_entries=1000, attrs=[], name=None):
     payload = {"since": float(since), "max_entries": int(max_entries), "attrs": attrs}
     if name:
@@ -151,6 +241,8 @@ class JobList:
           not empty.
     :user: Username or userid for which to fetch jobs. Default is all users.
     :max_entries: Maximum number of jobs to return
+    :page_size: Number of jobs per response when streaming with
+                ``jobs_stream()``
     """
 
     # pylint: disable=too-many-instance-attributes
@@ -181,12 +273,14 @@ class JobList:
         ids=[],
         user=None,
         max_entries=1000,
+        page_size=1000,
     ):
         self.handle = flux_handle
         self.attrs = list(attrs)
         self.states = 0
         self.results = 0
         self.max_entries = max_entries
+        self.page_size = page_size
         self.ids = ids
         self.errors = []
         for fname in filters:
@@ -262,3 +356,28 @@ class JobList:
         if hasattr(rpc, "errors"):
             self.errors = rpc.errors
         return [JobInfo(job) for job in jobs]
+
+    def jobs_stream(self):
+        """Yield JobInfo objects for the JobList query as they arrive
+
+        Unlike JobList.jobs(), the results are fetched with a streaming
+        RPC a page at a time, so the first jobs are available before the
+        entire listing has been generated.  If ``ids`` is set, the jobs are
+        fetched as in JobList.jobs().
+        """
+        if self.ids:
+            yield from self.jobs()
+            return
+        rpc = job_list_stream(
+            self.handle,
+            max_entries=self.max_entries,
+            attrs=self.attrs,
+            userid=self.userid,
+            states=self.states,
+            results=self.results,
+            page_size=self.page_size,
+        )
+        try:
+            yield from rpc.get_jobinfos()
+        finally:
+            rpc.cancel()
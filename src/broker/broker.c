@@ -20,6 +20,7 @@
 #include <libgen.h>
 #include <sys/types.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <sys/stat.h>
 #include <sys/prctl.h>
 #include <sys/signalfd.h>
@@ -69,6 +70,7 @@
 #include "heaptrace.h"
 #include "exec.h"
 #include "ping.h"
+#include "mrpc.h"
 #include "rusage.h"
 #include "boot_config.h"
 #include "boot_pmi.h"
@@ -86,6 +88,10 @@ static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
 
 static void parent_cb (struct overlay *ov, void *arg);
 static void child_cb (struct overlay *ov, void *arg);
+static void child_status_cb (struct overlay *ov,
+                             uint32_t rank,
+                             bool connected,
+                             void *arg);
 static void module_cb (module_t *p, void *arg);
 static void module_status_cb (module_t *p, int prev_state, void *arg);
 static void signal_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -104,6 +110,8 @@ static int unload_module_byname (broker_ctx_t *ctx, const char *name,
 static void set_proctitle (uint32_t rank);
 
 static int create_rundir (attr_t *attrs);
+static int init_zmq_io_threads (attr_t *attrs);
+static int init_overlay_compress (attr_t *attrs, struct overlay *ov);
 static int create_broker_rundir (struct overlay *ov, void *arg);
 static int create_dummyattrs (flux_t *h, uint32_t rank, uint32_t size);
 
@@ -299,6 +307,8 @@ int main (int argc, char *argv[])
     zsys_set_rcvhwm (0);
     zsys_set_sndhwm (0);
     zsys_set_ipv6 (1);
+    if (init_zmq_io_threads (ctx.attrs) < 0)
+        goto cleanup;
 
     /* Set up the flux reactor.
      */
@@ -345,6 +355,8 @@ int main (int argc, char *argv[])
     overlay_set_parent_cb (ctx.overlay, parent_cb, &ctx);
     overlay_set_child_cb (ctx.overlay, child_cb, &ctx);
     overlay_set_idle_warning (ctx.overlay, 5);
+    if (init_overlay_compress (ctx.attrs, ctx.overlay) < 0)
+        goto cleanup;
 
     /* Arrange for the publisher to route event messages.
      * handle_event - local subscribers (ctx.h)
@@ -484,6 +496,11 @@ int main (int argc, char *argv[])
         log_err ("rusage_initialize");
         goto cleanup;
     }
+    if (!(ctx.mrpc = mrpc_create (ctx.h, ctx.rank, ctx.size, ctx.tbon_k))) {
+        log_err ("mrpc_create");
+        goto cleanup;
+    }
+    overlay_set_child_status_cb (ctx.overlay, child_status_cb, &ctx);
 
     if (!(handlers = broker_add_services (&ctx))) {
         log_err ("broker_add_services");
@@ -575,6 +592,9 @@ cleanup:
      */
     attr_destroy (ctx.attrs);
     content_cache_destroy (ctx.cache);
+    if (ctx.overlay)
+        overlay_set_child_status_cb (ctx.overlay, NULL, NULL);
+    mrpc_destroy (ctx.mrpc);
 
     modhash_destroy (ctx.modhash);
     zlist_destroy (&ctx.sigwatchers);
@@ -796,6 +816,70 @@ cleanup:
     return rc;
 }
 
+/*  Handle tbon.zmq_io_threads attribute.
+ *
+ *  Overlay socket I/O, including CURVE encryption and decryption, runs in
+ *  zeromq's I/O threads rather than the broker thread.  Connections are
+ *  spread across the I/O threads, so on a broker with many TBON children,
+ *  more than one thread lets that work use more than one core.
+ *  Must be called before any zeromq sockets are created.
+ */
+static int init_zmq_io_threads (attr_t *attrs)
+{
+    const char *val;
+    char *endptr;
+    long n = 1;
+
+    if (attr_get (attrs, "tbon.zmq_io_threads", &val, NULL) == 0) {
+        errno = 0;
+        n = strtol (val, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || n < 1 || n > 1024) {
+            log_msg ("Error parsing tbon.zmq_io_threads attribute");
+            return -1;
+        }
+        if (attr_delete (attrs, "tbon.zmq_io_threads", true) < 0)
+            return -1;
+    }
+    if (attr_add_int (attrs,
+                      "tbon.zmq_io_threads",
+                      n,
+                      FLUX_ATTRFLAG_IMMUTABLE) < 0) {
+        log_err ("attr_add tbon.zmq_io_threads");
+        return -1;
+    }
+    zsys_set_io_threads (n);
+    return 0;
+}
+
+/* Handle tbon.compress_threshold attribute.
+ */
+static int init_overlay_compress (attr_t *attrs, struct overlay *ov)
+{
+    const char *val;
+    char *endptr;
+    long n = 0;
+
+    if (attr_get (attrs, "tbon.compress_threshold", &val, NULL) == 0) {
+        errno = 0;
+        n = strtol (val, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || n < 0 || n > INT_MAX) {
+            log_msg ("Error parsing tbon.compress_threshold attribute");
+            return -1;
+        }
+        if (attr_delete (attrs, "tbon.compress_threshold", true) < 0)
+            return -1;
+    }
+    if (attr_add_int (attrs,
+                      "tbon.compress_threshold",
+                      n,
+                      FLUX_ATTRFLAG_IMMUTABLE) < 0) {
+        log_err ("attr_add tbon.compress_threshold");
+        return -1;
+    }
+    overlay_set_compress_threshold (ov, n);
+    return 0;
+}
+
 /*  Handle global rundir attribute.
  *
  *  If not set, create a temporary directory and use it as the rundir.
@@ -958,6 +1042,7 @@ static void module_dlerror (const char *errmsg, void *arg)
 
 static int load_module_bypath (broker_ctx_t *ctx, const char *path,
                                const char *argz, size_t argz_len,
+                               int hwm, const char *hwm_policy,
                                const flux_msg_t *request)
 {
     module_t *p = NULL;
@@ -977,6 +1062,8 @@ static int load_module_bypath (broker_ctx_t *ctx, const char *path,
         module_add_arg (p, arg);
         arg = argz_next (argz, argz_len, arg);
     }
+    if (module_set_hwm (p, hwm, hwm_policy) < 0)
+        goto service_remove;
     module_set_poller_cb (p, module_cb, ctx);
     module_set_status_cb (p, module_status_cb, ctx);
     if (request && module_push_insmod (p, request) < 0) // response deferred
@@ -1010,7 +1097,7 @@ static int load_module_byname (broker_ctx_t *ctx, const char *name,
         log_msg ("%s: not found in module search path", name);
         return -1;
     }
-    if (load_module_bypath (ctx, path, argz, argz_len, request) < 0) {
+    if (load_module_bypath (ctx, path, argz, argz_len, 0, NULL, request) < 0) {
         free (path);
         return -1;
     }
@@ -1099,14 +1186,19 @@ static void broker_insmod_cb (flux_t *h, flux_msg_handler_t *mh,
     broker_ctx_t *ctx = arg;
     const char *path;
     json_t *args;
+    int hwm = 0;
+    const char *hwm_policy = NULL;
     size_t index;
     json_t *value;
     char *argz = NULL;
     size_t argz_len = 0;
     error_t e;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s:o}", "path", &path,
-                                                     "args", &args) < 0)
+    if (flux_request_unpack (msg, NULL, "{s:s s:o s?i s?s}",
+                             "path", &path,
+                             "args", &args,
+                             "hwm", &hwm,
+                             "hwm_policy", &hwm_policy) < 0)
         goto error;
     if (!json_is_array (args))
         goto proto;
@@ -1118,7 +1210,8 @@ static void broker_insmod_cb (flux_t *h, flux_msg_handler_t *mh,
             goto error;
         }
     }
-    if (load_module_bypath (ctx, path, argz, argz_len, msg) < 0)
+    if (load_module_bypath (ctx, path, argz, argz_len,
+                            hwm, hwm_policy, msg) < 0)
         goto error;
     free (argz);
     return;
@@ -1413,6 +1506,7 @@ static struct internal_service services[] = {
     { "config",             NULL },
     { "runat",              NULL },
     { "state-machine",      NULL },
+    { "mrpc",               NULL },
     { NULL, NULL, },
 };
 
@@ -1506,6 +1600,18 @@ done:
     flux_msg_destroy (msg);
 }
 
+/* A TBON child has connected or been lost.
+ */
+static void child_status_cb (struct overlay *ov,
+                             uint32_t rank,
+                             bool connected,
+                             void *arg)
+{
+    broker_ctx_t *ctx = arg;
+
+    mrpc_child_status (ctx->mrpc, rank, connected);
+}
+
 /* Handle events received by parent_cb.
  * On rank 0, publisher is wired to send events here also.
  */
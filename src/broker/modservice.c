@@ -83,7 +83,7 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
 
     flux_get_msgcounters (h, &mcs);
 
-    if (flux_respond_pack (h, msg, "{ s:i s:i s:i s:i s:i s:i s:i s:i }",
+    if (flux_respond_pack (h, msg, "{ s:i s:i s:i s:i s:i s:i s:i s:i s:i }",
                            "#request (tx)", mcs.request_tx,
                            "#request (rx)", mcs.request_rx,
                            "#response (tx)", mcs.response_tx,
@@ -91,7 +91,9 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                            "#event (tx)", mcs.event_tx,
                            "#event (rx)", mcs.event_rx,
                            "#keepalive (tx)", mcs.keepalive_tx,
-                           "#keepalive (rx)", mcs.keepalive_rx) < 0)
+                           "#keepalive (rx)", mcs.keepalive_rx,
+                           "#matchtag (outstanding)",
+                           (int)flux_matchtag_outstanding (h)) < 0)
       FLUX_LOG_ERROR (h);
 }
 
@@ -159,6 +161,7 @@ static void prepare_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     modservice_ctx_t *ctx = arg;
     flux_msg_t *msg = flux_keepalive_encode (0, FLUX_MODSTATE_SLEEPING);
+
     if (!msg || flux_send (ctx->h, msg, 0) < 0)
         flux_log_error (ctx->h, "error sending keepalive");
     flux_msg_destroy (msg);
@@ -171,6 +174,7 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     modservice_ctx_t *ctx = arg;
     flux_msg_t *msg = flux_keepalive_encode (0, FLUX_MODSTATE_RUNNING);
+
     if (!msg || flux_send (ctx->h, msg, 0) < 0)
         flux_log_error (ctx->h, "error sending keepalive");
     flux_msg_destroy (msg);
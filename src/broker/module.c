@@ -88,6 +88,20 @@ struct broker_module {
     flux_t *h;               /* module's handle */
 
     zlist_t *subs;          /* subscription strings */
+
+    /* Send queue accounting.  'txcount' is the number of messages sent
+     * to the module by the broker thread.  'rxcount' is the number the
+     * module has received, incremented by the shmem connector in the
+     * module thread as each message is received.  The difference
+     * is the number of messages queued for the module.
+     */
+    unsigned long txcount;
+    unsigned long rxcount;  /* accessed atomically */
+    int hwm;                /* limit on queued messages (0=unlimited) */
+    int hwm_policy;
+    bool overflow;          /* hwm was reached and not yet logged clear */
+    unsigned long dropped;  /* events dropped at hwm */
+    unsigned long rejected; /* requests rejected at hwm */
 };
 
 struct modhash {
@@ -156,6 +170,7 @@ static void *module_thread (void *arg)
     int mod_main_errno = 0;
     flux_msg_t *msg;
     flux_conf_t *conf;
+    unsigned long *rxcount;
 
     setup_module_profiling (p);
 
@@ -169,6 +184,12 @@ static void *module_thread (void *arg)
         log_err ("flux_open %s", uri);
         goto done;
     }
+    rxcount = &p->rxcount;
+    if (flux_opt_set (p->h, "flux::shmem_rxcount",
+                      &rxcount, sizeof (rxcount)) < 0) {
+        log_err ("%s: error setting rxcount counter", p->name);
+        goto done;
+    }
     if (asprintf (&rankstr, "%"PRIu32, p->rank) < 0) {
         log_err ("asprintf");
         goto done;
@@ -274,6 +295,7 @@ flux_msg_t *module_recvmsg (module_t *p)
 {
     flux_msg_t *msg = NULL;
     int type;
+    uint8_t flags;
     struct flux_msg_cred cred;
 
     assert (p->magic == MODULE_MAGIC);
@@ -295,6 +317,14 @@ flux_msg_t *module_recvmsg (module_t *p)
         default:
             break;
     }
+    /* FLUX_MSGFLAG_COMPRESSED is reserved for the overlay network.
+     * Don't let a local client or module set it.
+     */
+    if (flux_msg_get_flags (msg, &flags) < 0)
+        goto error;
+    if ((flags & FLUX_MSGFLAG_COMPRESSED)
+        && flux_msg_set_flags (msg, flags & ~FLUX_MSGFLAG_COMPRESSED) < 0)
+        goto error;
     /* All shmem:// connections to the broker have FLUX_ROLE_OWNER
      * and are "authenticated" as the instance owner.
      * Allow modules so endowed to change the userid/rolemask on messages when
@@ -316,6 +346,91 @@ error:
     return NULL;
 }
 
+int module_set_hwm (module_t *p, int hwm, const char *policy)
+{
+    int hwm_policy = MODULE_HWM_REJECT;
+
+    if (hwm < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (policy) {
+        if (!strcmp (policy, "reject"))
+            hwm_policy = MODULE_HWM_REJECT;
+        else if (!strcmp (policy, "drop"))
+            hwm_policy = MODULE_HWM_DROP;
+        else {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    p->hwm = hwm;
+    p->hwm_policy = hwm_policy;
+    return 0;
+}
+
+int module_get_sendq (module_t *p)
+{
+    unsigned long rxcount = __atomic_load_n (&p->rxcount, __ATOMIC_RELAXED);
+
+    /* rxcount is incremented by the module thread as each message is
+     * taken off the socket, so it is current here, and never exceeds
+     * txcount.
+     */
+    if (rxcount >= p->txcount)
+        return 0;
+    return p->txcount - rxcount;
+}
+
+enum hwm_action {
+    HWM_SEND,
+    HWM_DROP,
+    HWM_REJECT,
+};
+
+/* Apply the hwm policy to a message of 'type', returning whether the
+ * message should be sent, silently dropped, or rejected with EAGAIN.
+ * At the limit, requests are rejected under either policy, since the
+ * sender gets an error response and may retry.  Events are dropped
+ * only under the "drop" policy, since a module that misses an event
+ * (e.g. a kvs setroot) is left with stale state.  Responses and
+ * keepalives are never held back, since dropping them would leave RPCs
+ * or module state tracking hanging.
+ */
+static enum hwm_action hwm_check (module_t *p, int type)
+{
+    bool full;
+
+    if (p->hwm == 0
+        || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_EVENT))
+        return HWM_SEND;
+    full = (module_get_sendq (p) >= p->hwm);
+    if (!full) {
+        if (p->overflow) {
+            flux_log (p->broker_h, LOG_INFO,
+                      "%s: send queue below limit of %d messages",
+                      p->name, p->hwm);
+            p->overflow = false;
+        }
+        return HWM_SEND;
+    }
+    if (!p->overflow) {
+        flux_log (p->broker_h, LOG_WARNING,
+                  "%s: send queue reached limit of %d messages",
+                  p->name, p->hwm);
+        p->overflow = true;
+    }
+    if (type == FLUX_MSGTYPE_REQUEST) {
+        p->rejected++;
+        return HWM_REJECT;
+    }
+    if (p->hwm_policy == MODULE_HWM_DROP) {
+        p->dropped++;
+        return HWM_DROP;
+    }
+    return HWM_SEND;
+}
+
 int module_sendmsg (module_t *p, const flux_msg_t *msg)
 {
     flux_msg_t *cpy = NULL;
@@ -333,6 +448,15 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
         errno = ENOSYS;
         goto done;
     }
+    switch (hwm_check (p, type)) {
+        case HWM_SEND:
+            break;
+        case HWM_DROP:
+            return 0;
+        case HWM_REJECT:
+            errno = EAGAIN;
+            goto done;
+    }
     switch (type) {
         case FLUX_MSGTYPE_REQUEST: { /* simulate DEALER socket */
             char uuid[16];
@@ -359,6 +483,7 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             break;
     }
+    p->txcount++;
     rc = 0;
 done:
     flux_msg_destroy (cpy);
@@ -774,13 +899,19 @@ json_t *module_get_modlist (modhash_t *mh, struct service_switch *sw)
 
             if (!(svcs  = service_list_byuuid (sw, uuid)))
                 goto nomem;
-            if (!(entry = json_pack ("{s:s s:i s:s s:i s:i s:o}",
+            if (!(entry = json_pack ("{s:s s:i s:s s:i s:i s:o"
+                                     " s:i s:i s:I s:I}",
                                      "name", module_get_name (p),
                                      "size", p->size,
                                      "digest", p->digest,
                                       "idle", module_get_idle (p),
                                       "status", p->status,
-                                      "services", svcs))) {
+                                      "services", svcs,
+                                      "sendq", module_get_sendq (p),
+                                      "hwm", p->hwm,
+                                      "dropped", (json_int_t)p->dropped,
+                                      "rejected",
+                                      (json_int_t)p->rejected))) {
                 json_decref (svcs);
                 goto nomem;
             }
@@ -60,6 +60,24 @@ void module_set_poller_cb (module_t *p, modpoller_cb_f cb, void *arg);
 flux_msg_t *module_recvmsg (module_t *p);
 int module_sendmsg (module_t *p, const flux_msg_t *msg);
 
+/* Limit the number of requests and events queued for the module to 'hwm'
+ * (0 = unlimited).  At the limit, requests are rejected with EAGAIN.
+ * Events are queued anyway (policy "reject", the default if policy is
+ * NULL) or dropped (policy "drop").  Responses are always sent.
+ * Returns 0 on success, -1 with errno set on failure.
+ */
+enum {
+    MODULE_HWM_REJECT = 0,
+    MODULE_HWM_DROP = 1,
+};
+int module_set_hwm (module_t *p, int hwm, const char *policy);
+
+/* Get the number of messages sent to the module that it has not yet
+ * received.  The module's shmem connector counts received messages
+ * in the module_t directly, so the result is current.
+ */
+int module_get_sendq (module_t *p);
+
 /* Pass module's requests through this function to enable disconnect
  * messages to be sent when the module is unloaded.  The callback will
  * be used to send those messages.
@@ -0,0 +1,828 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* mrpc.c - send a request to a set of ranks along the TBON
+ *
+ * flux_rpc_multi() sends "mrpc.forward" to rank 0:
+ *   {"topic":s "ranks":s "payload":s|null}
+ *
+ * Each broker sends the embedded request to itself if it is one of the
+ * ranks, and forwards the remaining ranks to its TBON children, split
+ * by subtree, as "mrpc.forward" requests.  When the local response and
+ * all child responses have been received, the broker responds with:
+ *   {"responses":[{"ranks":s "errnum":i ?"errstr":s ?"payload":s}, ...]}
+ *
+ * Identical results are combined into one entry whose "ranks" covers
+ * all of the ranks that returned it, so a broker sends and receives
+ * O(k) messages, and responses shrink as they travel up the tree when
+ * many ranks return the same result.
+ *
+ * If "mrpc.forward" is a streaming request, the combined results are
+ * instead sent as each local or child response arrives, followed by
+ * an ENODATA error response.  flux_rpc_multi() uses this so that a slow
+ * subtree does not delay results from the others.
+ *
+ * Requests forwarded to TBON children are always streaming, so results
+ * from deep subtrees are relayed as they arrive rather than only with the
+ * first response from each child.
+ *
+ * If a TBON child is lost, ranks in its subtree that have not yet
+ * responded get an EHOSTUNREACH error.  The overlay reports a child lost
+ * when it sends a disconnect keepalive, or when a message cannot be
+ * routed to it, e.g. the next heartbeat after the child broker crashed.  A streaming request may be
+ * canceled by its sender with "mrpc.cancel" {"matchtag":i}, and all
+ * requests from a sender are dropped on "mrpc.disconnect".  In either
+ * case, the cancellation is passed on to TBON children.
+ *
+ * The embedded request carries the credentials of the original sender,
+ * so it is authorized by the target service on each rank as usual.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <jansson.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "src/common/libidset/idset.h"
+#include "src/common/libutil/kary.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "mrpc.h"
+
+struct mrpc {
+    flux_t *h;
+    uint32_t rank;
+    uint32_t size;
+    int k;
+    flux_msg_handler_t **handlers;
+    zlistx_t *requests;
+    struct idset *lost;         /* TBON children that have disconnected */
+    struct idset *lost_new;     /* lost children with forwards to fail */
+    flux_watcher_t *lost_w;
+};
+
+/* One or more ranks that returned identical results.
+ */
+struct mrpc_result {
+    struct idset *ranks;
+    json_t *o;                  /* response entry, without "ranks" */
+};
+
+struct mrpc_request {
+    struct mrpc *mrpc;
+    const flux_msg_t *msg;
+    void *handle;               /* handle in mrpc->requests */
+    zlistx_t *forwards;
+    zhashx_t *results;          /* encoded result => struct mrpc_result */
+    int pending;
+};
+
+/* The local request, or a request forwarded to a TBON child.
+ */
+struct mrpc_forward {
+    struct mrpc_request *mr;
+    void *handle;               /* handle in mr->forwards */
+    flux_future_t *f;
+    uint32_t nodeid;
+    bool child;
+    struct idset *ranks;        /* ranks that have not yet responded */
+};
+
+static void mrpc_result_destroy (struct mrpc_result *res)
+{
+    if (res) {
+        int saved_errno = errno;
+        idset_destroy (res->ranks);
+        json_decref (res->o);
+        free (res);
+        errno = saved_errno;
+    }
+}
+
+static void mrpc_result_destructor (void **item)
+{
+    if (item) {
+        mrpc_result_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static void mrpc_forward_destroy (struct mrpc_forward *fw)
+{
+    if (fw) {
+        int saved_errno = errno;
+        flux_future_destroy (fw->f);
+        idset_destroy (fw->ranks);
+        free (fw);
+        errno = saved_errno;
+    }
+}
+
+static void mrpc_forward_destructor (void **item)
+{
+    if (item) {
+        mrpc_forward_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static void mrpc_request_destroy (struct mrpc_request *mr)
+{
+    if (mr) {
+        int saved_errno = errno;
+        zlistx_destroy (&mr->forwards);
+        zhashx_destroy (&mr->results);
+        flux_msg_decref (mr->msg);
+        free (mr);
+        errno = saved_errno;
+    }
+}
+
+static void mrpc_request_destructor (void **item)
+{
+    if (item) {
+        mrpc_request_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct mrpc_request *mrpc_request_create (struct mrpc *mrpc,
+                                                 const flux_msg_t *msg)
+{
+    struct mrpc_request *mr;
+
+    if (!(mr = calloc (1, sizeof (*mr))))
+        return NULL;
+    mr->mrpc = mrpc;
+    mr->msg = flux_msg_incref (msg);
+    if (!(mr->forwards = zlistx_new ()) || !(mr->results = zhashx_new ()))
+        goto nomem;
+    zlistx_set_destructor (mr->forwards, mrpc_forward_destructor);
+    zhashx_set_destructor (mr->results, mrpc_result_destructor);
+    return mr;
+nomem:
+    mrpc_request_destroy (mr);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Create a response entry (without "ranks").
+ */
+static json_t *result_entry (int errnum, const char *errstr, const char *s)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i}", "errnum", errnum)))
+        goto nomem;
+    if (errnum && errstr) {
+        if (json_object_set_new (o, "errstr", json_string (errstr)) < 0)
+            goto nomem;
+    }
+    if (!errnum && s) {
+        if (json_object_set_new (o, "payload", json_string (s)) < 0)
+            goto nomem;
+    }
+    return o;
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Add result entry 'o' (stolen) for 'ranks' to the request, combining it
+ * with an identical result from other ranks, if any.
+ */
+static int mrpc_request_add (struct mrpc_request *mr,
+                             const struct idset *ranks,
+                             json_t *o)
+{
+    struct mrpc_result *res;
+    char *key;
+
+    if (!o)
+        return -1;
+    if (!(key = json_dumps (o, JSON_COMPACT | JSON_SORT_KEYS))) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((res = zhashx_lookup (mr->results, key))) {
+        json_decref (o);
+        if (idset_add (res->ranks, ranks) < 0)
+            goto error;
+    }
+    else {
+        if (!(res = calloc (1, sizeof (*res)))) {
+            json_decref (o);
+            goto error;
+        }
+        res->o = o;
+        if (!(res->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))
+            || idset_add (res->ranks, ranks) < 0) {
+            mrpc_result_destroy (res);
+            goto error;
+        }
+        (void)zhashx_insert (mr->results, key, res);
+    }
+    free (key);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, key);
+    return -1;
+}
+
+static json_t *mrpc_request_encode (struct mrpc_request *mr)
+{
+    struct mrpc_result *res;
+    json_t *a;
+
+    if (!(a = json_array ()))
+        goto nomem;
+    res = zhashx_first (mr->results);
+    while (res) {
+        json_t *entry;
+        char *s;
+
+        if (!(s = idset_encode (res->ranks, IDSET_FLAG_RANGE)))
+            goto error;
+        if (!(entry = json_copy (res->o))
+            || json_object_set_new (entry, "ranks", json_string (s)) < 0
+            || json_array_append_new (a, entry) < 0) {
+            json_decref (entry);
+            free (s);
+            goto nomem;
+        }
+        free (s);
+        res = zhashx_next (mr->results);
+    }
+    return a;
+nomem:
+    errno = ENOMEM;
+error:
+    ERRNO_SAFE_WRAP (json_decref, a);
+    return NULL;
+}
+
+/* Send the results accumulated so far.
+ */
+static void mrpc_request_respond (struct mrpc_request *mr)
+{
+    flux_t *h = mr->mrpc->h;
+    json_t *a;
+
+    if (!(a = mrpc_request_encode (mr))) {
+        if (flux_respond_error (h, mr->msg, errno, NULL) < 0)
+            flux_log_error (h, "error responding to mrpc.forward");
+        return;
+    }
+    if (flux_respond_pack (h, mr->msg, "{s:O}", "responses", a) < 0)
+        flux_log_error (h, "error responding to mrpc.forward");
+    json_decref (a);
+    zhashx_purge (mr->results);
+}
+
+/* One local or child request has completed.  If streaming, send its
+ * results now.  If it was the last one, finish the request.
+ */
+static void mrpc_request_complete_one (struct mrpc_request *mr)
+{
+    struct mrpc *mrpc = mr->mrpc;
+    bool streaming = flux_msg_is_streaming (mr->msg);
+
+    if (streaming && zhashx_size (mr->results) > 0)
+        mrpc_request_respond (mr);
+    if (--mr->pending > 0)
+        return;
+    if (streaming) {
+        if (flux_respond_error (mrpc->h, mr->msg, ENODATA, NULL) < 0)
+            flux_log_error (mrpc->h, "error responding to mrpc.forward");
+    }
+    else
+        mrpc_request_respond (mr);
+    zlistx_delete (mrpc->requests, mr->handle);
+}
+
+/* Record an error result for all 'ranks' of a failed local or child request.
+ */
+static void add_error (struct mrpc_request *mr,
+                       const struct idset *ranks,
+                       int errnum,
+                       const char *errstr)
+{
+    if (mrpc_request_add (mr, ranks, result_entry (errnum, errstr, NULL)) < 0)
+        flux_log_error (mr->mrpc->h, "mrpc: error recording result");
+}
+
+/* Destroy 'fw' and complete it.  This may destroy fw->mr.
+ */
+static void mrpc_forward_complete (struct mrpc_forward *fw)
+{
+    struct mrpc_request *mr = fw->mr;
+
+    zlistx_delete (mr->forwards, fw->handle);
+    mrpc_request_complete_one (mr);
+}
+
+/* Record an error for all ranks of 'fw' that have not yet responded,
+ * then complete it.
+ */
+static void mrpc_forward_fail (struct mrpc_forward *fw,
+                               int errnum,
+                               const char *errstr)
+{
+    if (idset_count (fw->ranks) > 0)
+        add_error (fw->mr, fw->ranks, errnum, errstr);
+    mrpc_forward_complete (fw);
+}
+
+static void local_continuation (flux_future_t *f, void *arg)
+{
+    struct mrpc_forward *fw = arg;
+    struct mrpc_request *mr = fw->mr;
+    const char *s = NULL;
+
+    if (flux_rpc_get (f, &s) < 0)
+        add_error (mr, fw->ranks, errno, flux_future_has_error (f)
+                                         ? flux_future_error_string (f)
+                                         : NULL);
+    else if (mrpc_request_add (mr, fw->ranks, result_entry (0, NULL, s)) < 0)
+        flux_log_error (mr->mrpc->h, "mrpc: error recording result");
+    mrpc_forward_complete (fw);
+}
+
+/* Handle one streaming response from a TBON child.  The child sends
+ * ENODATA after all ranks in its subtree have responded.
+ */
+static void child_continuation (flux_future_t *f, void *arg)
+{
+    struct mrpc_forward *fw = arg;
+    struct mrpc_request *mr = fw->mr;
+    json_t *responses;
+    size_t index;
+    json_t *entry;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "responses", &responses) < 0) {
+        if (errno == ENODATA)
+            mrpc_forward_fail (fw, EPROTO, "no response from rank");
+        else
+            mrpc_forward_fail (fw, errno, flux_future_has_error (f)
+                                          ? flux_future_error_string (f)
+                                          : NULL);
+        return;
+    }
+    json_array_foreach (responses, index, entry) {
+        const char *s;
+        struct idset *ids;
+        json_t *o;
+
+        if (json_unpack (entry, "{s:s}", "ranks", &s) < 0
+            || !(ids = idset_decode (s))) {
+            flux_log (mr->mrpc->h, LOG_ERR, "mrpc: malformed child response");
+            continue;
+        }
+        if (!(o = json_copy (entry))
+            || json_object_del (o, "ranks") < 0
+            || mrpc_request_add (mr, ids, o) < 0)
+            flux_log_error (mr->mrpc->h, "mrpc: error recording result");
+        (void)idset_subtract (fw->ranks, ids);
+        idset_destroy (ids);
+    }
+    flux_future_reset (f);
+    if (flux_msg_is_streaming (mr->msg) && zhashx_size (mr->results) > 0)
+        mrpc_request_respond (mr);
+}
+
+/* Send 'msg' to 'nodeid' on behalf of 'mr', with the original sender's
+ * credentials.  Requests to TBON children ('child' true) are streaming.
+ * Takes ownership of 'ranks'.  If the request cannot be sent, record an
+ * error result for 'ranks' instead.
+ */
+static void mrpc_request_send (struct mrpc_request *mr,
+                               flux_msg_t *msg,
+                               uint32_t nodeid,
+                               bool child,
+                               struct idset *ranks,
+                               flux_continuation_f cb)
+{
+    struct mrpc *mrpc = mr->mrpc;
+    struct flux_msg_cred cred;
+    struct mrpc_forward *fw;
+    int flags = child ? FLUX_RPC_STREAMING : 0;
+
+    if (child && idset_test (mrpc->lost, nodeid)) {
+        add_error (mr, ranks, EHOSTUNREACH, NULL);
+        idset_destroy (ranks);
+        goto done;
+    }
+    if (!(fw = calloc (1, sizeof (*fw)))) {
+        add_error (mr, ranks, errno, NULL);
+        idset_destroy (ranks);
+        goto done;
+    }
+    fw->mr = mr;
+    fw->nodeid = nodeid;
+    fw->child = child;
+    fw->ranks = ranks;
+    if (!msg
+        || flux_msg_get_cred (mr->msg, &cred) < 0
+        || flux_msg_set_cred (msg, cred) < 0
+        || !(fw->f = flux_rpc_message (mrpc->h, msg, nodeid, flags))
+        || flux_future_then (fw->f, -1., cb, fw) < 0)
+        goto error;
+    if (!(fw->handle = zlistx_add_end (mr->forwards, fw))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    mr->pending++;
+    goto done;
+error:
+    add_error (mr, ranks, errno, NULL);
+    mrpc_forward_destroy (fw);
+done:
+    flux_msg_destroy (msg);
+}
+
+/* Stop all outstanding local and child requests of 'mr', asking TBON
+ * children to cancel theirs.  The caller is responsible for responding
+ * to mr->msg, if required, and destroying 'mr'.
+ */
+static void mrpc_request_cancel (struct mrpc_request *mr)
+{
+    struct mrpc *mrpc = mr->mrpc;
+    struct mrpc_forward *fw;
+
+    fw = zlistx_first (mr->forwards);
+    while (fw) {
+        if (fw->child) {
+            flux_future_t *f;
+
+            if (!(f = flux_rpc_pack (mrpc->h,
+                                     "mrpc.cancel",
+                                     fw->nodeid,
+                                     FLUX_RPC_NORESPONSE,
+                                     "{s:i}",
+                                     "matchtag",
+                                     flux_rpc_get_matchtag (fw->f))))
+                flux_log_error (mrpc->h, "mrpc: error sending cancel");
+            flux_future_destroy (f);
+        }
+        fw = zlistx_next (mr->forwards);
+    }
+    zlistx_purge (mr->forwards);
+}
+
+static flux_msg_t *encode_forward (const char *topic,
+                                   const struct idset *ranks,
+                                   json_t *payload)
+{
+    flux_msg_t *msg;
+    char *s;
+
+    if (!(s = idset_encode (ranks, IDSET_FLAG_RANGE)))
+        return NULL;
+    if (!(msg = flux_request_encode ("mrpc.forward", NULL))
+        || flux_msg_pack (msg, "{s:s s:s s:O}",
+                          "topic", topic,
+                          "ranks", s,
+                          "payload", payload ? payload : json_null ()) < 0) {
+        ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
+        msg = NULL;
+    }
+    ERRNO_SAFE_WRAP (free, s);
+    return msg;
+}
+
+static void forward_cb (flux_t *h,
+                        flux_msg_handler_t *mh,
+                        const flux_msg_t *msg,
+                        void *arg)
+{
+    struct mrpc *mrpc = arg;
+    const char *topic;
+    const char *s;
+    json_t *payload = NULL;
+    struct idset *ranks = NULL;
+    struct idset **child = NULL;
+    struct mrpc_request *mr = NULL;
+    uint32_t first_child = kary_childof (mrpc->k, mrpc->size, mrpc->rank, 0);
+    const char *errstr = NULL;
+    bool local = false;
+    unsigned int id;
+    int i;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s?o}",
+                             "topic", &topic,
+                             "ranks", &s,
+                             "payload", &payload) < 0)
+        goto error;
+    if (json_is_null (payload))
+        payload = NULL;
+    if (payload && !json_is_string (payload)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(ranks = idset_decode (s))
+        || idset_count (ranks) == 0
+        || idset_last (ranks) >= mrpc->size) {
+        errstr = "invalid ranks";
+        errno = EINVAL;
+        goto error;
+    }
+    if (!(child = calloc (mrpc->k, sizeof (child[0]))))
+        goto error;
+    id = idset_first (ranks);
+    while (id != IDSET_INVALID_ID) {
+        if (id == mrpc->rank)
+            local = true;
+        else {
+            uint32_t c = kary_child_route (mrpc->k,
+                                           mrpc->size,
+                                           mrpc->rank,
+                                           id);
+            if (c == KARY_NONE) {
+                errstr = "ranks are not in this broker's subtree";
+                errno = EINVAL;
+                goto error;
+            }
+            i = c - first_child;
+            if (!child[i]
+                && !(child[i] = idset_create (0, IDSET_FLAG_AUTOGROW)))
+                goto error;
+            if (idset_set (child[i], id) < 0)
+                goto error;
+        }
+        id = idset_next (ranks, id);
+    }
+    if (!(mr = mrpc_request_create (mrpc, msg)))
+        goto error;
+    if (!(mr->handle = zlistx_add_end (mrpc->requests, mr))) {
+        mrpc_request_destroy (mr);
+        errno = ENOMEM;
+        goto error;
+    }
+    /* Hold a reference on the request while sending so that it cannot be
+     * finished by a send error before all requests have been sent.
+     */
+    mr->pending++;
+    if (local) {
+        struct idset *self;
+        flux_msg_t *req;
+
+        if (!(self = idset_create (0, IDSET_FLAG_AUTOGROW))
+            || idset_set (self, mrpc->rank) < 0) {
+            idset_destroy (self);
+            goto error_request;
+        }
+        req = flux_request_encode (topic, payload ? json_string_value (payload)
+                                                  : NULL);
+        mrpc_request_send (mr,
+                           req,
+                           mrpc->rank,
+                           false,
+                           self,
+                           local_continuation);
+    }
+    for (i = 0; i < mrpc->k; i++) {
+        if (child[i]) {
+            flux_msg_t *req = encode_forward (topic, child[i], payload);
+            mrpc_request_send (mr,
+                               req,
+                               first_child + i,
+                               true,
+                               child[i],
+                               child_continuation);
+            child[i] = NULL;
+        }
+    }
+    mrpc_request_complete_one (mr);
+    idset_destroy (ranks);
+    free (child);
+    return;
+error_request:
+    zlistx_delete (mrpc->requests, mr->handle);
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to mrpc.forward");
+    if (child) {
+        for (i = 0; i < mrpc->k; i++)
+            idset_destroy (child[i]);
+        free (child);
+    }
+    idset_destroy (ranks);
+}
+
+/* Returns true if 'sender' matches the sender of request 'msg'.
+ */
+static bool match_sender (const flux_msg_t *msg, const char *sender)
+{
+    char *sender2;
+    bool match = false;
+
+    if (flux_msg_get_route_first (msg, &sender2) == 0) {
+        if (!strcmp (sender2, sender))
+            match = true;
+        free (sender2);
+    }
+    return match;
+}
+
+/* Cancel the streaming request from the sender of 'msg' with matching
+ * "matchtag", and terminate its response stream with ENODATA.
+ */
+static void cancel_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct mrpc *mrpc = arg;
+    struct mrpc_request *mr;
+    int matchtag;
+    char *sender;
+
+    if (flux_request_unpack (msg, NULL, "{s:i}", "matchtag", &matchtag) < 0
+        || flux_msg_get_route_first (msg, &sender) < 0) {
+        flux_log_error (h, "error decoding mrpc.cancel request");
+        return;
+    }
+    mr = zlistx_first (mrpc->requests);
+    while (mr) {
+        uint32_t t;
+
+        if (flux_msg_is_streaming (mr->msg)
+            && flux_msg_get_matchtag (mr->msg, &t) == 0
+            && t == (uint32_t)matchtag
+            && match_sender (mr->msg, sender)) {
+            mrpc_request_cancel (mr);
+            if (flux_respond_error (h, mr->msg, ENODATA, NULL) < 0)
+                flux_log_error (h, "error responding to mrpc.forward");
+            zlistx_delete (mrpc->requests, mr->handle);
+            break;
+        }
+        mr = zlistx_next (mrpc->requests);
+    }
+    free (sender);
+}
+
+/* Drop all requests from the sender of 'msg', which has disconnected.
+ */
+static void disconnect_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct mrpc *mrpc = arg;
+    struct mrpc_request *mr;
+    char *sender;
+
+    if (flux_msg_get_route_first (msg, &sender) < 0)
+        return;
+    mr = zlistx_first (mrpc->requests);
+    while (mr) {
+        struct mrpc_request *next = zlistx_next (mrpc->requests);
+
+        if (match_sender (mr->msg, sender)) {
+            mrpc_request_cancel (mr);
+            zlistx_delete (mrpc->requests, mr->handle);
+        }
+        mr = next;
+    }
+    free (sender);
+}
+
+/* Fail outstanding forwards to TBON child 'rank' with EHOSTUNREACH.
+ */
+static void fail_child_forwards (struct mrpc *mrpc, uint32_t rank)
+{
+    struct mrpc_request *mr;
+    zlist_t *lost;
+    struct mrpc_forward *fw;
+    char errstr[64];
+
+    /* Collect forwards to 'rank' before failing them, since failing one
+     * may complete and destroy its request.  Each request forwards to a
+     * given child at most once.
+     */
+    if (!(lost = zlist_new ())) {
+        flux_log_error (mrpc->h, "mrpc: out of memory");
+        return;
+    }
+    mr = zlistx_first (mrpc->requests);
+    while (mr) {
+        fw = zlistx_first (mr->forwards);
+        while (fw) {
+            if (fw->child && fw->nodeid == rank) {
+                if (zlist_append (lost, fw) < 0)
+                    flux_log_error (mrpc->h, "mrpc: out of memory");
+            }
+            fw = zlistx_next (mr->forwards);
+        }
+        mr = zlistx_next (mrpc->requests);
+    }
+    snprintf (errstr, sizeof (errstr), "lost connection to broker rank %lu",
+              (unsigned long)rank);
+    while ((fw = zlist_pop (lost)))
+        mrpc_forward_fail (fw, EHOSTUNREACH, errstr);
+    zlist_destroy (&lost);
+}
+
+static void lost_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct mrpc *mrpc = arg;
+    unsigned int id;
+
+    while ((id = idset_first (mrpc->lost_new)) != IDSET_INVALID_ID) {
+        (void)idset_clear (mrpc->lost_new, id);
+        fail_child_forwards (mrpc, id);
+    }
+}
+
+/* The overlay may report a lost child from within a send, e.g. while
+ * mrpc_request_cancel() is walking a request's forwards, so forwards
+ * are failed from a zero-length timer rather than right here.  New
+ * requests to the child fail immediately.
+ */
+void mrpc_child_status (struct mrpc *mrpc, uint32_t rank, bool connected)
+{
+    if (connected) {
+        (void)idset_clear (mrpc->lost, rank);
+        return;
+    }
+    if (idset_test (mrpc->lost, rank))
+        return;
+    if (idset_set (mrpc->lost, rank) < 0
+        || idset_set (mrpc->lost_new, rank) < 0) {
+        flux_log_error (mrpc->h, "mrpc: error recording lost child");
+        return;
+    }
+    flux_watcher_start (mrpc->lost_w);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "mrpc.forward", forward_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "mrpc.cancel", cancel_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "mrpc.disconnect", disconnect_cb, FLUX_ROLE_USER },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+void mrpc_destroy (struct mrpc *mrpc)
+{
+    if (mrpc) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (mrpc->handlers);
+        flux_watcher_destroy (mrpc->lost_w);
+        zlistx_destroy (&mrpc->requests);
+        idset_destroy (mrpc->lost);
+        idset_destroy (mrpc->lost_new);
+        free (mrpc);
+        errno = saved_errno;
+    }
+}
+struct mrpc *mrpc_create (flux_t *h, uint32_t rank, uint32_t size, int k)
+{
+    struct mrpc *mrpc;
+
+    if (!(mrpc = calloc (1, sizeof (*mrpc))))
+        return NULL;
+    mrpc->h = h;
+    mrpc->rank = rank;
+    mrpc->size = size;
+    mrpc->k = k;
+    if (!(mrpc->requests = zlistx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(mrpc->lost = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(mrpc->lost_new = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        goto error;
+    if (!(mrpc->lost_w = flux_timer_watcher_create (flux_get_reactor (h),
+                                                    0.,
+                                                    0.,
+                                                    lost_cb,
+                                                    mrpc)))
+        goto error;
+    zlistx_set_destructor (mrpc->requests, mrpc_request_destructor);
+    if (flux_msg_handler_addvec (h, htab, mrpc, &mrpc->handlers) < 0)
+        goto error;
+    return mrpc;
+error:
+    mrpc_destroy (mrpc);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
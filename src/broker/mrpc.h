@@ -0,0 +1,31 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_MRPC_H
+#define _BROKER_MRPC_H
+
+/* Register the "mrpc" service, which sends a request to a set of ranks
+ * along the TBON on behalf of flux_rpc_multi().
+ */
+struct mrpc *mrpc_create (flux_t *h, uint32_t rank, uint32_t size, int k);
+void mrpc_destroy (struct mrpc *mrpc);
+
+/* Notify mrpc that TBON child 'rank' has connected or been lost.
+ * When lost, outstanding requests forwarded to the child fail with
+ * EHOSTUNREACH for the ranks in its subtree that have not yet responded,
+ * as do new requests until the child reconnects.
+ */
+void mrpc_child_status (struct mrpc *mrpc, uint32_t rank, bool connected);
+
+#endif /* !_BROKER_MRPC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -17,10 +17,13 @@
 #include <flux/core.h>
 #include <inttypes.h>
 #include <jansson.h>
+#include <arpa/inet.h>
+#include <lz4.h>
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/kary.h"
 #include "src/common/libutil/cleanup.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "heartbeat.h"
 #include "overlay.h"
@@ -75,10 +78,15 @@ struct overlay {
     overlay_monitor_cb_f child_monitor_cb;
     void *child_monitor_arg;
 
+    overlay_child_status_f child_status_cb;
+    void *child_status_arg;
+
     overlay_init_cb_f init_cb;
     void *init_arg;
 
     int idle_warning;
+
+    int compress_threshold;     /* compress payloads >= this size (0=off) */
 };
 
 /* Convenience iterator for ov->children
@@ -94,6 +102,28 @@ static void overlay_monitor_notify (struct overlay *ov)
         ov->child_monitor_cb (ov, ov->child_monitor_arg);
 }
 
+static void overlay_child_status_notify (struct overlay *ov,
+                                         struct child *child)
+{
+    if (ov->child_status_cb)
+        ov->child_status_cb (ov,
+                             child->rank,
+                             child->connected,
+                             ov->child_status_arg);
+}
+
+/* A message could not be routed to 'child' because its connection is gone.
+ * Returns true if it was previously thought to be connected.
+ */
+static bool overlay_child_lost (struct overlay *ov, struct child *child)
+{
+    bool prev_value = child->connected;
+
+    child->connected = false;
+    overlay_child_status_notify (ov, child);
+    return prev_value;
+}
+
 static void endpoint_destroy (struct endpoint *ep)
 {
     if (ep) {
@@ -258,8 +288,10 @@ void overlay_keepalive_child (struct overlay *ov, const char *uuid, int status)
             child->connected = false;
         child->lastseen = ov->epoch;
 
-        if (child->connected != prev_value)
+        if (child->connected != prev_value) {
+            overlay_child_status_notify (ov, child);
             overlay_monitor_notify (ov);
+        }
     }
 }
 
@@ -284,24 +316,157 @@ const char *overlay_get_parent_uri (struct overlay *ov)
     return ov->parent->uri;
 }
 
+void overlay_set_compress_threshold (struct overlay *ov, int threshold)
+{
+    ov->compress_threshold = threshold;
+}
+
+/* LZ4 cannot compress better than 255:1, so a peer claiming a larger
+ * uncompressed size is lying.  Also cap it at an absolute limit so a
+ * peer can't make the broker allocate arbitrary amounts of memory.
+ */
+#define LZ4_MAX_RATIO           255
+#define COMPRESS_MAX_PAYLOAD    (256*1024*1024)
+
+/* If compression is enabled and 'msg' has a payload of at least
+ * compress_threshold bytes, set '*cpy' to a copy of 'msg' with an LZ4
+ * compressed payload and FLUX_MSGFLAG_COMPRESSED set.  The compressed
+ * payload is prefixed with the uncompressed size (4 bytes, network order).
+ * Otherwise, set '*cpy' to NULL.  Returns 0 on success, -1 on failure.
+ */
+static int compress_msg (struct overlay *ov,
+                         const flux_msg_t *msg,
+                         flux_msg_t **cpy)
+{
+    const void *data;
+    int size;
+    int bound;
+    int r;
+    uint32_t hdr;
+    uint8_t flags;
+    char *buf;
+    flux_msg_t *newmsg = NULL;
+
+    *cpy = NULL;
+    if (ov->compress_threshold == 0
+        || flux_msg_get_payload (msg, &data, &size) < 0
+        || size < ov->compress_threshold
+        || size > COMPRESS_MAX_PAYLOAD)
+        return 0;
+    bound = LZ4_compressBound (size) + sizeof (hdr);
+    if (!(buf = malloc (bound)))
+        return -1;
+    r = LZ4_compress_default (data,
+                              buf + sizeof (hdr),
+                              size,
+                              bound - sizeof (hdr));
+    if (r == 0 || r + (int)sizeof (hdr) >= size) {
+        free (buf);
+        return 0; // incompressible - send as is
+    }
+    hdr = htonl (size);
+    memcpy (buf, &hdr, sizeof (hdr));
+    if (!(newmsg = flux_msg_copy (msg, false))
+        || flux_msg_set_payload_nocopy (newmsg, buf, r + sizeof (hdr)) < 0)
+        goto error;
+    buf = NULL; // owned by newmsg now
+    if (flux_msg_get_flags (newmsg, &flags) < 0
+        || flux_msg_set_flags (newmsg, flags | FLUX_MSGFLAG_COMPRESSED) < 0)
+        goto error;
+    *cpy = newmsg;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, buf);
+    flux_msg_destroy (newmsg);
+    return -1;
+}
+
+/* Decompress a received message in place if FLUX_MSGFLAG_COMPRESSED is set.
+ * This is done regardless of the local compress_threshold, so brokers
+ * with different settings can interoperate.  The data is decompressed
+ * directly into the buffer that becomes the new payload.
+ */
+static int decompress_msg (flux_msg_t *msg)
+{
+    const void *data;
+    int size;
+    uint32_t hdr;
+    int csize;
+    uint32_t orig_size;
+    char *buf;
+    int r;
+    uint8_t flags;
+
+    if (flux_msg_get_flags (msg, &flags) < 0)
+        return -1;
+    if (!(flags & FLUX_MSGFLAG_COMPRESSED))
+        return 0;
+    if (flux_msg_get_payload (msg, &data, &size) < 0
+        || size <= (int)sizeof (hdr))
+        goto proto;
+    memcpy (&hdr, data, sizeof (hdr));
+    orig_size = ntohl (hdr);
+    csize = size - sizeof (hdr);
+    if (orig_size == 0
+        || orig_size > COMPRESS_MAX_PAYLOAD
+        || orig_size > (uint64_t)csize * LZ4_MAX_RATIO)
+        goto proto;
+    if (!(buf = malloc (orig_size)))
+        return -1;
+    r = LZ4_decompress_safe ((char *)data + sizeof (hdr),
+                             buf,
+                             csize,
+                             orig_size);
+    if (r < 0 || (uint32_t)r != orig_size) {
+        free (buf);
+        goto proto;
+    }
+    if (flux_msg_set_payload_nocopy (msg, buf, orig_size) < 0) {
+        ERRNO_SAFE_WRAP (free, buf);
+        return -1;
+    }
+    return flux_msg_set_flags (msg, flags & ~FLUX_MSGFLAG_COMPRESSED);
+proto:
+    errno = EPROTO;
+    return -1;
+}
+
+static flux_msg_t *recvmsg_decompress (struct overlay *ov, zsock_t *zsock)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_msg_recvzsock (zsock)))
+        return NULL;
+    if (decompress_msg (msg) < 0) {
+        flux_log_error (ov->h, "error decompressing overlay message");
+        flux_msg_destroy (msg);
+        return NULL;
+    }
+    return msg;
+}
+
 int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
 {
+    flux_msg_t *cpy = NULL;
     int rc = -1;
 
     if (!ov->parent || !ov->parent->zsock) {
         errno = EHOSTUNREACH;
         goto done;
     }
-    rc = flux_msg_sendzsock (ov->parent->zsock, msg);
+    if (compress_msg (ov, msg, &cpy) < 0)
+        goto done;
+    rc = flux_msg_sendzsock (ov->parent->zsock, cpy ? cpy : msg);
     if (rc == 0)
         ov->parent_lastsent = ov->epoch;
 done:
+    flux_msg_destroy (cpy);
     return rc;
 }
 
 flux_msg_t *overlay_recvmsg_parent (struct overlay *ov)
 {
-    return flux_msg_recvzsock (ov->parent->zsock);
+    return recvmsg_decompress (ov, ov->parent->zsock);
 }
 
 static int overlay_keepalive_parent (struct overlay *ov, int status)
@@ -358,57 +523,66 @@ void overlay_set_child_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg)
 
 int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
 {
+    flux_msg_t *cpy = NULL;
     int rc = -1;
 
     if (!ov->child || !ov->child->zsock) {
         errno = EINVAL;
         goto done;
     }
-    rc = flux_msg_sendzsock_ex (ov->child->zsock, msg, true);
+    if (compress_msg (ov, msg, &cpy) < 0)
+        goto done;
+    rc = flux_msg_sendzsock_ex (ov->child->zsock, cpy ? cpy : msg, true);
+    if (rc < 0 && errno == EHOSTUNREACH) {
+        char *uuid = NULL;
+        struct child *child;
+
+        if (flux_msg_get_route_last (msg, &uuid) == 0
+            && uuid
+            && (child = child_lookup (ov, uuid))) {
+            if (overlay_child_lost (ov, child))
+                overlay_monitor_notify (ov);
+        }
+        free (uuid);
+        errno = EHOSTUNREACH;
+    }
 done:
+    flux_msg_destroy (cpy);
     return rc;
 }
 
 flux_msg_t *overlay_recvmsg_child (struct overlay *ov)
 {
-    return flux_msg_recvzsock (ov->child->zsock);
-}
-
-static int overlay_mcast_child_one (void *zsock,
-                                    const flux_msg_t *msg,
-                                    struct child *child)
-{
-    flux_msg_t *cpy;
-    int rc = -1;
-
-    if (!(cpy = flux_msg_copy (msg, true)))
-        return -1;
-    if (flux_msg_enable_route (cpy) < 0)
-        goto done;
-    if (flux_msg_push_route (cpy, child->uuid) < 0)
-        goto done;
-    if (flux_msg_sendzsock_ex (zsock, cpy, true) < 0)
-        goto done;
-    rc = 0;
-done:
-    flux_msg_destroy (cpy);
-    return rc;
+    return recvmsg_decompress (ov, ov->child->zsock);
 }
 
+/* N.B. the event is compressed once, and the compressed payload is
+ * shared by all children.
+ */
 void overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
 {
     struct child *child;
     int disconnects = 0;
+    flux_msg_t *cpy;
 
     if (!ov->child || !ov->child->zsock)
         return;
+    if (compress_msg (ov, msg, &cpy) < 0) {
+        flux_log_error (ov->h, "mcast error compressing event");
+        cpy = NULL;
+    }
+    if (cpy)
+        msg = cpy;
     foreach_overlay_child (ov, child) {
         if (!child->connected)
             continue;
-        if (overlay_mcast_child_one (ov->child->zsock, msg, child) < 0) {
+        if (flux_msg_sendzsock_route (ov->child->zsock,
+                                      msg,
+                                      child->uuid,
+                                      true) < 0) {
             if (errno == EHOSTUNREACH) {
-                child->connected = false;
-                disconnects++;
+                if (overlay_child_lost (ov, child))
+                    disconnects++;
             }
             else
                 flux_log_error (ov->h,
@@ -418,6 +592,7 @@ void overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
     }
     if (disconnects)
         overlay_monitor_notify (ov);
+    flux_msg_destroy (cpy);
 }
 
 static void child_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -690,6 +865,14 @@ void overlay_set_monitor_cb (struct overlay *ov,
     ov->child_monitor_arg = arg;
 }
 
+void overlay_set_child_status_cb (struct overlay *ov,
+                                  overlay_child_status_f cb,
+                                  void *arg)
+{
+    ov->child_status_cb = cb;
+    ov->child_status_arg = arg;
+}
+
 static json_t *lspeer_object_create (struct overlay *ov)
 {
     json_t *o = NULL;
@@ -11,6 +11,9 @@
 #ifndef _BROKER_OVERLAY_H
 #define _BROKER_OVERLAY_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "attr.h"
 
 enum {
@@ -23,6 +26,10 @@ struct overlay;
 typedef void (*overlay_sock_cb_f)(struct overlay *ov, void *arg);
 typedef int (*overlay_init_cb_f)(struct overlay *ov, void *arg);
 typedef void (*overlay_monitor_cb_f)(struct overlay *ov, void *arg);
+typedef void (*overlay_child_status_f)(struct overlay *ov,
+                                       uint32_t rank,
+                                       bool connected,
+                                       void *arg);
 
 struct overlay *overlay_create (flux_t *h);
 void overlay_destroy (struct overlay *ov);
@@ -41,6 +48,12 @@ int overlay_init (struct overlay *ov,
                   int tbon_k);
 void overlay_set_idle_warning (struct overlay *ov, int heartbeats);
 
+/* Compress payloads of at least 'threshold' bytes with LZ4 when sending
+ * to peers (0 = never compress, the default).  Compressed messages have
+ * FLUX_MSGFLAG_COMPRESSED set, and are always decompressed on receipt.
+ */
+void overlay_set_compress_threshold (struct overlay *ov, int threshold);
+
 
 /* CURVE key management
  * If downstream peers, call overlay_authorize() with public key of each peer.
@@ -95,6 +108,15 @@ void overlay_set_monitor_cb (struct overlay *ov,
                              overlay_monitor_cb_f cb,
                              void *arg);
 
+/* Register callback that will be called with the rank of a child each time
+ * it connects, or is found to be lost: on a disconnect keepalive, or when
+ * a message cannot be routed to it (EHOSTUNREACH) because its connection
+ * is gone, e.g. after the child broker crashed.
+ */
+void overlay_set_child_status_cb (struct overlay *ov,
+                                  overlay_child_status_f cb,
+                                  void *arg);
+
 /* Establish communication with parent.
  */
 int overlay_connect (struct overlay *ov);
@@ -14,6 +14,7 @@
 
 #include <errno.h>
 #include <string.h>
+#include <arpa/inet.h>
 #include <flux/core.h>
 #include <czmq.h>
 
@@ -210,6 +211,84 @@ flux_msg_t *recvmsg_parent_timeout (struct context *ctx, double timeout)
     return overlay_recvmsg_parent (ctx->ov);
 }
 
+/* Send a compressible payload from child to parent and back with
+ * compression enabled only on the sending side, and verify it arrives
+ * intact with FLUX_MSGFLAG_COMPRESSED cleared.  Then verify that a bogus
+ * compressed message is rejected.
+ */
+void check_compress (struct context *child, struct context *parent)
+{
+    char payload[8192];
+    char bogus[64];
+    uint32_t hdr;
+    char uuid[16];
+    flux_msg_t *msg;
+    const void *data;
+    int size;
+    uint8_t flags;
+
+    memset (payload, 'x', sizeof (payload));
+    overlay_set_compress_threshold (child->ov, 1024);
+
+    if (!(msg = flux_request_encode_raw ("zip", payload, sizeof (payload))))
+        BAIL_OUT ("flux_request_encode_raw failed");
+    ok (overlay_sendmsg_parent (child->ov, msg) == 0,
+        "%s: overlay_sendmsg_parent works with compression", child->name);
+    flux_msg_destroy (msg);
+
+    msg = recvmsg_child_timeout (parent, 5);
+    ok (msg != NULL,
+        "%s: overlay_recvmsg_child works", parent->name);
+    ok (flux_msg_get_payload (msg, &data, &size) == 0
+        && size == sizeof (payload)
+        && !memcmp (data, payload, size),
+        "%s: received payload was decompressed intact", parent->name);
+    ok (flux_msg_get_flags (msg, &flags) == 0
+        && !(flags & FLUX_MSGFLAG_COMPRESSED),
+        "%s: received message does not have COMPRESSED flag", parent->name);
+    flux_msg_destroy (msg);
+
+    overlay_set_compress_threshold (child->ov, 0);
+    overlay_set_compress_threshold (parent->ov, 1024);
+
+    if (!(msg = flux_response_encode_raw ("zap", payload, sizeof (payload))))
+        BAIL_OUT ("flux_response_encode_raw failed");
+    snprintf (uuid, sizeof (uuid), "%d", child->rank);
+    if (flux_msg_push_route (msg, uuid) < 0)
+        BAIL_OUT ("flux_msg_push_route failed");
+    ok (overlay_sendmsg_child (parent->ov, msg) == 0,
+        "%s: overlay_sendmsg_child works with compression", parent->name);
+    flux_msg_destroy (msg);
+
+    msg = recvmsg_parent_timeout (child, 5);
+    ok (msg != NULL,
+        "%s: overlay_recvmsg_parent works", child->name);
+    ok (flux_msg_get_payload (msg, &data, &size) == 0
+        && size == sizeof (payload)
+        && !memcmp (data, payload, size),
+        "%s: received payload was decompressed intact", child->name);
+    flux_msg_destroy (msg);
+
+    overlay_set_compress_threshold (parent->ov, 0);
+
+    /* A compressed payload claiming an implausible uncompressed size
+     * is rejected before anything is allocated.
+     */
+    hdr = htonl (0x7fffffff);
+    memcpy (bogus, &hdr, sizeof (hdr));
+    memset (bogus + sizeof (hdr), 0, sizeof (bogus) - sizeof (hdr));
+    if (!(msg = flux_request_encode_raw ("bogus", bogus, sizeof (bogus)))
+        || flux_msg_get_flags (msg, &flags) < 0
+        || flux_msg_set_flags (msg, flags | FLUX_MSGFLAG_COMPRESSED) < 0)
+        BAIL_OUT ("failed to create bogus compressed message");
+    ok (overlay_sendmsg_parent (child->ov, msg) == 0,
+        "%s: overlay_sendmsg_parent sent bogus compressed message",
+        child->name);
+    flux_msg_destroy (msg);
+    ok (recvmsg_child_timeout (parent, 5) == NULL,
+        "%s: overlay_recvmsg_child rejected it", parent->name);
+}
+
 void trio (flux_t *h)
 {
     struct context *ctx[2];
@@ -296,6 +375,10 @@ void trio (flux_t *h)
         "%s: received message has expected topic", ctx[1]->name);
     flux_msg_destroy (msg);
 
+    /* Send 1->0 and 0->1 with compression enabled on the sender only.
+     */
+    check_compress (ctx[1], ctx[0]);
+
     errno = 0;
     ok (overlay_bind (ctx[1]->ov, "ipc://@foo") < 0 && errno == EINVAL,
         "%s: second overlay_bind in proc fails with EINVAL", ctx[0]->name);
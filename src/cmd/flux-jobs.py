@@ -13,6 +13,7 @@ import sys
 import logging
 import argparse
 import fileinput
+import itertools
 import json
 
 import flux.constants
@@ -122,6 +123,18 @@ def fetch_jobs_flux(args, fields):
         max_entries=args.count,
     )
 
+    #  Stream jobs so they may be printed as they arrive, except when
+    #  listing specific jobids, where errors are reported up front.
+    #  Fetch the first page here, so that an error is raised before
+    #  the header is printed.
+    if not args.jobids:
+        stream = jobs_rpc.jobs_stream()
+        try:
+            first = next(stream)
+        except StopIteration:
+            return []
+        return itertools.chain([first], stream)
+
     jobs = jobs_rpc.jobs()
 
     #  Print all errors accumulated in JobList RPC:
@@ -137,7 +150,7 @@ def fetch_jobs_flux(args, fields):
 def fetch_jobs(args, fields):
     """
     Fetch jobs from flux or optionally stdin.
-    Returns a list of JobInfo objects
+    Returns an iterable of JobInfo objects
     """
     if args.from_stdin:
         lst = fetch_jobs_stdin()
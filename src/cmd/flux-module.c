@@ -37,10 +37,17 @@ int cmd_info (optparse_t *p, int argc, char **argv);
 int cmd_stats (optparse_t *p, int argc, char **argv);
 int cmd_debug (optparse_t *p, int argc, char **argv);
 
-static struct optparse_option legacy_opts[] =  {
+static struct optparse_option load_opts[] =  {
     { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "RANK",
       .usage = "Send RPC to specified rank",
     },
+    { .name = "hwm", .has_arg = 1, .arginfo = "N",
+      .usage = "Limit requests and events queued for module to N",
+    },
+    { .name = "hwm-policy", .has_arg = 1, .arginfo = "reject|drop",
+      .usage = "Queue (reject, default) or drop events when --hwm is reached."
+               " Events are always dropped.",
+    },
     OPTPARSE_TABLE_END,
 };
 
@@ -54,6 +61,23 @@ static struct optparse_option remove_opts[] =  {
     OPTPARSE_TABLE_END,
 };
 
+static struct optparse_option reload_opts[] =  {
+    { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "RANK",
+      .usage = "Send RPC to specified rank",
+    },
+    { .name = "force", .key = 'f',
+      .usage = "Ignore nonexistent modules",
+    },
+    { .name = "hwm", .has_arg = 1, .arginfo = "N",
+      .usage = "Limit requests and events queued for module to N",
+    },
+    { .name = "hwm-policy", .has_arg = 1, .arginfo = "reject|drop",
+      .usage = "Queue (reject, default) or drop events when --hwm is reached."
+               " Events are always dropped.",
+    },
+    OPTPARSE_TABLE_END,
+};
+
 static struct optparse_option stats_opts[] =  {
     { .name = "parse", .key = 'p', .has_arg = 1, .arginfo = "OBJNAME",
       .usage = "Parse object period-delimited object name",
@@ -114,14 +138,14 @@ static struct optparse_subcommand subcommands[] = {
       "Load module",
       cmd_load,
       0,
-      legacy_opts,
+      load_opts,
     },
     { "reload",
       "[OPTIONS] module",
       "Reload module",
       cmd_reload,
       0,
-      remove_opts,
+      reload_opts,
     },
     { "info",
       "[OPTIONS] module",
@@ -286,6 +310,7 @@ static void module_load (flux_t *h, optparse_t *p, int argc, char **argv)
     char *modname;
     char *modpath;
     int n;
+    json_t *payload;
     flux_future_t *f;
 
     if ((n = optparse_option_index (p)) == argc) {
@@ -306,15 +331,30 @@ static void module_load (flux_t *h, optparse_t *p, int argc, char **argv)
         n++;
     }
 
+    if (!(payload = json_pack ("{s:s s:O}", "path", modpath, "args", args)))
+        log_msg_exit ("json_pack() failed");
+    if (optparse_hasopt (p, "hwm")) {
+        int hwm = optparse_get_int (p, "hwm", 0);
+        json_t *o;
+        if (hwm < 0)
+            log_msg_exit ("--hwm value must be >= 0");
+        if (!(o = json_integer (hwm))
+            || json_object_set_new (payload, "hwm", o) < 0)
+            log_msg_exit ("json_integer() or json_object_set_new() failed");
+    }
+    if (optparse_hasopt (p, "hwm-policy")) {
+        const char *policy = optparse_get_str (p, "hwm-policy", NULL);
+        json_t *o;
+        if (!(o = json_string (policy))
+            || json_object_set_new (payload, "hwm_policy", o) < 0)
+            log_msg_exit ("json_string() or json_object_set_new() failed");
+    }
     if (!(f = flux_rpc_pack (h,
                              topic,
                              optparse_get_int (p, "rank", FLUX_NODEID_ANY),
                              0,
-                             "{s:s s:O}",
-                             "path",
-                             modpath,
-                             "args",
-                             args)))
+                             "O",
+                             payload)))
         log_err_exit ("%s", topic);
     if (flux_rpc_get (f, NULL) < 0) {
         if (errno == EEXIST)
@@ -325,6 +365,7 @@ static void module_load (flux_t *h, optparse_t *p, int argc, char **argv)
     free (topic);
     free (service);
     json_decref (args);
+    json_decref (payload);
     free (modpath);
     free (modname);
 }
@@ -457,8 +498,8 @@ char lsmod_state_char (int state)
 
 void lsmod_print_header (FILE *f)
 {
-    fprintf (f, "%-24s %8s %-7s %4s  %c %s\n",
-            "Module", "Size", "Digest", "Idle", 'S', "Service");
+    fprintf (f, "%-24s %8s %-7s %4s  %c %5s %s\n",
+            "Module", "Size", "Digest", "Idle", 'S', "Queue", "Service");
 }
 
 void lsmod_print_entry (FILE *f,
@@ -467,18 +508,20 @@ void lsmod_print_entry (FILE *f,
                        const char *digest,
                        int idle,
                        int status,
+                       int sendq,
                        json_t *services)
 {
     int digest_len = strlen (digest);
     char *serv_s = lsmod_services_string (services, name);
     char idle_s[16];
 
-    fprintf (f, "%-24.24s %8d %7s %4s  %c %s\n",
+    fprintf (f, "%-24.24s %8d %7s %4s  %c %5d %s\n",
              name,
              size,
              digest_len > 7 ? digest + digest_len - 7 : digest,
              lsmod_idle_string (idle, idle_s, sizeof (idle_s)),
              lsmod_state_char (status),
+             sendq,
              serv_s ? serv_s : "");
 
     free (serv_s);
@@ -493,16 +536,19 @@ void lsmod_print_list (FILE *f, json_t *o)
     const char *digest;
     int idle;
     int status;
+    int sendq;
     json_t *services;
 
     json_array_foreach (o, index, value) {
-        if (json_unpack (value, "{s:s s:i s:s s:i s:i s:o}",
+        sendq = 0;
+        if (json_unpack (value, "{s:s s:i s:s s:i s:i s:o s?i}",
                          "name", &name,
                          "size", &size,
                          "digest", &digest,
                          "idle", &idle,
                          "status", &status,
-                         "services", &services) < 0)
+                         "services", &services,
+                         "sendq", &sendq) < 0)
             log_msg_exit ("Erorr parsing lsmod response");
         if (!json_is_array (services))
             log_msg_exit ("Erorr parsing lsmod services array");
@@ -512,6 +558,7 @@ void lsmod_print_list (FILE *f, json_t *o)
                            digest,
                            idle,
                            status,
+                           sendq,
                            services);
     }
 }
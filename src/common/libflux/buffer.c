@@ -17,11 +17,12 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include "buffer.h"
 #include "buffer_private.h"
 
-#include "src/common/liblsd/cbuf.h"
+#include "src/common/libutil/ringbuf.h"
 
 #define FLUX_BUFFER_MIN   4096
 #define FLUX_BUFFER_MAGIC 0xeb4feb4f
@@ -37,7 +38,7 @@ struct flux_buffer {
     int magic;
     int size;
     bool readonly;
-    cbuf_t cbuf;
+    struct ringbuf *rb;
     char *buf;                  /* internal buffer for user reads */
     int buflen;
     int cb_type;
@@ -70,10 +71,7 @@ flux_buffer_t *flux_buffer_create (int size)
     fb->readonly = false;
 
     /* buffer can grow to size specified by user */
-    if (!(fb->cbuf = cbuf_create (minsize, fb->size)))
-        goto cleanup;
-
-    if (cbuf_opt_set (fb->cbuf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) < 0)
+    if (!(fb->rb = ringbuf_create (minsize, fb->size)))
         goto cleanup;
 
     /* +1 for possible NUL on line reads */
@@ -98,7 +96,7 @@ void flux_buffer_destroy (void *data)
     flux_buffer_t *fb = data;
     if (fb && fb->magic == FLUX_BUFFER_MAGIC) {
         fb->magic = ~FLUX_BUFFER_MAGIC;
-        cbuf_destroy (fb->cbuf);
+        ringbuf_destroy (fb->rb);
         free (fb->buf);
         free (fb);
     }
@@ -121,7 +119,7 @@ int flux_buffer_bytes (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_used (fb->cbuf);
+    return ringbuf_used (fb->rb);
 }
 
 int flux_buffer_space (flux_buffer_t *fb)
@@ -131,7 +129,7 @@ int flux_buffer_space (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_free (fb->cbuf);
+    return ringbuf_space (fb->rb);
 }
 
 int flux_buffer_readonly (flux_buffer_t *fb)
@@ -261,13 +259,15 @@ int flux_buffer_drop (flux_buffer_t *fb, int len)
 {
     int ret;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    if ((ret = cbuf_drop (fb->cbuf, len)) < 0)
-        return -1;
+    ret = ringbuf_used (fb->rb);
+    if (len >= 0 && len < ret)
+        ret = len;
+    ringbuf_consume (fb->rb, ret);
 
     check_write_cb (fb);
 
@@ -277,10 +277,7 @@ int flux_buffer_drop (flux_buffer_t *fb, int len)
 /* check if internal buffer can hold data from user */
 static int return_buffer_check (flux_buffer_t *fb)
 {
-    int used = cbuf_used (fb->cbuf);
-
-    if (used < 0)
-        return -1;
+    int used = ringbuf_used (fb->rb);
 
     assert (used <= fb->size);
 
@@ -317,13 +314,12 @@ const void *flux_buffer_peek (flux_buffer_t *fb, int len, int *lenp)
         return NULL;
 
     if (len < 0)
-        len = cbuf_used (fb->cbuf);
+        len = ringbuf_used (fb->rb);
 
-    if (len > fb->buflen)
-        len = fb->buflen;
+    if (len > fb->buflen - 1)
+        len = fb->buflen - 1;
 
-    if ((ret = cbuf_peek (fb->cbuf, fb->buf, len)) < 0)
-        return NULL;
+    ret = ringbuf_peek (fb->rb, fb->buf, len);
     fb->buf[ret] = '\0';
 
     if (lenp)
@@ -345,13 +341,13 @@ const void *flux_buffer_read (flux_buffer_t *fb, int len, int *lenp)
         return NULL;
 
     if (len < 0)
-        len = cbuf_used (fb->cbuf);
+        len = ringbuf_used (fb->rb);
 
-    if (len > fb->buflen)
-        len = fb->buflen;
+    if (len > fb->buflen - 1)
+        len = fb->buflen - 1;
 
-    if ((ret = cbuf_read (fb->cbuf, fb->buf, len)) < 0)
-        return NULL;
+    ret = ringbuf_peek (fb->rb, fb->buf, len);
+    ringbuf_consume (fb->rb, ret);
     fb->buf[ret] = '\0';
 
     if (lenp)
@@ -379,7 +375,15 @@ int flux_buffer_write (flux_buffer_t *fb, const void *data, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write (fb->cbuf, (void *)data, len, NULL)) < 0)
+    /* Write as much as fits, as long as something fits.
+     */
+    if ((ret = ringbuf_space (fb->rb)) == 0 && len > 0) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (len < ret)
+        ret = len;
+    if (ringbuf_write (fb->rb, data, ret) < 0)
         return -1;
 
     check_read_cb (fb);
@@ -394,17 +398,26 @@ int flux_buffer_lines (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_lines_used (fb->cbuf);
+    return ringbuf_count (fb->rb, '\n');
 }
 
 bool flux_buffer_has_line (flux_buffer_t *fb)
 {
-    char buf[1];
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return false;
     }
-    return (cbuf_peek_line (fb->cbuf, buf, 0, 1) > 0);
+    return (ringbuf_find (fb->rb, '\n') >= 0);
+}
+
+/* Return length of first line in buffer, including newline,
+ * or 0 if there is no complete line.
+ */
+static int line_length (flux_buffer_t *fb)
+{
+    ssize_t offset = ringbuf_find (fb->rb, '\n');
+
+    return offset < 0 ? 0 : offset + 1;
 }
 
 int flux_buffer_drop_line (flux_buffer_t *fb)
@@ -416,8 +429,8 @@ int flux_buffer_drop_line (flux_buffer_t *fb)
         return -1;
     }
 
-    if ((ret = cbuf_drop_line (fb->cbuf, fb->buflen, 1)) < 0)
-        return -1;
+    ret = line_length (fb);
+    ringbuf_consume (fb->rb, ret);
 
     check_write_cb (fb);
 
@@ -436,8 +449,9 @@ const void *flux_buffer_peek_line (flux_buffer_t *fb, int *lenp)
     if (return_buffer_check (fb) < 0)
         return NULL;
 
-    if ((ret = cbuf_peek_line (fb->cbuf, fb->buf, fb->buflen, 1)) < 0)
-        return NULL;
+    ret = line_length (fb);
+    ringbuf_peek (fb->rb, fb->buf, ret);
+    fb->buf[ret] = '\0';
 
     if (lenp)
         (*lenp) = ret;
@@ -476,8 +490,10 @@ const void *flux_buffer_read_line (flux_buffer_t *fb, int *lenp)
     if (return_buffer_check (fb) < 0)
         return NULL;
 
-    if ((ret = cbuf_read_line (fb->cbuf, fb->buf, fb->buflen, 1)) < 0)
-        return NULL;
+    ret = line_length (fb);
+    ringbuf_peek (fb->rb, fb->buf, ret);
+    ringbuf_consume (fb->rb, ret);
+    fb->buf[ret] = '\0';
 
     if (lenp)
         (*lenp) = ret;
@@ -508,6 +524,8 @@ const void *flux_buffer_read_trimmed_line (flux_buffer_t *fb, int *lenp)
 
 int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
 {
+    size_t len;
+    int newline;
     int ret;
 
     if (!fb
@@ -522,8 +540,18 @@ int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
         return -1;
     }
 
-    if ((ret = cbuf_write_line (fb->cbuf, (char *)data, NULL)) < 0)
+    /* Write line and newline together, or not at all.
+     */
+    len = strlen (data);
+    newline = (len == 0 || data[len - 1] != '\n');
+    if (len + newline > ringbuf_space (fb->rb)) {
+        errno = ENOSPC;
         return -1;
+    }
+    if (ringbuf_write (fb->rb, data, len) < 0
+        || (newline && ringbuf_write (fb->rb, "\n", 1) < 0))
+        return -1;
+    ret = len + newline;
 
     check_read_cb (fb);
 
@@ -532,25 +560,32 @@ int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
 
 int flux_buffer_peek_to_fd (flux_buffer_t *fb, int fd, int len)
 {
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    return cbuf_peek_to_fd (fb->cbuf, fd, len);
+    if (len < 0)
+        len = ringbuf_used (fb->rb);
+
+    return ringbuf_peek_to_fd (fb->rb, fd, len);
 }
 
 int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
 {
     int ret;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    if ((ret = cbuf_read_to_fd (fb->cbuf, fd, len)) < 0)
+    if (len < 0)
+        len = ringbuf_used (fb->rb);
+
+    if ((ret = ringbuf_peek_to_fd (fb->rb, fd, len)) < 0)
         return -1;
+    ringbuf_consume (fb->rb, ret);
 
     check_write_cb (fb);
 
@@ -561,7 +596,7 @@ int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
 {
     int ret;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || len < -1) {
         errno = EINVAL;
         return -1;
     }
@@ -571,7 +606,13 @@ int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write_from_fd (fb->cbuf, fd, len, NULL)) < 0)
+    /* Read into all free space if len is -1.  If the buffer is full,
+     * ringbuf_write_from_fd() fails with ENOSPC.
+     */
+    if (len < 0)
+        len = ringbuf_space (fb->rb) ? ringbuf_space (fb->rb) : 1;
+
+    if ((ret = ringbuf_write_from_fd (fb->rb, fd, len)) < 0)
         return -1;
 
     check_read_cb (fb);
@@ -547,6 +547,13 @@ uint32_t flux_matchtag_avail (flux_t *h)
     return tagpool_getattr (h->tagpool, TAGPOOL_ATTR_AVAIL);
 }
 
+uint32_t flux_matchtag_outstanding (flux_t *h)
+{
+    h = lookup_clone_ancestor (h);
+    return tagpool_getattr (h->tagpool, TAGPOOL_ATTR_SIZE)
+         - tagpool_getattr (h->tagpool, TAGPOOL_ATTR_AVAIL);
+}
+
 static void update_tx_stats (flux_t *h, const flux_msg_t *msg)
 {
     int type;
@@ -127,10 +127,12 @@ int flux_flags_get (flux_t *h);
 
 /* Alloc/free matchtag for matched request/response.
  * This is mainly used internally by the rpc code.
+ * flux_matchtag_outstanding() returns the number of matchtags allocated.
  */
 uint32_t flux_matchtag_alloc (flux_t *h);
 void flux_matchtag_free (flux_t *h, uint32_t matchtag);
 uint32_t flux_matchtag_avail (flux_t *h);
+uint32_t flux_matchtag_outstanding (flux_t *h);
 
 /* Send a message
  * flags may be 0 or FLUX_O_TRACE or FLUX_O_NONBLOCK (FLUX_O_COPROC is ignored)
@@ -21,6 +21,24 @@
  * PROTO frame
  *
  * See also: RFC 3
+ *
+ * Internally, a message is not stored as frames.  The PROTO fields are
+ * kept decoded in struct flux_msg, the topic is a string, and the route
+ * stack is an array of strings, most recently pushed last, so accessors
+ * need not search a frame list.  The payload is immutable and reference
+ * counted, so flux_msg_copy() shares it with the original, and setting
+ * a new payload replaces rather than modifies it.  Frames are produced
+ * only when a message is encoded or sent, and parsed only when it is
+ * decoded or received.
+ *
+ * Thread safety: a flux_msg_t and its reference count are not protected,
+ * so a message must be used by one thread at a time, and handed off to
+ * another thread only with a happens-before edge such as a zeromq send.
+ * The payload reference count is atomic, so copies that share a payload
+ * may be used and destroyed by different threads concurrently, and a
+ * zeromq I/O thread may release a payload sent with zero-copy.  Since the
+ * payload is never modified after creation, reading it is safe from any
+ * thread that holds a message referencing it.
  */
 
 #if HAVE_CONFIG_H
@@ -41,8 +59,32 @@
 
 #include "message.h"
 
+/* The payload refcount is updated atomically since a payload sent with
+ * zero-copy to a zeromq socket may be released by a zeromq I/O thread.
+ */
+struct msg_payload {
+    int refcount;
+    void *data;
+    int size;
+    zframe_t *zf;       /* if non-NULL, owns 'data' */
+};
+
 struct flux_msg {
-    zmsg_t *zmsg;
+    char **routes;
+    int routes_count;
+    int routes_alloc;
+    char *topic;
+    struct msg_payload *payload;
+
+    /* PROTO fields */
+    uint8_t type;
+    uint8_t flags;
+    uint32_t userid;
+    uint32_t rolemask;
+    uint32_t aux1;      /* nodeid (request), sequence (event), */
+                        /*   errnum (response, keepalive) */
+    uint32_t aux2;      /* matchtag (request, response), */
+                        /*   status (keepalive) */
     json_t *json;
     char *lasterr;
     struct aux_item *aux;
@@ -70,116 +112,130 @@ struct flux_msg {
 #define PROTO_U32_COUNT     4
 #define PROTO_SIZE          4 + (PROTO_U32_COUNT * 4)
 
-/* Helpful aliases */
-#define PROTO_IND_NODEID    PROTO_IND_AUX1 // request
-#define PROTO_IND_MATCHTAG  PROTO_IND_AUX2 // request, response
-#define PROTO_IND_SEQUENCE  PROTO_IND_AUX1 // event
-#define PROTO_IND_ERRNUM    PROTO_IND_AUX1 // response, keepalive
-#define PROTO_IND_STATUS    PROTO_IND_AUX2 // keepalive
-
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val);
-
-static int proto_set_type (uint8_t *data, int len, int type)
+static void proto_set_u32 (uint8_t *data, int index, uint32_t val)
+{
+    uint32_t x = htonl (val);
+    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    memcpy (&data[offset], &x, sizeof (x));
+}
+static uint32_t proto_get_u32 (const uint8_t *data, int index)
+{
+    uint32_t x;
+    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    memcpy (&x, &data[offset], sizeof (x));
+    return ntohl (x);
+}
+static void proto_encode (const flux_msg_t *msg, uint8_t *data)
+{
+    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
+    data[PROTO_OFF_VERSION] = PROTO_VERSION;
+    data[PROTO_OFF_TYPE] = msg->type;
+    data[PROTO_OFF_FLAGS] = msg->flags;
+    proto_set_u32 (data, PROTO_IND_USERID, msg->userid);
+    proto_set_u32 (data, PROTO_IND_ROLEMASK, msg->rolemask);
+    proto_set_u32 (data, PROTO_IND_AUX1, msg->aux1);
+    proto_set_u32 (data, PROTO_IND_AUX2, msg->aux2);
+}
+static int proto_decode (flux_msg_t *msg, const uint8_t *data, int len)
 {
     if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
+                         || data[PROTO_OFF_VERSION] != PROTO_VERSION) {
+        errno = EPROTO;
         return -1;
-    switch (type) {
-        case FLUX_MSGTYPE_REQUEST:
-            if (proto_set_u32 (data, len, PROTO_IND_NODEID,
-                               FLUX_NODEID_ANY) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_MATCHTAG,
-                               FLUX_MATCHTAG_NONE) < 0)
-                return -1;
-            break;
-        case FLUX_MSGTYPE_RESPONSE:
-            /* N.B. don't clobber matchtag from request on set_type */
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
-            break;
-        case FLUX_MSGTYPE_EVENT:
-            if (proto_set_u32 (data, len, PROTO_IND_SEQUENCE, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_AUX2, 0) < 0)
-                return -1;
-            break;
-        case FLUX_MSGTYPE_KEEPALIVE:
-            if (proto_set_u32 (data, len, PROTO_IND_STATUS, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
-            break;
-        default:
-            return -1;
     }
-    data[PROTO_OFF_TYPE] = type;
+    msg->type = data[PROTO_OFF_TYPE];
+    msg->flags = data[PROTO_OFF_FLAGS];
+    msg->userid = proto_get_u32 (data, PROTO_IND_USERID);
+    msg->rolemask = proto_get_u32 (data, PROTO_IND_ROLEMASK);
+    msg->aux1 = proto_get_u32 (data, PROTO_IND_AUX1);
+    msg->aux2 = proto_get_u32 (data, PROTO_IND_AUX2);
     return 0;
 }
-static int proto_get_type (uint8_t *data, int len, int *type)
+/* End manual codec
+ */
+
+static void payload_decref (struct msg_payload *pay)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *type = data[PROTO_OFF_TYPE];
-    return 0;
+    if (pay && __atomic_sub_fetch (&pay->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        int saved_errno = errno;
+        if (pay->zf)
+            zframe_destroy (&pay->zf);
+        else
+            free (pay->data);
+        free (pay);
+        errno = saved_errno;
+    }
 }
-static int proto_set_flags (uint8_t *data, int len, uint8_t flags)
+
+static struct msg_payload *payload_incref (struct msg_payload *pay)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    data[PROTO_OFF_FLAGS] = flags;
-    return 0;
+    __atomic_add_fetch (&pay->refcount, 1, __ATOMIC_RELAXED);
+    return pay;
 }
-static int proto_get_flags (uint8_t *data, int len, uint8_t *val)
+
+static struct msg_payload *payload_create (const void *buf, int size)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *val = data[PROTO_OFF_FLAGS];
-    return 0;
+    struct msg_payload *pay;
+
+    if (!(pay = calloc (1, sizeof (*pay))))
+        return NULL;
+    if (!(pay->data = malloc (size))) {
+        free (pay);
+        errno = ENOMEM;
+        return NULL;
+    }
+    memcpy (pay->data, buf, size);
+    pay->size = size;
+    pay->refcount = 1;
+    return pay;
 }
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val)
+
+/* Create payload that takes ownership of 'zf', avoiding a copy.
+ */
+static struct msg_payload *payload_create_zframe (zframe_t *zf)
 {
-    uint32_t x = htonl (val);
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    struct msg_payload *pay;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&data[offset], &x, sizeof (x));
-    return 0;
+    if (!(pay = calloc (1, sizeof (*pay))))
+        return NULL;
+    pay->zf = zf;
+    pay->data = zframe_data (zf);
+    pay->size = zframe_size (zf);
+    pay->refcount = 1;
+    return pay;
 }
-static int proto_get_u32 (uint8_t *data, int len, int index, uint32_t *val)
+
+static void routes_clear (flux_msg_t *msg)
 {
-    uint32_t x;
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    int i;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&x, &data[offset], sizeof (x));
-    *val = ntohl (x);
-    return 0;
+    for (i = 0; i < msg->routes_count; i++)
+        free (msg->routes[i]);
+    msg->routes_count = 0;
 }
-static void proto_init (uint8_t *data, int len, uint8_t flags)
+
+static int routes_push (flux_msg_t *msg, const char *id)
 {
-    int n;
-    assert (len >= PROTO_SIZE);
-    memset (data, 0, len);
-    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
-    data[PROTO_OFF_VERSION] = PROTO_VERSION;
-    data[PROTO_OFF_FLAGS] = flags;
-    n = proto_set_u32 (data, len, PROTO_IND_USERID, FLUX_USERID_UNKNOWN);
-    assert (n == 0);
-    n = proto_set_u32 (data, len, PROTO_IND_ROLEMASK, FLUX_ROLE_NONE);
-    assert (n == 0);
+    char *s;
+
+    if (msg->routes_count == msg->routes_alloc) {
+        int alloc = msg->routes_alloc ? msg->routes_alloc * 2 : 4;
+        char **routes;
+
+        if (!(routes = realloc (msg->routes, alloc * sizeof (routes[0])))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        msg->routes = routes;
+        msg->routes_alloc = alloc;
+    }
+    if (!(s = strdup (id))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    msg->routes[msg->routes_count++] = s;
+    return 0;
 }
-/* End manual codec
- */
 
 static flux_msg_t *flux_msg_create_common (void)
 {
@@ -193,21 +249,13 @@ static flux_msg_t *flux_msg_create_common (void)
 
 flux_msg_t *flux_msg_create (int type)
 {
-    uint8_t proto[PROTO_SIZE];
     flux_msg_t *msg;
 
     if (!(msg = flux_msg_create_common ()))
         return NULL;
-    proto_init (proto, PROTO_SIZE, 0);
-    if (proto_set_type (proto, PROTO_SIZE, type) < 0) {
-        errno = EINVAL;
-        goto error;
-    }
-    if (!(msg->zmsg = zmsg_new ())) {
-        errno = ENOMEM;
-        goto error;
-    }
-    if (zmsg_addmem (msg->zmsg, proto, PROTO_SIZE) < 0)
+    msg->userid = FLUX_USERID_UNKNOWN;
+    msg->rolemask = FLUX_ROLE_NONE;
+    if (flux_msg_set_type (msg, type) < 0)
         goto error;
     return msg;
 error:
@@ -220,7 +268,10 @@ void flux_msg_destroy (flux_msg_t *msg)
     if (msg && --msg->refcount == 0) {
         int saved_errno = errno;
         json_decref (msg->json);
-        zmsg_destroy (&msg->zmsg);
+        free (msg->topic);
+        routes_clear (msg);
+        free (msg->routes);
+        payload_decref (msg->payload);
         aux_destroy (&msg->aux);
         free (msg->lasterr);
         free (msg);
@@ -275,64 +326,198 @@ void *flux_msg_aux_get (const flux_msg_t *msg, const char *name)
     return aux_get (msg->aux, name);
 }
 
-size_t flux_msg_encode_size (const flux_msg_t *msg)
+/* Call fn for each frame of 'msg' in wire order (see top of file).
+ * Stop and return -1 if fn fails.
+ */
+typedef int (*frame_f)(const void *data, size_t size, bool more, void *arg);
+
+static int msg_foreach_frame (const flux_msg_t *msg, frame_f fn, void *arg)
 {
-    zframe_t *zf;
-    size_t size = 0;
+    uint8_t proto[PROTO_SIZE];
+    int i;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
-        if (n < 255)
-            size += 1;
-        else
-            size += 1 + 4;
-        size += n;
-        zf = zmsg_next (msg->zmsg);
+    if ((msg->flags & FLUX_MSGFLAG_ROUTE)) {
+        for (i = msg->routes_count - 1; i >= 0; i--) {
+            if (fn (msg->routes[i], strlen (msg->routes[i]), true, arg) < 0)
+                return -1;
+        }
+        if (fn (NULL, 0, true, arg) < 0)
+            return -1;
     }
-    return size;
+    if (msg->topic) {
+        if (fn (msg->topic, strlen (msg->topic) + 1, true, arg) < 0)
+            return -1;
+    }
+    if (msg->payload) {
+        if (fn (msg->payload->data, msg->payload->size, true, arg) < 0)
+            return -1;
+    }
+    proto_encode (msg, proto);
+    return fn (proto, PROTO_SIZE, false, arg);
 }
 
-
-int flux_msg_encode (const flux_msg_t *msg, void *buf, size_t size)
+/* Parse '*zmsg', a complete message in wire order, into 'msg'.
+ * The zmsg is destroyed, but its payload frame is adopted without a copy.
+ */
+static int msg_import_zmsg (flux_msg_t *msg, zmsg_t **zmsg)
 {
-    uint8_t *p = buf;
     zframe_t *zf;
+    int count;
+    int i;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
-        if (n < 0xff) {
-            if (size - (p - (uint8_t *)buf) < n + 1)
-                goto nospace;
-            *p++ = (uint8_t)n;
-        } else {
-            if (size - (p - (uint8_t *)buf) < n + 1 + 4)
-                goto nospace;
-            *p++ = 0xff;
-            *(uint32_t *)p = htonl (n);
-            p += 4;
+    if (!(zf = zmsg_last (*zmsg))
+        || proto_decode (msg, zframe_data (zf), zframe_size (zf)) < 0)
+        goto eproto;
+    if ((msg->flags & FLUX_MSGFLAG_ROUTE)) {
+        count = 0;
+        zf = zmsg_first (*zmsg);
+        while (zf && zframe_size (zf) > 0) {
+            zf = zmsg_next (*zmsg);
+            count++;
+        }
+        if (!zf)
+            goto eproto;
+        if (count > 0) {
+            if (!(msg->routes = calloc (count, sizeof (msg->routes[0]))))
+                goto nomem;
+            msg->routes_alloc = count;
+        }
+        for (i = count - 1; i >= 0; i--) {
+            bool valid;
+
+            zf = zmsg_pop (*zmsg);
+            valid = !memchr (zframe_data (zf), '\0', zframe_size (zf));
+            if (valid)
+                msg->routes[i] = zframe_strdup (zf);
+            zframe_destroy (&zf);
+            if (!msg->routes[i]) {
+                /* Slots are filled from the end, but flux_msg_destroy()
+                 * frees the first routes_count, so move them there.
+                 */
+                memmove (msg->routes,
+                         msg->routes + i + 1,
+                         msg->routes_count * sizeof (msg->routes[0]));
+                if (!valid)
+                    goto eproto;
+                goto nomem;
+            }
+            msg->routes_count++;
+        }
+        zf = zmsg_pop (*zmsg); /* route delimiter */
+        zframe_destroy (&zf);
+    }
+    if ((msg->flags & FLUX_MSGFLAG_TOPIC)) {
+        const char *s;
+        size_t size;
+
+        if (zmsg_size (*zmsg) < 2)
+            goto eproto;
+        zf = zmsg_pop (*zmsg);
+        s = (const char *)zframe_data (zf);
+        size = zframe_size (zf);
+        if (size == 0 || s[size - 1] != '\0') {
+            zframe_destroy (&zf);
+            goto eproto;
+        }
+        msg->topic = strdup (s);
+        zframe_destroy (&zf);
+        if (!msg->topic)
+            goto nomem;
+    }
+    if ((msg->flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (zmsg_size (*zmsg) < 2)
+            goto eproto;
+        zf = zmsg_pop (*zmsg);
+        if (!(msg->payload = payload_create_zframe (zf))) {
+            zframe_destroy (&zf);
+            goto nomem;
         }
-        memcpy (p, zframe_data (zf), n);
-        p += n;
-        zf = zmsg_next (msg->zmsg);
     }
+    if (zmsg_size (*zmsg) != 1)
+        goto eproto;
+    zmsg_destroy (zmsg);
+    return 0;
+nomem:
+    errno = ENOMEM;
+    goto error;
+eproto:
+    errno = EPROTO;
+error:
+    ERRNO_SAFE_WRAP (zmsg_destroy, zmsg);
+    return -1;
+}
+
+static int frame_size (const void *data, size_t n, bool more, void *arg)
+{
+    size_t *size = arg;
+
+    if (n < 255)
+        *size += 1;
+    else
+        *size += 1 + 4;
+    *size += n;
+    return 0;
+}
+
+size_t flux_msg_encode_size (const flux_msg_t *msg)
+{
+    size_t size = 0;
+
+    if (msg_foreach_frame (msg, frame_size, &size) < 0)
+        return 0;
+    return size;
+}
+
+struct encode_buf {
+    uint8_t *p;
+    size_t size;
+};
+
+static int frame_encode (const void *data, size_t n, bool more, void *arg)
+{
+    struct encode_buf *eb = arg;
+
+    if (n < 0xff) {
+        if (eb->size < n + 1)
+            goto nospace;
+        *eb->p++ = (uint8_t)n;
+        eb->size -= 1;
+    } else {
+        if (eb->size < n + 1 + 4)
+            goto nospace;
+        *eb->p++ = 0xff;
+        *(uint32_t *)eb->p = htonl (n);
+        eb->p += 4;
+        eb->size -= 1 + 4;
+    }
+    if (n > 0)
+        memcpy (eb->p, data, n);
+    eb->p += n;
+    eb->size -= n;
     return 0;
 nospace:
     errno = EINVAL;
     return -1;
 }
 
+int flux_msg_encode (const flux_msg_t *msg, void *buf, size_t size)
+{
+    struct encode_buf eb = { .p = buf, .size = size };
+
+    return msg_foreach_frame (msg, frame_encode, &eb);
+}
+
 flux_msg_t *flux_msg_decode (const void *buf, size_t size)
 {
     flux_msg_t *msg;
+    zmsg_t *zmsg;
     uint8_t const *p = buf;
     zframe_t *zf;
 
-    if (!(msg = flux_msg_create_common ()))
+    if (!(zmsg = zmsg_new ())) {
+        errno = ENOMEM;
         return NULL;
-    if (!(msg->zmsg = zmsg_new ()))
-        goto nomem;
+    }
     while (p - (uint8_t *)buf < size) {
         size_t n = *p++;
         if (n == 0xff) {
@@ -349,35 +534,62 @@ flux_msg_t *flux_msg_decode (const void *buf, size_t size)
         }
         if (!(zf = zframe_new (p, n)))
             goto nomem;
-        if (zmsg_append (msg->zmsg, &zf) < 0)
+        if (zmsg_append (zmsg, &zf) < 0)
             goto nomem;
         p += n;
     }
+    if (!(msg = flux_msg_create_common ()))
+        goto nomem;
+    if (msg_import_zmsg (msg, &zmsg) < 0) {
+        flux_msg_destroy (msg);
+        return NULL;
+    }
     return msg;
 nomem:
     errno = ENOMEM;
 error:
-    flux_msg_destroy (msg);
+    ERRNO_SAFE_WRAP (zmsg_destroy, &zmsg);
     return NULL;
 }
 
 int flux_msg_set_type (flux_msg_t *msg, int type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_type (zframe_data (zf), zframe_size (zf), type) < 0) {
+    if (!msg) {
         errno = EINVAL;
         return -1;
     }
+    switch (type) {
+        case FLUX_MSGTYPE_REQUEST:
+            msg->aux1 = FLUX_NODEID_ANY;
+            msg->aux2 = FLUX_MATCHTAG_NONE;
+            break;
+        case FLUX_MSGTYPE_RESPONSE:
+            /* N.B. don't clobber matchtag from request on set_type */
+            msg->aux1 = 0;
+            break;
+        case FLUX_MSGTYPE_EVENT:
+            msg->aux1 = 0;
+            msg->aux2 = 0;
+            break;
+        case FLUX_MSGTYPE_KEEPALIVE:
+            msg->aux1 = 0;
+            msg->aux2 = 0;
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    msg->type = type;
     return 0;
 }
 
 int flux_msg_get_type (const flux_msg_t *msg, int *type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), type) < 0) {
-        errno = EPROTO;
+    if (!msg || !type) {
+        errno = EINVAL;
         return -1;
     }
+    *type = msg->type;
     return 0;
 }
 
@@ -386,18 +598,15 @@ int flux_msg_set_flags (flux_msg_t *msg, uint8_t fl)
     const uint8_t valid_flags = FLUX_MSGFLAG_TOPIC | FLUX_MSGFLAG_PAYLOAD
                               | FLUX_MSGFLAG_ROUTE | FLUX_MSGFLAG_UPSTREAM
                               | FLUX_MSGFLAG_PRIVATE | FLUX_MSGFLAG_STREAMING
-                              | FLUX_MSGFLAG_NORESPONSE;
+                              | FLUX_MSGFLAG_NORESPONSE
+                              | FLUX_MSGFLAG_COMPRESSED;
 
     if (!msg || fl & ~valid_flags || ((fl & FLUX_MSGFLAG_STREAMING)
                                    && (fl & FLUX_MSGFLAG_NORESPONSE)) != 0) {
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->flags = fl;
     return 0;
 }
 
@@ -407,11 +616,7 @@ int flux_msg_get_flags (const flux_msg_t *msg, uint8_t *fl)
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *fl = msg->flags;
     return 0;
 }
 
@@ -473,77 +678,41 @@ bool flux_msg_is_noresponse (const flux_msg_t *msg)
 
 int flux_msg_set_userid (flux_msg_t *msg, uint32_t userid)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->userid = userid;
     return 0;
 }
 
 int flux_msg_get_userid (const flux_msg_t *msg, uint32_t *userid)
 {
-    zframe_t *zf;
-
     if (!msg || !userid) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *userid = msg->userid;
     return 0;
 }
 
 int flux_msg_set_rolemask (flux_msg_t *msg, uint32_t rolemask)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->rolemask = rolemask;
     return 0;
 }
 
 int flux_msg_get_rolemask (const flux_msg_t *msg, uint32_t *rolemask)
 {
-    zframe_t *zf;
-
     if (!msg || !rolemask) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *rolemask = msg->rolemask;
     return 0;
 }
 
@@ -597,22 +766,13 @@ int flux_msg_authorize (const flux_msg_t *msg, uint32_t userid)
 
 int flux_msg_set_nodeid (flux_msg_t *msg, uint32_t nodeid)
 {
-    zframe_t *zf;
-    int type;
-
     if (!msg)
         goto error;
     if (nodeid == FLUX_NODEID_UPSTREAM) /* should have been resolved earlier */
         goto error;
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, nodeid) < 0)
+    if (msg->type != FLUX_MSGTYPE_REQUEST)
         goto error;
+    msg->aux1 = nodeid;
     return 0;
 error:
     errno = EINVAL;
@@ -621,24 +781,13 @@ error:
 
 int flux_msg_get_nodeid (const flux_msg_t *msg, uint32_t *nodeidp)
 {
-    zframe_t *zf;
-    int type;
-    uint32_t nodeid;
-
     if (!msg || !nodeidp) {
         errno = EINVAL;
         return -1;
     }
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, &nodeid) < 0)
+    if (msg->type != FLUX_MSGTYPE_REQUEST)
         goto error;
-    *nodeidp = nodeid;
+    *nodeidp = msg->aux1;
     return 0;
 error:
     return EPROTO;
@@ -647,125 +796,85 @@ error:
 
 int flux_msg_set_errnum (flux_msg_t *msg, int e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, e) < 0) {
+    if (!msg || (msg->type != FLUX_MSGTYPE_RESPONSE
+              && msg->type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->aux1 = e;
     return 0;
 }
 
 int flux_msg_get_errnum (const flux_msg_t *msg, int *e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t xe;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, &xe) < 0) {
+    if (!msg || (msg->type != FLUX_MSGTYPE_RESPONSE
+              && msg->type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EPROTO;
         return -1;
     }
-    *e = xe;
+    *e = msg->aux1;
     return 0;
 }
 
 int flux_msg_set_seq (flux_msg_t *msg, uint32_t seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->type != FLUX_MSGTYPE_EVENT) {
         errno = EINVAL;
         return -1;
     }
+    msg->aux1 = seq;
     return 0;
 }
 
 int flux_msg_get_seq (const flux_msg_t *msg, uint32_t *seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->type != FLUX_MSGTYPE_EVENT) {
         errno = EPROTO;
         return -1;
     }
+    *seq = msg->aux1;
     return 0;
 }
 
 int flux_msg_set_matchtag (flux_msg_t *msg, uint32_t t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->type != FLUX_MSGTYPE_REQUEST
+              && msg->type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->aux2 = t;
     return 0;
 }
 
 int flux_msg_get_matchtag (const flux_msg_t *msg, uint32_t *t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->type != FLUX_MSGTYPE_REQUEST
+              && msg->type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EPROTO;
         return -1;
     }
+    *t = msg->aux2;
     return 0;
 }
 
 int flux_msg_set_status (flux_msg_t *msg, int s)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, s) < 0) {
+    if (!msg || msg->type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EINVAL;
         return -1;
     }
+    msg->aux2 = s;
     return 0;
 }
 
 int flux_msg_get_status (const flux_msg_t *msg, int *s)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t u;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, &u) < 0) {
+    if (!msg || msg->type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EPROTO;
         return -1;
     }
-    *s = u;
+    *s = msg->aux2;
     return 0;
 }
 
@@ -834,10 +943,6 @@ int flux_msg_enable_route (flux_msg_t *msg)
         return -1;
     if ((flags & FLUX_MSGFLAG_ROUTE))
         return 0;
-    if (zmsg_pushmem (msg->zmsg, NULL, 0) < 0) {
-        errno = ENOMEM;
-        return -1;
-    }
     flags |= FLUX_MSGFLAG_ROUTE;
     return flux_msg_set_flags (msg, flags);
 }
@@ -845,19 +950,12 @@ int flux_msg_enable_route (flux_msg_t *msg)
 int flux_msg_clear_route (flux_msg_t *msg)
 {
     uint8_t flags;
-    zframe_t *zf;
-    int size;
 
     if (flux_msg_get_flags (msg, &flags) < 0)
         return -1;
     if (!(flags & FLUX_MSGFLAG_ROUTE))
         return 0;
-    while ((zf = zmsg_pop (msg->zmsg))) {
-        size = zframe_size (zf);
-        zframe_destroy (&zf);
-        if (size == 0)
-            break;
-    }
+    routes_clear (msg);
     flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
     return flux_msg_set_flags (msg, flags);
 }
@@ -872,35 +970,25 @@ int flux_msg_push_route (flux_msg_t *msg, const char *id)
         errno = EPROTO;
         return -1;
     }
-    if (zmsg_pushstr (msg->zmsg, id) < 0) {
-        errno = ENOMEM;
-        return -1;
-    }
-    return 0;
+    return routes_push (msg, id);
 }
 
 int flux_msg_pop_route (flux_msg_t *msg, char **id)
 {
     uint8_t flags;
-    zframe_t *zf;
 
     if (flux_msg_get_flags (msg, &flags) < 0)
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
+    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zframe_size (zf) > 0 && (zf = zmsg_pop (msg->zmsg))) {
-        if (id) {
-            char *s = zframe_strdup (zf);
-            if (!s) {
-                zframe_destroy (&zf);
-                errno = ENOMEM;
-                return -1;
-            }
+    if (msg->routes_count > 0) {
+        char *s = msg->routes[--msg->routes_count];
+        if (id)
             *id = s;
-        }
-        zframe_destroy (&zf);
+        else
+            free (s);
     } else {
         if (id)
             *id = NULL;
@@ -908,20 +996,21 @@ int flux_msg_pop_route (flux_msg_t *msg, char **id)
     return 0;
 }
 
-/* replaces flux_msg_nexthop */
-int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
+/* Set *id to a copy of route 'index' of msg, or NULL if the route stack
+ * is empty, in which case 'index' is ignored.
+ */
+static int msg_get_route (const flux_msg_t *msg, int index, char **id)
 {
     uint8_t flags;
-    zframe_t *zf;
     char *s = NULL;
 
     if (flux_msg_get_flags (msg, &flags) < 0)
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
+    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
+    if (msg->routes_count > 0 && !(s = strdup (msg->routes[index]))) {
         errno = ENOMEM;
         return -1;
     }
@@ -929,43 +1018,21 @@ int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
     return 0;
 }
 
+/* replaces flux_msg_nexthop */
+int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
+{
+    return msg_get_route (msg, msg->routes_count - 1, id);
+}
+
 /* replaces flux_msg_sender */
 int flux_msg_get_route_first (const flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf, *zf_next;
-    char *s = NULL;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return -1;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf_next = zmsg_next (msg->zmsg);
-        if (zf_next && zframe_size (zf_next) == 0)
-            break;
-        zf = zf_next;
-    }
-    if (!zf) {
-        errno = EPROTO;
-        return -1;
-    }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
-        errno = ENOMEM;
-        return -1;
-    }
-    *id = s;
-    return 0;
+    return msg_get_route (msg, 0, id);
 }
 
 int flux_msg_get_route_count (const flux_msg_t *msg)
 {
     uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
 
     if (flux_msg_get_flags (msg, &flags) < 0)
         return -1;
@@ -973,12 +1040,7 @@ int flux_msg_get_route_count (const flux_msg_t *msg)
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    return count;
+    return msg->routes_count;
 }
 
 /* Get sum of size in bytes of route frames
@@ -986,8 +1048,8 @@ int flux_msg_get_route_count (const flux_msg_t *msg)
 static int flux_msg_get_route_size (const flux_msg_t *msg)
 {
     uint8_t flags;
-    zframe_t *zf;
     int size = 0;
+    int i;
 
     if (flux_msg_get_flags (msg, &flags) < 0)
         return -1;
@@ -995,42 +1057,15 @@ static int flux_msg_get_route_size (const flux_msg_t *msg)
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        size += zframe_size (zf);
-        zf = zmsg_next (msg->zmsg);
-    }
+    for (i = 0; i < msg->routes_count; i++)
+        size += strlen (msg->routes[i]);
     return size;
 }
 
-static zframe_t *flux_msg_get_route_nth (const flux_msg_t *msg, int n)
-{
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return NULL;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return NULL;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        if (count == n)
-            return zf;
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    errno = ENOENT;
-    return NULL;
-}
-
 char *flux_msg_get_route_string (const flux_msg_t *msg)
 {
     int hops, len;
     int n;
-    zframe_t *zf;
     char *buf, *cp;
 
     if (msg == NULL) {
@@ -1043,95 +1078,90 @@ char *flux_msg_get_route_string (const flux_msg_t *msg)
     }
     if (!(cp = buf = malloc (len + hops + 1)))
         return NULL;
-    for (n = hops - 1; n >= 0; n--) {
+    for (n = 0; n < hops; n++) {
         if (cp > buf)
             *cp++ = '!';
-        if (!(zf = flux_msg_get_route_nth (msg, n))) {
-            ERRNO_SAFE_WRAP (free, buf);
-            return NULL;
-        }
-        int cpylen = zframe_size (zf);
+        int cpylen = strlen (msg->routes[n]);
         if (cpylen == 36) /* abbreviate long UUID */
             cpylen = 8;
         assert (cp - buf + cpylen < len + hops);
-        memcpy (cp, zframe_data (zf), cpylen);
+        memcpy (cp, msg->routes[n], cpylen);
         cp += cpylen;
     }
     *cp = '\0';
     return buf;
 }
 
-static bool payload_overlap (const void *b, zframe_t *zf)
+static bool payload_overlap (const void *b, struct msg_payload *pay)
 {
-    return ((char *)b >= (char *)zframe_data (zf)
-         && (char *)b <  (char *)zframe_data (zf) + zframe_size (zf));
+    return ((char *)b >= (char *)pay->data
+         && (char *)b <  (char *)pay->data + pay->size);
 }
 
 int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size)
 {
-    zframe_t *zf;
+    struct msg_payload *pay;
     uint8_t flags;
-    int rc = -1;
 
     if (!msg) {
         errno = EINVAL;
-        goto done;
+        return -1;
     }
     json_decref (msg->json);            /* invalidate cached json object */
     msg->json = NULL;
     if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        rc = 0;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);      /* skip route frame */
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip route delim */
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip topic frame */
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
-    }
-    /* Case #1: replace existing payload.
+        return -1;
+    /* Remove payload.
      */
-    if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        if (zframe_data (zf) != buf || zframe_size (zf) != size) {
-            if (payload_overlap (buf, zf)) {
-                errno = EINVAL;
-                goto done;
-            }
-            zframe_reset (zf, buf, size);
-        }
-    /* Case #2: add payload.
+    if (buf == NULL || size == 0) {
+        if (!(flags & FLUX_MSGFLAG_PAYLOAD))
+            return 0;
+        payload_decref (msg->payload);
+        msg->payload = NULL;
+        flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
+        return flux_msg_set_flags (msg, flags);
+    }
+    /* Add or replace payload.  The payload may be shared with copies of
+     * this message, so it is replaced, never modified.
      */
-    } else if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        if (zmsg_addmem (msg->zmsg, buf, size) < 0
-                                        || zmsg_append (msg->zmsg, &zf) < 0) {
-            errno = ENOMEM;
-            goto done;
+    if (msg->payload) {
+        if (msg->payload->data == buf && msg->payload->size == size)
+            return 0;
+        if (payload_overlap (buf, msg->payload)) {
+            errno = EINVAL;
+            return -1;
         }
-        flags |= FLUX_MSGFLAG_PAYLOAD;
-    /* Case #3: remove payload.
-     */
-    } else if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
     }
-    if (flux_msg_set_flags (msg, flags) < 0)
-        goto done;
-    rc = 0;
-done:
-    return rc;
+    if (!(pay = payload_create (buf, size)))
+        return -1;
+    payload_decref (msg->payload);
+    msg->payload = pay;
+    flags |= FLUX_MSGFLAG_PAYLOAD;
+    return flux_msg_set_flags (msg, flags);
+}
+
+int flux_msg_set_payload_nocopy (flux_msg_t *msg, void *buf, int size)
+{
+    struct msg_payload *pay;
+    uint8_t flags;
+
+    if (!msg || !buf || size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_msg_get_flags (msg, &flags) < 0)
+        return -1;
+    if (!(pay = calloc (1, sizeof (*pay))))
+        return -1;
+    pay->data = buf;
+    pay->size = size;
+    pay->refcount = 1;
+    json_decref (msg->json);            /* invalidate cached json object */
+    msg->json = NULL;
+    payload_decref (msg->payload);
+    msg->payload = pay;
+    flags |= FLUX_MSGFLAG_PAYLOAD;
+    return flux_msg_set_flags (msg, flags);
 }
 
 static inline void msg_lasterr_reset (flux_msg_t *msg)
@@ -1208,34 +1238,18 @@ int flux_msg_pack (flux_msg_t *msg, const char *fmt, ...)
 
 int flux_msg_get_payload (const flux_msg_t *msg, const void **buf, int *size)
 {
-    zframe_t *zf;
     uint8_t flags;
 
     if (flux_msg_get_flags (msg, &flags) < 0)
         return -1;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD)) {
-        errno = EPROTO;
-        return -1;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {
+    if (!(flags & FLUX_MSGFLAG_PAYLOAD) || !msg->payload) {
         errno = EPROTO;
         return -1;
     }
     if (buf)
-        *buf = zframe_data (zf);
+        *buf = msg->payload->data;
     if (size)
-        *size = zframe_size (zf);
+        *size = msg->payload->size;
     return 0;
 }
 
@@ -1353,140 +1367,78 @@ const char *flux_msg_last_error (const flux_msg_t *msg)
 
 int flux_msg_set_topic (flux_msg_t *msg, const char *topic)
 {
-    zframe_t *zf, *zf2 = NULL;
-    uint8_t flags;
-    int rc = -1;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {   /* skip over routing frames, if any */
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC) && topic) {        /* case 1: repl topic */
-        zframe_reset (zf, topic, strlen (topic) + 1);
-    } else if (!(flags & FLUX_MSGFLAG_TOPIC) && topic) {/* case 2: add topic */
-        zmsg_remove (msg->zmsg, zf);
-        if ((flags & FLUX_MSGFLAG_PAYLOAD) && (zf2 = zmsg_next (msg->zmsg)))
-            zmsg_remove (msg->zmsg, zf2);
-        if (zmsg_addmem (msg->zmsg, topic, strlen (topic) + 1) < 0
-                                    || zmsg_append (msg->zmsg, &zf) < 0
-                                    || (zf2 && zmsg_append (msg->zmsg, &zf2) < 0)) {
-            errno = ENOMEM;
-            goto done;
-        }
-        flags |= FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    } else if ((flags & FLUX_MSGFLAG_TOPIC) && !topic) { /* case 3: del topic */
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    }
-    rc = 0;
-done:
-    return rc;
-}
-
-static int zf_topic (const flux_msg_t *msg, zframe_t **zfp)
-{
-    uint8_t flags;
-    zframe_t *zf = NULL;
-    int rc = -1;
+    char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_TOPIC)) {
-        errno = EPROTO;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
     }
-    if (!zf) {
-        errno = EPROTO;
-        goto done;
+    if (topic && !(s = strdup (topic))) {
+        errno = ENOMEM;
+        return -1;
     }
-    *zfp = zf;
-    rc = 0;
-done:
-    return rc;
+    free (msg->topic);
+    msg->topic = s;
+    if (topic)
+        msg->flags |= FLUX_MSGFLAG_TOPIC;
+    else
+        msg->flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
+    return 0;
 }
 
 int flux_msg_get_topic (const flux_msg_t *msg, const char **topic)
 {
-    zframe_t *zf;
-    const char *s;
-    int rc = -1;
-
-    if (zf_topic (msg, &zf) < 0)
-        goto done;
-    s = (const char *)zframe_data (zf);
-    if (s[zframe_size (zf) - 1] != '\0') {
+    if (!msg || !topic) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!msg->topic) {
         errno = EPROTO;
-        goto done;
+        return -1;
     }
-    *topic = s;
-    rc = 0;
-done:
-    return rc;
+    *topic = msg->topic;
+    return 0;
 }
 
+/* The copy shares the (immutable) payload of 'msg'.
+ */
 flux_msg_t *flux_msg_copy (const flux_msg_t *msg, bool payload)
 {
     flux_msg_t *cpy = NULL;
-    zframe_t *zf;
-    int count;
-    uint8_t flags;
-    bool skip_payload = false;
+    int i;
 
-    /* Set skip_payload = true if caller set 'payload' flag false
-     * AND message contains a payload frame.
-     */
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return NULL;
-    if (!payload && (flags & FLUX_MSGFLAG_PAYLOAD)) {
-        flags &= ~(FLUX_MSGFLAG_PAYLOAD);
-        skip_payload = true;
     }
     if (!(cpy = flux_msg_create_common ()))
         return NULL;
-    if (!(cpy->zmsg = zmsg_new ()))
+    cpy->type = msg->type;
+    cpy->flags = msg->flags;
+    cpy->userid = msg->userid;
+    cpy->rolemask = msg->rolemask;
+    cpy->aux1 = msg->aux1;
+    cpy->aux2 = msg->aux2;
+    if (msg->topic && !(cpy->topic = strdup (msg->topic)))
         goto nomem;
-
-    /* Copy frames from 'msg' to 'cpy'.
-     * 'count' indexes frames from 0 to zmsg_size (msg) - 1.
-     * The payload frame (if it exists) will be in the second to last position.
-     */
-    count = 0;
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        if (!skip_payload || count != zmsg_size (msg->zmsg) - 2) {
-            if (zmsg_addmem (cpy->zmsg, zframe_data (zf), zframe_size (zf)) < 0)
+    if (msg->routes_count > 0) {
+        if (!(cpy->routes = calloc (msg->routes_count,
+                                    sizeof (cpy->routes[0]))))
+            goto nomem;
+        cpy->routes_alloc = msg->routes_count;
+        for (i = 0; i < msg->routes_count; i++) {
+            if (!(cpy->routes[i] = strdup (msg->routes[i])))
                 goto nomem;
+            cpy->routes_count++;
         }
-        zf = zmsg_next (msg->zmsg);
-        count++;
     }
-    if (flux_msg_set_flags (cpy, flags) < 0)
-        goto error;
+    if (payload && msg->payload)
+        cpy->payload = payload_incref (msg->payload);
+    else
+        cpy->flags &= ~(uint8_t)FLUX_MSGFLAG_PAYLOAD;
     return cpy;
 nomem:
     errno = ENOMEM;
-error:
     flux_msg_destroy (cpy);
     return NULL;
 }
@@ -1529,16 +1481,16 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
 {
     int hops;
     int type = 0;
-    zframe_t *proto;
+    uint8_t proto[PROTO_SIZE];
     const char *prefix, *topic = NULL;
+    int i;
 
     fprintf (f, "--------------------------------------\n");
     if (!msg) {
         fprintf (f, "NULL");
         return;
     }
-    if (flux_msg_get_type (msg, &type) < 0
-            || (!(proto = zmsg_last (msg->zmsg)))) {
+    if (flux_msg_get_type (msg, &type) < 0) {
         fprintf (f, "malformed message");
         return;
     }
@@ -1573,36 +1525,99 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
     }
     /* Proto block
      */
-    zframe_fprint (proto, prefix, f);
+    proto_encode (msg, proto);
+    fprintf (f, "%s[%03d] ", prefix, PROTO_SIZE);
+    for (i = 0; i < PROTO_SIZE; i++)
+        fprintf (f, "%02X", proto[i]);
+    fprintf (f, "\n");
 }
 
-int flux_msg_sendzsock_ex (void *sock, const flux_msg_t *msg, bool nonblock)
+static void payload_zmq_free (void *data, void *hint)
 {
-    int rc = -1;
+    payload_decref (hint);
+}
 
-    if (!sock || !msg || !zmsg_is (msg->zmsg)) {
-        errno = EINVAL;
-        goto done;
+/* Send the payload frame without copying it.  zeromq holds a payload
+ * reference until the frame has been transmitted.
+ */
+static int payload_send (void *handle, struct msg_payload *pay, int flags)
+{
+    zmq_msg_t zmsg;
+
+    if (zmq_msg_init_data (&zmsg,
+                           pay->data,
+                           pay->size,
+                           payload_zmq_free,
+                           payload_incref (pay)) < 0) {
+        payload_decref (pay);
+        return -1;
     }
+    if (zmq_msg_send (&zmsg, handle, flags) < 0) {
+        ERRNO_SAFE_WRAP (zmq_msg_close, &zmsg);
+        return -1;
+    }
+    return 0;
+}
 
-    void *handle = zsock_resolve (sock);
-    int flags = ZFRAME_REUSE | ZFRAME_MORE;
-    zframe_t *zf = zmsg_first (msg->zmsg);
-    size_t count = 0;
+/* Send 'msg' in wire order.  If 'route' is non-NULL, send the message
+ * as though route were enabled and 'route' had been pushed onto a copy
+ * of it.  This allows one message to be sent to many ROUTER peers
+ * without copying it.
+ */
+static int msg_send (void *handle,
+                     const flux_msg_t *msg,
+                     const char *route,
+                     int flags)
+{
+    uint8_t proto[PROTO_SIZE];
+    int i;
 
-    if (nonblock)
-        flags |= ZFRAME_DONTWAIT;
+    if (route) {
+        if (zmq_send (handle, route, strlen (route), flags | ZMQ_SNDMORE) < 0)
+            return -1;
+    }
+    if (route || (msg->flags & FLUX_MSGFLAG_ROUTE)) {
+        if ((msg->flags & FLUX_MSGFLAG_ROUTE)) {
+            for (i = msg->routes_count - 1; i >= 0; i--) {
+                if (zmq_send (handle,
+                              msg->routes[i],
+                              strlen (msg->routes[i]),
+                              flags | ZMQ_SNDMORE) < 0)
+                    return -1;
+            }
+        }
+        if (zmq_send (handle, NULL, 0, flags | ZMQ_SNDMORE) < 0)
+            return -1;
+    }
+    if (msg->topic) {
+        if (zmq_send (handle,
+                      msg->topic,
+                      strlen (msg->topic) + 1,
+                      flags | ZMQ_SNDMORE) < 0)
+            return -1;
+    }
+    if (msg->payload) {
+        if (payload_send (handle, msg->payload, flags | ZMQ_SNDMORE) < 0)
+            return -1;
+    }
+    proto_encode (msg, proto);
+    if (route)
+        proto[PROTO_OFF_FLAGS] |= FLUX_MSGFLAG_ROUTE;
+    if (zmq_send (handle, proto, PROTO_SIZE, flags) < 0)
+        return -1;
+    return 0;
+}
 
-    while (zf) {
-        if (++count == zmsg_size (msg->zmsg))
-            flags &= ~ZFRAME_MORE;
-        if (zframe_send (&zf, handle, flags) < 0)
-            goto done;
-        zf = zmsg_next (msg->zmsg);
+int flux_msg_sendzsock_ex (void *sock, const flux_msg_t *msg, bool nonblock)
+{
+    if (!sock || !msg) {
+        errno = EINVAL;
+        return -1;
     }
-    rc = 0;
-done:
-    return rc;
+    return msg_send (zsock_resolve (sock),
+                     msg,
+                     NULL,
+                     nonblock ? ZMQ_DONTWAIT : 0);
 }
 
 int flux_msg_sendzsock (void *sock, const flux_msg_t *msg)
@@ -1610,6 +1625,21 @@ int flux_msg_sendzsock (void *sock, const flux_msg_t *msg)
     return flux_msg_sendzsock_ex (sock, msg, false);
 }
 
+int flux_msg_sendzsock_route (void *sock,
+                              const flux_msg_t *msg,
+                              const char *route,
+                              bool nonblock)
+{
+    if (!sock || !msg || !route) {
+        errno = EINVAL;
+        return -1;
+    }
+    return msg_send (zsock_resolve (sock),
+                     msg,
+                     route,
+                     nonblock ? ZMQ_DONTWAIT : 0);
+}
+
 flux_msg_t *flux_msg_recvzsock (void *sock)
 {
     zmsg_t *zmsg;
@@ -1622,13 +1652,24 @@ flux_msg_t *flux_msg_recvzsock (void *sock)
         errno = ENOMEM;
         return NULL;
     }
-    msg->zmsg = zmsg;
+    if (msg_import_zmsg (msg, &zmsg) < 0) {
+        flux_msg_destroy (msg);
+        return NULL;
+    }
     return msg;
 }
 
 int flux_msg_frames (const flux_msg_t *msg)
 {
-    return zmsg_size (msg->zmsg);
+    int n = 1; /* PROTO */
+
+    if ((msg->flags & FLUX_MSGFLAG_ROUTE))
+        n += msg->routes_count + 1;
+    if (msg->topic)
+        n++;
+    if (msg->payload)
+        n++;
+    return n;
 }
 
 struct flux_match flux_match_init (int typemask,
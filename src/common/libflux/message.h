@@ -41,6 +41,7 @@ enum {
     FLUX_MSGFLAG_UPSTREAM   = 0x10, /* request nodeid is sender (route away) */
     FLUX_MSGFLAG_PRIVATE    = 0x20, /* private to instance owner and sender */
     FLUX_MSGFLAG_STREAMING  = 0x40, /* request/response is streaming RPC */
+    FLUX_MSGFLAG_COMPRESSED = 0x80, /* payload is compressed (overlay only) */
 };
 
 /* N.B. FLUX_NODEID_UPSTREAM should be used in the RPC interface only.
@@ -132,6 +133,16 @@ flux_msg_t *flux_msg_decode (const void *buf, size_t size);
 int flux_msg_sendzsock (void *dest, const flux_msg_t *msg);
 int flux_msg_sendzsock_ex (void *dest, const flux_msg_t *msg, bool nonblock);
 
+/* Send message to zeromq socket as though 'route' had been pushed onto
+ * a route-enabled copy of it, without making the copy.  This is used to
+ * multicast one message to many ROUTER socket peers.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int flux_msg_sendzsock_route (void *dest,
+                              const flux_msg_t *msg,
+                              const char *route,
+                              bool nonblock);
+
 /* Receive a message from zeromq socket.
  * Returns message on success, NULL on failure with errno set.
  */
@@ -180,6 +191,12 @@ int flux_msg_get_payload (const flux_msg_t *msg, const void **buf, int *size);
 int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size);
 bool flux_msg_has_payload (const flux_msg_t *msg);
 
+/* Set payload to 'buf', transferring ownership of it to the message.
+ * 'buf' must have been allocated with malloc(3), and is freed with free(3)
+ * when no longer referenced.  On failure, the caller retains ownership.
+ */
+int flux_msg_set_payload_nocopy (flux_msg_t *msg, void *buf, int size);
+
 /* Get/set flags
  * Users should avoid using flux_msg_set_flags(), and instead use the
  * higher level functions that manipulate message flags.  It is exposed
@@ -25,13 +25,21 @@
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
+#include "src/common/libutil/errno_safe.h"
 
 struct dispatch {
     flux_t *h;
-    zlist_t *handlers;
     zlist_t *handlers_new;
     zhashx_t *handlers_rpc; // matchtag => response handler
     zhashx_t *handlers_method; // topic => request handler (non-glob only)
+    zhashx_t *handlers_topic; // topic => list of handlers (non-glob)
+    zhashx_t *handlers_prefix; // prefix => list of handlers ("prefix*" glob)
+    zlist_t *handlers_other; // handlers that must be tried on every message
+    int *prefix_count; // number of "prefix*" handlers by prefix length
+    size_t prefix_maxlen;
+    uint64_t seq;
+    int dispatch_depth;
+    flux_msg_handler_t *handlers_dead; // handlers destroyed during dispatch
     flux_watcher_t *w;
     int running_count;
     int usecount;
@@ -43,6 +51,15 @@ struct dispatch {
 #endif
 };
 
+/* Where a handler not in handlers_rpc or handlers_method is indexed.
+ */
+enum {
+    INDEX_NEW,      // handlers_new, not yet indexed
+    INDEX_TOPIC,
+    INDEX_PREFIX,
+    INDEX_OTHER,
+};
+
 #define HANDLER_MAGIC 0x44433322
 struct flux_msg_handler {
     int magic;
@@ -52,6 +69,10 @@ struct flux_msg_handler {
     flux_msg_handler_f fn;
     void *arg;
     uint8_t running:1;
+    uint8_t index;
+    char *prefix;   // INDEX_PREFIX: topic_glob without trailing '*'
+    uint64_t seq;   // order of indexing, newer handlers match first
+    flux_msg_handler_t *dead_next; // link in handlers_dead
 };
 
 static void handle_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -73,6 +94,21 @@ static bool isa_multmatch (const char *s)
     return false;
 }
 
+/* Return the length of the prefix if 's' is a glob of the form "prefix*",
+ * where prefix is not empty and contains no glob characters, else 0.
+ * Such a glob matches exactly the topics that begin with prefix.
+ */
+static size_t glob_prefix_len (const char *s)
+{
+    size_t len;
+
+    if (!s || (len = strlen (s)) < 2 || s[len - 1] != '*')
+        return 0;
+    if (strcspn (s, "*?[\\") != len - 1)
+        return 0;
+    return len - 1;
+}
+
 static void dispatch_requeue (struct dispatch *d)
 {
     if (d->unmatched) {
@@ -93,17 +129,21 @@ static void dispatch_usecount_decr (struct dispatch *d)
             dispatch_requeue (d);
             zlist_destroy (&d->unmatched);
         }
-        if (d->handlers) {
-            assert (zlist_size (d->handlers) == 0);
-            zlist_destroy (&d->handlers);
-        }
         if (d->handlers_new) {
             assert (zlist_size (d->handlers_new) == 0);
             zlist_destroy (&d->handlers_new);
         }
+        if (d->handlers_other) {
+            assert (zlist_size (d->handlers_other) == 0);
+            zlist_destroy (&d->handlers_other);
+        }
+        assert (d->handlers_dead == NULL);
         flux_watcher_destroy (d->w);
         zhashx_destroy (&d->handlers_rpc);
         zhashx_destroy (&d->handlers_method);
+        zhashx_destroy (&d->handlers_topic);
+        zhashx_destroy (&d->handlers_prefix);
+        free (d->prefix_count);
         free (d);
         errno = saved_errno;
     }
@@ -130,10 +170,10 @@ static struct dispatch *dispatch_get (flux_t *h)
             return NULL;
         memset (d, 0, sizeof (*d));
         d->usecount = 1;
-        if (!(d->handlers = zlist_new ()))
-            goto nomem;
         if (!(d->handlers_new = zlist_new ()))
             goto nomem;
+        if (!(d->handlers_other = zlist_new ()))
+            goto nomem;
         d->h = h;
         d->w = flux_handle_watcher_create (r, h, FLUX_POLLIN, handle_cb, d);
         if (!d->w)
@@ -151,6 +191,18 @@ static struct dispatch *dispatch_get (flux_t *h)
             goto nomem;
         zhashx_set_key_destructor (d->handlers_method, NULL);
         zhashx_set_key_duplicator (d->handlers_method, NULL);
+        /* N.B. d->handlers_topic and d->handlers_prefix own their keys,
+         * since a key must outlive the handler that created the entry.
+         * Entries are lists of handlers, newest first.
+         */
+        if (!(d->handlers_topic = zhashx_new ()))
+            goto nomem;
+        zhashx_set_destructor (d->handlers_topic,
+                               (zhashx_destructor_fn *)zlist_destroy);
+        if (!(d->handlers_prefix = zhashx_new ()))
+            goto nomem;
+        zhashx_set_destructor (d->handlers_prefix,
+                               (zhashx_destructor_fn *)zlist_destroy);
 #if HAVE_CALIPER
         d->prof_msg_type = cali_create_attribute ("flux.message.type",
                                                   CALI_TYPE_STRING,
@@ -209,6 +261,112 @@ static int copy_match (struct flux_match *dst,
     return 0;
 }
 
+static int bucket_push (zhashx_t *hash, const char *key,
+                        flux_msg_handler_t *mh)
+{
+    zlist_t *l;
+
+    if (!(l = zhashx_lookup (hash, key))) {
+        if (!(l = zlist_new ()))
+            goto nomem;
+        if (zhashx_insert (hash, key, l) < 0) {
+            zlist_destroy (&l);
+            goto nomem;
+        }
+    }
+    if (zlist_push (l, mh) < 0)
+        goto nomem;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+static void bucket_remove (zhashx_t *hash, const char *key,
+                           flux_msg_handler_t *mh)
+{
+    zlist_t *l;
+
+    if ((l = zhashx_lookup (hash, key))) {
+        zlist_remove (l, mh);
+        if (zlist_size (l) == 0)
+            zhashx_delete (hash, key);
+    }
+}
+
+static int prefix_count_incr (struct dispatch *d, size_t len)
+{
+    if (len > d->prefix_maxlen) {
+        int *count;
+        if (!(count = realloc (d->prefix_count, (len + 1) * sizeof (*count))))
+            return -1;
+        memset (count + d->prefix_maxlen + 1,
+                0,
+                (len - d->prefix_maxlen) * sizeof (*count));
+        d->prefix_count = count;
+        d->prefix_maxlen = len;
+    }
+    d->prefix_count[len]++;
+    return 0;
+}
+
+/* Index a handler that is not in handlers_rpc or handlers_method, so it
+ * can be found without walking all handlers:
+ * - non-glob topic: handlers_topic hash, by topic
+ * - "prefix*" glob: handlers_prefix hash, by prefix
+ * - anything else (NULL/"*", other globs): handlers_other list
+ */
+static int index_add (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    const char *glob = mh->match.topic_glob;
+    size_t len;
+
+    if (!isa_multmatch (glob)) {
+        if (bucket_push (d->handlers_topic, glob, mh) < 0)
+            return -1;
+        mh->index = INDEX_TOPIC;
+    }
+    else if ((len = glob_prefix_len (glob)) > 0) {
+        if (!mh->prefix && !(mh->prefix = strndup (glob, len)))
+            return -1;
+        if (prefix_count_incr (d, len) < 0)
+            return -1;
+        if (bucket_push (d->handlers_prefix, mh->prefix, mh) < 0) {
+            d->prefix_count[len]--;
+            return -1;
+        }
+        mh->index = INDEX_PREFIX;
+    }
+    else {
+        if (zlist_push (d->handlers_other, mh) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        mh->index = INDEX_OTHER;
+    }
+    mh->seq = ++d->seq;
+    return 0;
+}
+
+static void index_remove (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    switch (mh->index) {
+        case INDEX_NEW:
+            zlist_remove (d->handlers_new, mh);
+            break;
+        case INDEX_TOPIC:
+            bucket_remove (d->handlers_topic, mh->match.topic_glob, mh);
+            break;
+        case INDEX_PREFIX:
+            bucket_remove (d->handlers_prefix, mh->prefix, mh);
+            d->prefix_count[strlen (mh->prefix)]--;
+            break;
+        case INDEX_OTHER:
+            zlist_remove (d->handlers_other, mh);
+            break;
+    }
+}
+
 static void call_handler (flux_msg_handler_t *mh, const flux_msg_t *msg)
 {
     uint32_t rolemask, matchtag;
@@ -231,12 +389,153 @@ static void call_handler (flux_msg_handler_t *mh, const flux_msg_t *msg)
     mh->fn (mh->d->h, mh, msg, mh->arg);
 }
 
+/* Handlers that might match a message, collected from the index.
+ * Storage starts on the stack and moves to the heap if needed.
+ */
+struct candidates {
+    flux_msg_handler_t **mh;
+    int count;
+    int size;
+    flux_msg_handler_t *stack[16];
+};
+
+static int candidates_add (struct candidates *c, flux_msg_handler_t *mh)
+{
+    if (c->count == c->size) {
+        int size = c->size * 2;
+        flux_msg_handler_t **new;
+
+        if (c->mh == c->stack) {
+            if (!(new = malloc (size * sizeof (*new))))
+                return -1;
+            memcpy (new, c->stack, c->count * sizeof (*new));
+        }
+        else if (!(new = realloc (c->mh, size * sizeof (*new))))
+            return -1;
+        c->mh = new;
+        c->size = size;
+    }
+    c->mh[c->count++] = mh;
+    return 0;
+}
+
+/* Add running handlers from 'l' that match 'msg'.  Handlers in topic
+ * or prefix buckets are already known to match the topic, so only type
+ * and matchtag need to be checked.  Others need the full flux_msg_cmp().
+ */
+static int candidates_add_list (struct candidates *c,
+                                zlist_t *l,
+                                const flux_msg_t *msg,
+                                int type)
+{
+    flux_msg_handler_t *mh;
+
+    if (!l)
+        return 0;
+    FOREACH_ZLIST (l, mh) {
+        if (!mh->running)
+            continue;
+        if (mh->index == INDEX_OTHER) {
+            if (!flux_msg_cmp (msg, mh->match))
+                continue;
+        }
+        else {
+            if (mh->match.typemask != 0 && !(type & mh->match.typemask))
+                continue;
+            if (mh->match.matchtag != FLUX_MATCHTAG_NONE
+                && !flux_msg_cmp_matchtag (msg, mh->match.matchtag))
+                continue;
+        }
+        if (candidates_add (c, mh) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Look up the topic, each registered prefix length of the topic, and
+ * the handlers_other list.  The cost depends on the number of handlers
+ * that could match, not the total number registered.
+ */
+static int candidates_find (struct dispatch *d,
+                            const flux_msg_t *msg,
+                            int type,
+                            struct candidates *c)
+{
+    const char *topic;
+
+    if (flux_msg_get_topic (msg, &topic) == 0) {
+        if (candidates_add_list (c,
+                                 zhashx_lookup (d->handlers_topic, topic),
+                                 msg,
+                                 type) < 0)
+            return -1;
+        if (d->prefix_maxlen > 0) {
+            size_t topiclen = strlen (topic);
+            size_t maxlen = topiclen < d->prefix_maxlen ? topiclen
+                                                        : d->prefix_maxlen;
+            char buf[128];
+            char *key = buf;
+            size_t len;
+            int rc = 0;
+
+            if (maxlen >= sizeof (buf) && !(key = malloc (maxlen + 1)))
+                return -1;
+            memcpy (key, topic, maxlen);
+            for (len = 1; len <= maxlen && rc == 0; len++) {
+                if (d->prefix_count[len] == 0)
+                    continue;
+                key[len] = '\0';
+                rc = candidates_add_list (c,
+                                          zhashx_lookup (d->handlers_prefix,
+                                                         key),
+                                          msg,
+                                          type);
+                key[len] = topic[len];
+            }
+            if (key != buf)
+                ERRNO_SAFE_WRAP (free, key);
+            if (rc < 0)
+                return -1;
+        }
+    }
+    return candidates_add_list (c, d->handlers_other, msg, type);
+}
+
+/* Sort candidates newest first.  The list is short, so insertion sort.
+ */
+static void candidates_sort (struct candidates *c)
+{
+    int i, j;
+
+    for (i = 1; i < c->count; i++) {
+        flux_msg_handler_t *mh = c->mh[i];
+        for (j = i; j > 0 && c->mh[j - 1]->seq < mh->seq; j--)
+            c->mh[j] = c->mh[j - 1];
+        c->mh[j] = mh;
+    }
+}
+
+static void free_dead_handlers (struct dispatch *d)
+{
+    flux_msg_handler_t *mh;
+
+    while ((mh = d->handlers_dead)) {
+        d->handlers_dead = mh->dead_next;
+        free_msg_handler (mh);
+        dispatch_usecount_decr (d);
+    }
+}
+
 /* Messages are matched in the following order:
  * 1) RPC responses - lookup in handlers_rpc hash by matchtag.
  * 2) RPC requests - lookup in handlers_method hash by topic string
- * 3) Requests and responses not matched above - sent to first match in
- *    list of handlers, where most recently registered handlers match first.
- * 4) Events - sent to all matches in list of handlers
+ * 3) Requests and responses not matched above - sent to first match
+ *    among indexed handlers, where most recently registered handlers
+ *    match first.
+ * 4) Events - sent to all matches among indexed handlers, newest first
+ *
+ * Handlers destroyed by a callback during (3) or (4) are not freed until
+ * dispatch completes, since they may still be in the candidate list.
  */
 static bool dispatch_message (struct dispatch *d,
                               const flux_msg_t *msg,
@@ -270,17 +569,30 @@ static bool dispatch_message (struct dispatch *d,
     }
     /* other */
     if (!match) {
-        FOREACH_ZLIST (d->handlers, mh) {
-            if (!mh->running)
+        struct candidates c = { .size = 16 };
+        int i;
+
+        c.mh = c.stack;
+        if (candidates_find (d, msg, type, &c) < 0)
+            flux_log_error (d->h, "%s: error finding handlers", __FUNCTION__);
+        candidates_sort (&c);
+        dispatch_usecount_incr (d);
+        d->dispatch_depth++;
+        for (i = 0; i < c.count; i++) {
+            mh = c.mh[i];
+            if (!mh->running) // stopped or destroyed by earlier callback
                 continue;
-            if (flux_msg_cmp (msg, mh->match)) {
-                call_handler (mh, msg);
-                if (type != FLUX_MSGTYPE_EVENT) {
-                    match = true;
-                    break;
-                }
+            call_handler (mh, msg);
+            if (type != FLUX_MSGTYPE_EVENT) {
+                match = true;
+                break;
             }
         }
+        if (--d->dispatch_depth == 0)
+            free_dead_handlers (d);
+        if (c.mh != c.stack)
+            free (c.mh);
+        dispatch_usecount_decr (d);
     }
     return match;
 }
@@ -309,20 +621,16 @@ static void handle_late_response (struct dispatch *d, const flux_msg_t *msg)
         fprintf (stderr, "MATCHDEBUG: reclaimed matchtag=%d\n", matchtag);
 }
 
-static int transfer_items_zlist (zlist_t *from, zlist_t *to)
+static int index_new_handlers (struct dispatch *d)
 {
-    void *item;
-    int rc = -1;
+    flux_msg_handler_t *mh;
 
-    while ((item = zlist_pop (from))) {
-        if (zlist_push (to, item) < 0) {
-            errno = ENOMEM;
-            goto done;
-        }
+    while ((mh = zlist_first (d->handlers_new))) {
+        if (index_add (d, mh) < 0)
+            return -1;
+        zlist_remove (d->handlers_new, mh);
     }
-    rc = 0;
-done:
-    return rc;
+    return 0;
 }
 
 static void handle_cb (flux_reactor_t *r,
@@ -353,7 +661,7 @@ static void handle_cb (flux_reactor_t *r,
     /* Add any new handlers here, making handler creation
      * safe to call during handlers list traversal below.
      */
-    if (transfer_items_zlist (d->handlers_new, d->handlers) < 0)
+    if (index_new_handlers (d) < 0)
         goto done;
 
 #if defined(HAVE_CALIPER)
@@ -474,6 +782,7 @@ static void free_msg_handler (flux_msg_handler_t *mh)
         int saved_errno = errno;
         assert (mh->magic == HANDLER_MAGIC);
         flux_match_free (mh->match);
+        free (mh->prefix);
         mh->magic = ~HANDLER_MAGIC;
         free (mh);
         errno = saved_errno;
@@ -493,11 +802,19 @@ void flux_msg_handler_destroy (flux_msg_handler_t *mh)
                             && !isa_multmatch (mh->match.topic_glob)) {
             zhashx_delete (mh->d->handlers_method, mh->match.topic_glob);
         }
-        else {
-            zlist_remove (mh->d->handlers_new, mh);
-            zlist_remove (mh->d->handlers, mh);
-        }
+        else
+            index_remove (mh->d, mh);
         flux_msg_handler_stop (mh);
+        /* The handler may still be in a candidate list of a dispatch in
+         * progress, so it must not be freed here.  Linking it through the
+         * handler itself cannot fail.
+         */
+        if (mh->d->dispatch_depth > 0) {
+            mh->dead_next = mh->d->handlers_dead;
+            mh->d->handlers_dead = mh;
+            errno = saved_errno;
+            return; // freed after dispatch
+        }
         dispatch_usecount_decr (mh->d);
         free_msg_handler (mh);
         errno = saved_errno;
@@ -546,14 +863,14 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
         zhashx_update (d->handlers_method, mh->match.topic_glob, mh);
     }
     /* Request (glob), response (FLUX_MATCHTAG_NONE), events:
-     * Message handler is pushed to the front of the handlers list,
-     * and matches before older ones for requests and responses.
+     * Message handler is indexed by topic or glob prefix, and matches
+     * before older ones for requests and responses.
      * (Requests and responses in hashes above match first though).
      * Event messages are broadcast to all matching handlers.
      */
     else {
-        /* N.B. append(handlers_new); later, pop(handlers_new), push(handlers).
-         * Net effect: push(handlers).
+        /* N.B. append(handlers_new); indexed by next handle_cb(), so
+         * creating a handler is safe during dispatch.
          */
         if (zlist_append (d->handlers_new, mh) < 0) {
             errno = ENOMEM;
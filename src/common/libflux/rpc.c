@@ -16,6 +16,9 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
 #if HAVE_CALIPER
 #include <caliper/cali.h>
 #include <sys/syscall.h>
@@ -23,6 +26,9 @@
 #include <jansson.h>
 #include <czmq.h>
 
+#include "src/common/libidset/idset.h"
+#include "src/common/libutil/errno_safe.h"
+
 #include "request.h"
 #include "response.h"
 #include "message.h"
@@ -37,8 +43,12 @@ struct flux_rpc {
     int flags;
     flux_future_t *f;
     bool sent;
+    flux_msg_handler_f response_cb;
 };
 
+static void response_cb (flux_t *h, flux_msg_handler_t *mh,
+                         const flux_msg_t *msg, void *arg);
+
 static void log_matchtag_leak (flux_t *h, const char *msg, int matchtag)
 {
     if ((flux_flags_get (h) & FLUX_O_MATCHDEBUG))
@@ -100,6 +110,7 @@ static struct flux_rpc *rpc_create (flux_t *h, flux_future_t *f, int flags)
     }
     rpc->f = f;
     rpc->flags = flags;
+    rpc->response_cb = response_cb;
     if ((flags & FLUX_RPC_NORESPONSE)) {
         rpc->matchtag = FLUX_MATCHTAG_NONE;
     }
@@ -216,7 +227,7 @@ static void initialize_cb (flux_future_t *f, void *arg)
     struct flux_match m = FLUX_MATCH_RESPONSE;
 
     m.matchtag = rpc->matchtag;
-    if (!(mh = flux_msg_handler_create (h, m, response_cb, f)))
+    if (!(mh = flux_msg_handler_create (h, m, rpc->response_cb, f)))
         goto error;
     if (flux_future_aux_set (f, NULL, mh,
                             (flux_free_f)flux_msg_handler_destroy) < 0) {
@@ -412,6 +423,197 @@ uint32_t flux_rpc_get_matchtag (flux_future_t *f)
     return rpc ? rpc->matchtag : FLUX_MATCHTAG_NONE;
 }
 
+/* Fulfill future with a copy of 'rsp' for each rank in 'ranks'.
+ * The rank is attached to each copy, which shares the payload of 'rsp'.
+ */
+static int multi_fulfill (flux_future_t *f,
+                          const flux_msg_t *rsp,
+                          const struct idset *ranks)
+{
+    unsigned int id;
+
+    id = idset_first (ranks);
+    while (id != IDSET_INVALID_ID) {
+        flux_msg_t *cpy;
+        uint32_t *rank;
+
+        if (!(cpy = flux_msg_copy (rsp, true)))
+            return -1;
+        if (!(rank = malloc (sizeof (*rank)))
+            || flux_msg_aux_set (cpy, "flux::rank", rank, free) < 0) {
+            free (rank);
+            flux_msg_destroy (cpy);
+            errno = ENOMEM;
+            return -1;
+        }
+        *rank = id;
+        flux_future_fulfill (f, cpy, (flux_free_f)flux_msg_destroy);
+        id = idset_next (ranks, id);
+    }
+    return 0;
+}
+
+/* Message handler for "mrpc.forward" responses.
+ * Each response contains an array of results, each of which applies to
+ * a set of ranks.  Fulfill the future once per rank with a response
+ * message built from the result, as though the rank had responded directly.
+ */
+static void multi_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                               const flux_msg_t *msg, void *arg)
+{
+    flux_future_t *f = arg;
+    const char *topic = flux_future_aux_get (f, "flux::rpc_multi");
+    json_t *responses;
+    size_t index;
+    json_t *entry;
+    const char *errstr;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0
+        || flux_msg_unpack (msg, "{s:o}", "responses", &responses) < 0)
+        goto error;
+    if (!json_is_array (responses)) {
+        errno = EPROTO;
+        goto error;
+    }
+    json_array_foreach (responses, index, entry) {
+        const char *s;
+        int errnum;
+        const char *payload = NULL;
+        const char *entry_errstr = NULL;
+        struct idset *ranks;
+        flux_msg_t *rsp;
+
+        if (json_unpack (entry, "{s:s s:i s?s s?s}",
+                         "ranks", &s,
+                         "errnum", &errnum,
+                         "errstr", &entry_errstr,
+                         "payload", &payload) < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!(ranks = idset_decode (s))) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (errnum)
+            rsp = flux_response_encode_error (topic, errnum, entry_errstr);
+        else
+            rsp = flux_response_encode (topic, payload);
+        if (!rsp || multi_fulfill (f, rsp, ranks) < 0) {
+            ERRNO_SAFE_WRAP (flux_msg_destroy, rsp);
+            ERRNO_SAFE_WRAP (idset_destroy, ranks);
+            goto error;
+        }
+        flux_msg_destroy (rsp);
+        idset_destroy (ranks);
+    }
+    return;
+error:
+    if (flux_response_decode_error (msg, &errstr) == 0)
+        flux_future_fulfill_error (f, errno, errstr);
+    else
+        flux_future_fulfill_error (f, errno, NULL);
+}
+
+flux_future_t *flux_rpc_multi (flux_t *h,
+                               const char *topic,
+                               const char *s,
+                               const char *ranks,
+                               int flags)
+{
+    flux_msg_t *msg = NULL;
+    flux_future_t *f = NULL;
+    struct flux_rpc *rpc;
+    struct idset *ids;
+    char allranks[32];
+    char *cpy;
+
+    if (!h || !topic || !ranks || validate_flags (flags, 0) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!strcmp (ranks, "all")) {
+        uint32_t size;
+        if (flux_get_size (h, &size) < 0)
+            return NULL;
+        snprintf (allranks, sizeof (allranks), "0-%"PRIu32, size - 1);
+        ranks = allranks;
+    }
+    if (!(ids = idset_decode (ranks)) || idset_count (ids) == 0) {
+        idset_destroy (ids);
+        errno = EINVAL;
+        return NULL;
+    }
+    idset_destroy (ids);
+    if (!(msg = flux_request_encode ("mrpc.forward", NULL)))
+        goto done;
+    if (flux_msg_pack (msg, "{s:s s:s s:s?}", "topic", topic,
+                                              "ranks", ranks,
+                                              "payload", s) < 0)
+        goto done;
+    if (!(f = flux_rpc_message_nocopy (h, msg, 0, FLUX_RPC_STREAMING)))
+        goto done;
+    rpc = flux_future_aux_get (f, "flux::rpc");
+    rpc->response_cb = multi_response_cb;
+    if (!(cpy = strdup (topic))
+        || flux_future_aux_set (f, "flux::rpc_multi", cpy, free) < 0) {
+        ERRNO_SAFE_WRAP (free, cpy);
+        ERRNO_SAFE_WRAP (flux_future_destroy, f);
+        f = NULL;
+    }
+done:
+    flux_msg_destroy (msg);
+    return f;
+}
+
+flux_future_t *flux_rpc_multi_pack (flux_t *h,
+                                    const char *topic,
+                                    const char *ranks,
+                                    int flags,
+                                    const char *fmt, ...)
+{
+    va_list ap;
+    json_t *o;
+    char *s;
+    flux_future_t *f;
+
+    va_start (ap, fmt);
+    o = json_vpack_ex (NULL, 0, fmt, ap);
+    va_end (ap);
+    if (!o) {
+        errno = EINVAL;
+        return NULL;
+    }
+    s = json_dumps (o, JSON_COMPACT);
+    json_decref (o);
+    if (!s) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    f = flux_rpc_multi (h, topic, s, ranks, flags);
+    ERRNO_SAFE_WRAP (free, s);
+    return f;
+}
+
+int flux_rpc_multi_get_rank (flux_future_t *f, uint32_t *rank)
+{
+    const flux_msg_t *msg;
+    uint32_t *id;
+
+    if (!rank) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_future_get (f, (const void **)&msg) < 0)
+        return -1;
+    if (!msg || !(id = flux_msg_aux_get (msg, "flux::rank"))) {
+        errno = EINVAL;
+        return -1;
+    }
+    *rank = *id;
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
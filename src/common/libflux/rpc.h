@@ -52,6 +52,24 @@ int flux_rpc_get_raw (flux_future_t *f, const void **data, int *len);
  */
 uint32_t flux_rpc_get_matchtag (flux_future_t *f);
 
+/* Send a request to each rank in 'ranks', an RFC 22 idset or "all".
+ * The request is fanned out along the TBON by the broker "mrpc" service
+ * on rank 0, and responses are combined at each level on the way back.
+ * The future is fulfilled once for each rank, as with FLUX_RPC_STREAMING,
+ * then with ENODATA after all ranks have responded.  Use flux_rpc_get()
+ * to access each response and flux_rpc_multi_get_rank() to identify the
+ * rank that sent it.  Response payloads must be strings.  'flags' must
+ * be zero.
+ */
+flux_future_t *flux_rpc_multi (flux_t *h, const char *topic, const char *s,
+                               const char *ranks, int flags);
+
+flux_future_t *flux_rpc_multi_pack (flux_t *h, const char *topic,
+                                    const char *ranks, int flags,
+                                    const char *fmt, ...);
+
+int flux_rpc_multi_get_rank (flux_future_t *f, uint32_t *rank);
+
 #ifdef __cplusplus
 }
 #endif
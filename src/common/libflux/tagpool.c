@@ -13,6 +13,17 @@
 /* Matchtags are used to match requests and responses in RPC's.
  *
  * Requests that receive no response use FLUX_MATCHTAG_NONE (0).
+ *
+ * The pool is a bitmap with one bit per tag, set if the tag is free.
+ * A summary bitmap has one bit per 64-bit bitmap word, set if the word
+ * has any free tags.  The lowest free tag is found by scanning the
+ * summary from 'hint', the lowest summary word that may be nonzero,
+ * then taking the lowest set bit of the summary word and bitmap word.
+ * Tags are freed in O(1).  Allocation is O(1) amortized, since 'hint'
+ * only moves backwards when a tag below it is freed.
+ *
+ * The bitmap starts small and doubles when it is exhausted, up to
+ * TAGPOOL_COUNT tags.
  */
 
 #if HAVE_CONFIG_H
@@ -27,43 +38,71 @@
 #include "tagpool.h"
 #include "message.h"
 
-#include "src/common/libutil/veb.h"
-#include "src/common/libutil/log.h"
-
 #define TAGPOOL_COUNT (1UL<<20)
 #define TAGPOOL_START (1UL<<10)
 
+#define WORD_BITS       64
+#define WORDS(nbits)    (((nbits) + WORD_BITS - 1) / WORD_BITS)
+
 #define TAGPOOL_MAGIC   0x34447ff2
 struct tagpool {
     int             magic;
-    Veb             veb;
+    uint64_t        *map;       /* bit set if tag is free */
+    uint64_t        *summary;   /* bit set if map word has a free tag */
+    uint32_t        size;       /* number of tags in map */
+    uint32_t        hint;       /* summary words below this are zero */
     int             avail;
     tagpool_grow_f  grow_cb;
     void            *grow_arg;
     int             grow_depth;
 };
 
-static void pool_set (Veb veb, uint32_t from, uint32_t to, uint8_t value)
+/* Mark tags [from, to) free.  'from' and 'to' are multiples of WORD_BITS.
+ */
+static void pool_set_free (struct tagpool *t, uint32_t from, uint32_t to)
 {
-    while (from < to) {
-        if (value)
-            vebput (veb, from);
-        else
-            vebdel (veb, from);
-        from++;
+    uint32_t w;
+
+    for (w = from / WORD_BITS; w < to / WORD_BITS; w++) {
+        t->map[w] = ~0ULL;
+        t->summary[w / WORD_BITS] |= 1ULL << (w % WORD_BITS);
     }
 }
 
+/* Resize map and summary to 'size' tags, preserving existing bits.
+ * New tags are not free until pool_set_free() is called.
+ */
+static int pool_resize (struct tagpool *t, uint32_t size)
+{
+    size_t oldwords = WORDS (t->size);
+    size_t words = WORDS (size);
+    size_t oldswords = WORDS (oldwords);
+    size_t swords = WORDS (words);
+    uint64_t *map;
+    uint64_t *summary;
+
+    if (!(map = realloc (t->map, words * sizeof (*map))))
+        return -1;
+    t->map = map;
+    memset (map + oldwords, 0, (words - oldwords) * sizeof (*map));
+    if (!(summary = realloc (t->summary, swords * sizeof (*summary))))
+        return -1;
+    t->summary = summary;
+    memset (summary + oldswords, 0, (swords - oldswords) * sizeof (*summary));
+    t->size = size;
+    return 0;
+}
+
 struct tagpool *tagpool_create (void)
 {
     struct tagpool *t = calloc (1, sizeof (*t));
     if (!t)
         goto nomem;
     t->magic = TAGPOOL_MAGIC;
-    t->veb = vebnew (TAGPOOL_START, 1);
-    if (!t->veb.D)
+    if (pool_resize (t, TAGPOOL_START) < 0)
         goto nomem;
-    vebdel (t->veb, FLUX_MATCHTAG_NONE); /* allocate reserved value */
+    pool_set_free (t, 0, TAGPOOL_START);
+    t->map[0] &= ~1ULL; /* allocate reserved value FLUX_MATCHTAG_NONE */
     t->avail = TAGPOOL_COUNT - 1;
     return t;
 nomem:
@@ -76,7 +115,8 @@ void tagpool_destroy (struct tagpool *t)
 {
     if (t) {
         assert (t->magic == TAGPOOL_MAGIC);
-        free (t->veb.D);
+        free (t->map);
+        free (t->summary);
         t->magic = ~TAGPOOL_MAGIC;
         free (t);
     }
@@ -88,54 +128,80 @@ void tagpool_set_grow_cb (struct tagpool *t, tagpool_grow_f cb, void *arg)
     t->grow_arg = arg;
 }
 
-static uint32_t alloc_with_resize (struct tagpool *t)
+/* Double the pool size.  The new tags start at the old size.
+ */
+static int pool_grow (struct tagpool *t)
 {
-    uint32_t max = TAGPOOL_COUNT;
-    uint32_t oldsize, newsize, tag;
-
-    oldsize = t->veb.M;
-    newsize = oldsize << 1;
-    tag = vebsucc (t->veb, 0);
-
-    if (tag == t->veb.M && newsize <= max) {
-        if (t->grow_cb && t->grow_depth == 0) {
-            t->grow_depth++;
-            t->grow_cb (t->grow_arg, oldsize, newsize);
-            t->grow_depth--;
-        }
-        Veb new = vebnew (newsize, 0);
-        if (new.D) {
-            pool_set (new, oldsize, newsize, 1);
-            free (t->veb.D);
-            t->veb = new;
-            tag = vebsucc (t->veb, oldsize);
-            assert (tag == oldsize);
+    uint32_t oldsize = t->size;
+    uint32_t newsize = oldsize << 1;
+
+    if (newsize > TAGPOOL_COUNT)
+        return -1;
+    if (t->grow_cb && t->grow_depth == 0) {
+        t->grow_depth++;
+        t->grow_cb (t->grow_arg, oldsize, newsize);
+        t->grow_depth--;
+    }
+    if (pool_resize (t, newsize) < 0)
+        return -1;
+    pool_set_free (t, oldsize, newsize);
+    t->hint = (oldsize / WORD_BITS) / WORD_BITS;
+    return 0;
+}
+
+/* Find the lowest free tag, or return FLUX_MATCHTAG_NONE if the pool
+ * must be grown.
+ */
+static uint32_t pool_find (struct tagpool *t)
+{
+    uint32_t swords = WORDS (WORDS (t->size));
+    uint32_t s, w;
+
+    for (s = t->hint; s < swords; s++) {
+        if (t->summary[s] != 0) {
+            t->hint = s;
+            w = s * WORD_BITS + __builtin_ctzll (t->summary[s]);
+            return w * WORD_BITS + __builtin_ctzll (t->map[w]);
         }
     }
-    if (tag < t->veb.M)
-        vebdel (t->veb, tag);
-    return tag;
+    t->hint = swords;
+    return FLUX_MATCHTAG_NONE;
 }
 
 uint32_t tagpool_alloc (struct tagpool *t)
 {
     assert (t->magic == TAGPOOL_MAGIC);
     uint32_t tag;
+    uint32_t w;
 
-    tag = alloc_with_resize (t);
-    if (tag < t->veb.M) {
-        t->avail--;
-        return tag;
+    if ((tag = pool_find (t)) == FLUX_MATCHTAG_NONE) {
+        if (pool_grow (t) < 0)
+            return FLUX_MATCHTAG_NONE;
+        tag = pool_find (t);
+        assert (tag != FLUX_MATCHTAG_NONE);
     }
-    return FLUX_MATCHTAG_NONE;
+    w = tag / WORD_BITS;
+    t->map[w] &= ~(1ULL << (tag % WORD_BITS));
+    if (t->map[w] == 0)
+        t->summary[w / WORD_BITS] &= ~(1ULL << (w % WORD_BITS));
+    t->avail--;
+    return tag;
 }
 
 void tagpool_free (struct tagpool *t, uint32_t tag)
 {
     assert (t->magic == TAGPOOL_MAGIC);
     if (tag != FLUX_MATCHTAG_NONE) {
-        if (tag < t->veb.M) {
-            vebput (t->veb, tag);
+        if (tag < t->size) {
+            uint32_t w = tag / WORD_BITS;
+            uint64_t bit = 1ULL << (tag % WORD_BITS);
+
+            if ((t->map[w] & bit))
+                return; // already free
+            t->map[w] |= bit;
+            t->summary[w / WORD_BITS] |= 1ULL << (w % WORD_BITS);
+            if (t->hint > w / WORD_BITS)
+                t->hint = w / WORD_BITS;
             t->avail++;
         }
     }
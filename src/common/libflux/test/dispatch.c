@@ -462,6 +462,156 @@ void test_cloned_dispatch (flux_t *orig)
     diag ("destroyed reactor, closed clone");
 }
 
+/* Handlers append their label (arg) to 'order' when called.
+ */
+char order[64];
+void order_cb (flux_t *h, flux_msg_handler_t *mh,
+               const flux_msg_t *msg, void *arg)
+{
+    strncat (order, arg, sizeof (order) - strlen (order) - 1);
+}
+
+flux_msg_handler_t *victim;
+void destroy_cb (flux_t *h, flux_msg_handler_t *mh,
+                 const flux_msg_t *msg, void *arg)
+{
+    order_cb (h, mh, msg, arg);
+    flux_msg_handler_destroy (victim);
+    victim = NULL;
+}
+
+static flux_msg_handler_t *order_handler (flux_t *h,
+                                          int typemask,
+                                          const char *glob,
+                                          flux_msg_handler_f cb,
+                                          const char *label)
+{
+    struct flux_match match = FLUX_MATCH_ANY;
+    flux_msg_handler_t *mh;
+
+    match.typemask = typemask;
+    match.topic_glob = (char *)glob;
+    if (!(mh = flux_msg_handler_create (h, match, cb, (char *)label)))
+        BAIL_OUT ("flux_msg_handler_create %s failed", glob);
+    flux_msg_handler_start (mh);
+    return mh;
+}
+
+static void send_event (flux_t *h, const char *topic)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_event_encode (topic, NULL))
+        || flux_send (h, msg, 0) < 0)
+        BAIL_OUT ("failed to send %s event", topic);
+    flux_msg_destroy (msg);
+    order[0] = '\0';
+    if (flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT) < 0)
+        BAIL_OUT ("flux_reactor_run failed");
+}
+
+static void send_request (flux_t *h, const char *topic)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_request_encode (topic, NULL))
+        || flux_send (h, msg, 0) < 0)
+        BAIL_OUT ("failed to send %s request", topic);
+    flux_msg_destroy (msg);
+    order[0] = '\0';
+    if (flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT) < 0)
+        BAIL_OUT ("flux_reactor_run failed");
+}
+
+/* Verify that events are delivered to all matching handlers, newest
+ * first, whether they are indexed by exact topic, by glob prefix, or
+ * must be matched with fnmatch.
+ */
+void test_event_index (flux_t *h)
+{
+    flux_msg_handler_t *mh[6];
+
+    mh[0] = order_handler (h, FLUX_MSGTYPE_EVENT, "ev.foo", order_cb, "A");
+    mh[1] = order_handler (h, FLUX_MSGTYPE_EVENT, "ev.*", order_cb, "B");
+    mh[2] = order_handler (h, FLUX_MSGTYPE_EVENT, "ev.f*", order_cb, "C");
+    mh[3] = order_handler (h, FLUX_MSGTYPE_EVENT, NULL, order_cb, "D");
+    mh[4] = order_handler (h, FLUX_MSGTYPE_EVENT, "ev.f?o", order_cb, "E");
+    mh[5] = order_handler (h, FLUX_MSGTYPE_EVENT, "other.*", order_cb, "F");
+
+    send_event (h, "ev.foo");
+    ok (!strcmp (order, "EDCBA"),
+        "ev.foo event delivered to matching handlers newest first");
+    diag ("%s", order);
+    send_event (h, "ev.bar");
+    ok (!strcmp (order, "DB"),
+        "ev.bar event delivered to matching handlers newest first");
+    diag ("%s", order);
+    send_event (h, "ev");
+    ok (!strcmp (order, "D"),
+        "ev event is not matched by ev.* prefix");
+    diag ("%s", order);
+
+    flux_msg_handler_stop (mh[1]);
+    send_event (h, "ev.fxo");
+    ok (!strcmp (order, "EDC"),
+        "stopped handler is not called");
+    diag ("%s", order);
+
+    for (int i = 0; i < 6; i++)
+        flux_msg_handler_destroy (mh[i]);
+    send_event (h, "ev.foo");
+    ok (!strcmp (order, ""),
+        "destroyed handlers are not called");
+}
+
+/* Verify that a handler destroyed by an earlier handler for the same
+ * event is not called.
+ */
+void test_event_destroy (flux_t *h)
+{
+    flux_msg_handler_t *mh;
+
+    victim = order_handler (h, FLUX_MSGTYPE_EVENT, "ev.*", order_cb, "V");
+    mh = order_handler (h, FLUX_MSGTYPE_EVENT, "ev.foo", destroy_cb, "K");
+
+    send_event (h, "ev.foo");
+    ok (!strcmp (order, "K") && victim == NULL,
+        "handler destroyed during dispatch was not called");
+    diag ("%s", order);
+    send_event (h, "ev.foo");
+    ok (!strcmp (order, "K"),
+        "remaining handler is still called");
+
+    flux_msg_handler_destroy (mh);
+}
+
+/* Verify that the newest matching glob request handler is called,
+ * whether it is a prefix glob or a catch-all.
+ */
+void test_request_index (flux_t *h)
+{
+    flux_msg_handler_t *mh[3];
+
+    mh[0] = order_handler (h, FLUX_MSGTYPE_REQUEST, "req.*", order_cb, "A");
+    send_request (h, "req.abc");
+    ok (!strcmp (order, "A"),
+        "req.abc request matched req.*");
+    mh[1] = order_handler (h, FLUX_MSGTYPE_REQUEST, "req.a*", order_cb, "B");
+    send_request (h, "req.abc");
+    ok (!strcmp (order, "B"),
+        "req.abc request matched newer req.a*");
+    send_request (h, "req.xyz");
+    ok (!strcmp (order, "A"),
+        "req.xyz request matched req.*");
+    mh[2] = order_handler (h, FLUX_MSGTYPE_REQUEST, NULL, order_cb, "C");
+    send_request (h, "req.abc");
+    ok (!strcmp (order, "C"),
+        "req.abc request matched newer catch-all");
+
+    for (int i = 0; i < 3; i++)
+        flux_msg_handler_destroy (mh[i]);
+}
+
 int main (int argc, char *argv[])
 {
     flux_t *h;
@@ -481,6 +631,9 @@ int main (int argc, char *argv[])
     test_request_catchall (h);
     test_response_catchall (h);
     test_response_with_routes (h);
+    test_event_index (h);
+    test_event_destroy (h);
+    test_request_index (h);
 
     flux_close (h);
     done_testing();
@@ -397,6 +397,39 @@ void check_payload (void)
     flux_msg_destroy (msg);
 }
 
+/* flux_msg_set_payload_nocopy
+ */
+void check_payload_nocopy (void)
+{
+    flux_msg_t *msg, *cpy;
+    const void *buf;
+    char *pay;
+    int len;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)))
+        BAIL_OUT ("flux_msg_create failed");
+    if (!(pay = strdup ("fluffy")))
+        BAIL_OUT ("strdup failed");
+    errno = 0;
+    ok (flux_msg_set_payload_nocopy (msg, NULL, 6) < 0 && errno == EINVAL,
+        "flux_msg_set_payload_nocopy buf=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_set_payload_nocopy (msg, pay, 0) < 0 && errno == EINVAL,
+        "flux_msg_set_payload_nocopy size=0 fails with EINVAL");
+    ok (flux_msg_set_payload_nocopy (msg, pay, 7) == 0,
+        "flux_msg_set_payload_nocopy works");
+    ok (flux_msg_get_payload (msg, &buf, &len) == 0
+        && buf == pay && len == 7,
+        "flux_msg_get_payload returns the original buffer");
+    ok ((cpy = flux_msg_copy (msg, true)) != NULL,
+        "flux_msg_copy works");
+    flux_msg_destroy (msg);
+    ok (flux_msg_get_payload (cpy, &buf, &len) == 0
+        && len == 7 && !strcmp (buf, "fluffy"),
+        "payload survives destruction of the original message");
+    flux_msg_destroy (cpy);
+}
+
 /* flux_msg_set_type, flux_msg_get_type
  * flux_msg_set_nodeid, flux_msg_get_nodeid
  * flux_msg_set_errnum, flux_msg_get_errnum
@@ -678,11 +711,76 @@ void check_encode (void)
     flux_msg_destroy (msg2);
 }
 
+/* Replace the second character of route 'id' in encoded message 'buf'
+ * with a NUL, so the route frame is invalid.
+ */
+static void corrupt_route (char *buf, size_t size, const char *id)
+{
+    size_t len = strlen (id);
+    size_t i;
+
+    for (i = 0; i + len <= size; i++) {
+        if (!memcmp (buf + i, id, len)) {
+            buf[i + 1] = '\0';
+            return;
+        }
+    }
+    BAIL_OUT ("route %s not found in encoded message", id);
+}
+
+void check_decode_routes_error (void)
+{
+    flux_msg_t *msg, *msg2;
+    char *buf;
+    size_t size;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_enable_route (msg) < 0
+        || flux_msg_push_route (msg, "aaaa") < 0
+        || flux_msg_push_route (msg, "bbbb") < 0
+        || flux_msg_push_route (msg, "cccc") < 0)
+        BAIL_OUT ("could not create message with routes");
+    size = flux_msg_encode_size (msg);
+    if (!(buf = malloc (size)))
+        BAIL_OUT ("malloc failed");
+
+    /* The innermost route is decoded last, after the others are filled.
+     */
+    ok (flux_msg_encode (msg, buf, size) == 0,
+        "flux_msg_encode works on message with 3 routes");
+    corrupt_route (buf, size, "aaaa");
+    errno = 0;
+    msg2 = flux_msg_decode (buf, size);
+    ok (msg2 == NULL && errno == EPROTO,
+        "flux_msg_decode fails with EPROTO on bad innermost route");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_encode (msg, buf, size) == 0,
+        "flux_msg_encode works on message with 3 routes");
+    corrupt_route (buf, size, "cccc");
+    errno = 0;
+    msg2 = flux_msg_decode (buf, size);
+    ok (msg2 == NULL && errno == EPROTO,
+        "flux_msg_decode fails with EPROTO on bad outermost route");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_encode (msg, buf, size) == 0
+        && (msg2 = flux_msg_decode (buf, size)) != NULL
+        && flux_msg_get_route_count (msg2) == 3,
+        "flux_msg_decode works on unmodified message with 3 routes");
+    flux_msg_destroy (msg2);
+
+    free (buf);
+    flux_msg_destroy (msg);
+}
+
 void check_sendzsock (void)
 {
     zsock_t *zsock[2] = { NULL, NULL };
     flux_msg_t *msg, *msg2;
     const char *topic;
+    const char *s;
+    char *route;
     int type;
     const char *uri = "inproc://test";
 
@@ -730,6 +828,56 @@ void check_sendzsock (void)
     flux_msg_destroy (msg2);
     flux_msg_destroy (msg);
 
+    /* The payload is sent without a copy, so zeromq must hold a reference
+     * on it after the message is destroyed.
+     */
+    ok ((msg = flux_msg_create (FLUX_MSGTYPE_EVENT)) != NULL
+            && flux_msg_set_topic (msg, "foo.baz") == 0
+            && flux_msg_set_string (msg, "hello") == 0,
+        "created event message with payload");
+    ok (flux_msg_sendzsock (zsock[1], msg) == 0,
+        "flux_msg_sendzsock works with payload");
+    flux_msg_destroy (msg);
+    ok ((msg2 = flux_msg_recvzsock (zsock[0])) != NULL,
+        "flux_msg_recvzsock works");
+    ok (flux_msg_get_string (msg2, &s) == 0 && s && !strcmp (s, "hello"),
+        "payload survived destruction of the sent message");
+    flux_msg_destroy (msg2);
+
+    /* Send with a route added in transit.
+     */
+    errno = 0;
+    ok (flux_msg_sendzsock_route (zsock[1], NULL, "child", false) < 0
+            && errno == EINVAL,
+        "flux_msg_sendzsock_route msg=NULL fails with EINVAL");
+    ok ((msg = flux_msg_create (FLUX_MSGTYPE_EVENT)) != NULL
+            && flux_msg_set_topic (msg, "foo.baz") == 0
+            && flux_msg_set_string (msg, "world") == 0,
+        "created event message with payload");
+    errno = 0;
+    ok (flux_msg_sendzsock_route (zsock[1], msg, NULL, false) < 0
+            && errno == EINVAL,
+        "flux_msg_sendzsock_route route=NULL fails with EINVAL");
+    ok (flux_msg_sendzsock_route (zsock[1], msg, "child", false) == 0,
+        "flux_msg_sendzsock_route works");
+    ok ((msg2 = flux_msg_recvzsock (zsock[0])) != NULL,
+        "flux_msg_recvzsock works");
+    ok (flux_msg_get_route_count (msg2) == 1
+            && flux_msg_get_route_first (msg2, &route) == 0
+            && route != NULL && !strcmp (route, "child"),
+        "received message has the added route");
+    free (route);
+    ok (flux_msg_get_type (msg2, &type) == 0 && type == FLUX_MSGTYPE_EVENT
+            && flux_msg_get_topic (msg2, &topic) == 0
+            && !strcmp (topic, "foo.baz")
+            && flux_msg_get_string (msg2, &s) == 0
+            && s && !strcmp (s, "world"),
+        "received message has original type, topic, and payload");
+    ok (flux_msg_get_route_count (msg) < 0 && errno == EPROTO,
+        "sent message was not modified");
+    flux_msg_destroy (msg2);
+    flux_msg_destroy (msg);
+
     zsock_destroy (&zsock[0]);
     zsock_destroy (&zsock[1]);
 
@@ -808,6 +956,21 @@ void check_copy (void)
              && flux_msg_get_route_count (cpy) == 0
              && flux_msg_get_topic (cpy, &topic) == 0 && !strcmp (topic,"foo"),
         "copy is request: w/route delim, topic, and payload");
+    const void *msgbuf;
+    ok (flux_msg_get_payload (msg, &msgbuf, NULL) == 0 && msgbuf == cpybuf,
+        "copy shares payload with original");
+    char *id = NULL;
+    ok (flux_msg_push_route (cpy, "hop") == 0
+        && flux_msg_get_route_count (cpy) == 1
+        && flux_msg_get_route_count (msg) == 0,
+        "pushing route onto copy does not affect original");
+    ok (flux_msg_set_payload (cpy, "yyy", 4) == 0
+        && flux_msg_get_payload (msg, &msgbuf, &cpylen) == 0
+        && cpylen == sizeof (buf) && memcmp (msgbuf, buf, cpylen) == 0,
+        "replacing payload of copy does not affect original");
+    ok (flux_msg_pop_route (cpy, &id) == 0 && id && !strcmp (id, "hop"),
+        "popped route from copy");
+    free (id);
     flux_msg_destroy (cpy);
 
     ok ((cpy = flux_msg_copy (msg, false)) != NULL,
@@ -1021,6 +1184,7 @@ int main (int argc, char *argv[])
     check_routes ();
     check_topic ();
     check_payload ();
+    check_payload_nocopy ();
     check_payload_json ();
     check_payload_json_formatted ();
     check_matchtag ();
@@ -1032,6 +1196,7 @@ int main (int argc, char *argv[])
     check_cmp ();
 
     check_encode ();
+    check_decode_routes_error ();
     check_sendzsock ();
 
     check_params ();
@@ -297,6 +297,8 @@ void test_service (flux_t *h)
         "flux_rpc sent request to rpctest.hello service");
     ok (flux_matchtag_avail (h) == count - 1,
         "flux_rpc allocated one matchtag");
+    ok (flux_matchtag_outstanding (h) == 1,
+        "flux_matchtag_outstanding returns 1");
     msg = flux_recv (h, FLUX_MATCH_RESPONSE, 0);
     ok (msg != NULL,
         "flux_recv matched response");
@@ -8,10 +8,170 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
+/* Usage: test_tagpool.t [--bench [ITERATIONS]]
+ *
+ * With --bench, run only the alloc/free microbenchmark, reporting the
+ * cost of an alloc/free pair at several window sizes with diag().
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
 #include "src/common/libflux/message.h"
 #include "src/common/libflux/tagpool.h"
 #include "src/common/libtap/tap.h"
 
+#define MAX_TAGS (1<<20) /* matches TAGPOOL_COUNT in tagpool.c */
+
+static double monotime (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+
+static void grow_cb (void *arg, uint32_t oldsize, uint32_t newsize)
+{
+    int *count = arg;
+    (*count)++;
+}
+
+void check_grow (void)
+{
+    struct tagpool *t;
+    uint32_t tag, size, avail;
+    int grow_count = 0;
+    int i, errors;
+
+    if (!(t = tagpool_create ()))
+        BAIL_OUT ("tagpool_create failed");
+    tagpool_set_grow_cb (t, grow_cb, &grow_count);
+    size = tagpool_getattr (t, TAGPOOL_ATTR_SIZE);
+
+    errors = 0;
+    for (i = 1; i <= 5000; i++) {
+        if (tagpool_alloc (t) != i)
+            errors++;
+    }
+    ok (errors == 0,
+        "grow: allocated 5000 tags in order across pool growth");
+    ok (grow_count == 3,
+        "grow: grow callback was called 3 times");
+
+    tagpool_free (t, 4000);
+    tagpool_free (t, 100);
+    tagpool_free (t, 3000);
+    tag = tagpool_alloc (t);
+    ok (tag == 100,
+        "grow: lowest freed tag is allocated first");
+    tag = tagpool_alloc (t);
+    ok (tag == 3000,
+        "grow: next lowest freed tag is allocated next");
+    tag = tagpool_alloc (t);
+    ok (tag == 4000,
+        "grow: next lowest freed tag is allocated next");
+    tag = tagpool_alloc (t);
+    ok (tag == 5001,
+        "grow: then allocation resumes after highest tag");
+
+    avail = tagpool_getattr (t, TAGPOOL_ATTR_AVAIL);
+    tagpool_free (t, 42);
+    tagpool_free (t, 42);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL) == avail + 1,
+        "grow: freeing a tag twice only counts once");
+    tagpool_free (t, size + 1);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL) == avail + 1,
+        "grow: freeing an out of range tag is ignored");
+
+    tagpool_destroy (t);
+}
+
+/* Keep 'window' tags allocated while freeing and reallocating one at a
+ * time, and verify that no tag is handed out twice.
+ */
+void check_churn (int window, int iterations)
+{
+    struct tagpool *t;
+    uint32_t *tags;
+    bool *inuse;
+    int i, errors = 0;
+
+    if (!(t = tagpool_create ()))
+        BAIL_OUT ("tagpool_create failed");
+    if (!(tags = calloc (window, sizeof (tags[0])))
+        || !(inuse = calloc (MAX_TAGS, sizeof (inuse[0]))))
+        BAIL_OUT ("out of memory");
+    for (i = 0; i < window; i++) {
+        tags[i] = tagpool_alloc (t);
+        if (tags[i] == FLUX_MATCHTAG_NONE || inuse[tags[i]])
+            errors++;
+        else
+            inuse[tags[i]] = true;
+    }
+    for (i = 0; i < iterations; i++) {
+        uint32_t *tag = &tags[i % window];
+
+        tagpool_free (t, *tag);
+        inuse[*tag] = false;
+        *tag = tagpool_alloc (t);
+        if (*tag == FLUX_MATCHTAG_NONE || inuse[*tag])
+            errors++;
+        else
+            inuse[*tag] = true;
+    }
+    ok (errors == 0,
+        "churn: window=%d: %d alloc/free pairs returned unique tags",
+        window, iterations);
+
+    for (i = 0; i < window; i++)
+        tagpool_free (t, tags[i]);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL)
+        == tagpool_getattr (t, TAGPOOL_ATTR_SIZE),
+        "churn: window=%d: all tags returned to pool", window);
+
+    free (inuse);
+    free (tags);
+    tagpool_destroy (t);
+}
+
+/* Simulate an RPC-heavy client with a window of outstanding tags,
+ * freeing the oldest tag before each allocation.
+ */
+void check_bench (int window, int iterations)
+{
+    struct tagpool *t;
+    uint32_t *tags;
+    double t0, elapsed;
+    int i, errors = 0;
+
+    if (!(t = tagpool_create ()))
+        BAIL_OUT ("tagpool_create failed");
+    if (!(tags = calloc (window, sizeof (tags[0]))))
+        BAIL_OUT ("out of memory");
+    for (i = 0; i < window; i++)
+        tags[i] = tagpool_alloc (t);
+
+    t0 = monotime ();
+    for (i = 0; i < iterations; i++) {
+        tagpool_free (t, tags[i % window]);
+        if ((tags[i % window] = tagpool_alloc (t)) == FLUX_MATCHTAG_NONE)
+            errors++;
+    }
+    elapsed = monotime () - t0;
+
+    ok (errors == 0,
+        "bench: window=%d: %d alloc/free pairs succeeded",
+        window, iterations);
+    diag ("window=%d: %.1f ns per alloc/free pair",
+          window, elapsed * 1E9 / iterations);
+
+    free (tags);
+    tagpool_destroy (t);
+}
+
 int main (int argc, char *argv[])
 {
     struct tagpool *t;
@@ -22,6 +182,18 @@ int main (int argc, char *argv[])
 
     plan (NO_PLAN);
 
+    if (argc > 1 && !strcmp (argv[1], "--bench")) {
+        int iterations = argc > 2 ? strtol (argv[2], NULL, 10) : 1000000;
+
+        if (iterations <= 0)
+            BAIL_OUT ("invalid iteration count");
+        check_bench (1, iterations);
+        check_bench (1000, iterations);
+        check_bench (100000, iterations);
+        done_testing ();
+        return (0);
+    }
+
     t = tagpool_create ();
     ok (t != NULL,
         "tagpool_create works");
@@ -89,6 +261,11 @@ int main (int argc, char *argv[])
 
     tagpool_destroy (t);
 
+    check_grow ();
+    check_churn (1, 1000);
+    check_churn (100, 10000);
+    check_churn (5000, 10000);
+
     done_testing ();
     return (0);
 }
@@ -31,23 +31,49 @@ int validate_idset_flags (int flags, int allowed)
     return 0;
 }
 
+static bool is_bitmap (const struct idset *idset)
+{
+    return (idset->flags & IDSET_FLAG_BITMAP);
+}
+
+static int bitmap_create (struct idset *idset, size_t size)
+{
+    if (!(idset->bitmap = calloc (IDSET_BITMAP_WORDS (size),
+                                  sizeof (idset->bitmap[0]))))
+        return -1;
+    idset->T.D = NULL;
+    idset->T.k = 0;
+    idset->T.M = size;
+    return 0;
+}
+
 struct idset *idset_create (size_t size, int flags)
 {
     struct idset *idset;
 
-    if (validate_idset_flags (flags, IDSET_FLAG_AUTOGROW) < 0)
+    if (validate_idset_flags (flags, IDSET_FLAG_AUTOGROW
+                                   | IDSET_FLAG_BITMAP) < 0)
         return NULL;
     if (size == 0)
         size = IDSET_DEFAULT_SIZE;
-    if (!(idset = malloc (sizeof (*idset))))
+    if (!(idset = calloc (1, sizeof (*idset))))
         return NULL;
-    idset->T = vebnew (size, 0);
-    if (!idset->T.D) {
-        free (idset);
-        errno = ENOMEM;
-        return NULL;
-    }
     idset->flags = flags;
+    if (is_bitmap (idset)) {
+        if (bitmap_create (idset, size) < 0) {
+            free (idset);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    else {
+        idset->T = vebnew (size, 0);
+        if (!idset->T.D) {
+            free (idset);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
     idset->count = 0;
     return idset;
 }
@@ -57,6 +83,7 @@ void idset_destroy (struct idset *idset)
     if (idset) {
         int saved_errno = errno;
         free (idset->T.D);
+        free (idset->bitmap);
         free (idset);
         errno = saved_errno;
     }
@@ -82,13 +109,24 @@ struct idset *idset_copy (const struct idset *idset)
         errno = EINVAL;
         return NULL;
     }
-    if (!(cpy = malloc (sizeof (*idset))))
+    if (!(cpy = calloc (1, sizeof (*idset))))
         return NULL;
     cpy->flags = idset->flags;
-    cpy->T = vebdup (idset->T);
-    if (!cpy->T.D) {
-        idset_destroy (cpy);
-        return NULL;
+    if (is_bitmap (idset)) {
+        if (bitmap_create (cpy, idset->T.M) < 0) {
+            idset_destroy (cpy);
+            return NULL;
+        }
+        memcpy (cpy->bitmap,
+                idset->bitmap,
+                IDSET_BITMAP_WORDS (idset->T.M) * sizeof (idset->bitmap[0]));
+    }
+    else {
+        cpy->T = vebdup (idset->T);
+        if (!cpy->T.D) {
+            idset_destroy (cpy);
+            return NULL;
+        }
     }
     cpy->count = idset->count;
     return cpy;
@@ -101,6 +139,89 @@ static bool valid_id (unsigned int id)
     return true;
 }
 
+/* Return the first id >= 'id' in idset, or T.M if there is none.
+ */
+static unsigned int bitmap_succ (const struct idset *idset, unsigned int id)
+{
+    size_t nwords = IDSET_BITMAP_WORDS (idset->T.M);
+    size_t i = id / 64;
+    uint64_t w;
+
+    if (id >= idset->T.M)
+        return idset->T.M;
+    w = idset->bitmap[i] & (~0ULL << (id % 64));
+    while (w == 0) {
+        if (++i == nwords)
+            return idset->T.M;
+        w = idset->bitmap[i];
+    }
+    return i * 64 + __builtin_ctzll (w);
+}
+
+/* Return the last id <= 'id' in idset, or T.M if there is none.
+ */
+static unsigned int bitmap_pred (const struct idset *idset, unsigned int id)
+{
+    size_t i;
+    uint64_t w;
+
+    if (idset->T.M == 0)
+        return idset->T.M;
+    if (id >= idset->T.M)
+        id = idset->T.M - 1;
+    i = id / 64;
+    w = idset->bitmap[i] & (~0ULL >> (63 - id % 64));
+    while (w == 0) {
+        if (i-- == 0)
+            return idset->T.M;
+        w = idset->bitmap[i];
+    }
+    return i * 64 + 63 - __builtin_clzll (w);
+}
+
+static unsigned int idset_succ (const struct idset *idset, unsigned int id)
+{
+    if (is_bitmap (idset))
+        return bitmap_succ (idset, id);
+    return vebsucc (idset->T, id);
+}
+
+static unsigned int idset_pred (const struct idset *idset, unsigned int id)
+{
+    if (is_bitmap (idset))
+        return bitmap_pred (idset, id);
+    return vebpred (idset->T, id);
+}
+
+/* Count ids in idset using popcount, e.g. after a bulk operation.
+ */
+static size_t bitmap_count (const struct idset *idset)
+{
+    size_t nwords = IDSET_BITMAP_WORDS (idset->T.M);
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < nwords; i++)
+        count += __builtin_popcountll (idset->bitmap[i]);
+    return count;
+}
+
+static int bitmap_grow (struct idset *idset, size_t newsize)
+{
+    size_t nwords = IDSET_BITMAP_WORDS (idset->T.M);
+    size_t newwords = IDSET_BITMAP_WORDS (newsize);
+    uint64_t *bitmap;
+
+    if (newwords > nwords) {
+        if (!(bitmap = realloc (idset->bitmap, newwords * sizeof (*bitmap))))
+            return -1;
+        memset (bitmap + nwords, 0, (newwords - nwords) * sizeof (*bitmap));
+        idset->bitmap = bitmap;
+    }
+    idset->T.M = newsize;
+    return 0;
+}
+
 /* Double idset size until it has at least 'size' slots.
  * Return 0 on success, -1 on failure with errno == ENOMEM.
  */
@@ -118,6 +239,8 @@ static int idset_grow (struct idset *idset, size_t size)
             errno = EINVAL;
             return -1;
         }
+        if (is_bitmap (idset))
+            return bitmap_grow (idset, newsize);
         T = vebnew (newsize, 0);
         if (!T.D)
             return -1;
@@ -139,16 +262,50 @@ static void idset_put (struct idset *idset, unsigned int id)
 {
     if (!idset_test (idset, id))
         idset->count++;
-    vebput (idset->T, id);
+    if (is_bitmap (idset))
+        idset->bitmap[id / 64] |= 1ULL << (id % 64);
+    else
+        vebput (idset->T, id);
 }
 
 /* Wrapper for vebdel() which decrements idset count if needed
  */
 static void idset_del (struct idset *idset, unsigned int id)
 {
-    if (idset_test (idset, id))
+    if (idset_test (idset, id)) {
         idset->count--;
-    vebdel (idset->T, id);
+        if (is_bitmap (idset))
+            idset->bitmap[id / 64] &= ~(1ULL << (id % 64));
+        else
+            vebdel (idset->T, id);
+    }
+}
+
+/* Set or clear ids [lo-hi] in a bitmap idset a word at a time.
+ * The range must be normalized and hi < T.M.
+ */
+static void bitmap_range_update (struct idset *idset,
+                                 unsigned int lo,
+                                 unsigned int hi,
+                                 bool set)
+{
+    size_t i;
+
+    for (i = lo / 64; i <= hi / 64; i++) {
+        uint64_t mask = ~0ULL;
+        uint64_t old = idset->bitmap[i];
+
+        if (i == lo / 64)
+            mask &= ~0ULL << (lo % 64);
+        if (i == hi / 64)
+            mask &= ~0ULL >> (63 - hi % 64);
+        if (set)
+            idset->bitmap[i] |= mask;
+        else
+            idset->bitmap[i] &= ~mask;
+        idset->count += __builtin_popcountll (idset->bitmap[i]);
+        idset->count -= __builtin_popcountll (old);
+    }
 }
 
 int idset_set (struct idset *idset, unsigned int id)
@@ -183,8 +340,12 @@ int idset_range_set (struct idset *idset, unsigned int lo, unsigned int hi)
     normalize_range (&lo, &hi);
     if (idset_grow (idset, hi + 1) < 0)
         return -1;
-    for (id = lo; id <= hi; id++)
-        idset_put (idset, id);
+    if (is_bitmap (idset))
+        bitmap_range_update (idset, lo, hi, true);
+    else {
+        for (id = lo; id <= hi; id++)
+            idset_put (idset, id);
+    }
     return 0;
 }
 
@@ -207,8 +368,14 @@ int idset_range_clear (struct idset *idset, unsigned int lo, unsigned int hi)
         return -1;
     }
     normalize_range (&lo, &hi);
-    for (id = lo; id <= hi && id < idset->T.M; id++)
-        idset_del (idset, id);
+    if (is_bitmap (idset)) {
+        if (lo < idset->T.M)
+            bitmap_range_update (idset, lo, MIN (hi, idset->T.M - 1), false);
+    }
+    else {
+        for (id = lo; id <= hi && id < idset->T.M; id++)
+            idset_del (idset, id);
+    }
     return 0;
 }
 
@@ -216,6 +383,8 @@ bool idset_test (const struct idset *idset, unsigned int id)
 {
     if (!idset || !valid_id (id) || id >= idset->T.M)
         return false;
+    if (is_bitmap (idset))
+        return (idset->bitmap[id / 64] & (1ULL << (id % 64))) != 0;
     return (vebsucc (idset->T, id) == id);
 }
 
@@ -224,7 +393,7 @@ unsigned int idset_first (const struct idset *idset)
     unsigned int next = IDSET_INVALID_ID;
 
     if (idset) {
-        next = vebsucc (idset->T, 0);
+        next = idset_succ (idset, 0);
         if (next == idset->T.M)
             next = IDSET_INVALID_ID;
     }
@@ -237,7 +406,7 @@ unsigned int idset_next (const struct idset *idset, unsigned int prev)
     unsigned int next = IDSET_INVALID_ID;
 
     if (idset) {
-        next = vebsucc (idset->T, prev + 1);
+        next = idset_succ (idset, prev + 1);
         if (next == idset->T.M)
             next = IDSET_INVALID_ID;
     }
@@ -249,7 +418,7 @@ unsigned int idset_last (const struct idset *idset)
     unsigned int last = IDSET_INVALID_ID;
 
     if (idset) {
-        last = vebpred (idset->T, idset->T.M - 1);
+        last = idset_pred (idset, idset->T.M - 1);
         if (last == idset->T.M)
             last = IDSET_INVALID_ID;
     }
@@ -273,21 +442,161 @@ bool idset_equal (const struct idset *idset1,
     if (idset_count (idset1) != idset_count (idset2))
         return false;
 
-    id = vebsucc (idset1->T, 0);
+    if (is_bitmap (idset1) && is_bitmap (idset2)) {
+        size_t n1 = IDSET_BITMAP_WORDS (idset1->T.M);
+        size_t n2 = IDSET_BITMAP_WORDS (idset2->T.M);
+        size_t i;
+
+        /* With equal counts, the sets are equal if all words in common
+         * are equal.
+         */
+        for (i = 0; i < MIN (n1, n2); i++) {
+            if (idset1->bitmap[i] != idset2->bitmap[i])
+                return false;
+        }
+        return true;
+    }
+    id = idset_succ (idset1, 0);
     while (id < idset1->T.M) {
-        if (vebsucc (idset2->T, id) != id)
+        if (!idset_test (idset2, id))
             return false; // id in idset1 not set in idset2
-        id = vebsucc (idset1->T, id + 1);
+        id = idset_succ (idset1, id + 1);
     }
-    id = vebsucc (idset2->T, 0);
+    id = idset_succ (idset2, 0);
     while (id < idset2->T.M) {
-        if (vebsucc (idset1->T, id) != id)
+        if (!idset_test (idset1, id))
             return false; // id in idset2 not set in idset1
-        id = vebsucc (idset2->T, id + 1);
+        id = idset_succ (idset2, id + 1);
     }
     return true;
 }
 
+int idset_add (struct idset *idset1, const struct idset *idset2)
+{
+    unsigned int id;
+
+    if (!idset1 || !idset2) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((id = idset_last (idset2)) == IDSET_INVALID_ID)
+        return 0;
+    if (idset_grow (idset1, id + 1) < 0)
+        return -1;
+    if (is_bitmap (idset1) && is_bitmap (idset2)) {
+        size_t nwords = IDSET_BITMAP_WORDS (id + 1);
+        size_t i;
+
+        for (i = 0; i < nwords; i++)
+            idset1->bitmap[i] |= idset2->bitmap[i];
+        idset1->count = bitmap_count (idset1);
+    }
+    else {
+        id = idset_first (idset2);
+        while (id != IDSET_INVALID_ID) {
+            idset_put (idset1, id);
+            id = idset_next (idset2, id);
+        }
+    }
+    return 0;
+}
+
+int idset_subtract (struct idset *idset1, const struct idset *idset2)
+{
+    unsigned int id;
+
+    if (!idset1 || !idset2) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (is_bitmap (idset1) && is_bitmap (idset2)) {
+        size_t n1 = IDSET_BITMAP_WORDS (idset1->T.M);
+        size_t n2 = IDSET_BITMAP_WORDS (idset2->T.M);
+        size_t i;
+
+        for (i = 0; i < MIN (n1, n2); i++)
+            idset1->bitmap[i] &= ~idset2->bitmap[i];
+        idset1->count = bitmap_count (idset1);
+    }
+    else {
+        id = idset_first (idset2);
+        while (id != IDSET_INVALID_ID) {
+            if (id < idset1->T.M)
+                idset_del (idset1, id);
+            id = idset_next (idset2, id);
+        }
+    }
+    return 0;
+}
+
+struct idset *idset_union (const struct idset *idset1,
+                           const struct idset *idset2)
+{
+    struct idset *result;
+
+    if (!idset1 || !idset2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_copy (idset1)))
+        return NULL;
+    if (idset_add (result, idset2) < 0) {
+        idset_destroy (result);
+        return NULL;
+    }
+    return result;
+}
+
+struct idset *idset_difference (const struct idset *idset1,
+                                const struct idset *idset2)
+{
+    struct idset *result;
+
+    if (!idset1 || !idset2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_copy (idset1)))
+        return NULL;
+    if (idset_subtract (result, idset2) < 0) {
+        idset_destroy (result);
+        return NULL;
+    }
+    return result;
+}
+
+struct idset *idset_intersect (const struct idset *idset1,
+                               const struct idset *idset2)
+{
+    struct idset *result;
+    unsigned int id;
+
+    if (!idset1 || !idset2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_copy (idset1)))
+        return NULL;
+    if (is_bitmap (result) && is_bitmap (idset2)) {
+        size_t n1 = IDSET_BITMAP_WORDS (result->T.M);
+        size_t n2 = IDSET_BITMAP_WORDS (idset2->T.M);
+        size_t i;
+
+        for (i = 0; i < n1; i++)
+            result->bitmap[i] &= i < n2 ? idset2->bitmap[i] : 0;
+        result->count = bitmap_count (result);
+    }
+    else {
+        id = idset_first (idset1);
+        while (id != IDSET_INVALID_ID) {
+            if (!idset_test (idset2, id))
+                idset_del (result, id);
+            id = idset_next (idset1, id);
+        }
+    }
+    return result;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -27,6 +27,7 @@ enum idset_flags {
     IDSET_FLAG_AUTOGROW = 1, // allow idset size to automatically grow
     IDSET_FLAG_BRACKETS = 2, // encode non-singleton idset with brackets
     IDSET_FLAG_RANGE = 4,    // encode with ranges ("2,3,4,8" -> "2-4,8")
+    IDSET_FLAG_BITMAP = 8,   // use bitmap implementation (faster bulk ops)
 };
 
 #define IDSET_INVALID_ID    (UINT_MAX - 1)
@@ -35,6 +36,9 @@ enum idset_flags {
  * Set the initial size to 'size' (0 means implementation uses a default size).
  * If 'flags' includes IDSET_FLAG_AUTOGROW, the idset is resized to fit if
  * an id >= size is set.
+ * If 'flags' includes IDSET_FLAG_BITMAP, the idset is implemented as a
+ * plain bitmap, which makes iteration and the set operations below faster
+ * for dense sets.
  * Returns idset on success, or NULL on failure with errno set.
  */
 struct idset *idset_create (size_t size, int flags);
@@ -104,6 +108,27 @@ size_t idset_count (const struct idset *idset);
  */
 bool idset_equal (const struct idset *set1, const struct idset *set2);
 
+/* Add (subtract) the ids in 'set2' to (from) 'set1'.
+ * idset_add() fails with EINVAL if an id in 'set2' does not fit in 'set1'
+ * and 'set1' was not created with IDSET_FLAG_AUTOGROW.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+int idset_add (struct idset *set1, const struct idset *set2);
+int idset_subtract (struct idset *set1, const struct idset *set2);
+
+/* Return a new idset containing the union, intersection, or difference
+ * (ids in 'set1' but not in 'set2') of 'set1' and 'set2'.  The result
+ * takes its size and flags from 'set1', so idset_union() may fail like
+ * idset_add().
+ * Returns idset on success, or NULL on failure with errno set.
+ */
+struct idset *idset_union (const struct idset *set1,
+                           const struct idset *set2);
+struct idset *idset_intersect (const struct idset *set1,
+                               const struct idset *set2);
+struct idset *idset_difference (const struct idset *set1,
+                                const struct idset *set2);
+
 #ifdef __cplusplus
 }
 #endif
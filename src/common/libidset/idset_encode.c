@@ -86,10 +86,10 @@ static int encode_ranged (const struct idset *idset,
     unsigned int hi = 0;
     bool first = true;
 
-    lo = hi = id = vebsucc (idset->T, 0);
-    while (id < idset->T.M) {
-        unsigned int next = vebsucc (idset->T, id + 1);;
-        bool last = (next == idset->T.M);
+    lo = hi = id = idset_first (idset);
+    while (id != IDSET_INVALID_ID) {
+        unsigned int next = idset_next (idset, id);
+        bool last = (next == IDSET_INVALID_ID);
 
         if (first)                  // first iteration
             first = false;
@@ -120,10 +120,10 @@ static int encode_simple (const struct idset *idset,
     int count = 0;
     unsigned int id;
 
-    id = vebsucc (idset->T, 0);
-    while (id != idset->T.M) {
-        int next = vebsucc (idset->T, id + 1);
-        char *sep = next == idset->T.M ? "" : ",";
+    id = idset_first (idset);
+    while (id != IDSET_INVALID_ID) {
+        unsigned int next = idset_next (idset, id);
+        char *sep = next == IDSET_INVALID_ID ? "" : ",";
         if (catprintf (s, sz, len, "%d%s", id, sep) < 0)
             return -1;
         if (count < INT_MAX)
@@ -14,17 +14,26 @@
 /* Implemented as a Van Emde Boas tree using code.google.com/p/libveb.
  * T.D is data; T.M is size
  * All ops are O(log m), for key bitsize m: 2^m == T.M.
+ *
+ * If created with IDSET_FLAG_BITMAP, implemented instead as a bitmap of
+ * T.M bits in 'bitmap', and T.D is NULL.  Test, set, and clear are O(1),
+ * while iteration and bulk set operations proceed a word at a time.
  */
 
+#include <stdint.h>
+
 #include "src/common/libutil/veb.h"
 #include "idset.h"
 
 struct idset {
     size_t count;
     Veb T;
+    uint64_t *bitmap;
     int flags;
 };
 
+#define IDSET_BITMAP_WORDS(size) (((size) + 63) / 64)
+
 #define IDSET_ENCODE_CHUNK 1024
 #define IDSET_DEFAULT_SIZE 1024 // default idset size if size=0
 
@@ -633,6 +633,197 @@ void issue_2336 (void)
     }
 }
 
+/* Decode 's' into an idset created with 'flags'.
+ */
+static struct idset *decode_flags (const char *s, int flags)
+{
+    struct idset *ids;
+    struct idset *result;
+
+    if (!(ids = idset_decode (s)))
+        BAIL_OUT ("idset_decode %s failed", s);
+    if (!(result = idset_create (0, flags)))
+        BAIL_OUT ("idset_create flags=%d failed", flags);
+    if (idset_add (result, ids) < 0)
+        BAIL_OUT ("idset_add %s failed", s);
+    idset_destroy (ids);
+    return result;
+}
+
+static void check_encode (struct idset *idset, const char *s, const char *msg)
+{
+    char *str = idset_encode (idset, IDSET_FLAG_RANGE);
+    is (str, s, "%s returned %s", msg, s);
+    free (str);
+}
+
+void test_bitmap (void)
+{
+    struct idset *idset;
+    struct idset *cpy;
+    struct idset *veb;
+
+    idset = idset_create (100, IDSET_FLAG_BITMAP);
+    ok (idset != NULL,
+        "idset_create size=100 flags=BITMAP works");
+    ok (idset_set (idset, 0) == 0
+        && idset_set (idset, 63) == 0
+        && idset_set (idset, 64) == 0
+        && idset_set (idset, 99) == 0,
+        "idset_set 0,63,64,99 works");
+    errno = 0;
+    ok (idset_set (idset, 100) < 0 && errno == EINVAL,
+        "idset_set 100 fails with EINVAL");
+    ok (idset_count (idset) == 4,
+        "idset_count returns 4");
+    ok (idset_first (idset) == 0
+        && idset_next (idset, 0) == 63
+        && idset_next (idset, 63) == 64
+        && idset_next (idset, 64) == 99
+        && idset_next (idset, 99) == IDSET_INVALID_ID
+        && idset_last (idset) == 99,
+        "iteration returns expected ids");
+    ok (idset_range_set (idset, 10, 70) == 0,
+        "idset_range_set 10-70 works");
+    ok (idset_count (idset) == 63,
+        "idset_count returns 63");
+    check_encode (idset, "0,10-70,99", "idset_encode");
+    ok (idset_range_clear (idset, 60, 200) == 0,
+        "idset_range_clear 60-200 works");
+    ok (idset_count (idset) == 51,
+        "idset_count returns 51");
+    ok (idset_last (idset) == 59,
+        "idset_last returns 59");
+    ok (idset_clear (idset, 0) == 0 && idset_clear (idset, 0) == 0,
+        "idset_clear 0 twice works");
+    ok (idset_count (idset) == 50 && idset_first (idset) == 10,
+        "idset_count returns 50 and idset_first returns 10");
+
+    ok ((cpy = idset_copy (idset)) != NULL
+        && idset_equal (idset, cpy),
+        "idset_copy works");
+    if (!(veb = idset_decode ("10-59")))
+        BAIL_OUT ("idset_decode 10-59 failed");
+    ok (idset_equal (idset, veb) && idset_equal (veb, idset),
+        "bitmap idset is equal to veb idset with same ids");
+    ok (idset_clear (cpy, 59) == 0 && !idset_equal (idset, cpy),
+        "bitmap idsets are unequal after idset_clear on copy");
+    idset_destroy (veb);
+    idset_destroy (cpy);
+    idset_destroy (idset);
+
+    idset = idset_create (1, IDSET_FLAG_BITMAP | IDSET_FLAG_AUTOGROW);
+    ok (idset != NULL,
+        "idset_create size=1 flags=BITMAP|AUTOGROW works");
+    ok (idset_set (idset, 1000) == 0 && idset_set (idset, 0) == 0,
+        "idset_set 0,1000 works");
+    ok (idset->T.M > 1000,
+        "idset internal size grew");
+    ok (idset_range_set (idset, 2000, 2100) == 0,
+        "idset_range_set 2000-2100 works");
+    check_encode (idset, "0,1000,2000-2100", "idset_encode");
+    idset_destroy (idset);
+}
+
+struct setop_test {
+    const char *a;
+    const char *b;
+    const char *a_union_b;
+    const char *a_intersect_b;
+    const char *a_difference_b;
+};
+
+struct setop_test setop_tests[] = {
+    { "",           "",             "",                 "",     "" },
+    { "0-9,100",    "",             "0-9,100",          "",     "0-9,100" },
+    { "",           "0-9,100",      "0-9,100",          "",     "" },
+    { "0-9,100",    "5-14,200",     "0-14,100,200",     "5-9",  "0-4,100" },
+    { "0-63",       "64-127",       "0-127",            "",     "0-63" },
+    { "1-1000",     "1-1000",       "1-1000",           "1-1000", "" },
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+void test_setops (void)
+{
+    int flags[] = { IDSET_FLAG_AUTOGROW,
+                    IDSET_FLAG_AUTOGROW | IDSET_FLAG_BITMAP };
+    struct setop_test *t;
+    struct idset *a;
+    struct idset *b;
+    struct idset *result;
+    int i, j;
+
+    for (t = &setop_tests[0]; t->a != NULL; t++) {
+        for (i = 0; i < 2; i++) {
+            for (j = 0; j < 2; j++) {
+                a = decode_flags (t->a, flags[i]);
+                b = decode_flags (t->b, flags[j]);
+                diag ("a=[%s] flags=%d b=[%s] flags=%d",
+                      t->a, flags[i], t->b, flags[j]);
+
+                result = idset_union (a, b);
+                ok (result != NULL, "idset_union works");
+                check_encode (result, t->a_union_b, "idset_union");
+                idset_destroy (result);
+
+                result = idset_intersect (a, b);
+                ok (result != NULL, "idset_intersect works");
+                check_encode (result, t->a_intersect_b, "idset_intersect");
+                idset_destroy (result);
+
+                result = idset_difference (a, b);
+                ok (result != NULL, "idset_difference works");
+                check_encode (result, t->a_difference_b, "idset_difference");
+                idset_destroy (result);
+
+                ok (idset_add (a, b) == 0,
+                    "idset_add works");
+                check_encode (a, t->a_union_b, "idset_add");
+                ok (idset_subtract (a, b) == 0,
+                    "idset_subtract works");
+                check_encode (a, t->a_difference_b, "idset_subtract");
+
+                idset_destroy (a);
+                idset_destroy (b);
+            }
+        }
+    }
+}
+
+void test_setops_badparam (void)
+{
+    struct idset *a;
+    struct idset *b;
+
+    if (!(a = idset_create (10, 0)) || !(b = idset_decode ("5,20")))
+        BAIL_OUT ("idset_create failed");
+
+    errno = 0;
+    ok (idset_add (a, b) < 0 && errno == EINVAL,
+        "idset_add fails with EINVAL if set2 does not fit in set1");
+    errno = 0;
+    ok (idset_union (a, b) == NULL && errno == EINVAL,
+        "idset_union fails with EINVAL if set2 does not fit in set1");
+    errno = 0;
+    ok (idset_add (NULL, b) < 0 && errno == EINVAL,
+        "idset_add set1=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_subtract (a, NULL) < 0 && errno == EINVAL,
+        "idset_subtract set2=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_union (NULL, b) == NULL && errno == EINVAL,
+        "idset_union set1=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_intersect (a, NULL) == NULL && errno == EINVAL,
+        "idset_intersect set2=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_difference (NULL, NULL) == NULL && errno == EINVAL,
+        "idset_difference set1=NULL fails with EINVAL");
+
+    idset_destroy (a);
+    idset_destroy (b);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -652,6 +843,9 @@ int main (int argc, char *argv[])
     test_format_first ();
     issue_1974 ();
     issue_2336 ();
+    test_bitmap ();
+    test_setops ();
+    test_setops_badparam ();
 
     done_testing ();
 }
@@ -57,6 +57,10 @@ int PMI_Init (int *spawned)
             return PMI_ERR_NOMEM;
         return PMI_FAIL;
     }
+    if (pmi_simple_client_set_shm_kvs (ctx, getenv ("PMI_SHM_KVS")) < 0) {
+        pmi_simple_client_destroy (ctx);
+        return PMI_ERR_NOMEM;
+    }
 
     result = pmi_simple_client_init (ctx);
     if (result != PMI_SUCCESS) {
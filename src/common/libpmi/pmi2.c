@@ -72,6 +72,10 @@ int PMI2_Init (int *spawned, int *size, int *rank, int *appnum)
             return PMI2_ERR_NOMEM;
         return PMI2_FAIL;
     }
+    if (pmi_simple_client_set_shm_kvs (ctx, getenv ("PMI_SHM_KVS")) < 0) {
+        pmi_simple_client_destroy (ctx);
+        return PMI2_ERR_NOMEM;
+    }
 
     result = pmi_simple_client_init (ctx);
     if (result != PMI2_SUCCESS) {
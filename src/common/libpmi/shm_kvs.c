@@ -0,0 +1,370 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* shm_kvs.c - read-only node-local PMI KVS snapshot
+ *
+ * File layout (host byte order, since writer and readers share a node):
+ *
+ *   struct shm_kvs_header
+ *   uint32_t bucket[nbuckets]     file offset of entry, or 0 if empty
+ *   entries                       key\0value\0 ...
+ *
+ * nbuckets is a power of two at least twice the number of keys,
+ * and collisions are resolved by linear probing.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "simple_server.h"
+#include "shm_kvs.h"
+
+#define SHM_KVS_MAGIC "FLUXKVS1"
+#define SHM_KVS_MIN_BUCKETS 16
+
+struct shm_kvs_header {
+    char magic[8];
+    uint32_t nbuckets;
+    uint32_t count;
+    uint64_t size;
+    char kvsname[SIMPLE_KVS_NAME_MAX];
+};
+
+struct shm_kvs_writer {
+    char kvsname[SIMPLE_KVS_NAME_MAX];
+    char **keys;
+    char **vals;
+    int count;
+    int alloc;
+};
+
+struct shm_kvs {
+    void *base;
+    size_t size;
+    const struct shm_kvs_header *hdr;
+    const uint32_t *bucket;
+};
+
+/* 32-bit FNV-1a
+ */
+static uint32_t hash_key (const char *key)
+{
+    uint32_t h = 2166136261U;
+
+    while (*key) {
+        h ^= (unsigned char)*key++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+void shm_kvs_writer_clear (struct shm_kvs_writer *w)
+{
+    if (w) {
+        int i;
+        for (i = 0; i < w->count; i++) {
+            free (w->keys[i]);
+            free (w->vals[i]);
+        }
+        w->count = 0;
+    }
+}
+
+void shm_kvs_writer_destroy (struct shm_kvs_writer *w)
+{
+    if (w) {
+        int saved_errno = errno;
+        shm_kvs_writer_clear (w);
+        free (w->keys);
+        free (w->vals);
+        free (w);
+        errno = saved_errno;
+    }
+}
+
+struct shm_kvs_writer *shm_kvs_writer_create (const char *kvsname)
+{
+    struct shm_kvs_writer *w;
+
+    if (!kvsname || strlen (kvsname) >= SIMPLE_KVS_NAME_MAX) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(w = calloc (1, sizeof (*w))))
+        return NULL;
+    strcpy (w->kvsname, kvsname);
+    return w;
+}
+
+int shm_kvs_writer_put (struct shm_kvs_writer *w,
+                        const char *key,
+                        const char *val)
+{
+    char *k = NULL;
+    char *v = NULL;
+
+    if (!w || !key || !val) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (w->count == w->alloc) {
+        int alloc = w->alloc ? w->alloc * 2 : 64;
+        char **keys;
+        char **vals;
+
+        if (!(keys = realloc (w->keys, alloc * sizeof (keys[0]))))
+            return -1;
+        w->keys = keys;
+        if (!(vals = realloc (w->vals, alloc * sizeof (vals[0]))))
+            return -1;
+        w->vals = vals;
+        w->alloc = alloc;
+    }
+    if (!(k = strdup (key)) || !(v = strdup (val))) {
+        free (k);
+        return -1;
+    }
+    w->keys[w->count] = k;
+    w->vals[w->count] = v;
+    w->count++;
+    return 0;
+}
+
+static int write_all (int fd, const void *buf, size_t len)
+{
+    const char *cp = buf;
+
+    while (len > 0) {
+        ssize_t n = write (fd, cp, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        cp += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int shm_kvs_writer_commit (struct shm_kvs_writer *w, const char *path)
+{
+    struct shm_kvs_header *hdr;
+    uint32_t *bucket;
+    uint32_t nbuckets = SHM_KVS_MIN_BUCKETS;
+    uint32_t count = 0;
+    size_t size;
+    size_t offset;
+    char *buf = NULL;
+    char *tmp = NULL;
+    int fd = -1;
+    int i;
+
+    if (!w || !path) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (nbuckets < (uint32_t)w->count * 2)
+        nbuckets <<= 1;
+    size = sizeof (*hdr) + nbuckets * sizeof (bucket[0]);
+    for (i = 0; i < w->count; i++)
+        size += strlen (w->keys[i]) + strlen (w->vals[i]) + 2;
+    if (size > UINT32_MAX) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (!(buf = calloc (1, size)))
+        return -1;
+    hdr = (struct shm_kvs_header *)buf;
+    bucket = (uint32_t *)(buf + sizeof (*hdr));
+    offset = sizeof (*hdr) + nbuckets * sizeof (bucket[0]);
+    for (i = 0; i < w->count; i++) {
+        uint32_t b = hash_key (w->keys[i]) & (nbuckets - 1);
+        size_t keylen = strlen (w->keys[i]) + 1;
+        size_t vallen = strlen (w->vals[i]) + 1;
+
+        while (bucket[b] != 0 && strcmp (buf + bucket[b], w->keys[i]) != 0)
+            b = (b + 1) & (nbuckets - 1);
+        if (bucket[b] == 0)
+            count++;
+        bucket[b] = offset;
+        memcpy (buf + offset, w->keys[i], keylen);
+        memcpy (buf + offset + keylen, w->vals[i], vallen);
+        offset += keylen + vallen;
+    }
+    memcpy (hdr->magic, SHM_KVS_MAGIC, sizeof (hdr->magic));
+    hdr->nbuckets = nbuckets;
+    hdr->count = count;
+    hdr->size = size;
+    strcpy (hdr->kvsname, w->kvsname);
+
+    /* Write to a temporary file, then rename it into place so that
+     * readers never observe a partially written snapshot.
+     */
+    if (asprintf (&tmp, "%s.XXXXXX", path) < 0) {
+        tmp = NULL;
+        goto error;
+    }
+    if ((fd = mkstemp (tmp)) < 0)
+        goto error;
+    if (write_all (fd, buf, size) < 0)
+        goto error;
+    if (close (fd) < 0) {
+        fd = -1;
+        goto error;
+    }
+    fd = -1;
+    if (rename (tmp, path) < 0)
+        goto error;
+    free (tmp);
+    free (buf);
+    return 0;
+error:
+    if (fd >= 0) {
+        int saved_errno = errno;
+        (void)close (fd);
+        errno = saved_errno;
+    }
+    if (tmp) {
+        int saved_errno = errno;
+        (void)unlink (tmp);
+        free (tmp);
+        errno = saved_errno;
+    }
+    free (buf);
+    return -1;
+}
+
+void shm_kvs_close (struct shm_kvs *kvs)
+{
+    if (kvs) {
+        int saved_errno = errno;
+        if (kvs->base)
+            (void)munmap (kvs->base, kvs->size);
+        free (kvs);
+        errno = saved_errno;
+    }
+}
+
+struct shm_kvs *shm_kvs_open (const char *path)
+{
+    struct shm_kvs *kvs;
+    struct stat sb;
+    int fd;
+
+    if (!path) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((fd = open (path, O_RDONLY | O_NOFOLLOW)) < 0)
+        return NULL;
+    if (!(kvs = calloc (1, sizeof (*kvs))))
+        goto error;
+    if (fstat (fd, &sb) < 0)
+        goto error;
+    /* The path is predictable, so only trust a snapshot written by this
+     * user that nobody else could have modified.
+     */
+    if (!S_ISREG (sb.st_mode)
+        || sb.st_uid != getuid ()
+        || (sb.st_mode & (S_IWGRP | S_IWOTH))) {
+        errno = EPERM;
+        goto error;
+    }
+    if (sb.st_size < sizeof (struct shm_kvs_header)) {
+        errno = EINVAL;
+        goto error;
+    }
+    kvs->size = sb.st_size;
+    if ((kvs->base = mmap (NULL,
+                           kvs->size,
+                           PROT_READ,
+                           MAP_SHARED,
+                           fd,
+                           0)) == MAP_FAILED) {
+        kvs->base = NULL;
+        goto error;
+    }
+    kvs->hdr = kvs->base;
+    kvs->bucket = (const uint32_t *)((char *)kvs->base + sizeof (*kvs->hdr));
+    if (memcmp (kvs->hdr->magic, SHM_KVS_MAGIC, sizeof (kvs->hdr->magic)) != 0
+        || kvs->hdr->size != kvs->size
+        || kvs->hdr->nbuckets == 0
+        || (kvs->hdr->nbuckets & (kvs->hdr->nbuckets - 1)) != 0
+        || sizeof (*kvs->hdr) + kvs->hdr->nbuckets * sizeof (uint32_t)
+                                                            > kvs->size
+        || memchr (kvs->hdr->kvsname, '\0', SIMPLE_KVS_NAME_MAX) == NULL) {
+        errno = EINVAL;
+        goto error;
+    }
+    (void)close (fd);
+    return kvs;
+error:
+    shm_kvs_close (kvs);
+    (void)close (fd);
+    return NULL;
+}
+
+const char *shm_kvs_get (struct shm_kvs *kvs,
+                         const char *kvsname,
+                         const char *key)
+{
+    const char *base;
+    uint32_t mask;
+    uint32_t b;
+    uint32_t n;
+
+    if (!kvs || !kvsname || !key) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (strcmp (kvs->hdr->kvsname, kvsname) != 0)
+        goto noent;
+    base = kvs->base;
+    mask = kvs->hdr->nbuckets - 1;
+    b = hash_key (key) & mask;
+    for (n = 0; n < kvs->hdr->nbuckets; n++) {
+        uint32_t offset = kvs->bucket[b];
+        const char *k;
+        size_t room;
+        const char *end;
+
+        if (offset == 0)
+            break;
+        if (offset >= kvs->size)
+            goto noent;
+        k = base + offset;
+        room = kvs->size - offset;
+        if (!(end = memchr (k, '\0', room))
+            || !memchr (end + 1, '\0', room - (end + 1 - k)))
+            goto noent;
+        if (!strcmp (k, key))
+            return end + 1;
+        b = (b + 1) & mask;
+    }
+noent:
+    errno = ENOENT;
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,64 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_PMI_SHM_KVS_H
+#define _FLUX_PMI_SHM_KVS_H
+
+/* Read-only, node-local snapshot of a PMI KVS.
+ *
+ * The process manager builds a snapshot with the writer interface and
+ * commits it to a file, ideally on a memory-backed file system such as
+ * /dev/shm.  The commit replaces any previous snapshot atomically, so
+ * a reader that opens the path sees either the old or the new snapshot.
+ *
+ * Readers map the snapshot read-only and look up keys in an open
+ * addressing hash table without any communication.  A miss means only
+ * that the key is not in this snapshot, not that it does not exist.
+ */
+
+struct shm_kvs_writer;
+struct shm_kvs;
+
+/* Create a writer for a snapshot of KVS 'kvsname'.
+ */
+struct shm_kvs_writer *shm_kvs_writer_create (const char *kvsname);
+void shm_kvs_writer_destroy (struct shm_kvs_writer *w);
+
+/* Add key and value to the snapshot.  A later put of the same key
+ * replaces the earlier value.
+ */
+int shm_kvs_writer_put (struct shm_kvs_writer *w,
+                        const char *key,
+                        const char *val);
+
+/* Write the snapshot to 'path', replacing any existing file.
+ * The writer may be reused after clearing it with shm_kvs_writer_clear().
+ */
+int shm_kvs_writer_commit (struct shm_kvs_writer *w, const char *path);
+void shm_kvs_writer_clear (struct shm_kvs_writer *w);
+
+/* Map the snapshot at 'path'.  Fails with EPERM unless it is a regular
+ * file owned by the caller's uid and not writable by group or other.
+ */
+struct shm_kvs *shm_kvs_open (const char *path);
+void shm_kvs_close (struct shm_kvs *kvs);
+
+/* Look up 'key' in 'kvsname'.  Returns NULL with errno = ENOENT if the key
+ * is not found, or if the snapshot is not for 'kvsname'.
+ */
+const char *shm_kvs_get (struct shm_kvs *kvs,
+                         const char *kvsname,
+                         const char *key);
+
+#endif /* !_FLUX_PMI_SHM_KVS_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -27,6 +27,7 @@
 #include "clique.h"
 #include "dgetline.h"
 #include "keyval.h"
+#include "shm_kvs.h"
 #include "pmi.h"
 
 int pmi_simple_client_init (struct pmi_simple_client *pmi)
@@ -172,6 +173,13 @@ int pmi_simple_client_barrier (struct pmi_simple_client *pmi)
         result = rc;
         goto done;
     }
+    /* The process manager publishes a new snapshot before releasing
+     * the barrier, so pick it up now.
+     */
+    if (pmi->shm_path) {
+        shm_kvs_close (pmi->shm);
+        pmi->shm = shm_kvs_open (pmi->shm_path);
+    }
     result = PMI_SUCCESS;
 done:
     return result;
@@ -246,6 +254,15 @@ int pmi_simple_client_kvs_get (struct pmi_simple_client *pmi,
         return PMI_ERR_INIT;
     if (!kvsname || !key || !value || len <= 0)
         return PMI_ERR_INVALID_ARG;
+    if (pmi->shm) {
+        const char *val;
+        if ((val = shm_kvs_get (pmi->shm, kvsname, key))) {
+            if (strlen (val) >= len)
+                return PMI_ERR_INVALID_VAL_LENGTH;
+            strcpy (value, val);
+            return PMI_SUCCESS;
+        }
+    }
     if (dprintf (pmi->fd, "cmd=get kvsname=%s key=%s\n", kvsname, key) < 0)
         goto done;
     if (dgetline (pmi->fd, pmi->buf, pmi->buflen) < 0)
@@ -405,6 +422,8 @@ void pmi_simple_client_destroy (struct pmi_simple_client *pmi)
     if (pmi) {
         int saved_errno = errno;
         aux_destroy (&pmi->aux);
+        shm_kvs_close (pmi->shm);
+        free (pmi->shm_path);
         if (pmi->fd != -1)
             (void)close (pmi->fd);
         free (pmi->buf);
@@ -413,6 +432,26 @@ void pmi_simple_client_destroy (struct pmi_simple_client *pmi)
     }
 }
 
+int pmi_simple_client_set_shm_kvs (struct pmi_simple_client *pmi,
+                                   const char *path)
+{
+    char *cpy;
+
+    if (!pmi) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!path)
+        return 0;
+    if (!(cpy = strdup (path)))
+        return -1;
+    free (pmi->shm_path);
+    pmi->shm_path = cpy;
+    shm_kvs_close (pmi->shm);
+    pmi->shm = shm_kvs_open (pmi->shm_path); // may be NULL until barrier
+    return 0;
+}
+
 struct pmi_simple_client *pmi_simple_client_create_fd (const char *pmi_fd,
                                                        const char *pmi_rank,
                                                        const char *pmi_size,
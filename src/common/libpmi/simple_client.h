@@ -31,6 +31,8 @@ struct pmi_simple_client {
     int buflen;
     int fd;
     struct aux_item *aux;
+    char *shm_path;
+    struct shm_kvs *shm;
 };
 
 /* Create/destroy
@@ -44,6 +46,13 @@ struct pmi_simple_client *pmi_simple_client_create_fd (const char *pmi_fd,
                                                        const char *pmi_size,
                                                        const char *pmi_spawned);
 
+/* Enable lookups in the node-local KVS snapshot at 'path', published by
+ * the process manager after each barrier.  Keys not found there are
+ * fetched with the wire protocol.  A NULL 'path' is ignored.
+ */
+int pmi_simple_client_set_shm_kvs (struct pmi_simple_client *pmi,
+                                   const char *path);
+
 /* Core operations
  */
 int pmi_simple_client_init (struct pmi_simple_client *pmi);
@@ -0,0 +1,151 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "src/common/libpmi/shm_kvs.h"
+#include "src/common/libtap/tap.h"
+
+int main (int argc, char *argv[])
+{
+    struct shm_kvs_writer *w;
+    struct shm_kvs *kvs;
+    char path[] = "/tmp/shm_kvs-test.XXXXXX";
+    char link[64];
+    char key[64];
+    char val[64];
+    const char *s;
+    int fd;
+    int i;
+    int errors;
+
+    plan (NO_PLAN);
+
+    fd = mkstemp (path);
+    if (fd < 0)
+        BAIL_OUT ("mkstemp failed");
+    close (fd);
+
+    errno = 0;
+    ok (shm_kvs_open (path) == NULL && errno == EINVAL,
+        "shm_kvs_open fails with EINVAL on empty file");
+
+    w = shm_kvs_writer_create ("kvs1");
+    ok (w != NULL,
+        "shm_kvs_writer_create works");
+    ok (shm_kvs_writer_commit (w, path) == 0,
+        "shm_kvs_writer_commit works with no keys");
+    kvs = shm_kvs_open (path);
+    ok (kvs != NULL,
+        "shm_kvs_open works on empty snapshot");
+    errno = 0;
+    ok (shm_kvs_get (kvs, "kvs1", "foo") == NULL && errno == ENOENT,
+        "shm_kvs_get foo fails with ENOENT");
+    shm_kvs_close (kvs);
+
+    for (i = 0; i < 1000; i++) {
+        snprintf (key, sizeof (key), "key%d", i);
+        snprintf (val, sizeof (val), "val%d", i);
+        if (shm_kvs_writer_put (w, key, val) < 0)
+            BAIL_OUT ("shm_kvs_writer_put failed");
+    }
+    ok (shm_kvs_writer_put (w, "key0", "newval") == 0,
+        "shm_kvs_writer_put works on duplicate key");
+    ok (shm_kvs_writer_commit (w, path) == 0,
+        "shm_kvs_writer_commit works with 1000 keys");
+    kvs = shm_kvs_open (path);
+    ok (kvs != NULL,
+        "shm_kvs_open works");
+    errors = 0;
+    for (i = 1; i < 1000; i++) {
+        snprintf (key, sizeof (key), "key%d", i);
+        snprintf (val, sizeof (val), "val%d", i);
+        if (!(s = shm_kvs_get (kvs, "kvs1", key)) || strcmp (s, val) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "shm_kvs_get returns expected values");
+    s = shm_kvs_get (kvs, "kvs1", "key0");
+    ok (s != NULL && !strcmp (s, "newval"),
+        "shm_kvs_get returns the last value put for duplicate key");
+    errno = 0;
+    ok (shm_kvs_get (kvs, "kvs1", "nokey") == NULL && errno == ENOENT,
+        "shm_kvs_get fails with ENOENT on missing key");
+    errno = 0;
+    ok (shm_kvs_get (kvs, "kvs2", "key1") == NULL && errno == ENOENT,
+        "shm_kvs_get fails with ENOENT on wrong kvsname");
+    errno = 0;
+    ok (shm_kvs_get (kvs, "kvs1", NULL) == NULL && errno == EINVAL,
+        "shm_kvs_get key=NULL fails with EINVAL");
+
+    /* Existing mapping is unaffected by a new commit.
+     */
+    shm_kvs_writer_clear (w);
+    ok (shm_kvs_writer_put (w, "a", "b") == 0
+        && shm_kvs_writer_commit (w, path) == 0,
+        "shm_kvs_writer_commit works after clear");
+    s = shm_kvs_get (kvs, "kvs1", "key1");
+    ok (s != NULL && !strcmp (s, "val1"),
+        "old mapping still returns old values");
+    shm_kvs_close (kvs);
+    kvs = shm_kvs_open (path);
+    ok (kvs != NULL
+        && shm_kvs_get (kvs, "kvs1", "key1") == NULL
+        && (s = shm_kvs_get (kvs, "kvs1", "a")) != NULL
+        && !strcmp (s, "b"),
+        "new mapping returns new values");
+    shm_kvs_close (kvs);
+    shm_kvs_writer_destroy (w);
+
+    /* Snapshot that others could have written is not trusted.
+     */
+    if (chmod (path, 0620) < 0)
+        BAIL_OUT ("chmod failed");
+    errno = 0;
+    ok (shm_kvs_open (path) == NULL && errno == EPERM,
+        "shm_kvs_open fails with EPERM on group writable snapshot");
+    if (chmod (path, 0602) < 0)
+        BAIL_OUT ("chmod failed");
+    errno = 0;
+    ok (shm_kvs_open (path) == NULL && errno == EPERM,
+        "shm_kvs_open fails with EPERM on other writable snapshot");
+    if (chmod (path, 0644) < 0)
+        BAIL_OUT ("chmod failed");
+    kvs = shm_kvs_open (path);
+    ok (kvs != NULL,
+        "shm_kvs_open works on snapshot readable by others");
+    shm_kvs_close (kvs);
+    snprintf (link, sizeof (link), "%s.link", path);
+    if (symlink (path, link) < 0)
+        BAIL_OUT ("symlink failed");
+    ok (shm_kvs_open (link) == NULL,
+        "shm_kvs_open fails on symlink");
+    unlink (link);
+
+    errno = 0;
+    ok (shm_kvs_writer_create (NULL) == NULL && errno == EINVAL,
+        "shm_kvs_writer_create kvsname=NULL fails with EINVAL");
+    errno = 0;
+    ok (shm_kvs_open (NULL) == NULL && errno == EINVAL,
+        "shm_kvs_open path=NULL fails with EINVAL");
+
+    unlink (path);
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -53,10 +53,27 @@ sprintfcat (char **s, size_t *sz, size_t *lenp, const char *fmt, ...)
     return (n);
 }
 
+static void rlist_index_clear (struct rlist *rl)
+{
+    int i;
+    for (i = 0; i < rl->avail_index_size; i++)
+        idset_destroy (rl->avail_index[i]);
+    free (rl->avail_index);
+    rl->avail_index = NULL;
+    rl->avail_index_size = 0;
+    if (rl->rank_index)
+        zhashx_purge (rl->rank_index);
+    if (rl->avail_ranks)
+        idset_range_clear (rl->avail_ranks, 0, IDSET_INVALID_ID - 1);
+}
+
 void rlist_destroy (struct rlist *rl)
 {
     if (rl) {
         int saved_errno = errno;
+        rlist_index_clear (rl);
+        zhashx_destroy (&rl->rank_index);
+        idset_destroy (rl->avail_ranks);
         zlistx_destroy (&rl->nodes);
         zhashx_destroy (&rl->noremap);
         json_decref (rl->scheduling);
@@ -79,6 +96,173 @@ static void valfree (void **item)
     }
 }
 
+/*  Entry in rl->rank_index for one node of rl->nodes.
+ */
+struct rnode_entry {
+    uint32_t rank;
+    void *handle;   /* handle of node in rl->nodes */
+    int avail;      /* current rl->avail_index bucket, or -1 if none */
+};
+
+/* N.B. zhashx_hash_fn signature
+ */
+static size_t rank_hasher (const void *key)
+{
+    const uint32_t *rank = key;
+    return *rank;
+}
+
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+/* N.B. zhashx_comparator_fn signature
+ */
+static int rank_hash_key_cmp (const void *key1, const void *key2)
+{
+    const uint32_t *r1 = key1;
+    const uint32_t *r2 = key2;
+    return NUMCMP (*r1, *r2);
+}
+
+static zhashx_t *rank_index_create (void)
+{
+    zhashx_t *hash;
+
+    if (!(hash = zhashx_new ()))
+        return NULL;
+    zhashx_set_key_hasher (hash, rank_hasher);
+    zhashx_set_key_comparator (hash, rank_hash_key_cmp);
+    zhashx_set_key_duplicator (hash, NULL);
+    zhashx_set_key_destructor (hash, NULL);
+    zhashx_set_destructor (hash, valfree);
+    return hash;
+}
+
+static struct rnode_entry *rlist_entry (const struct rlist *rl, uint32_t rank)
+{
+    return zhashx_lookup (rl->rank_index, &rank);
+}
+
+/*  Move entry 'e' to availability bucket 'avail' (-1 for no bucket).
+ *  On failure, the entry is left in its current bucket.
+ */
+static int rlist_index_move (struct rlist *rl,
+                             struct rnode_entry *e,
+                             int avail)
+{
+    if (e->avail == avail)
+        return 0;
+    if (avail >= rl->avail_index_size) {
+        struct idset **new;
+        int size = rl->avail_index_size ? rl->avail_index_size : 16;
+
+        while (size <= avail)
+            size *= 2;
+        if (!(new = realloc (rl->avail_index, size * sizeof (*new))))
+            return -1;
+        memset (new + rl->avail_index_size,
+                0,
+                (size - rl->avail_index_size) * sizeof (*new));
+        rl->avail_index = new;
+        rl->avail_index_size = size;
+    }
+    if (avail >= 0) {
+        if (!rl->avail_index[avail]
+            && !(rl->avail_index[avail] = idset_create (0,
+                                                IDSET_FLAG_AUTOGROW
+                                                | IDSET_FLAG_BITMAP)))
+            return -1;
+        if (idset_set (rl->avail_index[avail], e->rank) < 0)
+            return -1;
+    }
+    if (e->avail >= 0)
+        (void) idset_clear (rl->avail_index[e->avail], e->rank);
+    if (avail > 0) {
+        if (idset_set (rl->avail_ranks, e->rank) < 0)
+            return -1;
+    }
+    else
+        (void) idset_clear (rl->avail_ranks, e->rank);
+    e->avail = avail;
+    return 0;
+}
+
+/*  Update the availability bucket of node 'n' after a change in its
+ *   available cores or up/down state.
+ */
+static int rlist_index_update (struct rlist *rl, const struct rnode *n)
+{
+    struct rnode_entry *e = rlist_entry (rl, n->rank);
+    if (!e) {
+        errno = ENOENT;
+        return -1;
+    }
+    return rlist_index_move (rl, e, n->up ? (int) rnode_avail (n) : -1);
+}
+
+static int rlist_index_add (struct rlist *rl, struct rnode *n, void *handle)
+{
+    struct rnode_entry *e;
+
+    if (!(e = calloc (1, sizeof (*e))))
+        return -1;
+    e->rank = n->rank;
+    e->handle = handle;
+    e->avail = -1;
+    if (zhashx_insert (rl->rank_index, &e->rank, e) < 0) {
+        free (e);
+        errno = EEXIST;
+        return -1;
+    }
+    if (rlist_index_update (rl, n) < 0) {
+        zhashx_delete (rl->rank_index, &n->rank);
+        return -1;
+    }
+    return 0;
+}
+
+static void rlist_index_remove (struct rlist *rl, uint32_t rank)
+{
+    struct rnode_entry *e = rlist_entry (rl, rank);
+    if (e) {
+        (void) rlist_index_move (rl, e, -1);
+        zhashx_delete (rl->rank_index, &rank);
+    }
+}
+
+/*  Rebuild all indexes, e.g. after nodes have been re-ranked.
+ */
+static int rlist_reindex (struct rlist *rl)
+{
+    struct rnode *n;
+
+    rlist_index_clear (rl);
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        if (rlist_index_add (rl, n, zlistx_cursor (rl->nodes)) < 0)
+            return -1;
+        n = zlistx_next (rl->nodes);
+    }
+    return 0;
+}
+
+/*  Sort rl->nodes using comparator 'cmp'.  zlistx_sort() swaps items
+ *   between list nodes, so the handles in the rank index are refreshed.
+ */
+static void rlist_sort_nodes (const struct rlist *rl, zlistx_comparator_fn *cmp)
+{
+    struct rnode *n;
+
+    zlistx_set_comparator (rl->nodes, cmp);
+    zlistx_sort (rl->nodes);
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        struct rnode_entry *e = rlist_entry (rl, n->rank);
+        if (e)
+            e->handle = zlistx_cursor (rl->nodes);
+        n = zlistx_next (rl->nodes);
+    }
+}
+
 struct rlist *rlist_create (void)
 {
     struct rlist *rl = calloc (1, sizeof (*rl));
@@ -86,6 +270,11 @@ struct rlist *rlist_create (void)
         goto err;
     zlistx_set_destructor (rl->nodes, rn_free_fn);
 
+    if (!(rl->rank_index = rank_index_create ())
+        || !(rl->avail_ranks = idset_create (0, IDSET_FLAG_AUTOGROW
+                                                | IDSET_FLAG_BITMAP)))
+        goto err;
+
     if (!(rl->noremap = zhashx_new ()))
         goto err;
     zhashx_set_destructor (rl->noremap, valfree);
@@ -118,13 +307,10 @@ static json_t * scheduling_key_append (json_t *s1, json_t *s2)
 
 static struct rnode *rlist_find_rank (const struct rlist *rl, uint32_t rank)
 {
-    struct rnode *n = zlistx_first (rl->nodes);
-    while (n) {
-        if (n->rank == rank)
-            return (n);
-        n = zlistx_next (rl->nodes);
-    }
-    return NULL;
+    struct rnode_entry *e = rlist_entry (rl, rank);
+    if (!e)
+        return NULL;
+    return zlistx_handle_item (e->handle);
 }
 
 static void rlist_update_totals (struct rlist *rl, struct rnode *n)
@@ -136,8 +322,15 @@ static void rlist_update_totals (struct rlist *rl, struct rnode *n)
 
 static int rlist_add_rnode_new (struct rlist *rl, struct rnode *n)
 {
-    if (!zlistx_add_end (rl->nodes, n))
+    void *handle;
+    if (!(handle = zlistx_add_end (rl->nodes, n)))
+        return -1;
+    if (rlist_index_add (rl, n, handle) < 0) {
+        int saved_errno = errno;
+        zlistx_detach (rl->nodes, handle);
+        errno = saved_errno;
         return -1;
+    }
     rlist_update_totals (rl, n);
     return 0;
 }
@@ -152,6 +345,7 @@ static int rlist_add_rnode (struct rlist *rl, struct rnode *n)
     if (found) {
         if (rnode_add (found, n) < 0)
             return -1;
+        (void) rlist_index_update (rl, found);
         rlist_update_totals (rl, n);
         rnode_destroy (n);
     }
@@ -199,6 +393,26 @@ fail:
     return NULL;
 }
 
+/*  rnode_copy() resets state to up, so carry it over here.
+ */
+static struct rnode *rnode_copy_with_state (const struct rnode *orig)
+{
+    struct rnode *n = rnode_copy (orig);
+    if (n)
+        n->up = orig->up;
+    return n;
+}
+
+struct rlist *rlist_copy (const struct rlist *orig)
+{
+    struct rlist *rl = rlist_copy_internal (orig, rnode_copy_with_state);
+    if (rl) {
+        rl->starttime = orig->starttime;
+        rl->expiration = orig->expiration;
+    }
+    return rl;
+}
+
 struct rlist *rlist_copy_empty (const struct rlist *orig)
 {
     return rlist_copy_internal (orig, rnode_copy_empty);
@@ -281,6 +495,17 @@ err:
     return NULL;
 }
 
+static struct rnode *rlist_detach_rank (struct rlist *rl, uint32_t rank)
+{
+    struct rnode_entry *e = rlist_entry (rl, rank);
+    void *handle;
+    if (!e)
+        return NULL;
+    handle = e->handle;
+    rlist_index_remove (rl, rank);
+    return zlistx_detach (rl->nodes, handle);
+}
+
 int rlist_remove_ranks (struct rlist *rl, struct idset *ranks)
 {
     int count = 0;
@@ -288,8 +513,8 @@ int rlist_remove_ranks (struct rlist *rl, struct idset *ranks)
     unsigned int i;
     i = idset_first (ranks);
     while (i != IDSET_INVALID_ID) {
-        if ((n = rlist_find_rank (rl, i))) {
-            zlistx_delete (rl->nodes, zlistx_cursor (rl->nodes));
+        if ((n = rlist_detach_rank (rl, i))) {
+            rnode_destroy (n);
             count++;
         }
         i = idset_next (ranks, i);
@@ -299,6 +524,7 @@ int rlist_remove_ranks (struct rlist *rl, struct idset *ranks)
 
 int rlist_remap (struct rlist *rl)
 {
+    int rc = 0;
     uint32_t rank = 0;
     struct rnode *n;
 
@@ -310,11 +536,13 @@ int rlist_remap (struct rlist *rl)
     n = zlistx_first (rl->nodes);
     while (n) {
         n->rank = rank++;
-        if (rnode_remap (n, rl->noremap) < 0)
-            return -1;
+        if ((rc = rnode_remap (n, rl->noremap)) < 0)
+            break;
         n = zlistx_next (rl->nodes);
     }
-    return 0;
+    if (rlist_reindex (rl) < 0)
+        rc = -1;
+    return rc;
 }
 
 struct rnode * rlist_find_host (const struct rlist *rl, const char *host)
@@ -374,20 +602,14 @@ int rlist_rerank (struct rlist *rl, const char *hosts)
         (void) rlist_rerank_hostlist (rl, orig);
         errno = saved_errno;
     }
+    if (rlist_reindex (rl) < 0)
+        rc = -1;
 done:
     hostlist_destroy (orig);
     hostlist_destroy (hl);
     return rc;
 }
 
-static struct rnode *rlist_detach_rank (struct rlist *rl, uint32_t rank)
-{
-    struct rnode *n = rlist_find_rank (rl, rank);
-    if (n)
-        zlistx_detach_cur (rl->nodes);
-    return n;
-}
-
 struct rlist *rlist_diff (const struct rlist *rla, const struct rlist *rlb)
 {
     struct rnode *n;
@@ -749,7 +971,7 @@ int rlist_rank_add_child (struct rlist *rl,
     }
     if (rnode_add_child (n, name, ids) == NULL)
         return -1;
-    return 0;
+    return rlist_index_update (rl, n);
 }
 
 static int rlist_append_ranks (struct rlist *rl,
@@ -830,8 +1052,7 @@ static int rlist_assign_hostlist (struct rlist *rl, struct hostlist *hl)
         return -1;
 
     /*  Reset default sort to order nodes by "rank" */
-    zlistx_set_comparator (rl->nodes, by_rank);
-    zlistx_sort(rl->nodes);
+    rlist_sort_nodes (rl, by_rank);
 
     /*  Consume a hostname for each node in the rlist */
     n = zlistx_first (rl->nodes);
@@ -1148,8 +1369,7 @@ struct hostlist *rlist_nodelist (const struct rlist *rl)
 
     /*  List must be sorted by rank before collecting nodelist
      */
-    zlistx_set_comparator (rl->nodes, by_rank);
-    zlistx_sort (rl->nodes);
+    rlist_sort_nodes (rl, by_rank);
 
     n = zlistx_first (rl->nodes);
     while (n) {
@@ -1321,16 +1541,6 @@ static int by_rank (const void *item1, const void *item2)
     return (x->rank - y->rank);
 }
 
-static int by_avail (const void *item1, const void *item2)
-{
-    int n;
-    const struct rnode *x = item1;
-    const struct rnode *y = item2;
-    if ((n = rnode_avail (x) - rnode_avail (y)) == 0)
-        n = by_rank (x, y);
-    return n;
-}
-
 static int by_used (const void *item1, const void *item2)
 {
     int n;
@@ -1347,6 +1557,7 @@ static int rlist_rnode_alloc (struct rlist *rl, struct rnode *n,
     if (!n || rnode_alloc (n, count, idsetp) < 0)
         return -1;
     rl->avail -= idset_count (*idsetp);
+    (void) rlist_index_update (rl, n);
     return 0;
 }
 
@@ -1361,60 +1572,126 @@ static uint32_t rlist_rnode_rank (struct rlist *rl)
 }
 #endif
 
-static struct rnode *rlist_first (struct rlist *rl)
+/*
+ *  Allocate as many of `slots` slots of size cores_per_slot as will fit
+ *   on node n, and append the allocated cores to `result`.
+ *  Returns the number of slots allocated, or -1 on failure.
+ */
+static int rlist_alloc_slots (struct rlist *rl,
+                              struct rnode *n,
+                              struct rlist *result,
+                              int cores_per_slot,
+                              int slots)
 {
-    return zlistx_first (rl->nodes);
+    int rc;
+    int count;
+    struct idset *ids = NULL;
+
+    if ((count = rnode_avail (n) / cores_per_slot) > slots)
+        count = slots;
+    if (count == 0)
+        return 0;
+    if (rlist_rnode_alloc (rl, n, count * cores_per_slot, &ids) < 0)
+        return -1;
+    rc = rlist_append_cores (result, n->hostname, n->rank, ids);
+    idset_destroy (ids);
+    if (rc < 0)
+        return -1;
+    return count;
 }
 
-static struct rnode *rlist_next (struct rlist *rl)
-{
-    return zlistx_next (rl->nodes);
+/*
+ *  Allocate `slots` of size cores_per_slot from the nodes of rlist `rl`
+ *   with ranks in `ranks`, in rank order.  Returns the number of slots
+ *   that could not be allocated, or -1 on failure.
+ */
+static int rlist_alloc_ranks (struct rlist *rl,
+                              struct idset *ranks,
+                              struct rlist *result,
+                              int cores_per_slot,
+                              int slots)
+{
+    unsigned int rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID && slots > 0) {
+        struct rnode *n = rlist_find_rank (rl, rank);
+        int count = 0;
+
+        /*  Allocation may remove this rank from `ranks`, so get the
+         *   next rank first.
+         */
+        rank = idset_next (ranks, rank);
+        if (n && (count = rlist_alloc_slots (rl,
+                                             n,
+                                             result,
+                                             cores_per_slot,
+                                             slots)) < 0)
+            return -1;
+        slots -= count;
+    }
+    return slots;
 }
 
 /*
  *  Allocate the first available N slots of size cores_per_slot from
- *   resource list rl after sorting the nodes with the current sort strategy.
+ *   resource list rl, visiting nodes in rank order.
  */
 static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
                                              int cores_per_slot,
                                              int slots)
 {
-    int rc;
-    struct idset *ids = NULL;
-    struct rnode *n = NULL;
     struct rlist *result = NULL;
 
-    zlistx_sort (rl->nodes);
+    if (!(result = rlist_create ()))
+        return NULL;
 
-    if (!(n = rlist_first (rl)))
+    /*  Only up nodes with available cores are in rl->avail_ranks
+     */
+    if (rlist_alloc_ranks (rl,
+                           rl->avail_ranks,
+                           result,
+                           cores_per_slot,
+                           slots) != 0) {
+        rlist_free (rl, result);
+        rlist_destroy (result);
+        errno = ENOSPC;
         return NULL;
+    }
+    return result;
+}
+
+/*
+ *  Allocate `slots` of size cores_per_slot from rlist `rl`, visiting
+ *   nodes by available cores ascending if `ascending` is true, otherwise
+ *   descending, and by rank for nodes with the same number of available
+ *   cores.  Nodes are found in rl->avail_index, so no sort is required.
+ */
+static struct rlist * rlist_alloc_by_avail (struct rlist *rl,
+                                            int cores_per_slot,
+                                            int slots,
+                                            bool ascending)
+{
+    int i;
+    struct rlist *result = NULL;
 
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 2. assign slots to first nodes where they fit
-     */
-    while (n && slots) {
-        /*  Try to allocate a slot on this node. If we fail with ENOSPC,
-         *   then advance to the next node and try again.
+    for (i = 0; i < rl->avail_index_size && slots > 0; i++) {
+        int avail = ascending ? i : rl->avail_index_size - 1 - i;
+
+        /*  A node moves to a lower bucket once allocated from, so it
+         *   is either not revisited, or no longer fits a slot.
          */
-        if ((rc = rlist_rnode_alloc (rl, n, cores_per_slot, &ids)) < 0) {
-            if (errno != ENOSPC)
-                goto unwind;
-            n = rlist_next (rl);
+        if (avail < cores_per_slot || !rl->avail_index[avail])
             continue;
-        }
-        /*  Append the allocated cores to the result set and continue
-         *   if needed
-         */
-        rc = rlist_append_cores (result, n->hostname, n->rank, ids);
-        idset_destroy (ids);
-        if (rc < 0)
-            goto unwind;
-        slots--;
+        if ((slots = rlist_alloc_ranks (rl,
+                                        rl->avail_index[avail],
+                                        result,
+                                        cores_per_slot,
+                                        slots)) < 0)
+            break;
     }
     if (slots != 0) {
-unwind:
         rlist_free (rl, result);
         rlist_destroy (result);
         errno = ENOSPC;
@@ -1425,49 +1702,56 @@ unwind:
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by smallest available first, so that
+ *   the result. Visits nodes with smallest available first, so that
  *   we get something like "best fit". (minimize nodes used)
  */
 static struct rlist * rlist_alloc_best_fit (struct rlist *rl,
                                             int cores_per_slot,
                                             int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_avail);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_by_avail (rl, cores_per_slot, slots, true);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by least utilized first, so that
+ *   the result. Visits least utilized nodes first, so that
  *   we get something like "worst fit". (Spread jobs across nodes)
  */
 static struct rlist * rlist_alloc_worst_fit (struct rlist *rl,
                                              int cores_per_slot,
                                              int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_used);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_by_avail (rl, cores_per_slot, slots, false);
 }
 
-
+/*  Get the first nnodes up nodes, least utilized first.
+ */
 static zlistx_t *rlist_get_nnodes (struct rlist *rl, int nnodes)
 {
-    struct rnode *n;
+    int i;
     zlistx_t *l = zlistx_new ();
     if (!l)
         return NULL;
-    n = zlistx_first (rl->nodes);
-    while (nnodes > 0) {
-        if (n == NULL) {
-            errno = ENOSPC;
-            goto err;
-        }
-        if (n->up) {
-            if (!zlistx_add_end (l, n))
-                goto err;
-            nnodes--;
+    for (i = rl->avail_index_size - 1; i >= 0 && nnodes > 0; i--) {
+        struct idset *ranks = rl->avail_index[i];
+        unsigned int rank;
+
+        if (!ranks)
+            continue;
+        rank = idset_first (ranks);
+        while (rank != IDSET_INVALID_ID && nnodes > 0) {
+            struct rnode *n = rlist_find_rank (rl, rank);
+            if (n) {
+                if (!zlistx_add_end (l, n))
+                    goto err;
+                nnodes--;
+            }
+            rank = idset_next (ranks, rank);
         }
-        n = zlistx_next (rl->nodes);
+    }
+    if (nnodes > 0) {
+        errno = ENOSPC;
+        goto err;
     }
     return (l);
 err:
@@ -1497,12 +1781,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 1. sort rank list by used cores ascending:
-     */
-    zlistx_set_comparator (rl->nodes, by_used);
-    zlistx_sort (rl->nodes);
-
-    /* 2. get a list of the first up n nodes
+    /* 1. get a list of the first up n nodes, by used cores ascending
      */
     if (!(cl = rlist_get_nnodes (rl, nnodes)))
         goto unwind;
@@ -1513,7 +1792,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     zlistx_set_comparator (cl, by_used);
 
     /*
-     * 3. divide slots across all nodes, placing each slot
+     * 2. divide slots across all nodes, placing each slot
      *    on most empty node first
      */
     while (slots > 0) {
@@ -1563,9 +1842,6 @@ static struct rlist *rlist_try_alloc (struct rlist *rl, const char *mode,
         return NULL;
     }
 
-    /*  Reset default sort to order nodes by "rank" */
-    zlistx_set_comparator (rl->nodes, by_rank);
-
     if (nnodes > 0)
         result = rlist_alloc_nnodes (rl, nnodes, cores_per_slot, slots);
     else if (mode == NULL || strcmp (mode, "worst-fit") == 0)
@@ -1642,6 +1918,7 @@ static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
         return -1;
     if (rnode->up)
         rl->avail += idset_count (n->cores->ids);
+    (void) rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -1655,6 +1932,7 @@ static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
     if (rnode_alloc_idset (rnode, n->cores->avail) < 0)
         return -1;
     rl->avail -= idset_count (n->cores->avail);
+    (void) rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -1739,6 +2017,7 @@ static int rlist_mark_all (struct rlist *rl, bool up)
         if (n->up != up)
             count += idset_count (n->cores->avail);
         n->up = up;
+        (void) rlist_index_update (rl, n);
         n = zlistx_next (rl->nodes);
     }
     return count;
@@ -1757,6 +2036,7 @@ static int rlist_mark_state (struct rlist *rl, bool up, const char *ids)
         if (n->up != up)
             count += idset_count (n->cores->avail);
         n->up = up;
+        (void) rlist_index_update (rl, n);
         i = idset_next (idset, i);
     }
     idset_destroy (idset);
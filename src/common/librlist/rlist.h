@@ -30,6 +30,15 @@ struct rlist {
     int avail;
     zlistx_t *nodes;
 
+    /*  rank => node index, and ranks of up nodes bucketed by number of
+     *   available cores (avail_index[n] contains nodes with n cores free).
+     *   avail_ranks is the set of up nodes with any cores free.
+     */
+    zhashx_t *rank_index;
+    struct idset **avail_index;
+    int avail_index_size;
+    struct idset *avail_ranks;
+
     /*  hash of resources to ignore on remap */
     zhashx_t *noremap;
 
@@ -53,6 +62,9 @@ int rlist_mark_down (struct rlist *rl, const char *ids);
  */
 int rlist_mark_up (struct rlist *rl, const char *ids);
 
+/*  Create a copy of rlist rl, including allocated and up/down state */
+struct rlist *rlist_copy (const struct rlist *rl);
+
 /*  Create a copy of rlist rl with all cores available */
 struct rlist *rlist_copy_empty (const struct rlist *rl);
 
@@ -22,26 +22,16 @@
 
 #include "rnode.h"
 
-static int idset_subtract (struct idset *from, struct idset *ids)
-{
-    unsigned int i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (from, i);
-        i = idset_next (ids, i);
-    }
-    return 0;
-}
-
-struct idset * idset_intersect (const struct idset *a,
-                                const struct idset *b)
+/*  Return a copy of 'ids' using the bitmap idset implementation, so that
+ *   set operations on resource children proceed a word at a time.
+ */
+static struct idset *idset_copy_bitmap (const struct idset *ids)
 {
-    unsigned int i;
-    struct idset *result = idset_create (0, IDSET_FLAG_AUTOGROW);
-    i = idset_first (b);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (a, i))
-            idset_set (result, i);
-        i = idset_next (b, i);
+    struct idset *result = idset_create (0, IDSET_FLAG_AUTOGROW
+                                          | IDSET_FLAG_BITMAP);
+    if (!result || idset_add (result, ids) < 0) {
+        idset_destroy (result);
+        return NULL;
     }
     return result;
 }
@@ -53,26 +43,16 @@ struct idset * idset_intersect (const struct idset *a,
 static struct idset * idset_add_set (const struct idset *set,
                                      const struct idset *new)
 {
-    unsigned int i;
-    struct idset *result = idset_copy (set);
+    struct idset *result = idset_union (set, new);
 
     if (!result)
         return NULL;
-
-    i = idset_first (new);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (result, i)) {
-            errno = EEXIST;
-            goto fail;
-        }
-        if (idset_set (result, i) < 0)
-            goto fail;
-        i = idset_next (new, i);
+    if (idset_count (result) != idset_count (set) + idset_count (new)) {
+        idset_destroy (result);
+        errno = EEXIST;
+        return NULL;
     }
     return result;
-fail:
-    idset_destroy (result);
-    return NULL;
 }
 
 void rnode_destroy (struct rnode *n)
@@ -105,8 +85,8 @@ static struct rnode_child *rnode_child_idset (const char *name,
     struct rnode_child *c = calloc (1, sizeof (*c));
     if (!(c->name = strdup (name)))
         return NULL;
-     if (!(c->ids = idset_copy (ids))
-        || !(c->avail = idset_copy (avail)))
+     if (!(c->ids = idset_copy_bitmap (ids))
+        || !(c->avail = idset_copy_bitmap (avail)))
         goto fail;
     return c;
 fail:
@@ -481,17 +461,24 @@ int rnode_alloc (struct rnode *n, int count, struct idset **setp)
         errno = ENOSPC;
         return -1;
     }
-    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW | IDSET_FLAG_BITMAP)))
         return -1;
     i = idset_first (n->cores->avail);
     while (count--) {
-        idset_set (ids, i);
-        idset_clear (n->cores->avail, i);
+        if (idset_set (ids, i) < 0)
+            goto error;
         i = idset_next (n->cores->avail, i);
     }
+    if (idset_subtract (n->cores->avail, ids) < 0)
+        goto error;
     if (setp != NULL)
         *setp = ids;
+    else
+        idset_destroy (ids);
     return (0);
+error:
+    idset_destroy (ids);
+    return -1;
 }
 
 /*
@@ -517,19 +504,13 @@ static bool alloc_ids_valid (struct rnode *n, struct idset *ids)
 
 int rnode_alloc_idset (struct rnode *n, struct idset *ids)
 {
-    unsigned int i;
     if (!ids) {
         errno = EINVAL;
         return -1;
     }
     if (!alloc_ids_valid (n, ids))
         return -1;
-    i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (n->cores->avail, i);
-        i = idset_next (ids, i);
-    }
-    return 0;
+    return idset_subtract (n->cores->avail, ids);
 }
 
 /*
@@ -555,19 +536,13 @@ static bool free_ids_valid (struct rnode *n, struct idset *ids)
 
 int rnode_free_idset (struct rnode *n, struct idset *ids)
 {
-    unsigned int i;
     if (!ids) {
         errno = EINVAL;
         return -1;
     }
     if (!free_ids_valid (n, ids))
         return -1;
-    i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_set (n->cores->avail, i);
-        i = idset_next (ids, i);
-    }
-    return 0;
+    return idset_add (n->cores->avail, ids);
 }
 
 int rnode_free (struct rnode *n, const char *s)
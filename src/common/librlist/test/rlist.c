@@ -163,6 +163,24 @@ struct rlist_test_entry test_6n_4c[] = {
       "rank[0-2]/core[0-3] rank3/core[0-1]",
       "rank3/core[2-3] rank[4-5]/core[0-3]",
       0, false },
+    { "best-fit: down rank is skipped",              "best-fit", "3",
+      { 0, 1, 2 },
+      "rank4/core[0-1]",
+      "rank[0-2]/core[0-3] rank[3-4]/core[0-1]",
+      NULL,
+      0, false },
+    { "first-fit: down rank is skipped",            "first-fit", "3",
+      { 0, 1, 1 },
+      "rank4/core2",
+      "rank[0-2]/core[0-3] rank3/core[0-1] rank4/core[0-2]",
+      NULL,
+      0, false },
+    { "worst-fit: alloc 1 core lands on empty rank", "worst-fit", NULL,
+      { 0, 1, 1 },
+      "rank5/core0",
+      "rank[0-2]/core[0-3] rank3/core[0-1] rank4/core[0-2] rank5/core0",
+      "rank3/core[2-3] rank4/core3 rank5/core[1-3]",
+      0, false },
     RLIST_TEST_END,
 };
 
@@ -735,6 +753,51 @@ static void test_updown ()
     rlist_destroy (rl2);
 }
 
+static void test_copy ()
+{
+    struct rlist *rl = NULL;
+    struct rlist *alloc = NULL;
+    struct rlist *copy = NULL;
+    struct rlist *down = NULL;
+    struct rlist *allocated = NULL;
+    char *result = NULL;
+    char *R = R_create ("0-3", "0-3", NULL, "host[0-3]");
+    if (!(rl = rlist_from_R (R)))
+        BAIL_OUT ("rlist_from_R failed");
+    free (R);
+
+    if (rlist_mark_down (rl, "3") < 0)
+        BAIL_OUT ("rlist_mark_down failed");
+    if (!(alloc = rlist_alloc (rl, "first-fit", 0, 1, 2)))
+        BAIL_OUT ("rlist_alloc failed");
+
+    copy = rlist_copy (rl);
+    ok (copy != NULL,
+        "rlist_copy works");
+    ok (copy->total == rl->total && copy->avail == rl->avail,
+        "rlist_copy: total=%d avail=%d", copy->total, copy->avail);
+    if (!(down = rlist_copy_down (copy))
+        || !(allocated = rlist_copy_allocated (copy)))
+        BAIL_OUT ("rlist_copy_down/allocated failed");
+    ok (rlist_nnodes (down) == 1,
+        "rlist_copy preserves down ranks");
+    result = rlist_dumps (allocated);
+    is (result, "rank0/core[0-1]",
+        "rlist_copy preserves allocated resources");
+    free (result);
+    rlist_destroy (down);
+    rlist_destroy (allocated);
+
+    ok (rlist_free (copy, alloc) == 0,
+        "rlist_free of original allocation works on copy");
+    ok (copy->avail == 12 && rl->avail == 10,
+        "freeing from copy does not affect original");
+
+    rlist_destroy (copy);
+    rlist_destroy (alloc);
+    rlist_destroy (rl);
+}
+
 struct append_test {
     const char *ranksa;
     const char *coresa;
@@ -1550,6 +1613,7 @@ int main (int ac, char *av[])
     test_issue2202 ();
     test_issue2473 ();
     test_updown ();
+    test_copy ();
     test_append ();
     test_diff ();
     test_union ();
@@ -11,6 +11,8 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <stdlib.h>
+#include <string.h>
 #include <flux/core.h>
 #include <jansson.h>
 
@@ -18,30 +20,43 @@
 #include "init.h"
 #include "alloc.h"
 
-static int schedutil_alloc_respond (flux_t *h, const flux_msg_t *msg,
+static int schedutil_alloc_respond (schedutil_t *util, const flux_msg_t *msg,
                                     int type, const char *note,
-                                    json_t *annotations)
+                                    json_t *annotations, const char *R)
 {
     flux_jobid_t id;
-    int rc;
+    json_t *o;
+    int rc = -1;
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
         return -1;
-    if (annotations)
-        rc = flux_respond_pack (h, msg, "{s:I s:i s:O}",
-                                        "id", id,
-                                        "type", type,
-                                        "annotations", annotations);
-    else if (note)
-        rc = flux_respond_pack (h, msg, "{s:I s:i s:s}",
-                                        "id", id,
-                                        "type", type,
-                                        "note", note);
+    if (!(o = json_pack ("{s:I s:i}", "id", id, "type", type)))
+        goto nomem;
+    if (annotations) {
+        if (json_object_set (o, "annotations", annotations) < 0)
+            goto nomem;
+    }
+    else if (note) {
+        if (json_object_set_new (o, "note", json_string (note)) < 0)
+            goto nomem;
+    }
+    /* R is included so the job manager can hand it back in sched.free
+     * and sched-hello without a KVS lookup on the scheduler side.
+     */
+    if (R) {
+        if (json_object_set_new (o, "R", json_string (R)) < 0)
+            goto nomem;
+    }
+    if (schedutil_batch_member (msg))
+        rc = schedutil_batch_respond (util, msg, o);
     else
-        rc = flux_respond_pack (h, msg, "{s:I s:i}",
-                                        "id", id,
-                                        "type", type);
+        rc = flux_respond_pack (util->h, msg, "O", o);
+    json_decref (o);
     return rc;
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return -1;
 }
 
 int schedutil_alloc_respond_annotate_pack (schedutil_t *util,
@@ -57,8 +72,8 @@ int schedutil_alloc_respond_annotate_pack (schedutil_t *util,
         errno = EINVAL;
         goto error;
     }
-    rc = schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_ANNOTATE,
-                                  NULL, o);
+    rc = schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_ANNOTATE,
+                                  NULL, o, NULL);
 error:
     va_end (ap);
     json_decref (o);
@@ -68,86 +83,242 @@ error:
 int schedutil_alloc_respond_deny (schedutil_t *util, const flux_msg_t *msg,
                                   const char *note)
 {
-    return schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_DENY,
-                                    note, NULL);
+    return schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_DENY,
+                                    note, NULL, NULL);
 }
 
 int schedutil_alloc_respond_cancel (schedutil_t *util, const flux_msg_t *msg)
 {
-    return schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_CANCEL,
-                                    NULL, NULL);
+    return schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_CANCEL,
+                                    NULL, NULL, NULL);
 }
 
+/* R for allocations made in the same reactor iteration is written to the
+ * KVS in a single commit, started from a prepare watcher.  The success
+ * responses are sent, in order, once that commit completes.
+ *
+ * If the commit fails, each job in the batch gets a fatal exception, and
+ * then its success response with R, so that the job manager cleans up
+ * the job and returns R to the scheduler with sched.free.
+ */
 struct alloc {
+    flux_jobid_t id;
+    char *R;
     json_t *annotations;
     const flux_msg_t *msg;
+};
+
+struct alloc_batch {
     flux_kvs_txn_t *txn;
+    zlistx_t *allocs;
 };
 
 static void alloc_destroy (struct alloc *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
-        flux_kvs_txn_destroy (ctx->txn);
         flux_msg_decref (ctx->msg);
         json_decref (ctx->annotations);
+        free (ctx->R);
         free (ctx);
         errno = saved_errno;
     }
 }
 
-static struct alloc *alloc_create (const flux_msg_t *msg, const char *R,
+/* zlistx_destructor_fn footprint */
+static void alloc_destructor (void **item)
+{
+    if (*item) {
+        alloc_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct alloc *alloc_create (const flux_msg_t *msg,
+                                   flux_jobid_t id,
+                                   const char *R,
                                    const char *fmt, va_list ap)
 {
     struct alloc *ctx;
-    flux_jobid_t id;
-    char key[64];
 
-    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
-        return NULL;
-    if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
-        errno = EINVAL;
-        return NULL;
-    }
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
+    ctx->id = id;
     ctx->msg = flux_msg_incref (msg);
+    if (!(ctx->R = strdup (R)))
+        goto error;
     if (fmt) {
-        if (!(ctx->annotations = json_vpack_ex (NULL, 0, fmt, ap)))
+        if (!(ctx->annotations = json_vpack_ex (NULL, 0, fmt, ap))) {
+            errno = EINVAL;
             goto error;
+        }
     }
-    if (!(ctx->txn = flux_kvs_txn_create ()))
-        goto error;
-    if (flux_kvs_txn_put (ctx->txn, 0, key, R) < 0)
-        goto error;
     return ctx;
 error:
     alloc_destroy (ctx);
     return NULL;
 }
 
+static void alloc_batch_destroy (struct alloc_batch *batch)
+{
+    if (batch) {
+        int saved_errno = errno;
+        flux_kvs_txn_destroy (batch->txn);
+        zlistx_destroy (&batch->allocs);
+        free (batch);
+        errno = saved_errno;
+    }
+}
+
+static struct alloc_batch *alloc_batch_create (void)
+{
+    struct alloc_batch *batch;
+
+    if (!(batch = calloc (1, sizeof (*batch))))
+        return NULL;
+    if (!(batch->txn = flux_kvs_txn_create ()))
+        goto error;
+    if (!(batch->allocs = zlistx_new ()))
+        goto nomem;
+    zlistx_set_destructor (batch->allocs, alloc_destructor);
+    return batch;
+nomem:
+    errno = ENOMEM;
+error:
+    alloc_batch_destroy (batch);
+    return NULL;
+}
+
+static void raise_continuation (flux_future_t *f, void *arg)
+{
+    schedutil_t *util = arg;
+
+    schedutil_remove_outstanding_future (util, f);
+    if (flux_future_get (f, NULL) < 0)
+        flux_log_error (util->h, "alloc: error raising job exception");
+    flux_future_destroy (f);
+}
+
+/* Respond to alloc request 'ctx->msg' with R, caching R for sched.free.
+ */
+static void alloc_respond_R (schedutil_t *util, struct alloc *ctx)
+{
+    if (schedutil_R_cache_insert (util, ctx->id, ctx->R) < 0)
+        flux_log_error (util->h, "alloc: error caching R for id=%ju",
+                        (uintmax_t)ctx->id);
+    if (schedutil_alloc_respond (util, ctx->msg, FLUX_SCHED_ALLOC_SUCCESS,
+                                 NULL, ctx->annotations, ctx->R) < 0)
+        flux_log_error (util->h, "alloc response for id=%ju",
+                        (uintmax_t)ctx->id);
+}
+
+/* R of the jobs in 'batch' could not be committed, with 'errnum'.
+ * Raise a fatal exception on each job before responding, so the job
+ * does not run, and its resources are freed through sched.free.
+ */
+static void alloc_batch_fail (schedutil_t *util,
+                              struct alloc_batch *batch,
+                              int errnum)
+{
+    struct alloc *ctx;
+    char note[128];
+
+    (void)snprintf (note, sizeof (note),
+                    "scheduler failed to commit R: %s",
+                    flux_strerror (errnum));
+    ctx = zlistx_first (batch->allocs);
+    while (ctx) {
+        flux_future_t *f;
+
+        if (!(f = flux_job_raise (util->h, ctx->id, "alloc", 0, note))
+            || flux_future_then (f, -1, raise_continuation, util) < 0) {
+            flux_log_error (util->h, "alloc: error raising exception on id=%ju",
+                            (uintmax_t)ctx->id);
+            flux_future_destroy (f);
+        }
+        else if (schedutil_add_outstanding_future (util, f) < 0)
+            flux_log_error (util->h, "alloc: unable to add outstanding future");
+        alloc_respond_R (util, ctx);
+        ctx = zlistx_next (batch->allocs);
+    }
+}
+
 static void alloc_continuation (flux_future_t *f, void *arg)
 {
     schedutil_t *util = arg;
-    flux_t *h = util->h;
-    struct alloc *ctx = flux_future_aux_get (f, "flux::alloc_ctx");
+    struct alloc_batch *batch = flux_future_aux_get (f, "flux::alloc_batch");
+    struct alloc *ctx;
 
+    schedutil_remove_outstanding_future (util, f);
     if (flux_future_get (f, NULL) < 0) {
-        flux_log_error (h, "commit R");
-        goto error;
+        flux_log_error (util->h, "commit R");
+        alloc_batch_fail (util, batch, errno);
+        flux_future_destroy (f);
+        return;
     }
-    schedutil_remove_outstanding_future (util, f);
-    if (schedutil_alloc_respond (h, ctx->msg, FLUX_SCHED_ALLOC_SUCCESS,
-                                 NULL, ctx->annotations) < 0) {
-        flux_log_error (h, "alloc response");
-        goto error;
+    ctx = zlistx_first (batch->allocs);
+    while (ctx) {
+        alloc_respond_R (util, ctx);
+        ctx = zlistx_next (batch->allocs);
     }
     flux_future_destroy (f);
+}
+
+static void alloc_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    schedutil_t *util = arg;
+    struct alloc_batch *batch = util->alloc_batch;
+    flux_future_t *f;
+
+    flux_watcher_stop (w);
+    util->alloc_batch = NULL;
+    if (!batch || zlistx_size (batch->allocs) == 0) {
+        alloc_batch_destroy (batch);
+        return;
+    }
+    if (!(f = flux_kvs_commit (util->h, NULL, 0, batch->txn)))
+        goto error;
+    if (flux_future_aux_set (f, "flux::alloc_batch",
+                             batch, (flux_free_f)alloc_batch_destroy) < 0) {
+        flux_future_destroy (f);
+        goto error;
+    }
+    if (flux_future_then (f, -1, alloc_continuation, util) < 0) {
+        flux_log_error (util->h, "commit R");
+        alloc_batch_fail (util, batch, errno);
+        flux_future_destroy (f); // destroys batch
+        return;
+    }
+    schedutil_add_outstanding_future (util, f);
     return;
 error:
-    flux_reactor_stop_error (flux_get_reactor (h)); // XXX
-    alloc_destroy (ctx);
-    flux_future_destroy (f);
+    flux_log_error (util->h, "commit R");
+    alloc_batch_fail (util, batch, errno);
+    alloc_batch_destroy (batch);
+}
+
+int schedutil_alloc_batch_init (schedutil_t *util)
+{
+    flux_reactor_t *r = flux_get_reactor (util->h);
+
+    if (!r)
+        return -1;
+    if (!(util->alloc_prep = flux_prepare_watcher_create (r,
+                                                          alloc_prep_cb,
+                                                          util)))
+        return -1;
+    return 0;
+}
+
+void schedutil_alloc_batch_cleanup (schedutil_t *util)
+{
+    flux_watcher_destroy (util->alloc_prep);
+    util->alloc_prep = NULL;
+    alloc_batch_destroy (util->alloc_batch);
+    util->alloc_batch = NULL;
 }
 
 int schedutil_alloc_respond_success_pack (schedutil_t *util,
@@ -156,28 +327,38 @@ int schedutil_alloc_respond_success_pack (schedutil_t *util,
                                           const char *fmt, ...)
 {
     struct alloc *ctx;
-    flux_future_t *f;
-    flux_t *h = util->h;
+    flux_jobid_t id;
+    char key[64];
     va_list ap;
 
+    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
+        return -1;
+    if (!R || flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
+        errno = EINVAL;
+        return -1;
+    }
     va_start (ap, fmt);
-    ctx = alloc_create (msg, R, fmt, ap);
+    ctx = alloc_create (msg, id, R, fmt, ap);
     va_end (ap);
     if (!ctx)
         return -1;
-    if (!(f = flux_kvs_commit (h, NULL, 0, ctx->txn)))
+    if (!util->alloc_batch) {
+        if (!(util->alloc_batch = alloc_batch_create ()))
+            goto error;
+        flux_watcher_start (util->alloc_prep);
+    }
+    /* N.B. a failed put leaves the transaction unmodified, so a bad R
+     * fails only this job and not the others in the batch.
+     */
+    if (flux_kvs_txn_put (util->alloc_batch->txn, 0, key, R) < 0)
         goto error;
-    if (flux_future_aux_set (f, "flux::alloc_ctx",
-                             ctx, (flux_free_f)alloc_destroy) < 0) {
+    if (!zlistx_add_end (util->alloc_batch->allocs, ctx)) {
+        errno = ENOMEM;
         goto error;
     }
-    if (flux_future_then (f, -1, alloc_continuation, util) < 0)
-        goto error;
-    schedutil_add_outstanding_future (util, f);
     return 0;
 error:
     alloc_destroy (ctx);
-    flux_future_destroy (f);
     return -1;
 }
 
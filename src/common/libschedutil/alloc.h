@@ -45,6 +45,8 @@ int schedutil_alloc_respond_deny (schedutil_t *util, const flux_msg_t *msg,
 
 /* Respond to alloc request message - success, allocate R.
  * R is committed to the KVS first, then the response is sent.
+ * R from all successful allocations made in the same reactor iteration is
+ * committed together, so responses are deferred until the reactor runs.
  * If something goes wrong after this function returns, the reactor is stopped.
  */
 int schedutil_alloc_respond_success_pack (schedutil_t *util,
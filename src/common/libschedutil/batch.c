@@ -0,0 +1,192 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* batch.c - batched sched.alloc and sched.free messages
+ *
+ * If the scheduler sets SCHEDUTIL_BATCH and the job manager agrees in
+ * sched-ready, a sched.alloc or sched.free request may carry a "jobs"
+ * array instead of a single job.  Each entry is split into a copy of
+ * the request (so it keeps the original route) and passed to the
+ * scheduler callbacks as though it had been sent alone.
+ *
+ * Responses to these per-job messages are collected and sent once per
+ * reactor loop iteration as a single response with a "jobs" array.
+ * Error responses are not batched; they go out individually.  If the
+ * batched response cannot be sent, each job's response is retried alone,
+ * so a failure affects only the jobs whose responses cannot be sent.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "schedutil_private.h"
+#include "init.h"
+
+static const char *batch_auxkey = "schedutil::batch";
+
+bool schedutil_batch_member (const flux_msg_t *msg)
+{
+    return flux_msg_aux_get (msg, batch_auxkey) ? true : false;
+}
+
+int schedutil_batch_foreach (schedutil_t *util,
+                             const flux_msg_t *msg,
+                             schedutil_batch_f fn)
+{
+    json_t *jobs = NULL;
+    size_t index;
+    json_t *entry;
+
+    if (flux_request_unpack (msg, NULL, "{s?:o}", "jobs", &jobs) < 0)
+        return -1;
+    if (!jobs) {
+        fn (util, msg);
+        return 0;
+    }
+    if (!json_is_array (jobs)) {
+        errno = EPROTO;
+        return -1;
+    }
+    json_array_foreach (jobs, index, entry) {
+        flux_msg_t *m;
+
+        if (!(m = flux_msg_copy (msg, false)))
+            return -1;
+        if (flux_msg_pack (m, "O", entry) < 0
+            || flux_msg_aux_set (m, batch_auxkey, util, NULL) < 0) {
+            flux_msg_destroy (m);
+            return -1;
+        }
+        fn (util, m);
+        flux_msg_decref (m);
+    }
+    return 0;
+}
+
+int schedutil_batch_respond (schedutil_t *util,
+                             const flux_msg_t *msg,
+                             json_t *o)
+{
+    const char *topic;
+    json_t **jobs;
+    const flux_msg_t **reply;
+
+    if (flux_msg_get_topic (msg, &topic) < 0)
+        return -1;
+    if (!strcmp (topic, "sched.alloc")) {
+        jobs = &util->alloc_responses;
+        reply = &util->alloc_reply;
+    }
+    else if (!strcmp (topic, "sched.free")) {
+        jobs = &util->free_responses;
+        reply = &util->free_reply;
+    }
+    else {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!*jobs && !(*jobs = json_array ()))
+        goto nomem;
+    if (json_array_append (*jobs, o) < 0)
+        goto nomem;
+    if (!*reply)
+        *reply = flux_msg_incref (msg);
+    flux_watcher_start (util->batch_prep);
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Send the responses in 'jobs' to 'reply' individually, after the
+ * batched response failed.  Log the jobs whose response is lost.
+ */
+static void batch_respond_each (schedutil_t *util,
+                                const char *name,
+                                json_t *jobs,
+                                const flux_msg_t *reply)
+{
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach (jobs, index, entry) {
+        if (flux_respond_pack (util->h, reply, "O", entry) < 0) {
+            json_int_t id = 0;
+
+            (void)json_unpack (entry, "{s:I}", "id", &id);
+            flux_log_error (util->h, "%s response for id=%ju",
+                            name, (uintmax_t)id);
+        }
+    }
+}
+
+static void batch_flush (schedutil_t *util,
+                         const char *name,
+                         json_t **jobs,
+                         const flux_msg_t **reply)
+{
+    if (*jobs && json_array_size (*jobs) > 0) {
+        if (flux_respond_pack (util->h, *reply, "{s:O}", "jobs", *jobs) < 0) {
+            flux_log_error (util->h, "batched %s response", name);
+            batch_respond_each (util, name, *jobs, *reply);
+        }
+    }
+    json_decref (*jobs);
+    *jobs = NULL;
+    flux_msg_decref (*reply);
+    *reply = NULL;
+}
+
+static void batch_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    schedutil_t *util = arg;
+
+    flux_watcher_stop (w);
+    batch_flush (util, "alloc", &util->alloc_responses, &util->alloc_reply);
+    batch_flush (util, "free", &util->free_responses, &util->free_reply);
+}
+
+int schedutil_batch_init (schedutil_t *util)
+{
+    flux_reactor_t *r = flux_get_reactor (util->h);
+
+    if (!r)
+        return -1;
+    if (!(util->batch_prep = flux_prepare_watcher_create (r,
+                                                          batch_prep_cb,
+                                                          util)))
+        return -1;
+    return 0;
+}
+
+void schedutil_batch_cleanup (schedutil_t *util)
+{
+    flux_watcher_destroy (util->batch_prep);
+    util->batch_prep = NULL;
+    json_decref (util->alloc_responses);
+    util->alloc_responses = NULL;
+    flux_msg_decref (util->alloc_reply);
+    util->alloc_reply = NULL;
+    json_decref (util->free_responses);
+    util->free_responses = NULL;
+    flux_msg_decref (util->free_reply);
+    util->free_reply = NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
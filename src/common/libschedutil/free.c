@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "schedutil_private.h"
 #include "init.h"
@@ -20,10 +21,20 @@
 int schedutil_free_respond (schedutil_t *util, const flux_msg_t *msg)
 {
     flux_jobid_t id;
+    json_t *o;
+    int rc;
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
         return -1;
-    return flux_respond_pack (util->h, msg, "{s:I}", "id", id);
+    if (!schedutil_batch_member (msg))
+        return flux_respond_pack (util->h, msg, "{s:I}", "id", id);
+    if (!(o = json_pack ("{s:I}", "id", id))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    rc = schedutil_batch_respond (util, msg, o);
+    json_decref (o);
+    return rc;
 }
 
 /*
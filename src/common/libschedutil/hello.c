@@ -23,18 +23,25 @@ static int schedutil_hello_job (schedutil_t *util,
 {
     char key[64];
     flux_future_t *f = NULL;
-    const char *R;
+    const char *R = NULL;
     flux_jobid_t id;
 
-    if (flux_msg_unpack (msg, "{s:I}", "id", &id) < 0)
-        goto error;
-    if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
-        errno = EPROTO;
+    if (flux_msg_unpack (msg, "{s:I s?:s}", "id", &id, "R", &R) < 0)
         goto error;
+    /* Older job managers, or one that could not recover R on restart,
+     * may not send R.
+     */
+    if (!R) {
+        if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!(f = flux_kvs_lookup (util->h, NULL, 0, key)))
+            goto error;
+        if (flux_kvs_lookup_get (f, &R) < 0)
+            goto error;
     }
-    if (!(f = flux_kvs_lookup (util->h, NULL, 0, key)))
-        goto error;
-    if (flux_kvs_lookup_get (f, &R) < 0)
+    if (schedutil_R_cache_insert (util, id, R) < 0)
         goto error;
     if (util->ops->hello (util->h,
                           msg,
@@ -50,15 +57,117 @@ error:
     return -1;
 }
 
+/* Pass each job in the sched-snapshot response to ops->hello as if it
+ * had arrived in a sched-hello response.
+ */
+static int schedutil_hello_each (schedutil_t *util,
+                                 const flux_msg_t *msg,
+                                 json_t *jobs)
+{
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach (jobs, index, entry) {
+        flux_msg_t *cpy;
+        int rc;
+
+        if (!(cpy = flux_msg_copy (msg, false)))
+            return -1;
+        if ((rc = flux_msg_pack (cpy, "O", entry)) == 0)
+            rc = schedutil_hello_job (util, cpy);
+        flux_msg_destroy (cpy);
+        if (rc < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Pass the union of R for all jobs to ops->hello_snapshot.
+ */
+static int schedutil_hello_all (schedutil_t *util,
+                                const flux_msg_t *msg,
+                                json_t *R,
+                                json_t *jobs)
+{
+    size_t index;
+    json_t *entry;
+    char *s;
+    int rc;
+
+    json_array_foreach (jobs, index, entry) {
+        flux_jobid_t id;
+        const char *jobR;
+
+        if (json_unpack (entry, "{s:I s:s}", "id", &id, "R", &jobR) < 0) {
+            errno = EPROTO;
+            return -1;
+        }
+        if (schedutil_R_cache_insert (util, id, jobR) < 0)
+            return -1;
+    }
+    if (!(s = json_dumps (R, JSON_COMPACT))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    rc = util->ops->hello_snapshot (util->h, msg, s, util->cb_arg);
+    free (s);
+    return rc;
+}
+
+/* Fetch all allocated jobs in one sched-snapshot RPC.
+ * Return 1 if the job-manager cannot provide a snapshot, so the caller
+ * should fall back to sched-hello.
+ */
+static int schedutil_hello_snapshot (schedutil_t *util)
+{
+    flux_future_t *f;
+    const flux_msg_t *msg;
+    json_t *R;
+    json_t *jobs;
+    int rc = -1;
+
+    if (!(f = flux_rpc (util->h, "job-manager.sched-snapshot",
+                        NULL, FLUX_NODEID_ANY, 0)))
+        return -1;
+    if (flux_future_get (f, (const void **)&msg) < 0) {
+        if (errno == ENOSYS || errno == EAGAIN) {
+            flux_log (util->h, LOG_DEBUG, "hello: snapshot unavailable: %s",
+                      future_strerror (f, errno));
+            rc = 1;
+        }
+        goto done;
+    }
+    if (flux_msg_unpack (msg, "{s:o s:o}", "R", &R, "jobs", &jobs) < 0)
+        goto done;
+    if (!json_is_array (jobs)) {
+        errno = EPROTO;
+        goto done;
+    }
+    if (util->ops->hello_snapshot)
+        rc = schedutil_hello_all (util, msg, R, jobs);
+    else
+        rc = schedutil_hello_each (util, msg, jobs);
+done:
+    flux_future_destroy (f);
+    return rc;
+}
+
 int schedutil_hello (schedutil_t *util)
 {
     flux_future_t *f;
     int rc = -1;
 
-    if (!util || !util->ops->hello) {
+    if (!util || (!util->ops->hello && !util->ops->hello_snapshot)) {
         errno = EINVAL;
         return -1;
     }
+    if ((rc = schedutil_hello_snapshot (util)) <= 0)
+        return rc;
+    if (!util->ops->hello) {
+        errno = ENOSYS;
+        return -1;
+    }
+    rc = -1;
     if (!(f = flux_rpc (util->h, "job-manager.sched-hello",
                         NULL, FLUX_NODEID_ANY, FLUX_RPC_STREAMING)))
         return -1;
@@ -21,8 +21,11 @@ extern "C" {
 
 /* Send hello announcement to job-manager.
  * The job-manager responds with a list of jobs that have resources assigned.
- * This function looks up R for each job and passes R + metadata to
- * ops->hello callback.
+ * This function passes the union of R for all jobs to ops->hello_snapshot,
+ * if set, or R + metadata for each job to ops->hello callback.  R is
+ * taken from a single sched-snapshot response if the job-manager supports
+ * it, otherwise from the sched-hello stream, looking up R in the KVS if
+ * the job-manager did not send it.
  */
 int schedutil_hello (schedutil_t *util);
 
@@ -10,6 +10,8 @@
 
 #include <czmq.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <flux/core.h>
 
 #include "src/common/libutil/aux.h"
@@ -17,6 +19,40 @@
 #include "init.h"
 #include "schedutil_private.h"
 
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+static size_t id_hasher (const void *key)
+{
+    const flux_jobid_t *id = key;
+    return *id;
+}
+
+static int id_comparator (const void *key1, const void *key2)
+{
+    const flux_jobid_t *id1 = key1;
+    const flux_jobid_t *id2 = key2;
+
+    return NUMCMP (*id1, *id2);
+}
+
+static void *id_duplicator (const void *key)
+{
+    flux_jobid_t *id;
+
+    if ((id = malloc (sizeof (*id))))
+        *id = *(const flux_jobid_t *)key;
+    return id;
+}
+
+/* free key or R string - zhashx_destructor_fn footprint */
+static void free_destructor (void **item)
+{
+    if (*item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
 /* destroy future - zlistx_dsetructor_t footprint */
 static void future_destructor (void **item)
 {
@@ -53,11 +89,23 @@ schedutil_t *schedutil_create (flux_t *h,
     if (!(util->outstanding_futures = zlistx_new ()))
         goto error;
     zlistx_set_destructor (util->outstanding_futures, future_destructor);
+    if (!(util->R_cache = zhashx_new ()))
+        goto nomem;
+    zhashx_set_key_hasher (util->R_cache, id_hasher);
+    zhashx_set_key_comparator (util->R_cache, id_comparator);
+    zhashx_set_key_duplicator (util->R_cache, id_duplicator);
+    zhashx_set_key_destructor (util->R_cache, free_destructor);
+    zhashx_set_destructor (util->R_cache, free_destructor);
+    if (schedutil_alloc_batch_init (util) < 0)
+        goto error;
+    if (schedutil_batch_init (util) < 0)
+        goto error;
     if (schedutil_ops_register (util) < 0)
         goto error;
 
     return util;
-
+nomem:
+    errno = ENOMEM;
 error:
     schedutil_destroy (util);
     return NULL;
@@ -67,7 +115,10 @@ void schedutil_destroy (schedutil_t *util)
 {
     if (util) {
         int saved_errno = errno;
+        schedutil_alloc_batch_cleanup (util);
+        schedutil_batch_cleanup (util);
         zlistx_destroy (&util->outstanding_futures);
+        zhashx_destroy (&util->R_cache);
         schedutil_ops_unregister (util);
         free (util);
         errno = saved_errno;
@@ -90,6 +141,30 @@ int schedutil_remove_outstanding_future (schedutil_t *util, flux_future_t *fut)
     return 0;
 }
 
+int schedutil_R_cache_insert (schedutil_t *util,
+                              flux_jobid_t id,
+                              const char *R)
+{
+    char *cpy;
+
+    if (util->flags & SCHEDUTIL_FREE_NOLOOKUP)
+        return 0;
+    if (!(cpy = strdup (R)))
+        return -1;
+    zhashx_update (util->R_cache, &id, cpy);
+    return 0;
+}
+
+const char *schedutil_R_cache_lookup (schedutil_t *util, flux_jobid_t id)
+{
+    return zhashx_lookup (util->R_cache, &id);
+}
+
+void schedutil_R_cache_remove (schedutil_t *util, flux_jobid_t id)
+{
+    zhashx_delete (util->R_cache, &id);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
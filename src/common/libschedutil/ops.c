@@ -20,6 +20,11 @@
 #include "init.h"
 #include "ops.h"
 
+static void alloc_one (schedutil_t *util, const flux_msg_t *msg)
+{
+    util->ops->alloc (util->h, msg, util->cb_arg);
+}
+
 static void alloc_cb (flux_t *h, flux_msg_handler_t *mh,
                       const flux_msg_t *msg, void *arg)
 {
@@ -27,7 +32,8 @@ static void alloc_cb (flux_t *h, flux_msg_handler_t *mh,
 
     assert (util);
 
-    util->ops->alloc (h, msg, util->cb_arg);
+    if (schedutil_batch_foreach (util, msg, alloc_one) < 0)
+        flux_log_error (h, "sched.alloc: error unpacking batch");
 }
 
 static void cancel_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -63,23 +69,31 @@ error:
     flux_future_destroy (f);
 }
 
-static void free_cb (flux_t *h, flux_msg_handler_t *mh,
-                     const flux_msg_t *msg, void *arg)
+static void free_one (schedutil_t *util, const flux_msg_t *msg)
 {
-    schedutil_t *util = arg;
+    flux_t *h = util->h;
     flux_jobid_t id;
+    const char *R = NULL;
     flux_future_t *f;
     char key[64];
 
-    assert (util);
-
     if (util->flags & SCHEDUTIL_FREE_NOLOOKUP) {
         util->ops->free (h, msg, NULL, util->cb_arg);
         return;
     }
 
-    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
+    if (flux_request_unpack (msg, NULL, "{s:I s?:s}",
+                                        "id", &id,
+                                        "R", &R) < 0)
         goto error;
+    /* Prefer R sent by the job manager, then R cached at alloc/hello time.
+     * Only fall back to a KVS lookup if neither is available.
+     */
+    if (R || (R = schedutil_R_cache_lookup (util, id))) {
+        util->ops->free (h, msg, R, util->cb_arg);
+        schedutil_R_cache_remove (util, id);
+        return;
+    }
     if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
         errno = EPROTO;
         goto error;
@@ -107,6 +121,20 @@ error:
         flux_log_error (h, "sched.free respond_error");
 }
 
+static void free_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    schedutil_t *util = arg;
+
+    assert (util);
+
+    if (schedutil_batch_foreach (util, msg, free_one) < 0) {
+        flux_log_error (h, "sched.free: error unpacking batch");
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "sched.free respond_error");
+    }
+}
+
 static void prioritize_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
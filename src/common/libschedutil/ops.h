@@ -20,6 +20,10 @@ extern "C" {
 /* In the following callbacks, 'msg' is a request or response message from
  * the job manager with payload defined by RFC 27.  The message's reference
  * count is decremented when the callback returns.
+ *
+ * If SCHEDUTIL_BATCH is set, alloc and free request messages may have been
+ * split out of a batched request.  Respond to those only with the schedutil
+ * functions (or flux_respond_error()) so that responses are batched too.
  */
 struct schedutil_ops {
     /* Callback for ingesting R + metadata for jobs that have resources
@@ -39,16 +43,18 @@ struct schedutil_ops {
                   const flux_msg_t *msg,
                   void *arg);
 
-    /* Callback for a free request.  R is looked up as a convenience.
+    /* Callback for a free request.  R is provided as a convenience.
+     * It is taken from the request if the job manager included it,
+     * otherwise from R cached at alloc or hello time, and only then
+     * looked up in the KVS.
      * 'msg' and 'R' are only valid for the duration of this call.
      * You should either respond to the request immediately (see
      * free.h), or cache this information for later response.
      *
      * If R is unneeded, it is recommended that the
      * SCHEDUTIL_FREE_NOLOOKUP flag be set in schedutil_create().  By
-     * setting this flag, R will not be looked up, saving a KVS lookup
-     * on every invocation of this callback.  R will be set to NULL
-     * instead.
+     * setting this flag, R will not be cached or looked up, and R will
+     * be set to NULL instead.
      */
     void (*free)(flux_t *h,
                  const flux_msg_t *msg,
@@ -71,6 +77,20 @@ struct schedutil_ops {
     void (*prioritize)(flux_t *h,
                        const flux_msg_t *msg,
                        void *arg);
+
+    /* Optional callback for ingesting resources of all jobs that have
+     * them at once.  'R' is the union of R for those jobs, and 'msg' is
+     * the job manager's sched-snapshot response, which lists the jobs
+     * with their R in "jobs", and the pending queue in "pending".
+     * If set, it is called instead of hello unless the job manager
+     * cannot provide a snapshot.  Alloc requests for pending jobs are
+     * still sent after schedutil_ready().
+     * Return 0 on success, -1 on failure with errno set.
+     */
+    int (*hello_snapshot)(flux_t *h,
+                          const flux_msg_t *msg,
+                          const char *R,
+                          void *arg);
 };
 
 #ifdef __cplusplus
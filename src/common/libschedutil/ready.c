@@ -20,9 +20,11 @@
 
 int schedutil_ready (schedutil_t *util, const char *mode, int *queue_depth)
 {
-    flux_future_t *f;
+    flux_future_t *f = NULL;
+    json_t *o = NULL;
     int limit = 0;
     int count;
+    int batch = 0;
 
     if (!util || !mode) {
         errno = EINVAL;
@@ -42,28 +44,39 @@ int schedutil_ready (schedutil_t *util, const char *mode, int *queue_depth)
         errno = EINVAL;
         return -1;
     }
+    if (!(o = json_pack ("{s:s}", "mode", mode)))
+        goto nomem;
     if (limit) {
-        if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
-                                 FLUX_NODEID_ANY, 0,
-                                 "{s:s s:i}",
-                                 "mode", mode,
-                                 "limit", limit)))
-            return -1;
+        if (json_object_set_new (o, "limit", json_integer (limit)) < 0)
+            goto nomem;
     }
-    else {
-        if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
-                                 FLUX_NODEID_ANY, 0,
-                                 "{s:s}", "mode", mode)))
-            return -1;
+    if ((util->flags & SCHEDUTIL_BATCH)) {
+        if (json_object_set_new (o, "batch", json_true ()) < 0)
+            goto nomem;
     }
-    if (flux_rpc_get_unpack (f, "{s:i}", "count", &count) < 0)
+    if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
+                             FLUX_NODEID_ANY, 0,
+                             "O", o)))
+        goto error;
+    /* N.B. an older job-manager does not return "batch", and never
+     * sends batched requests.
+     */
+    if (flux_rpc_get_unpack (f, "{s:i s?:b}",
+                             "count", &count,
+                             "batch", &batch) < 0)
         goto error;
+    if (batch)
+        flux_log (util->h, LOG_DEBUG, "ready: alloc/free batching enabled");
     if (queue_depth)
         *queue_depth = count;
     flux_future_destroy (f);
+    json_decref (o);
     return 0;
+nomem:
+    errno = ENOMEM;
 error:
     flux_future_destroy (f);
+    json_decref (o);
     return -1;
 }
 
@@ -11,7 +11,9 @@
 #ifndef HAVE_SCHEDUTIL_PRIVATE_H
 #define HAVE_SCHEDUTIL_PRIVATE_H 1
 
+#include <stdbool.h>
 #include <czmq.h>
+#include <jansson.h>
 #include <flux/core.h>
 
 #include "init.h"
@@ -24,6 +26,14 @@ struct schedutil_ctx {
     int flags;
     void *cb_arg;
     zlistx_t *outstanding_futures;
+    zhashx_t *R_cache;
+    flux_watcher_t *alloc_prep;
+    struct alloc_batch *alloc_batch;
+    flux_watcher_t *batch_prep;
+    json_t *alloc_responses;
+    const flux_msg_t *alloc_reply;
+    json_t *free_responses;
+    const flux_msg_t *free_reply;
 };
 
 /* Track futures that need to be destroyed on scheduler unload.
@@ -33,6 +43,41 @@ int schedutil_add_outstanding_future (schedutil_t *util, flux_future_t *fut);
 int schedutil_remove_outstanding_future (schedutil_t *util,
                                          flux_future_t *fut);
 
+/* Cache R of jobs allocated by this scheduler, or reported by the
+ * job manager at hello time, so that sched.free needs no KVS lookup.
+ * Nothing is cached if SCHEDUTIL_FREE_NOLOOKUP is set.
+ */
+int schedutil_R_cache_insert (schedutil_t *util,
+                              flux_jobid_t id,
+                              const char *R);
+const char *schedutil_R_cache_lookup (schedutil_t *util, flux_jobid_t id);
+void schedutil_R_cache_remove (schedutil_t *util, flux_jobid_t id);
+
+/* Create/destroy the prepare watcher and pending batch used to commit
+ * R for successful allocations in bulk (see alloc.c).
+ */
+int schedutil_alloc_batch_init (schedutil_t *util);
+void schedutil_alloc_batch_cleanup (schedutil_t *util);
+
+/* Batched sched.alloc and sched.free messages (see batch.c).
+ * schedutil_batch_foreach() calls 'fn' once per job in 'msg', which
+ * may or may not be a batch.  If schedutil_batch_member() is true for
+ * a message passed to 'fn', its responses must be sent with
+ * schedutil_batch_respond(), which queues payload 'o' for the next
+ * batched response.
+ */
+typedef void (*schedutil_batch_f)(schedutil_t *util, const flux_msg_t *msg);
+
+int schedutil_batch_init (schedutil_t *util);
+void schedutil_batch_cleanup (schedutil_t *util);
+int schedutil_batch_foreach (schedutil_t *util,
+                             const flux_msg_t *msg,
+                             schedutil_batch_f fn);
+bool schedutil_batch_member (const flux_msg_t *msg);
+int schedutil_batch_respond (schedutil_t *util,
+                             const flux_msg_t *msg,
+                             json_t *o);
+
 /* (Un-)register callbacks for alloc, free, cancel.
  */
 int schedutil_ops_register (schedutil_t *util);
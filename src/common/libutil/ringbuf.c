@@ -0,0 +1,325 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* ringbuf.c - growable byte ring buffer
+ *
+ * 'head' and 'tail' are free-running byte counters: 'head' counts bytes
+ * written and 'tail' bytes consumed.  Their difference is the number of
+ * bytes stored, and since storage is a power of two in size, a counter
+ * masked with (size - 1) is its position in storage.  When storage
+ * grows, stored data is moved to the start of the new storage.
+ *
+ * ringbuf_splice() hands storage from one buffer to another when the
+ * destination is empty and the whole source is moved, as when a reader
+ * drains one buffer into another.  Storage may then exceed 'maxsize'
+ * rounded up, which is harmless since ringbuf_space() and
+ * ringbuf_reserve() enforce 'maxsize' independently of storage size.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ringbuf.h"
+
+struct ringbuf {
+    char *data;
+    size_t size;        /* power of two */
+    size_t maxsize;
+    size_t head;
+    size_t tail;
+};
+
+static size_t roundup_pow2 (size_t n)
+{
+    size_t size = 1;
+
+    while (size < n)
+        size <<= 1;
+    return size;
+}
+
+void ringbuf_destroy (struct ringbuf *rb)
+{
+    if (rb) {
+        int saved_errno = errno;
+        free (rb->data);
+        free (rb);
+        errno = saved_errno;
+    }
+}
+
+struct ringbuf *ringbuf_create (size_t size, size_t maxsize)
+{
+    struct ringbuf *rb;
+
+    if (maxsize == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (size > maxsize)
+        size = maxsize;
+    if (!(rb = calloc (1, sizeof (*rb))))
+        return NULL;
+    rb->size = roundup_pow2 (size);
+    rb->maxsize = maxsize;
+    if (!(rb->data = malloc (rb->size)))
+        goto error;
+    return rb;
+error:
+    ringbuf_destroy (rb);
+    return NULL;
+}
+
+size_t ringbuf_used (struct ringbuf *rb)
+{
+    return rb->head - rb->tail;
+}
+
+size_t ringbuf_space (struct ringbuf *rb)
+{
+    return rb->maxsize - ringbuf_used (rb);
+}
+
+/* Fill 'iov' with spans covering 'len' bytes starting at counter 'pos'.
+ */
+static int spans (struct ringbuf *rb,
+                  size_t pos,
+                  size_t len,
+                  struct iovec iov[2])
+{
+    size_t offset = pos & (rb->size - 1);
+    size_t first = rb->size - offset;
+
+    if (len == 0)
+        return 0;
+    if (first > len)
+        first = len;
+    iov[0].iov_base = rb->data + offset;
+    iov[0].iov_len = first;
+    if (first == len)
+        return 1;
+    iov[1].iov_base = rb->data;
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+int ringbuf_peek_iov (struct ringbuf *rb, size_t len, struct iovec iov[2])
+{
+    size_t used = ringbuf_used (rb);
+
+    return spans (rb, rb->tail, len < used ? len : used, iov);
+}
+
+int ringbuf_space_iov (struct ringbuf *rb, size_t len, struct iovec iov[2])
+{
+    size_t avail = rb->size - ringbuf_used (rb);
+
+    return spans (rb, rb->head, len < avail ? len : avail, iov);
+}
+
+size_t ringbuf_peek (struct ringbuf *rb, void *buf, size_t len)
+{
+    struct iovec iov[2];
+    size_t n = 0;
+    int i, count;
+
+    count = ringbuf_peek_iov (rb, len, iov);
+    for (i = 0; i < count; i++) {
+        memcpy ((char *)buf + n, iov[i].iov_base, iov[i].iov_len);
+        n += iov[i].iov_len;
+    }
+    return n;
+}
+
+int ringbuf_reserve (struct ringbuf *rb, size_t len)
+{
+    size_t used = ringbuf_used (rb);
+    size_t size;
+    char *data;
+
+    if (len > ringbuf_space (rb)) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (used + len <= rb->size)
+        return 0;
+    size = roundup_pow2 (used + len);
+    if (!(data = malloc (size)))
+        return -1;
+    ringbuf_peek (rb, data, used);
+    free (rb->data);
+    rb->data = data;
+    rb->size = size;
+    rb->tail = 0;
+    rb->head = used;
+    return 0;
+}
+
+void ringbuf_produce (struct ringbuf *rb, size_t len)
+{
+    rb->head += len;
+}
+
+void ringbuf_consume (struct ringbuf *rb, size_t len)
+{
+    rb->tail += len;
+}
+
+int ringbuf_write (struct ringbuf *rb, const void *data, size_t len)
+{
+    struct iovec iov[2];
+    size_t n = 0;
+    int i, count;
+
+    if (ringbuf_reserve (rb, len) < 0)
+        return -1;
+    count = ringbuf_space_iov (rb, len, iov);
+    for (i = 0; i < count; i++) {
+        memcpy (iov[i].iov_base, (const char *)data + n, iov[i].iov_len);
+        n += iov[i].iov_len;
+    }
+    ringbuf_produce (rb, n);
+    return 0;
+}
+
+ssize_t ringbuf_find (struct ringbuf *rb, int c)
+{
+    struct iovec iov[2];
+    size_t offset = 0;
+    char *p;
+    int i, count;
+
+    count = ringbuf_peek_iov (rb, ringbuf_used (rb), iov);
+    for (i = 0; i < count; i++) {
+        if ((p = memchr (iov[i].iov_base, c, iov[i].iov_len)))
+            return offset + (p - (char *)iov[i].iov_base);
+        offset += iov[i].iov_len;
+    }
+    return -1;
+}
+
+size_t ringbuf_count (struct ringbuf *rb, int c)
+{
+    struct iovec iov[2];
+    size_t n = 0;
+    int i, count;
+
+    count = ringbuf_peek_iov (rb, ringbuf_used (rb), iov);
+    for (i = 0; i < count; i++) {
+        char *p = iov[i].iov_base;
+        char *end = p + iov[i].iov_len;
+
+        while (p < end && (p = memchr (p, c, end - p))) {
+            n++;
+            p++;
+        }
+    }
+    return n;
+}
+
+ssize_t ringbuf_peek_to_fd (struct ringbuf *rb, int fd, size_t len)
+{
+    struct iovec iov[2];
+    ssize_t n;
+    int count;
+
+    if (fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((count = ringbuf_peek_iov (rb, len, iov)) == 0)
+        return 0;
+    do {
+        n = writev (fd, iov, count);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+ssize_t ringbuf_write_from_fd (struct ringbuf *rb, int fd, size_t len)
+{
+    struct iovec iov[2];
+    size_t space = ringbuf_space (rb);
+    ssize_t n;
+    int count;
+
+    if (fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len == 0)
+        return 0;
+    if (space == 0) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (len > space)
+        len = space;
+    if (ringbuf_reserve (rb, len) < 0)
+        return -1;
+    count = ringbuf_space_iov (rb, len, iov);
+    do {
+        n = readv (fd, iov, count);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0)
+        ringbuf_produce (rb, n);
+    return n;
+}
+
+ssize_t ringbuf_splice (struct ringbuf *dst, struct ringbuf *src, size_t len)
+{
+    size_t used = ringbuf_used (src);
+    size_t space = ringbuf_space (dst);
+    struct iovec iov[2];
+    int i, count;
+
+    if (dst == src) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len > used)
+        len = used;
+    if (len == 0)
+        return 0;
+    if (space == 0) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (len > space)
+        len = space;
+    if (ringbuf_used (dst) == 0 && len == used) {
+        char *data = dst->data;
+        size_t size = dst->size;
+
+        dst->data = src->data;
+        dst->size = src->size;
+        dst->head = src->head;
+        dst->tail = src->tail;
+        src->data = data;
+        src->size = size;
+        src->head = src->tail = 0;
+        return len;
+    }
+    if (ringbuf_reserve (dst, len) < 0)
+        return -1;
+    count = ringbuf_peek_iov (src, len, iov);
+    for (i = 0; i < count; i++)
+        (void)ringbuf_write (dst, iov[i].iov_base, iov[i].iov_len);
+    ringbuf_consume (src, len);
+    return len;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,108 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_RINGBUF_H
+#define _UTIL_RINGBUF_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/* Growable byte ring buffer with one reader and one writer.
+ *
+ * Storage is a power of two in size, so it grows by doubling as needed,
+ * until 'maxsize' bytes are stored.  There is no internal locking.
+ *
+ * Stored data and free space are each accessible as at most two
+ * contiguous spans (struct iovec), for use with readv(2), writev(2),
+ * vmsplice(2), or memchr(3) without an intermediate copy.
+ */
+
+struct ringbuf;
+
+/* Create/destroy ring buffer.  Initial storage is 'size' bytes
+ * rounded up to a power of two.  At most 'maxsize' bytes may be stored.
+ * Returns ringbuf on success, NULL on failure with errno set.
+ */
+struct ringbuf *ringbuf_create (size_t size, size_t maxsize);
+void ringbuf_destroy (struct ringbuf *rb);
+
+/* Return number of bytes stored, and number of bytes that may be
+ * written before 'maxsize' is reached.
+ */
+size_t ringbuf_used (struct ringbuf *rb);
+size_t ringbuf_space (struct ringbuf *rb);
+
+/* Grow storage if needed so that 'len' more bytes can be written.
+ * Returns 0 on success, -1 on failure with errno set
+ * (ENOSPC if 'len' exceeds ringbuf_space()).
+ */
+int ringbuf_reserve (struct ringbuf *rb, size_t len);
+
+/* Fill 'iov' with spans covering up to 'len' stored bytes, oldest first.
+ * Returns the number of spans (0, 1, or 2).
+ */
+int ringbuf_peek_iov (struct ringbuf *rb, size_t len, struct iovec iov[2]);
+
+/* Fill 'iov' with spans covering up to 'len' bytes of free storage,
+ * in the order they will be written.  Call ringbuf_reserve() first
+ * to ensure storage is available.  Returns the number of spans.
+ */
+int ringbuf_space_iov (struct ringbuf *rb, size_t len, struct iovec iov[2]);
+
+/* Mark 'len' bytes as written into spans from ringbuf_space_iov(),
+ * or as consumed from the front of the buffer.  'len' must not exceed
+ * the span lengths or ringbuf_used(), respectively.
+ */
+void ringbuf_produce (struct ringbuf *rb, size_t len);
+void ringbuf_consume (struct ringbuf *rb, size_t len);
+
+/* Copy 'len' bytes into the buffer.  Returns 0 on success, -1 on
+ * failure with errno set (ENOSPC if 'len' exceeds ringbuf_space()).
+ */
+int ringbuf_write (struct ringbuf *rb, const void *data, size_t len);
+
+/* Copy up to 'len' stored bytes to 'buf' without consuming them.
+ * Returns the number of bytes copied.
+ */
+size_t ringbuf_peek (struct ringbuf *rb, void *buf, size_t len);
+
+/* Return the offset of the first stored byte equal to 'c', or -1 if
+ * there is none.
+ */
+ssize_t ringbuf_find (struct ringbuf *rb, int c);
+
+/* Return the number of stored bytes equal to 'c'.
+ */
+size_t ringbuf_count (struct ringbuf *rb, int c);
+
+/* Write up to 'len' stored bytes to 'fd' without consuming them.
+ * Returns the number of bytes written, or -1 on failure with errno set.
+ */
+ssize_t ringbuf_peek_to_fd (struct ringbuf *rb, int fd, size_t len);
+
+/* Read up to 'len' bytes from 'fd' into the buffer.
+ * Returns the number of bytes read, 0 on EOF, or -1 on failure with
+ * errno set (ENOSPC if the buffer is full).
+ */
+ssize_t ringbuf_write_from_fd (struct ringbuf *rb, int fd, size_t len);
+
+/* Move up to 'len' stored bytes from 'src' to the end of 'dst'.
+ * If 'dst' is empty and all of 'src' is moved, storage is exchanged
+ * rather than copied; otherwise bytes are copied span to span.
+ * Returns the number of bytes moved, or -1 on failure with errno set
+ * (ENOSPC if 'dst' is full, EINVAL if 'dst' and 'src' are the same).
+ */
+ssize_t ringbuf_splice (struct ringbuf *dst, struct ringbuf *src, size_t len);
+
+#endif /* !_UTIL_RINGBUF_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
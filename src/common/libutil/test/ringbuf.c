@@ -0,0 +1,237 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/ringbuf.h"
+
+void check_basic (void)
+{
+    struct ringbuf *rb;
+    char buf[64];
+
+    errno = 0;
+    ok (ringbuf_create (16, 0) == NULL && errno == EINVAL,
+        "ringbuf_create maxsize=0 fails with EINVAL");
+    ok ((rb = ringbuf_create (4, 10)) != NULL,
+        "ringbuf_create size=4 maxsize=10 works");
+    ok (ringbuf_used (rb) == 0 && ringbuf_space (rb) == 10,
+        "empty buffer has used=0 space=10");
+    ok (ringbuf_find (rb, '\n') == -1,
+        "ringbuf_find on empty buffer returns -1");
+    ok (ringbuf_peek (rb, buf, sizeof (buf)) == 0,
+        "ringbuf_peek on empty buffer returns 0");
+
+    ok (ringbuf_write (rb, "abc\ndef", 7) == 0,
+        "ringbuf_write of 7 bytes works, growing storage");
+    ok (ringbuf_used (rb) == 7 && ringbuf_space (rb) == 3,
+        "buffer has used=7 space=3");
+    ok (ringbuf_find (rb, '\n') == 3,
+        "ringbuf_find returns offset of newline");
+    ok (ringbuf_count (rb, '\n') == 1,
+        "ringbuf_count returns 1 newline");
+    errno = 0;
+    ok (ringbuf_write (rb, "ghij", 4) < 0 && errno == ENOSPC,
+        "ringbuf_write past maxsize fails with ENOSPC");
+    ok (ringbuf_used (rb) == 7,
+        "failed write stored nothing");
+
+    memset (buf, 0, sizeof (buf));
+    ok (ringbuf_peek (rb, buf, 4) == 4 && !memcmp (buf, "abc\n", 4),
+        "ringbuf_peek returns first 4 bytes");
+    ringbuf_consume (rb, 4);
+    ok (ringbuf_used (rb) == 3 && ringbuf_space (rb) == 7,
+        "ringbuf_consume 4 leaves used=3 space=7");
+    ok (ringbuf_count (rb, '\n') == 0,
+        "ringbuf_count returns 0 newlines");
+
+    ringbuf_destroy (rb);
+}
+
+/* Write data that wraps around the end of storage, then check that
+ * spans, searches, and growth handle the wrap.
+ */
+void check_wrap (void)
+{
+    struct ringbuf *rb;
+    struct iovec iov[2];
+    char buf[64];
+
+    ok ((rb = ringbuf_create (8, 64)) != NULL,
+        "ringbuf_create size=8 maxsize=64 works");
+    ok (ringbuf_write (rb, "xxxxxx", 6) == 0,
+        "wrote 6 bytes");
+    ringbuf_consume (rb, 6);
+    ok (ringbuf_write (rb, "ab\ncd\n", 6) == 0,
+        "wrote 6 more bytes, wrapping around storage");
+    ok (ringbuf_peek_iov (rb, 64, iov) == 2
+        && iov[0].iov_len == 2 && !memcmp (iov[0].iov_base, "ab", 2)
+        && iov[1].iov_len == 4 && !memcmp (iov[1].iov_base, "\ncd\n", 4),
+        "ringbuf_peek_iov returns two spans");
+    ok (ringbuf_peek_iov (rb, 1, iov) == 1 && iov[0].iov_len == 1,
+        "ringbuf_peek_iov len=1 returns one span");
+    ok (ringbuf_find (rb, '\n') == 2,
+        "ringbuf_find finds newline in second span");
+    ok (ringbuf_count (rb, '\n') == 2,
+        "ringbuf_count counts newlines across spans");
+    ok (ringbuf_space_iov (rb, 64, iov) == 1 && iov[0].iov_len == 2,
+        "ringbuf_space_iov returns free span within storage");
+
+    ok (ringbuf_write (rb, "0123456789", 10) == 0,
+        "wrote 10 more bytes, growing storage");
+    memset (buf, 0, sizeof (buf));
+    ok (ringbuf_peek (rb, buf, sizeof (buf)) == 16
+        && !memcmp (buf, "ab\ncd\n0123456789", 16),
+        "data is intact after growth");
+    ok (ringbuf_peek_iov (rb, 64, iov) == 1 && iov[0].iov_len == 16,
+        "data is contiguous after growth");
+
+    ok (ringbuf_reserve (rb, 48) == 0,
+        "ringbuf_reserve up to maxsize works");
+    errno = 0;
+    ok (ringbuf_reserve (rb, 49) < 0 && errno == ENOSPC,
+        "ringbuf_reserve past maxsize fails with ENOSPC");
+    ok (ringbuf_space_iov (rb, 64, iov) >= 1,
+        "ringbuf_space_iov works");
+    memcpy (iov[0].iov_base, "Z", 1);
+    ringbuf_produce (rb, 1);
+    ok (ringbuf_used (rb) == 17 && ringbuf_find (rb, 'Z') == 16,
+        "ringbuf_produce appends data written into space span");
+
+    ringbuf_destroy (rb);
+}
+
+void check_fd (void)
+{
+    struct ringbuf *rb;
+    int pfds[2];
+    char buf[64];
+
+    if (pipe (pfds) < 0)
+        BAIL_OUT ("pipe");
+    ok ((rb = ringbuf_create (4, 16)) != NULL,
+        "ringbuf_create size=4 maxsize=16 works");
+    errno = 0;
+    ok (ringbuf_peek_to_fd (rb, -1, 16) < 0 && errno == EINVAL,
+        "ringbuf_peek_to_fd fd=-1 fails with EINVAL");
+    errno = 0;
+    ok (ringbuf_write_from_fd (rb, -1, 16) < 0 && errno == EINVAL,
+        "ringbuf_write_from_fd fd=-1 fails with EINVAL");
+    ok (ringbuf_peek_to_fd (rb, pfds[1], 16) == 0,
+        "ringbuf_peek_to_fd on empty buffer returns 0");
+
+    ok (ringbuf_write (rb, "hello world", 11) == 0,
+        "wrote 11 bytes");
+    ok (ringbuf_peek_to_fd (rb, pfds[1], 16) == 11,
+        "ringbuf_peek_to_fd wrote 11 bytes to pipe");
+    ok (ringbuf_used (rb) == 11,
+        "ringbuf_peek_to_fd did not consume data");
+    ringbuf_consume (rb, 11);
+
+    ok (ringbuf_write_from_fd (rb, pfds[0], 64) == 11,
+        "ringbuf_write_from_fd read 11 bytes from pipe");
+    memset (buf, 0, sizeof (buf));
+    ok (ringbuf_peek (rb, buf, sizeof (buf)) == 11
+        && !strcmp (buf, "hello world"),
+        "buffer contains data read from pipe");
+
+    ok (ringbuf_write (rb, "12345", 5) == 0,
+        "filled buffer to maxsize");
+    errno = 0;
+    ok (ringbuf_write_from_fd (rb, pfds[0], 1) < 0 && errno == ENOSPC,
+        "ringbuf_write_from_fd on full buffer fails with ENOSPC");
+    ok (ringbuf_write_from_fd (rb, pfds[0], 0) == 0,
+        "ringbuf_write_from_fd len=0 returns 0");
+
+    close (pfds[1]);
+    ringbuf_consume (rb, 16);
+    ok (ringbuf_write_from_fd (rb, pfds[0], 16) == 0,
+        "ringbuf_write_from_fd returns 0 on EOF");
+    close (pfds[0]);
+
+    ringbuf_destroy (rb);
+}
+
+void check_splice (void)
+{
+    struct ringbuf *a;
+    struct ringbuf *b;
+    struct iovec iov[2];
+    char buf[64];
+    void *data;
+
+    ok ((a = ringbuf_create (8, 64)) != NULL
+        && (b = ringbuf_create (4, 12)) != NULL,
+        "created two buffers");
+    errno = 0;
+    ok (ringbuf_splice (a, a, 1) < 0 && errno == EINVAL,
+        "ringbuf_splice dst=src fails with EINVAL");
+    ok (ringbuf_splice (b, a, 16) == 0,
+        "ringbuf_splice from empty buffer returns 0");
+
+    ok (ringbuf_write (a, "xxxxxx", 6) == 0,
+        "wrote 6 bytes");
+    ringbuf_consume (a, 6);
+    ok (ringbuf_write (a, "abcdef", 6) == 0,
+        "wrote 6 more bytes, wrapping around storage");
+    ok (ringbuf_peek_iov (a, 64, iov) == 2,
+        "source data is in two spans");
+    data = iov[0].iov_base;
+    ok (ringbuf_splice (b, a, 64) == 6,
+        "ringbuf_splice of whole source into empty buffer moved 6 bytes");
+    ok (ringbuf_used (a) == 0 && ringbuf_used (b) == 6,
+        "source is empty and destination holds 6 bytes");
+    ok (ringbuf_peek_iov (b, 64, iov) == 2 && iov[0].iov_base == data,
+        "storage was exchanged rather than copied");
+    memset (buf, 0, sizeof (buf));
+    ok (ringbuf_peek (b, buf, sizeof (buf)) == 6 && !strcmp (buf, "abcdef"),
+        "destination data is intact");
+    ok (ringbuf_write (a, "0123456789", 10) == 0,
+        "source is usable after exchange");
+
+    ok (ringbuf_splice (b, a, 4) == 4,
+        "ringbuf_splice of 4 bytes into non-empty buffer moved 4 bytes");
+    ok (ringbuf_used (a) == 6 && ringbuf_used (b) == 10,
+        "source holds 6 bytes and destination 10");
+    ok (ringbuf_splice (b, a, 64) == 2,
+        "ringbuf_splice is limited by destination maxsize");
+    memset (buf, 0, sizeof (buf));
+    ok (ringbuf_peek (b, buf, sizeof (buf)) == 12
+        && !strcmp (buf, "abcdef012345"),
+        "destination data is intact");
+    memset (buf, 0, sizeof (buf));
+    ok (ringbuf_peek (a, buf, sizeof (buf)) == 4 && !strcmp (buf, "6789"),
+        "remaining source data is intact");
+    errno = 0;
+    ok (ringbuf_splice (b, a, 1) < 0 && errno == ENOSPC,
+        "ringbuf_splice into full buffer fails with ENOSPC");
+
+    ringbuf_destroy (a);
+    ringbuf_destroy (b);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    check_basic ();
+    check_wrap ();
+    check_fd ();
+    check_splice ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
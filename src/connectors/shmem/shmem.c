@@ -13,6 +13,7 @@
 #endif
 #include <assert.h>
 #include <errno.h>
+#include <string.h>
 #include <czmq.h>
 #include <argz.h>
 #if HAVE_CALIPER
@@ -23,9 +24,18 @@
 #include "src/common/libutil/log.h"
 
 #define MODHANDLE_MAGIC    0xfeefbe02
+
+/* flux_opt_set() option taking a pointer to an unsigned long counter,
+ * which is incremented atomically as each message is received from
+ * the socket.  The broker reads it from another thread to compute
+ * the module's send queue depth.
+ */
+#define SHMEM_OPT_RXCOUNT  "flux::shmem_rxcount"
+
 typedef struct {
     int magic;
     zsock_t *sock;
+    unsigned long *rxcount;
     char *uuid;
     flux_t *h;
     char *argz;
@@ -88,11 +98,30 @@ static flux_msg_t *op_recv (void *impl, int flags)
             goto done;
         }
     }
-    msg = flux_msg_recvzsock (ctx->sock);
+    if ((msg = flux_msg_recvzsock (ctx->sock)) && ctx->rxcount)
+        __atomic_add_fetch (ctx->rxcount, 1, __ATOMIC_RELAXED);
 done:
     return msg;
 }
 
+static int op_setopt (void *impl, const char *option,
+                      const void *val, size_t size)
+{
+    shmem_ctx_t *ctx = impl;
+    assert (ctx->magic == MODHANDLE_MAGIC);
+
+    if (option && !strcmp (option, SHMEM_OPT_RXCOUNT)) {
+        if (size != sizeof (ctx->rxcount)) {
+            errno = EINVAL;
+            return -1;
+        }
+        memcpy (&ctx->rxcount, val, size);
+        return 0;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
 static int op_event_subscribe (void *impl, const char *topic)
 {
     shmem_ctx_t *ctx = impl;
@@ -213,7 +242,7 @@ static const struct flux_handle_ops handle_ops = {
     .send = op_send,
     .recv = op_recv,
     .getopt = NULL,
-    .setopt = NULL,
+    .setopt = op_setopt,
     .event_subscribe = op_event_subscribe,
     .event_unsubscribe = op_event_unsubscribe,
     .impl_destroy = op_fini,
@@ -39,6 +39,7 @@ static void disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
     }
     watchers_cancel (ctx, sender, FLUX_MATCHTAG_NONE);
     guest_watchers_cancel (ctx, sender, FLUX_MATCHTAG_NONE);
+    list_streams_cancel (ctx, sender, FLUX_MATCHTAG_NONE);
     free (sender);
 }
 
@@ -123,6 +124,11 @@ static const struct flux_msg_handler_spec htab[] = {
       .cb           = list_cb,
       .rolemask     = FLUX_ROLE_USER
     },
+    { .typemask     = FLUX_MSGTYPE_REQUEST,
+      .topic_glob   = "job-info.list-cancel",
+      .cb           = list_cancel_cb,
+      .rolemask     = FLUX_ROLE_USER
+    },
     { .typemask     = FLUX_MSGTYPE_REQUEST,
       .topic_glob   = "job-info.list-inactive",
       .cb           = list_inactive_cb,
@@ -182,6 +188,9 @@ static void info_ctx_destroy (struct info_ctx *ctx)
             guest_watch_cleanup (ctx);
             zlist_destroy (&ctx->guest_watchers);
         }
+        /* list streams hold job pointers, destroy before jsctx */
+        if (ctx->list_streams)
+            list_stream_cleanup (ctx);
         if (ctx->jsctx)
             job_state_destroy (ctx->jsctx);
         if (ctx->idsync_lookups)
@@ -205,6 +214,8 @@ static struct info_ctx *info_ctx_create (flux_t *h)
         goto error;
     if (!(ctx->guest_watchers = zlist_new ()))
         goto error;
+    if (list_stream_setup (ctx) < 0)
+        goto error;
     if (!(ctx->jsctx = job_state_create (ctx)))
         goto error;
     if (idsync_setup (ctx) < 0)
@@ -13,6 +13,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <stddef.h>
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
@@ -174,6 +175,209 @@ static bool search_direction (struct job *job)
         return false;
 }
 
+static size_t userid_hasher (const void *key)
+{
+    const uint32_t *userid = key;
+    return *userid;
+}
+
+static int userid_cmp (const void *key1, const void *key2)
+{
+    const uint32_t *u1 = key1;
+    const uint32_t *u2 = key2;
+    return NUMCMP (*u1, *u2);
+}
+
+static void job_user_destroy (struct job_user *user)
+{
+    if (user) {
+        int saved_errno = errno;
+        zlistx_destroy (&user->pending);
+        zlistx_destroy (&user->running);
+        zlistx_destroy (&user->inactive);
+        free (user);
+        errno = saved_errno;
+    }
+}
+
+static void job_user_destroy_wrapper (void **data)
+{
+    if (data) {
+        job_user_destroy (*data);
+        *data = NULL;
+    }
+}
+
+static struct job_user *job_user_create (uint32_t userid)
+{
+    struct job_user *user;
+
+    if (!(user = calloc (1, sizeof (*user))))
+        return NULL;
+    user->userid = userid;
+    if (!(user->pending = zlistx_new ())
+        || !(user->running = zlistx_new ())
+        || !(user->inactive = zlistx_new ()))
+        goto error_nomem;
+    zlistx_set_comparator (user->pending, job_urgency_cmp);
+    zlistx_set_comparator (user->running, job_running_cmp);
+    zlistx_set_comparator (user->inactive, job_inactive_cmp);
+    return user;
+error_nomem:
+    job_user_destroy (user);
+    errno = ENOMEM;
+    return NULL;
+}
+
+struct job_user *job_state_lookup_user (struct job_state_ctx *jsctx,
+                                        uint32_t userid)
+{
+    return zhashx_lookup (jsctx->users, &userid);
+}
+
+static struct job_user *job_user_get (struct job_state_ctx *jsctx,
+                                      uint32_t userid)
+{
+    struct job_user *user;
+
+    if (!(user = zhashx_lookup (jsctx->users, &userid))) {
+        if (!(user = job_user_create (userid)))
+            return NULL;
+        /* key is owned by user */
+        (void)zhashx_insert (jsctx->users, &user->userid, user);
+    }
+    return user;
+}
+
+/* Map a single result bit to its index in inactive_results[],
+ * or -1 if 'result' is not a single valid result.
+ */
+static int result_index (flux_job_result_t result)
+{
+    switch (result) {
+        case FLUX_JOB_RESULT_COMPLETED:
+            return 0;
+        case FLUX_JOB_RESULT_FAILED:
+            return 1;
+        case FLUX_JOB_RESULT_CANCELED:
+            return 2;
+        case FLUX_JOB_RESULT_TIMEOUT:
+            return 3;
+    }
+    return -1;
+}
+
+zlistx_t *job_state_result_list (struct job_state_ctx *jsctx,
+                                 flux_job_result_t result)
+{
+    int i = result_index (result);
+    return i < 0 ? NULL : jsctx->inactive_results[i];
+}
+
+/* Return the list of 'user' that mirrors primary list 'list'.
+ */
+static zlistx_t *user_list (struct job_state_ctx *jsctx,
+                            struct job_user *user,
+                            zlistx_t *list)
+{
+    if (list == jsctx->pending)
+        return user->pending;
+    else if (list == jsctx->running)
+        return user->running;
+    else if (list == jsctx->inactive)
+        return user->inactive;
+    return NULL;
+}
+
+/* Add job to secondary indexes of primary list 'list'.  The job must
+ * already have been placed on 'list'.
+ */
+static void job_index_add (struct job_state_ctx *jsctx,
+                           struct job *job,
+                           zlistx_t *list)
+{
+    struct job_user *user;
+    zlistx_t *l;
+
+    if (!(user = job_user_get (jsctx, job->userid))) {
+        flux_log_error (jsctx->h, "%s: job_user_get", __FUNCTION__);
+        return;
+    }
+    l = user_list (jsctx, user, list);
+    if (list == jsctx->pending)
+        job->user_handle = zlistx_insert (l, job, search_direction (job));
+    else
+        job->user_handle = zlistx_add_start (l, job);
+    if (!job->user_handle)
+        flux_log_error (jsctx->h, "%s: zlistx_insert", __FUNCTION__);
+
+    if (list == jsctx->inactive) {
+        if (!(l = job_state_result_list (jsctx, job->result))) {
+            flux_log (jsctx->h, LOG_ERR, "%s: job %ju invalid result %d",
+                      __FUNCTION__, (uintmax_t)job->id, job->result);
+            return;
+        }
+        if (!(job->result_handle = zlistx_add_start (l, job)))
+            flux_log_error (jsctx->h, "%s: zlistx_add_start",
+                            __FUNCTION__);
+    }
+}
+
+/* Remove job from secondary indexes of primary list 'list'.
+ * Inactive jobs are never removed, so only the user index is touched.
+ */
+static void job_index_remove (struct job_state_ctx *jsctx,
+                              struct job *job,
+                              zlistx_t *list)
+{
+    struct job_user *user;
+    zlistx_t *l;
+
+    if (!job->user_handle)
+        return;
+    if ((user = zhashx_lookup (jsctx->users, &job->userid))
+        && (l = user_list (jsctx, user, list))) {
+        if (zlistx_detach (l, job->user_handle) < 0)
+            flux_log_error (jsctx->h, "%s: zlistx_detach", __FUNCTION__);
+    }
+    job->user_handle = NULL;
+}
+
+/* Re-sort job on the pending list and the user's pending list after
+ * a priority change.
+ */
+static void job_pending_reorder (struct job_state_ctx *jsctx,
+                                 struct job *job)
+{
+    struct job_user *user;
+
+    zlistx_reorder (jsctx->pending,
+                    job->list_handle,
+                    search_direction (job));
+    if (job->user_handle
+        && (user = zhashx_lookup (jsctx->users, &job->userid)))
+        zlistx_reorder (user->pending,
+                        job->user_handle,
+                        search_direction (job));
+}
+
+/* zlistx_sort() moves items between list nodes rather than moving
+ * the nodes themselves, so any handle a job holds into 'list' is
+ * stale afterwards.  Sort and then reacquire the handle stored at
+ * 'offset' in each job.
+ */
+static void list_sort (zlistx_t *list, size_t offset)
+{
+    struct job *job;
+
+    zlistx_sort (list);
+    job = zlistx_first (list);
+    while (job) {
+        *(void **)((char *)job + offset) = zlistx_cursor (list);
+        job = zlistx_next (list);
+    }
+}
+
 static void update_job_state (struct info_ctx *ctx,
                               struct job *job,
                               flux_job_state_t new_state,
@@ -208,6 +412,21 @@ static void revert_job_state (struct info_ctx *ctx,
     }
 }
 
+static zlistx_t *get_list (struct job_state_ctx *jsctx, flux_job_state_t state)
+{
+    if (state == FLUX_JOB_STATE_NEW)
+        return jsctx->processing;
+    else if (state == FLUX_JOB_STATE_DEPEND
+             || state == FLUX_JOB_STATE_PRIORITY
+             || state == FLUX_JOB_STATE_SCHED)
+        return jsctx->pending;
+    else if (state == FLUX_JOB_STATE_RUN
+             || state == FLUX_JOB_STATE_CLEANUP)
+        return jsctx->running;
+    else /* state == FLUX_JOB_STATE_INACTIVE */
+        return jsctx->inactive;
+}
+
 static void job_insert_list (struct job_state_ctx *jsctx,
                              struct job *job,
                              flux_job_state_t newstate)
@@ -236,6 +455,8 @@ static void job_insert_list (struct job_state_ctx *jsctx,
             flux_log_error (jsctx->h, "%s: zlistx_add_start",
                             __FUNCTION__);
     }
+    if (job->list_handle)
+        job_index_add (jsctx, job, get_list (jsctx, newstate));
 }
 
 /* remove job from one list and move it to another based on the
@@ -249,25 +470,11 @@ static void job_change_list (struct job_state_ctx *jsctx,
         flux_log_error (jsctx->h, "%s: zlistx_detach",
                         __FUNCTION__);
     job->list_handle = NULL;
+    job_index_remove (jsctx, job, oldlist);
 
     job_insert_list (jsctx, job, newstate);
 }
 
-static zlistx_t *get_list (struct job_state_ctx *jsctx, flux_job_state_t state)
-{
-    if (state == FLUX_JOB_STATE_NEW)
-        return jsctx->processing;
-    else if (state == FLUX_JOB_STATE_DEPEND
-             || state == FLUX_JOB_STATE_PRIORITY
-             || state == FLUX_JOB_STATE_SCHED)
-        return jsctx->pending;
-    else if (state == FLUX_JOB_STATE_RUN
-             || state == FLUX_JOB_STATE_CLEANUP)
-        return jsctx->running;
-    else /* state == FLUX_JOB_STATE_INACTIVE */
-        return jsctx->inactive;
-}
-
 static void update_job_state_and_list (struct info_ctx *ctx,
                                        struct job *job,
                                        flux_job_state_t newstate,
@@ -292,9 +499,7 @@ static void update_job_state_and_list (struct info_ctx *ctx,
         job_change_list (jsctx, job, oldlist, newstate);
     else if (oldlist == jsctx->pending
              && newstate == FLUX_JOB_STATE_SCHED)
-        zlistx_reorder (jsctx->pending,
-                        job->list_handle,
-                        search_direction (job));
+        job_pending_reorder (jsctx, job);
 }
 
 static void list_id_respond (struct info_ctx *ctx,
@@ -1144,17 +1349,29 @@ done:
 /* Read jobs present in the KVS at startup. */
 int job_state_init_from_kvs (struct info_ctx *ctx)
 {
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    struct job_user *user;
     const char *dirname = "job";
     int dirskip = strlen (dirname);
     int count;
+    int i;
 
     count = depthfirst_map (ctx, dirname, dirskip);
     if (count < 0)
         return -1;
     flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs", __FUNCTION__, count);
 
-    zlistx_sort (ctx->jsctx->running);
-    zlistx_sort (ctx->jsctx->inactive);
+    list_sort (jsctx->running, offsetof (struct job, list_handle));
+    list_sort (jsctx->inactive, offsetof (struct job, list_handle));
+    user = zhashx_first (jsctx->users);
+    while (user) {
+        list_sort (user->running, offsetof (struct job, user_handle));
+        list_sort (user->inactive, offsetof (struct job, user_handle));
+        user = zhashx_next (jsctx->users);
+    }
+    for (i = 0; i < JOB_RESULT_INDEX_COUNT; i++)
+        list_sort (jsctx->inactive_results[i],
+                   offsetof (struct job, result_handle));
     return 0;
 }
 
@@ -1357,9 +1574,7 @@ static int journal_priority_event (struct job_state_ctx *jsctx,
 
     if (job->state & FLUX_JOB_STATE_PENDING
         && job->priority != orig_priority)
-        zlistx_reorder (jsctx->pending,
-                        job->list_handle,
-                        search_direction (job));
+        job_pending_reorder (jsctx, job);
 
     return job_transition_state (jsctx,
                                  job,
@@ -1737,6 +1952,7 @@ struct job_state_ctx *job_state_create (struct info_ctx *ctx)
 {
     struct job_state_ctx *jsctx = NULL;
     int saved_errno;
+    int i;
 
     if (!(jsctx = calloc (1, sizeof (*jsctx)))) {
         flux_log_error (ctx->h, "calloc");
@@ -1769,6 +1985,20 @@ struct job_state_ctx *job_state_create (struct info_ctx *ctx)
     if (!(jsctx->processing = zlistx_new ()))
         goto error;
 
+    if (!(jsctx->users = zhashx_new ()))
+        goto error;
+    zhashx_set_key_hasher (jsctx->users, userid_hasher);
+    zhashx_set_key_comparator (jsctx->users, userid_cmp);
+    zhashx_set_key_duplicator (jsctx->users, NULL);
+    zhashx_set_key_destructor (jsctx->users, NULL);
+    zhashx_set_destructor (jsctx->users, job_user_destroy_wrapper);
+
+    for (i = 0; i < JOB_RESULT_INDEX_COUNT; i++) {
+        if (!(jsctx->inactive_results[i] = zlistx_new ()))
+            goto error;
+        zlistx_set_comparator (jsctx->inactive_results[i], job_inactive_cmp);
+    }
+
     if (!(jsctx->futures = zlistx_new ()))
         goto error;
 
@@ -1807,6 +2037,7 @@ void job_state_destroy (void *data)
 {
     struct job_state_ctx *jsctx = data;
     if (jsctx) {
+        int i;
         /* Don't destroy processing until futures are complete */
         if (jsctx->futures) {
             flux_future_t *f;
@@ -1823,6 +2054,9 @@ void job_state_destroy (void *data)
         /* Destroy index last, as it is the one that will actually
          * destroy the job objects */
         zlistx_destroy (&jsctx->processing);
+        for (i = 0; i < JOB_RESULT_INDEX_COUNT; i++)
+            zlistx_destroy (&jsctx->inactive_results[i]);
+        zhashx_destroy (&jsctx->users);
         zlistx_destroy (&jsctx->inactive);
         zlistx_destroy (&jsctx->running);
         zlistx_destroy (&jsctx->pending);
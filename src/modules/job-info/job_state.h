@@ -34,8 +34,23 @@
  * cannot yet be stored on one of the lists above.
  *
  * The list `futures` is used to store in process futures.
+ *
+ * Jobs on the pending, running, and inactive lists are also indexed
+ * by userid (`users`, a hash of struct job_user) and inactive jobs
+ * are additionally indexed by result (`inactive_results`), so that
+ * filtered list requests need not walk every job.  Each secondary
+ * list is kept in the same order as its primary list.
  */
 
+#define JOB_RESULT_INDEX_COUNT 4
+
+struct job_user {
+    uint32_t userid;
+    zlistx_t *pending;
+    zlistx_t *running;
+    zlistx_t *inactive;
+};
+
 struct job_state_ctx {
     flux_t *h;
     struct info_ctx *ctx;
@@ -44,6 +59,8 @@ struct job_state_ctx {
     zlistx_t *running;
     zlistx_t *inactive;
     zlistx_t *processing;
+    zhashx_t *users;
+    zlistx_t *inactive_results[JOB_RESULT_INDEX_COUNT];
     zlistx_t *futures;
 
     /*  Job statistics: */
@@ -106,6 +123,8 @@ struct job {
     unsigned int states_mask;
     unsigned int states_events_mask;
     void *list_handle;
+    void *user_handle;
+    void *result_handle;
 
     /* timestamp of when we enter the state
      *
@@ -137,6 +156,18 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
 
 int job_state_init_from_kvs (struct info_ctx *ctx);
 
+/* Return the jobs of 'userid' indexed by state, or NULL if the user
+ * has no jobs.
+ */
+struct job_user *job_state_lookup_user (struct job_state_ctx *jsctx,
+                                        uint32_t userid);
+
+/* Return the list of inactive jobs with 'result', sorted like the
+ * inactive list, or NULL if 'result' is not a single valid result.
+ */
+zlistx_t *job_state_result_list (struct job_state_ctx *jsctx,
+                                 flux_job_result_t result);
+
 #endif /* ! _FLUX_JOB_INFO_JOB_STATE_H */
 
 /*
@@ -24,6 +24,8 @@
 #include "job_util.h"
 #include "job_state.h"
 
+#define LIST_PAGE_SIZE 1000
+
 json_t *get_job_by_id (struct info_ctx *ctx,
                        job_info_error_t *errp,
                        const flux_msg_t *msg,
@@ -44,46 +46,290 @@ bool job_filter (struct job *job, uint32_t userid, int states, int results)
     return true;
 }
 
-/* Put jobs from list onto jobs array, breaking if max_entries has
- * been reached. Returns 1 if jobs array is full, 0 if continue, -1
- * one error with errno set:
- *
- * ENOMEM - out of memory
+/* A list cursor identifies the last job returned to the caller by
+ * the list it was returned from (FLUX_JOB_STATE_PENDING, RUNNING, or
+ * INACTIVE), its sort key on that list, and its jobid.  A request
+ * carrying a cursor resumes listing after that job.
  */
-int get_jobs_from_list (json_t *jobs,
-                        job_info_error_t *errp,
-                        zlistx_t *list,
-                        int max_entries,
-                        json_t *attrs,
-                        uint32_t userid,
-                        int states,
-                        int results)
+struct list_cursor {
+    int state;
+    double key;
+    flux_jobid_t id;
+};
+
+/* Called for each job selected by foreach_job().  Return 1 to stop
+ * iteration, 0 to continue, or -1 on error with errno set.
+ */
+typedef int (*list_job_f)(struct job *job, int list_state, void *arg);
+
+/* State of a cursor skip in progress on one list.
+ */
+struct cursor_skip {
+    const struct list_cursor *cursor;
+    bool skipping;
+    bool ties;
+};
+
+static int list_order (int list_state)
+{
+    if (list_state == FLUX_JOB_STATE_PENDING)
+        return 0;
+    else if (list_state == FLUX_JOB_STATE_RUNNING)
+        return 1;
+    return 2;
+}
+
+static double cursor_key (struct job *job, int list_state)
+{
+    if (list_state == FLUX_JOB_STATE_PENDING)
+        return job->priority;
+    else if (list_state == FLUX_JOB_STATE_RUNNING)
+        return job->t_run;
+    return job->t_inactive;
+}
+
+static json_t *cursor_encode (struct job *job, int list_state)
+{
+    return json_pack ("{s:i s:f s:I}",
+                      "state", list_state,
+                      "key", cursor_key (job, list_state),
+                      "id", job->id);
+}
+
+static void cursor_skip_init (struct cursor_skip *cs,
+                              struct job_state_ctx *jsctx,
+                              const struct list_cursor *cursor,
+                              int list_state)
 {
     struct job *job;
 
+    cs->cursor = cursor;
+    cs->skipping = cursor && cursor->state == list_state;
+    cs->ties = false;
+
+    /* Running and inactive jobs with equal timestamps are in no
+     * particular order.  Skip those only up to the cursor job, and only
+     * if the cursor job is still among them.
+     */
+    if (cs->skipping
+        && (job = zhashx_lookup (jsctx->index, &cursor->id))
+        && (job->state & list_state)
+        && cursor_key (job, list_state) == cursor->key)
+        cs->ties = true;
+}
+
+/* Return true if job precedes or is the cursor job on the list
+ * being walked.  Lists are walked in order, so once a job follows the
+ * cursor, all subsequent ones do too.
+ */
+static bool cursor_skip (struct cursor_skip *cs,
+                         struct job *job,
+                         int list_state)
+{
+    double key;
+
+    if (!cs->skipping)
+        return false;
+    key = cursor_key (job, list_state);
+    if (list_state == FLUX_JOB_STATE_PENDING) {
+        /* pending list is sorted by priority (highest first), then id */
+        if (key > cs->cursor->key
+            || (key == cs->cursor->key && job->id <= cs->cursor->id))
+            return true;
+    }
+    else {
+        if (key > cs->cursor->key)
+            return true;
+        if (key == cs->cursor->key && cs->ties) {
+            if (job->id == cs->cursor->id)
+                cs->ties = false;
+            return true;
+        }
+    }
+    cs->skipping = false;
+    return false;
+}
+
+/* Call fn for each job on list that passes the filter and follows
+ * the cursor.  Returns the first nonzero value returned by fn, else 0.
+ */
+static int foreach_list (struct job_state_ctx *jsctx,
+                         zlistx_t *list,
+                         int list_state,
+                         const struct list_cursor *cursor,
+                         uint32_t userid,
+                         int states,
+                         int results,
+                         list_job_f fn,
+                         void *arg)
+{
+    struct cursor_skip cs;
+    struct job *job;
+    int ret;
+
+    cursor_skip_init (&cs, jsctx, cursor, list_state);
     job = zlistx_first (list);
     while (job) {
-        if (job_filter (job, userid, states, results)) {
-            json_t *o;
-            if (!(o = job_to_json (job, attrs, errp)))
-                return -1;
-            if (json_array_append_new (jobs, o) < 0) {
-                json_decref (o);
-                errno = ENOMEM;
-                return -1;
-            }
-            if (json_array_size (jobs) == max_entries)
-                return 1;
+        if (!cursor_skip (&cs, job, list_state)
+            && job_filter (job, userid, states, results)) {
+            if ((ret = fn (job, list_state, arg)) != 0)
+                return ret;
         }
         job = zlistx_next (list);
     }
+    return 0;
+}
+
+/* Like foreach_list() on the inactive list, but merge the per-result
+ * inactive lists selected by 'results', most recently completed first.
+ */
+static int foreach_results (struct job_state_ctx *jsctx,
+                            const struct list_cursor *cursor,
+                            uint32_t userid,
+                            int states,
+                            int results,
+                            list_job_f fn,
+                            void *arg)
+{
+    zlistx_t *lists[JOB_RESULT_INDEX_COUNT];
+    struct job *next[JOB_RESULT_INDEX_COUNT];
+    struct cursor_skip cs;
+    int nlists = 0;
+    int bit;
+    int i;
+    int ret;
+
+    for (bit = 1; bit <= results; bit <<= 1) {
+        zlistx_t *l;
+        if ((results & bit) && (l = job_state_result_list (jsctx, bit))) {
+            lists[nlists] = l;
+            next[nlists] = zlistx_first (l);
+            nlists++;
+        }
+    }
+    cursor_skip_init (&cs, jsctx, cursor, FLUX_JOB_STATE_INACTIVE);
+    while (true) {
+        int n = -1;
+        for (i = 0; i < nlists; i++) {
+            if (next[i]
+                && (n < 0 || next[i]->t_inactive > next[n]->t_inactive))
+                n = i;
+        }
+        if (n < 0)
+            break;
+        if (!cursor_skip (&cs, next[n], FLUX_JOB_STATE_INACTIVE)
+            && job_filter (next[n], userid, states, results)) {
+            if ((ret = fn (next[n], FLUX_JOB_STATE_INACTIVE, arg)) != 0)
+                return ret;
+        }
+        next[n] = zlistx_next (lists[n]);
+    }
+    return 0;
+}
 
+/* Call fn for each job matching (userid, states, results) following
+ * 'cursor' (if non-NULL), in the order pending, running, inactive.
+ *
+ * Jobs of a single user are found through the per-user index, and
+ * inactive jobs of a subset of results through the per-result index,
+ * so that the cost is proportional to the number of matching jobs.
+ */
+static int foreach_job (struct info_ctx *ctx,
+                        const struct list_cursor *cursor,
+                        uint32_t userid,
+                        int states,
+                        int results,
+                        list_job_f fn,
+                        void *arg)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    zlistx_t *lists[] = { jsctx->pending, jsctx->running, jsctx->inactive };
+    int list_states[] = { FLUX_JOB_STATE_PENDING,
+                          FLUX_JOB_STATE_RUNNING,
+                          FLUX_JOB_STATE_INACTIVE };
+    int all_results = (FLUX_JOB_RESULT_COMPLETED
+                       | FLUX_JOB_RESULT_FAILED
+                       | FLUX_JOB_RESULT_CANCELED
+                       | FLUX_JOB_RESULT_TIMEOUT);
+    int i;
+    int ret;
+
+    if (userid != FLUX_USERID_UNKNOWN) {
+        struct job_user *user;
+        if (!(user = job_state_lookup_user (jsctx, userid)))
+            return 0;
+        lists[0] = user->pending;
+        lists[1] = user->running;
+        lists[2] = user->inactive;
+    }
+    for (i = 0; i < 3; i++) {
+        if (!(states & list_states[i]))
+            continue;
+        if (cursor && list_order (cursor->state) > i)
+            continue;
+        if (list_states[i] == FLUX_JOB_STATE_INACTIVE
+            && userid == FLUX_USERID_UNKNOWN
+            && (results & all_results) != all_results)
+            ret = foreach_results (jsctx,
+                                   cursor,
+                                   userid,
+                                   states,
+                                   results,
+                                   fn,
+                                   arg);
+        else
+            ret = foreach_list (jsctx,
+                                lists[i],
+                                list_states[i],
+                                cursor,
+                                userid,
+                                states,
+                                results,
+                                fn,
+                                arg);
+        if (ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
+struct get_jobs_arg {
+    json_t *jobs;
+    job_info_error_t *errp;
+    int max_entries;
+    json_t *attrs;
+    struct job *last;
+    int last_state;
+};
+
+/* Put job onto jobs array.  Returns 1 if jobs array is full, 0 if
+ * continue, -1 on error with errno set.
+ */
+static int get_jobs_append (struct job *job, int list_state, void *arg)
+{
+    struct get_jobs_arg *a = arg;
+    json_t *o;
+
+    if (!(o = job_to_json (job, a->attrs, a->errp)))
+        return -1;
+    if (json_array_append_new (a->jobs, o) < 0) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    a->last = job;
+    a->last_state = list_state;
+    if (json_array_size (a->jobs) == a->max_entries)
+        return 1;
     return 0;
 }
 
 /* Create a JSON array of 'job' objects.  'max_entries' determines the
- * max number of jobs to return, 0=unlimited.  Returns JSON object
- * which the caller must free.  On error, return NULL with errno set:
+ * max number of jobs to return, 0=unlimited.  If 'cursor' is non-NULL,
+ * begin after the job it identifies.  Returns JSON object which the
+ * caller must free.  If 'cursorp' is non-NULL, set it to the cursor of
+ * the last job returned, or NULL if none.  On error, return NULL with
+ * errno set:
  *
  * EPROTO - malformed or empty attrs array, max_entries out of range
  * ENOMEM - out of memory
@@ -92,89 +338,337 @@ json_t *get_jobs (struct info_ctx *ctx,
                   job_info_error_t *errp,
                   int max_entries,
                   json_t *attrs,
+                  const struct list_cursor *cursor,
                   uint32_t userid,
                   int states,
-                  int results)
+                  int results,
+                  json_t **cursorp)
 {
-    json_t *jobs = NULL;
-    int saved_errno;
-    int ret = 0;
-
-    if (!(jobs = json_array ()))
+    struct get_jobs_arg a = {
+        .errp = errp,
+        .max_entries = max_entries,
+        .attrs = attrs,
+    };
+    json_t *c = NULL;
+
+    if (!(a.jobs = json_array ()))
         goto error_nomem;
 
-    /* We return jobs in the following order, pending, running,
-     * inactive */
-
-    if (states & FLUX_JOB_STATE_PENDING) {
-        if ((ret = get_jobs_from_list (jobs,
-                                       errp,
-                                       ctx->jsctx->pending,
-                                       max_entries,
-                                       attrs,
-                                       userid,
-                                       states,
-                                       results)) < 0)
-            goto error;
+    if (foreach_job (ctx,
+                     cursor,
+                     userid,
+                     states,
+                     results,
+                     get_jobs_append,
+                     &a) < 0)
+        goto error;
+
+    if (cursorp) {
+        if (a.last && !(c = cursor_encode (a.last, a.last_state)))
+            goto error_nomem;
+        *cursorp = c;
     }
+    return a.jobs;
 
-    if (states & FLUX_JOB_STATE_RUNNING) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->running,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results)) < 0)
-                goto error;
-        }
+error_nomem:
+    errno = ENOMEM;
+error:
+    ERRNO_SAFE_WRAP (json_decref, a.jobs);
+    return NULL;
+}
+
+/* A streaming job-info.list request.  The matching jobs are selected
+ * when the request is received, then returned 'page_size' at a time,
+ * one page per reactor loop iteration, so that a large listing
+ * neither produces one huge message nor stalls other requests.  Jobs
+ * are never freed while the module is loaded, so holding pointers to
+ * them across iterations is safe.  The stream is terminated with an
+ * ENODATA error response.
+ */
+struct list_stream {
+    struct info_ctx *ctx;
+    const flux_msg_t *msg;
+    json_t *attrs;
+    struct job **jobs;
+    int *list_states;
+    size_t count;
+    size_t alloc;
+    size_t next;
+    int max_entries;
+    int page_size;
+    flux_watcher_t *check_w;
+    flux_watcher_t *idle_w;
+    void *handle;
+};
+
+static void list_stream_destroy (struct list_stream *ls)
+{
+    if (ls) {
+        int saved_errno = errno;
+        flux_watcher_destroy (ls->check_w);
+        flux_watcher_destroy (ls->idle_w);
+        flux_msg_decref (ls->msg);
+        json_decref (ls->attrs);
+        free (ls->jobs);
+        free (ls->list_states);
+        free (ls);
+        errno = saved_errno;
+    }
+}
+
+static int list_stream_add (struct job *job, int list_state, void *arg)
+{
+    struct list_stream *ls = arg;
+
+    if (ls->count == ls->alloc) {
+        size_t alloc = ls->alloc ? ls->alloc * 2 : 64;
+        struct job **jobs;
+        int *list_states;
+
+        if (!(jobs = realloc (ls->jobs, alloc * sizeof (jobs[0]))))
+            return -1;
+        ls->jobs = jobs;
+        if (!(list_states = realloc (ls->list_states,
+                                     alloc * sizeof (list_states[0]))))
+            return -1;
+        ls->list_states = list_states;
+        ls->alloc = alloc;
     }
+    ls->jobs[ls->count] = job;
+    ls->list_states[ls->count] = list_state;
+    ls->count++;
+    if (ls->count == (size_t)ls->max_entries)
+        return 1;
+    return 0;
+}
 
-    if (states & FLUX_JOB_STATE_INACTIVE) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->inactive,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results)) < 0)
-                goto error;
+/* Send the next page of jobs.  Return 1 if the stream is complete.
+ */
+static int list_stream_respond_page (struct list_stream *ls,
+                                     job_info_error_t *errp)
+{
+    flux_t *h = ls->ctx->h;
+    json_t *jobs;
+    json_t *cursor = NULL;
+    size_t last;
+
+    if (ls->next == ls->count) {
+        if (flux_respond_error (h, ls->msg, ENODATA, NULL) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        return 1;
+    }
+    if (!(jobs = json_array ()))
+        goto nomem;
+    while (ls->next < ls->count
+           && json_array_size (jobs) < (size_t)ls->page_size) {
+        json_t *o;
+        if (!(o = job_to_json (ls->jobs[ls->next], ls->attrs, errp)))
+            goto error;
+        if (json_array_append_new (jobs, o) < 0) {
+            json_decref (o);
+            goto nomem;
         }
+        ls->next++;
     }
+    last = ls->next - 1;
+    if (!(cursor = cursor_encode (ls->jobs[last], ls->list_states[last])))
+        goto nomem;
+    if (flux_respond_pack (h, ls->msg, "{s:O s:O}",
+                           "jobs", jobs,
+                           "cursor", cursor) < 0) {
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        goto error;
+    }
+    json_decref (cursor);
+    json_decref (jobs);
+    return 0;
+nomem:
+    errno = ENOMEM;
+error:
+    ERRNO_SAFE_WRAP (json_decref, cursor);
+    ERRNO_SAFE_WRAP (json_decref, jobs);
+    return -1;
+}
 
-    return jobs;
+static void list_stream_check_cb (flux_reactor_t *r,
+                                  flux_watcher_t *w,
+                                  int revents,
+                                  void *arg)
+{
+    struct list_stream *ls = arg;
+    job_info_error_t err = {{0}};
+    int rc;
 
-error_nomem:
+    if ((rc = list_stream_respond_page (ls, &err)) < 0) {
+        if (flux_respond_error (ls->ctx->h, ls->msg, errno, err.text) < 0)
+            flux_log_error (ls->ctx->h, "%s: flux_respond_error",
+                            __FUNCTION__);
+    }
+    if (rc != 0)
+        zlistx_delete (ls->ctx->list_streams, ls->handle);
+}
+
+static void list_stream_destroy_wrapper (void **data)
+{
+    if (data) {
+        list_stream_destroy (*data);
+        *data = NULL;
+    }
+}
+
+static int list_stream_start (struct info_ctx *ctx,
+                              const flux_msg_t *msg,
+                              int max_entries,
+                              json_t *attrs,
+                              const struct list_cursor *cursor,
+                              uint32_t userid,
+                              int states,
+                              int results,
+                              int page_size)
+{
+    flux_reactor_t *r = flux_get_reactor (ctx->h);
+    struct list_stream *ls;
+
+    if (!(ls = calloc (1, sizeof (*ls))))
+        return -1;
+    ls->ctx = ctx;
+    ls->msg = flux_msg_incref (msg);
+    ls->attrs = json_incref (attrs);
+    ls->max_entries = max_entries;
+    ls->page_size = page_size;
+    if (foreach_job (ctx,
+                     cursor,
+                     userid,
+                     states,
+                     results,
+                     list_stream_add,
+                     ls) < 0)
+        goto error;
+    if (!(ls->check_w = flux_check_watcher_create (r,
+                                                   list_stream_check_cb,
+                                                   ls))
+        || !(ls->idle_w = flux_idle_watcher_create (r, NULL, NULL)))
+        goto error;
+    if (!(ls->handle = zlistx_add_end (ctx->list_streams, ls)))
+        goto nomem;
+    flux_watcher_start (ls->check_w);
+    flux_watcher_start (ls->idle_w);
+    return 0;
+nomem:
     errno = ENOMEM;
 error:
-    saved_errno = errno;
-    json_decref (jobs);
-    errno = saved_errno;
-    return NULL;
+    list_stream_destroy (ls);
+    return -1;
+}
+
+/* Return true if list stream 'ls' matches (sender, matchtag).
+ * matchtag=FLUX_MATCHTAG_NONE matches any matchtag.
+ */
+static bool list_stream_match (struct list_stream *ls,
+                               const char *sender,
+                               uint32_t matchtag)
+{
+    uint32_t t;
+    char *s;
+    bool match = false;
+
+    if (matchtag != FLUX_MATCHTAG_NONE
+        && (flux_msg_get_matchtag (ls->msg, &t) < 0 || matchtag != t))
+        return false;
+    if (flux_msg_get_route_first (ls->msg, &s) < 0)
+        return false;
+    if (!strcmp (sender, s))
+        match = true;
+    free (s);
+    return match;
+}
+
+void list_streams_cancel (struct info_ctx *ctx,
+                          const char *sender,
+                          uint32_t matchtag)
+{
+    struct list_stream *ls;
+
+    ls = zlistx_first (ctx->list_streams);
+    while (ls) {
+        if (list_stream_match (ls, sender, matchtag)) {
+            if (matchtag != FLUX_MATCHTAG_NONE) {
+                if (flux_respond_error (ctx->h, ls->msg, ENODATA, NULL) < 0)
+                    flux_log_error (ctx->h, "%s: flux_respond_error",
+                                    __FUNCTION__);
+            }
+            zlistx_delete (ctx->list_streams, ls->handle);
+        }
+        ls = zlistx_next (ctx->list_streams);
+    }
+}
+
+void list_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    struct info_ctx *ctx = arg;
+    uint32_t matchtag;
+    char *sender;
+
+    if (flux_request_unpack (msg, NULL, "{s:i}", "matchtag", &matchtag) < 0) {
+        flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
+        return;
+    }
+    if (flux_msg_get_route_first (msg, &sender) < 0) {
+        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
+        return;
+    }
+    list_streams_cancel (ctx, sender, matchtag);
+    free (sender);
+}
+
+int list_stream_setup (struct info_ctx *ctx)
+{
+    if (!(ctx->list_streams = zlistx_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    zlistx_set_destructor (ctx->list_streams, list_stream_destroy_wrapper);
+    return 0;
+}
+
+void list_stream_cleanup (struct info_ctx *ctx)
+{
+    struct list_stream *ls;
+
+    ls = zlistx_first (ctx->list_streams);
+    while (ls) {
+        if (flux_respond_error (ctx->h, ls->msg, ENOSYS, NULL) < 0)
+            flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+        ls = zlistx_next (ctx->list_streams);
+    }
+    zlistx_destroy (&ctx->list_streams);
 }
 
 void list_cb (flux_t *h, flux_msg_handler_t *mh,
               const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
-    job_info_error_t err;
+    job_info_error_t err = {{0}};
     json_t *jobs = NULL;
+    json_t *c = NULL;
     json_t *attrs;
+    json_t *cursor_obj = NULL;
+    struct list_cursor cursor;
     int max_entries;
+    int page_size = LIST_PAGE_SIZE;
     uint32_t userid;
     int states;
     int results;
 
-    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i s?i s?o}",
                              "max_entries", &max_entries,
                              "attrs", &attrs,
                              "userid", &userid,
                              "states", &states,
-                             "results", &results) < 0) {
+                             "results", &results,
+                             "page_size", &page_size,
+                             "cursor", &cursor_obj) < 0) {
         seterror (&err, "invalid payload: %s", flux_msg_last_error (msg));
         errno = EPROTO;
         goto error;
@@ -184,11 +678,29 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
+    if (page_size <= 0) {
+        seterror (&err, "invalid payload: page_size must be > 0");
+        errno = EPROTO;
+        goto error;
+    }
     if (!json_is_array (attrs)) {
         seterror (&err, "invalid payload: attrs must be an array");
         errno = EPROTO;
         goto error;
     }
+    if (cursor_obj) {
+        if (json_unpack (cursor_obj, "{s:i s:F s:I}",
+                         "state", &cursor.state,
+                         "key", &cursor.key,
+                         "id", &cursor.id) < 0
+            || (cursor.state != FLUX_JOB_STATE_PENDING
+                && cursor.state != FLUX_JOB_STATE_RUNNING
+                && cursor.state != FLUX_JOB_STATE_INACTIVE)) {
+            seterror (&err, "invalid payload: malformed cursor");
+            errno = EPROTO;
+            goto error;
+        }
+    }
     /* If user sets no states, assume they want all information */
     if (!states)
         states = (FLUX_JOB_STATE_PENDING
@@ -202,22 +714,41 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
                    | FLUX_JOB_RESULT_CANCELED
                    | FLUX_JOB_RESULT_TIMEOUT);
 
-    if (!(jobs = get_jobs (ctx, &err, max_entries,
-                           attrs, userid, states, results)))
+    if (flux_msg_is_streaming (msg)) {
+        if (list_stream_start (ctx,
+                               msg,
+                               max_entries,
+                               attrs,
+                               cursor_obj ? &cursor : NULL,
+                               userid,
+                               states,
+                               results,
+                               page_size) < 0)
+            goto error;
+        return;
+    }
+
+    if (!(jobs = get_jobs (ctx, &err, max_entries, attrs,
+                           cursor_obj ? &cursor : NULL,
+                           userid, states, results, &c)))
         goto error;
 
-    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0) {
+    if (flux_respond_pack (h, msg, "{s:O s:O}",
+                           "jobs", jobs,
+                           "cursor", c ? c : json_null ()) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
 
     json_decref (jobs);
+    json_decref (c);
     return;
 
 error:
     if (flux_respond_error (h, msg, errno, err.text) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     json_decref (jobs);
+    json_decref (c);
 }
 
 /* Create a JSON array of 'job' objects.  'since' limits entries
@@ -18,6 +18,19 @@
 void list_cb (flux_t *h, flux_msg_handler_t *mh,
               const flux_msg_t *msg, void *arg);
 
+void list_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg);
+
+/* Cancel streaming list requests matching (sender, matchtag).
+ * matchtag=FLUX_MATCHTAG_NONE matches any matchtag.
+ */
+void list_streams_cancel (struct info_ctx *ctx,
+                          const char *sender, uint32_t matchtag);
+
+int list_stream_setup (struct info_ctx *ctx);
+
+void list_stream_cleanup (struct info_ctx *ctx);
+
 void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
                        const flux_msg_t *msg, void *arg);
 
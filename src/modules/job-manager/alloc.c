@@ -31,6 +31,10 @@
 #include "drain.h"
 #include "annotate.h"
 
+/* Max number of jobs in one batched sched.alloc request.
+ */
+#define ALLOC_BATCH_MAX 128
+
 struct alloc {
     struct job_manager *ctx;
     flux_msg_handler_t **handlers;
@@ -48,6 +52,8 @@ struct alloc {
     unsigned int alloc_pending_count;
     unsigned int free_pending_count;
     char *sched_sender; // for disconnect
+    bool batch;         // scheduler accepts batched alloc/free requests
+    json_t *free_batch; // free requests to send in the next batch
 };
 
 static void requeue_pending (struct alloc *alloc, struct job *job)
@@ -103,6 +109,9 @@ static void interface_teardown (struct alloc *alloc, char *s, int errnum)
             job = zhashx_next (ctx->active_jobs);
         }
         alloc->ready = false;
+        alloc->batch = false;
+        json_decref (alloc->free_batch);
+        alloc->free_batch = NULL;
         alloc->alloc_pending_count = 0;
         alloc->free_pending_count = 0;
         free (alloc->sched_sender);
@@ -111,60 +120,150 @@ static void interface_teardown (struct alloc *alloc, char *s, int errnum)
     }
 }
 
-/* Handle a sched.free response.
+/* Call 'fn' for each job in a sched.alloc or sched.free response, which
+ * may hold a single job or, from a batching scheduler, a "jobs" array.
  */
-static void free_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                              const flux_msg_t *msg, void *arg)
+static int foreach_response (struct job_manager *ctx,
+                             const flux_msg_t *msg,
+                             int (*fn)(struct job_manager *ctx, json_t *o))
 {
-    struct job_manager *ctx = arg;
+    json_t *jobs = NULL;
+    json_t *o;
+    size_t index;
+
+    if (flux_msg_unpack (msg, "{s?:o}", "jobs", &jobs) < 0)
+        return -1;
+    if (!jobs) {
+        if (flux_msg_unpack (msg, "o", &o) < 0)
+            return -1;
+        return fn (ctx, o);
+    }
+    if (!json_is_array (jobs)) {
+        errno = EPROTO;
+        return -1;
+    }
+    json_array_foreach (jobs, index, o) {
+        if (fn (ctx, o) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int free_response_one (struct job_manager *ctx, json_t *o)
+{
+    flux_t *h = ctx->h;
     flux_jobid_t id = 0;
     struct job *job;
 
-    if (flux_response_decode (msg, NULL, NULL) < 0)
-        goto teardown;
-    if (flux_msg_unpack (msg, "{s:I}", "id", &id) < 0)
-        goto teardown;
+    if (json_unpack (o, "{s:I}", "id", &id) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "sched.free-response: id=%ju not active",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     if (!job->has_resources) {
         flux_log (h, LOG_ERR, "sched.free-response: id=%ju not allocated",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     job->free_pending = 0;
     ctx->alloc->free_pending_count--;
-    if (event_job_post_pack (ctx->event, job, "free", 0, NULL) < 0)
-        goto teardown;
-    return;
-teardown:
-    interface_teardown (ctx->alloc, "free response error", errno);
+    free (job->R);
+    job->R = NULL;
+    return event_job_post_pack (ctx->event, job, "free", 0, NULL);
+}
+
+/* Handle a sched.free response.
+ */
+static void free_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0
+        || foreach_response (ctx, msg, free_response_one) < 0)
+        interface_teardown (ctx->alloc, "free response error", errno);
+}
+
+static json_t *free_request_payload (struct job *job)
+{
+    json_t *o;
+
+    if (job->R)
+        o = json_pack ("{s:I s:s}", "id", job->id, "R", job->R);
+    else
+        o = json_pack ("{s:I}", "id", job->id);
+    if (!o)
+        errno = ENOMEM;
+    return o;
 }
 
-/* Send sched.free request for job.
+/* Send sched.free request for job, or in batch mode, add it to the
+ * batch sent from prep_cb().
  * Update flags.
  */
 int free_request (struct alloc *alloc, struct job *job)
 {
     flux_msg_t *msg;
+    json_t *o;
 
-    if (!(msg = flux_request_encode ("sched.free", NULL)))
+    if (!(o = free_request_payload (job)))
         return -1;
-    if (flux_msg_pack (msg, "{s:I}", "id", job->id) < 0)
+    if (alloc->batch) {
+        if (!alloc->free_batch && !(alloc->free_batch = json_array ()))
+            goto nomem;
+        if (json_array_append_new (alloc->free_batch, o) < 0) {
+            o = NULL;
+            goto nomem;
+        }
+        return 0;
+    }
+    if (!(msg = flux_request_encode ("sched.free", NULL)))
         goto error;
+    if (flux_msg_pack (msg, "O", o) < 0)
+        goto error_msg;
     if (flux_send (alloc->ctx->h, msg, 0) < 0)
-        goto error;
+        goto error_msg;
     flux_msg_destroy (msg);
+    json_decref (o);
     return 0;
-error:
+nomem:
+    errno = ENOMEM;
+    goto error;
+error_msg:
     flux_msg_destroy (msg);
+error:
+    json_decref (o);
     return -1;
 }
 
+/* Send free requests accumulated in batch mode as one sched.free request.
+ */
+static int free_batch_flush (struct alloc *alloc)
+{
+    flux_msg_t *msg;
+    int rc = -1;
+
+    if (!alloc->free_batch || json_array_size (alloc->free_batch) == 0)
+        return 0;
+    if (!(msg = flux_request_encode ("sched.free", NULL)))
+        return -1;
+    if (flux_msg_pack (msg, "{s:O}", "jobs", alloc->free_batch) < 0)
+        goto done;
+    if (flux_send (alloc->ctx->h, msg, 0) < 0)
+        goto done;
+    json_array_clear (alloc->free_batch);
+    rc = 0;
+done:
+    flux_msg_destroy (msg);
+    return rc;
+}
+
 /* Send sched.cancel request for job.
 */
 int cancel_request (struct alloc *alloc, struct job *job)
@@ -186,40 +285,38 @@ int cancel_request (struct alloc *alloc, struct job *job)
     return 0;
 }
 
-/* Handle a sched.alloc response.
- * Update flags.
- */
-static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                               const flux_msg_t *msg, void *arg)
+static int alloc_response_one (struct job_manager *ctx, json_t *o)
 {
-    struct job_manager *ctx = arg;
+    flux_t *h = ctx->h;
     struct alloc *alloc = ctx->alloc;
     flux_jobid_t id;
     int type;
     char *note = NULL;
     json_t *annotations = NULL;
+    const char *R = NULL;
     struct job *job;
     bool cleared = false;
 
-    if (flux_response_decode (msg, NULL, NULL) < 0)
-        goto teardown; // ENOSYS here if scheduler not loaded/shutting down
-    if (flux_msg_unpack (msg, "{s:I s:i s?:s s?:o}",
-                              "id", &id,
-                              "type", &type,
-                              "note", &note,
-                              "annotations", &annotations) < 0)
-        goto teardown;
+    if (json_unpack (o, "{s:I s:i s?:s s?:o s?:s}",
+                        "id", &id,
+                        "type", &type,
+                        "note", &note,
+                        "annotations", &annotations,
+                        "R", &R) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "sched.alloc-response: id=%ju not active",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     if (!job->alloc_pending) {
         flux_log (h, LOG_ERR, "sched.alloc-response: id=%ju not requested",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     switch (type) {
     case FLUX_SCHED_ALLOC_SUCCESS:
@@ -236,7 +333,17 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
                       "sched.alloc-response: id=%ju already allocated",
                       (uintmax_t)id);
             errno = EEXIST;
-            goto teardown;
+            return -1;
+        }
+        /* Keep R, if the scheduler sent it, to pass back in sched.free
+         * and sched-hello.  Not fatal if missing: the scheduler can
+         * still look it up in the KVS.
+         */
+        if (R) {
+            free (job->R);
+            if (!(job->R = strdup (R)))
+                flux_log_error (h, "sched.alloc-response: id=%ju copy R",
+                                (uintmax_t)id);
         }
         if (annotations_update_and_publish (ctx, job, annotations) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
@@ -244,17 +351,17 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
             if (event_job_post_pack (ctx->event, job, "alloc", 0,
                                      "{ s:O }",
                                      "annotations", job->annotations) < 0)
-                goto teardown;
+                return -1;
         }
         else {
             if (event_job_post_pack (ctx->event, job, "alloc", 0, NULL) < 0)
-                goto teardown;
+                return -1;
         }
         break;
     case FLUX_SCHED_ALLOC_ANNOTATE: // annotation
         if (!annotations) {
             errno = EPROTO;
-            goto teardown;
+            return -1;
         }
         if (annotations_update_and_publish (ctx, job, annotations) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
@@ -282,7 +389,7 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
                                  "severity", 0,
                                  "userid", FLUX_USERID_UNKNOWN,
                                  "note", note ? note : "") < 0)
-            goto teardown;
+            return -1;
         break;
     case FLUX_SCHED_ALLOC_CANCEL:
         alloc->alloc_pending_count--;
@@ -309,17 +416,29 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
             flux_log_error (h,
                             "event_job_action id=%ju on alloc cancel",
                             (uintmax_t)id);
-            goto teardown;
+            return -1;
         }
         drain_check (alloc->ctx->drain);
         break;
     default:
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
-    return;
-teardown:
-    interface_teardown (alloc, "alloc response error", errno);
+    return 0;
+}
+
+/* Handle a sched.alloc response.
+ * Update flags.
+ */
+static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                               const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+
+    // ENOSYS from decode if scheduler not loaded/shutting down
+    if (flux_response_decode (msg, NULL, NULL) < 0
+        || foreach_response (ctx, msg, alloc_response_one) < 0)
+        interface_teardown (ctx->alloc, "alloc response error", errno);
 }
 
 /* Send sched.alloc request for job.
@@ -347,6 +466,52 @@ error:
     return -1;
 }
 
+/* Send one sched.alloc request for up to 'max' jobs from the head of
+ * the queue.  Set 'count' to the number of jobs included.
+ */
+static int alloc_request_batch (struct alloc *alloc, int max, int *count)
+{
+    flux_msg_t *msg = NULL;
+    json_t *jobs;
+    struct job *job;
+    int n = 0;
+
+    if (!(jobs = json_array ()))
+        goto nomem;
+    job = zlistx_first (alloc->queue);
+    while (job && n < max && job->priority != FLUX_JOB_PRIORITY_MIN) {
+        json_t *o;
+        if (!(o = json_pack ("{s:I s:I s:i s:f s:O}",
+                             "id", job->id,
+                             "priority", (json_int_t)job->priority,
+                             "userid", job->userid,
+                             "t_submit", job->t_submit,
+                             "jobspec", job->jobspec_redacted))
+            || json_array_append_new (jobs, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+        n++;
+        job = zlistx_next (alloc->queue);
+    }
+    if (!(msg = flux_request_encode ("sched.alloc", NULL)))
+        goto error;
+    if (flux_msg_pack (msg, "{s:O}", "jobs", jobs) < 0)
+        goto error;
+    if (flux_send (alloc->ctx->h, msg, 0) < 0)
+        goto error;
+    flux_msg_destroy (msg);
+    json_decref (jobs);
+    *count = n;
+    return 0;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_msg_destroy (msg);
+    json_decref (jobs);
+    return -1;
+}
+
 /* sched-hello:
  * Scheduler obtains jobs that have resources allocated.
  */
@@ -369,12 +534,23 @@ static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
     job = zhashx_first (ctx->active_jobs);
     while (job) {
         if (job->has_resources) {
-            if (flux_respond_pack (h, msg,
-                                   "{s:I s:I s:i s:f}",
-                                   "id", job->id,
-                                   "priority", job->priority,
-                                   "userid", job->userid,
-                                   "t_submit", job->t_submit) < 0)
+            int rc;
+            if (job->R)
+                rc = flux_respond_pack (h, msg,
+                                        "{s:I s:I s:i s:f s:s}",
+                                        "id", job->id,
+                                        "priority", job->priority,
+                                        "userid", job->userid,
+                                        "t_submit", job->t_submit,
+                                        "R", job->R);
+            else
+                rc = flux_respond_pack (h, msg,
+                                        "{s:I s:I s:i s:f}",
+                                        "id", job->id,
+                                        "priority", job->priority,
+                                        "userid", job->userid,
+                                        "t_submit", job->t_submit);
+            if (rc < 0)
                 goto error;
         }
         job = zhashx_next (ctx->active_jobs);
@@ -398,12 +574,14 @@ static void ready_cb (flux_t *h, flux_msg_handler_t *mh,
     struct job_manager *ctx = arg;
     const char *mode;
     int limit = 0;
+    int batch = 0;
     int count;
     struct job *job;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s?:i}",
+    if (flux_request_unpack (msg, NULL, "{s:s s?:i s?:b}",
                                         "mode", &mode,
-                                        "limit", &limit) < 0)
+                                        "limit", &limit,
+                                        "batch", &batch) < 0)
         goto error;
     if (!strcmp (mode, "limited")) {
         if (limit <= 0) {
@@ -423,9 +601,13 @@ static void ready_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     ctx->alloc->ready = true;
-    flux_log (h, LOG_DEBUG, "scheduler: ready %s", mode);
+    ctx->alloc->batch = batch ? true : false;
+    flux_log (h, LOG_DEBUG, "scheduler: ready %s%s",
+              mode, batch ? " batch" : "");
     count = zlistx_size (ctx->alloc->queue);
-    if (flux_respond_pack (h, msg, "{s:i}", "count", count) < 0)
+    if (flux_respond_pack (h, msg, "{s:i s:b}",
+                           "count", count,
+                           "batch", batch) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     /* Restart any free requests that might have been interrupted
      * when scheduler was last unloaded.
@@ -458,6 +640,10 @@ static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct alloc *alloc = ctx->alloc;
     struct job *job;
 
+    if (free_batch_flush (alloc) < 0) {
+        interface_teardown (alloc, "free request error", errno);
+        return;
+    }
     if (!alloc->ready || alloc->disable)
         return;
     if (alloc->alloc_limit
@@ -495,25 +681,44 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     */
     if ((job = zlistx_first (alloc->queue))
         && job->priority != FLUX_JOB_PRIORITY_MIN) {
-        bool fwd = job->priority > (FLUX_JOB_PRIORITY_MAX / 2);
-        if (alloc_request (alloc, job) < 0) {
+        int count = 1;
+        int rc;
+
+        if (alloc->batch) {
+            int max = ALLOC_BATCH_MAX;
+            if (alloc->alloc_limit
+                && alloc->alloc_limit - alloc->alloc_pending_count < max)
+                max = alloc->alloc_limit - alloc->alloc_pending_count;
+            rc = alloc_request_batch (alloc, max, &count);
+        }
+        else
+            rc = alloc_request (alloc, job);
+        if (rc < 0) {
             flux_log_error (ctx->h, "alloc_request fatal error");
             flux_reactor_stop_error (flux_get_reactor (ctx->h));
             return;
         }
-        zlistx_delete (alloc->queue, job->handle);
-        job->handle = NULL;
-        job->alloc_pending = 1;
-        job->alloc_queued = 0;
-        alloc->alloc_pending_count++;
-        if (alloc->alloc_limit) {
-            if (!(job->handle = zlistx_insert (alloc->pending_jobs, job, fwd)))
-                flux_log (ctx->h, LOG_ERR, "failed to enqueue pending job");
-        }
-        if ((job->flags & FLUX_JOB_DEBUG))
-            (void)event_job_post_pack (ctx->event, job,
-                                       "debug.alloc-request", 0, NULL);
+        /* The jobs just sent are the first 'count' in the queue.
+         */
+        while (count-- > 0 && (job = zlistx_first (alloc->queue))) {
+            bool fwd = job->priority > (FLUX_JOB_PRIORITY_MAX / 2);
 
+            zlistx_delete (alloc->queue, job->handle);
+            job->handle = NULL;
+            job->alloc_pending = 1;
+            job->alloc_queued = 0;
+            alloc->alloc_pending_count++;
+            if (alloc->alloc_limit) {
+                if (!(job->handle = zlistx_insert (alloc->pending_jobs,
+                                                   job,
+                                                   fwd)))
+                    flux_log (ctx->h, LOG_ERR,
+                              "failed to enqueue pending job");
+            }
+            if ((job->flags & FLUX_JOB_DEBUG))
+                (void)event_job_post_pack (ctx->event, job,
+                                           "debug.alloc-request", 0, NULL);
+        }
     }
 }
 
@@ -782,6 +987,7 @@ void alloc_ctx_destroy (struct alloc *alloc)
         flux_watcher_destroy (alloc->idle);
         zlistx_destroy (&alloc->queue);
         zlistx_destroy (&alloc->pending_jobs);
+        json_decref (alloc->free_batch);
         free (alloc->disable_reason);
         free (alloc->sched_sender);
         free (alloc);
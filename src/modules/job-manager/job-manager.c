@@ -30,6 +30,7 @@
 #include "annotate.h"
 #include "journal.h"
 #include "getattr.h"
+#include "snapshot.h"
 #include "jobtap-internal.h"
 
 #include "job-manager.h"
@@ -112,6 +113,12 @@ static const struct flux_msg_handler_spec htab[] = {
         getinfo_handle_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.sched-snapshot",
+        snapshot_handle_request,
+        0
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "job-manager.jobtap",
@@ -29,6 +29,7 @@ void job_decref (struct job *job)
         flux_msg_decref (job->waiter);
         json_decref (job->jobspec_redacted);
         json_decref (job->annotations);
+        free (job->R);
         free (job);
         errno = saved_errno;
     }
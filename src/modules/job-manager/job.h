@@ -36,6 +36,7 @@ struct job {
     uint8_t start_pending:1;// start request sent to job-exec
 
     json_t *annotations;
+    char *R;                // R from alloc response (may be NULL)
 
     void *handle;           // zlistx_t handle
     int refcount;           // private to job.c
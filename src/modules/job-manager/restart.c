@@ -14,6 +14,7 @@
 #include "config.h"
 #endif
 #include <stdlib.h>
+#include <string.h>
 #include <argz.h>
 #include <envz.h>
 #include <flux/core.h>
@@ -158,6 +159,64 @@ static int restart_map_cb (struct job *job, void *arg)
     return 0;
 }
 
+/* Maximum number of R lookups in flight during restart.
+ */
+#define LOOKUP_R_BATCH 1024
+
+static void lookup_R_finish (flux_t *h, flux_future_t **fv, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        struct job *job = flux_future_aux_get (fv[i], "job");
+        const char *R;
+
+        if (flux_kvs_lookup_get (fv[i], &R) < 0
+            || !(job->R = strdup (R)))
+            flux_log_error (h, "restart: id=%ju: error looking up R",
+                            (uintmax_t)job->id);
+        flux_future_destroy (fv[i]);
+    }
+}
+
+/* Recover R of active jobs that still have resources, so it can be passed
+ * back to the scheduler in sched.free, sched-hello, and sched-snapshot.
+ * Lookups are sent in batches, then the responses are collected, so
+ * restart does not wait for a KVS round trip per job.
+ * Not fatal on failure: the scheduler can look it up itself.
+ */
+static void lookup_R (struct job_manager *ctx)
+{
+    flux_future_t *fv[LOOKUP_R_BATCH];
+    int count = 0;
+    struct job *job;
+
+    job = zhashx_first (ctx->active_jobs);
+    while (job) {
+        if (job->has_resources && !job->R) {
+            flux_future_t *f = NULL;
+            char key[64];
+
+            if (flux_job_kvs_key (key, sizeof (key), job->id, "R") < 0
+                || !(f = flux_kvs_lookup (ctx->h, NULL, 0, key))
+                || flux_future_aux_set (f, "job", job, NULL) < 0) {
+                flux_log_error (ctx->h, "restart: id=%ju: error looking up R",
+                                (uintmax_t)job->id);
+                flux_future_destroy (f);
+            }
+            else {
+                fv[count++] = f;
+                if (count == LOOKUP_R_BATCH) {
+                    lookup_R_finish (ctx->h, fv, count);
+                    count = 0;
+                }
+            }
+        }
+        job = zhashx_next (ctx->active_jobs);
+    }
+    lookup_R_finish (ctx->h, fv, count);
+}
+
 static int checkpoint_save (struct job_manager *ctx)
 {
     flux_future_t *f = NULL;
@@ -213,6 +272,7 @@ int restart_from_kvs (struct job_manager *ctx)
     count = depthfirst_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
     if (count < 0)
         return -1;
+    lookup_R (ctx);
     flux_log (ctx->h, LOG_INFO, "restart: %d jobs", count);
     /* Post flux-restart to any jobs in SCHED state, so they may
      * transition back to PRIORITY and re-obtain the priority.
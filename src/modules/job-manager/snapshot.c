@@ -0,0 +1,152 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sched-snapshot - scheduler state in one response
+ *
+ * Purpose:
+ *   Let a (re)loaded scheduler rebuild its state in one round trip,
+ *   instead of the sched-hello stream of one response per job.
+ *
+ * Input:
+ * - none
+ *
+ * Output:
+ * - R: union of R for all jobs that have resources allocated
+ * - jobs: array of {id, priority, userid, t_submit, R} for those jobs
+ * - pending: array of {id, priority, userid, t_submit} for jobs in
+ *   the alloc queue, in queue order
+ *
+ * Errors:
+ * - EAGAIN: R is not known for some job with resources.  The scheduler
+ *   should fall back to sched-hello.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/librlist/rlist.h"
+
+#include "job.h"
+#include "alloc.h"
+#include "job-manager.h"
+
+#include "snapshot.h"
+
+static int append_job (json_t *a, struct job *job, const char *R)
+{
+    json_t *o;
+
+    if (R)
+        o = json_pack ("{s:I s:I s:i s:f s:s}",
+                       "id", job->id,
+                       "priority", job->priority,
+                       "userid", job->userid,
+                       "t_submit", job->t_submit,
+                       "R", R);
+    else
+        o = json_pack ("{s:I s:I s:i s:f}",
+                       "id", job->id,
+                       "priority", job->priority,
+                       "userid", job->userid,
+                       "t_submit", job->t_submit);
+    if (!o || json_array_append_new (a, o) < 0) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void snapshot_handle_request (flux_t *h,
+                              flux_msg_handler_t *mh,
+                              const flux_msg_t *msg,
+                              void *arg)
+{
+    struct job_manager *ctx = arg;
+    struct rlist *rl = NULL;
+    json_t *jobs = NULL;
+    json_t *pending = NULL;
+    json_t *R = NULL;
+    const char *errmsg = NULL;
+    struct job *job;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(rl = rlist_create ())
+        || !(jobs = json_array ())
+        || !(pending = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    job = zhashx_first (ctx->active_jobs);
+    while (job) {
+        if (job->has_resources) {
+            struct rlist *alloc;
+            int rc;
+
+            if (!job->R) {
+                errmsg = "R is not known for all jobs";
+                errno = EAGAIN;
+                goto error;
+            }
+            if (!(alloc = rlist_from_R (job->R))) {
+                errmsg = "error decoding R";
+                errno = EPROTO;
+                goto error;
+            }
+            rc = rlist_append (rl, alloc);
+            rlist_destroy (alloc);
+            if (rc < 0) {
+                errmsg = "error merging R";
+                errno = EPROTO;
+                goto error;
+            }
+            if (append_job (jobs, job, job->R) < 0)
+                goto error;
+        }
+        job = zhashx_next (ctx->active_jobs);
+    }
+    job = alloc_queue_first (ctx->alloc);
+    while (job) {
+        if (append_job (pending, job, NULL) < 0)
+            goto error;
+        job = alloc_queue_next (ctx->alloc);
+    }
+    if (!(R = rlist_to_R (rl))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    flux_log (h, LOG_DEBUG, "scheduler: snapshot (%zu jobs, %zu pending)",
+              json_array_size (jobs),
+              json_array_size (pending));
+    if (flux_respond_pack (h, msg, "{s:O s:O s:O}",
+                           "R", R,
+                           "jobs", jobs,
+                           "pending", pending) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (R);
+    json_decref (jobs);
+    json_decref (pending);
+    rlist_destroy (rl);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (jobs);
+    json_decref (pending);
+    rlist_destroy (rl);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
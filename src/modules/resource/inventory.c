@@ -159,22 +159,24 @@ static void inventory_put_continuation (flux_future_t *f, void *arg)
     (void)inventory_put_finalize (inv);
 }
 
-static int xml_to_fixed_array_map (unsigned int id, json_t *val, void *arg)
+static int xml_to_fixed_array_map (unsigned int id, const char *xml, void *arg)
 {
     json_t *array = arg;
+    json_t *o;
 
     if (id >= json_array_size (array)) {
         errno = EINVAL;
         return -1;
     }
-    if (json_array_set (array, id, val) < 0) {
+    if (!(o = json_string (xml)) || json_array_set_new (array, id, o) < 0) {
+        json_decref (o);
         errno = ENOMEM;
         return -1;
     }
     return 0;
 }
 
-/* Convert object with idset keys to fixed size array, which should be easier
+/* Convert xmlset to fixed size array, which should be easier
  * for end users to handle.  Any unpopulated array slots are set to JSON null.
  */
 static json_t *xml_to_fixed_array (json_t *xml, uint32_t size)
@@ -188,7 +190,7 @@ static json_t *xml_to_fixed_array (json_t *xml, uint32_t size)
         if (json_array_append (array, json_null ()) < 0)
             goto nomem;
     }
-    if (rutil_idkey_map (xml, xml_to_fixed_array_map, array) < 0)
+    if (rutil_xmlset_map (xml, xml_to_fixed_array_map, array) < 0)
         goto error;
     return array;
 nomem:
@@ -211,8 +213,8 @@ int inventory_put_xml (struct inventory *inv, json_t *xml)
         errno = EEXIST;
         return -1;
     }
-    flux_log (inv->ctx->h, LOG_DEBUG, "xml %d ranks in %zu objects",
-              rutil_idkey_count (xml), json_object_size (xml));
+    flux_log (inv->ctx->h, LOG_DEBUG, "xml %d ranks in %d unique topologies",
+              rutil_xmlset_count (xml), rutil_xmlset_unique (xml));
     inv->xml = json_incref (xml);
 
     if (zlist_size (inv->waiters) > 0) {
@@ -578,6 +580,29 @@ static int rank_from_key (const char *key)
     return rank;
 }
 
+static json_t *xmlset_from_xml (json_t *xml)
+{
+    const char *key;
+    json_t *value;
+    int rank;
+    json_t *xs;
+
+    if (!(xs = rutil_xmlset_create ()))
+        return NULL;
+    json_object_foreach (xml, key, value) {
+        if ((rank = rank_from_key (key)) < 0) {
+            errno = EINVAL;
+            goto error;
+        }
+        if (rutil_xmlset_insert (xs, rank, json_string_value (value)) < 0)
+            goto error;
+    }
+    return xs;
+error:
+    ERRNO_SAFE_WRAP (json_decref, xs);
+    return NULL;
+}
+
 static json_t *resobj_from_xml (json_t *xml)
 {
     const char *key;
@@ -650,6 +675,7 @@ static void resource_reload (flux_t *h,
     int force_flag;
     json_t *resobj = NULL;
     json_t *xml = NULL;
+    json_t *xs = NULL;
 
     if (flux_request_unpack (msg,
                              NULL,
@@ -680,6 +706,8 @@ static void resource_reload (flux_t *h,
             errstr = errbuf;
             goto error;
         }
+        if (!(xs = xmlset_from_xml (xml)))
+            goto error;
     }
     else {
         if (!(resobj = rutil_load_file (path, errbuf, sizeof (errbuf)))) {
@@ -710,12 +738,12 @@ static void resource_reload (flux_t *h,
         errstr = "resources are busy (unload scheduler?)";
         goto error;
     }
-    if (xml) {
+    if (xs) {
         if (inv->xml) {
             json_decref (inv->xml);
             inv->xml = NULL;
         }
-        if (inventory_put_xml (inv, xml) < 0)
+        if (inventory_put_xml (inv, xs) < 0)
             goto error;
     }
     if (inv->R) {
@@ -732,12 +760,14 @@ static void resource_reload (flux_t *h,
         flux_log_error (h, "error responding to resource.reload request");
     json_decref (resobj);
     json_decref (xml);
+    json_decref (xs);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "error responding to resource.reload request");
     json_decref (resobj);
     json_decref (xml);
+    json_decref (xs);
 }
 
 static const struct flux_msg_handler_spec htab[] = {
@@ -38,6 +38,8 @@ const char *inventory_get_method (struct inventory *inv);
  */
 int inventory_put (struct inventory *inv, json_t *R, const char *method);
 
+/* Set the hwloc XML for all ranks, in rutil xmlset form.
+ */
 int inventory_put_xml (struct inventory *inv, json_t *xml);
 
 /* Return a set of ranks for a string of "targets". The 'targets' argument
@@ -72,18 +72,14 @@ const struct idset *monitor_get_up (struct monitor *monitor)
 const struct idset *monitor_get_down (struct monitor *monitor)
 {
     uint32_t size = monitor->ctx->size;
-    unsigned int id;
 
     if (!monitor->down) {
-        if (!(monitor->down = idset_create (size, 0)))
+        if (!(monitor->down = idset_create (size, IDSET_FLAG_BITMAP)))
             return NULL;
     }
-    for (id = 0; id < size; id++) {
-        if (idset_test (monitor->up, id))
-            (void)idset_clear (monitor->down, id);
-        else
-            (void)idset_set (monitor->down, id);
-    }
+    if (idset_range_set (monitor->down, 0, size - 1) < 0
+        || (monitor->up && idset_subtract (monitor->down, monitor->up) < 0))
+        return NULL;
     return monitor->down;
 }
 
@@ -104,9 +100,9 @@ static struct batch *batch_create (struct monitor *monitor)
 
     if (!(b = calloc (1, sizeof (*b))))
         return NULL;
-    if (!(b->up = idset_create (monitor->ctx->size, 0)))
+    if (!(b->up = idset_create (monitor->ctx->size, IDSET_FLAG_BITMAP)))
         goto error;
-    if (!(b->down = idset_create (monitor->ctx->size, 0)))
+    if (!(b->down = idset_create (monitor->ctx->size, IDSET_FLAG_BITMAP)))
         goto error;
     flux_timer_watcher_reset (monitor->batch_timer, batch_timeout_seconds, 0.);
     flux_watcher_start (monitor->batch_timer);
@@ -453,7 +449,7 @@ struct monitor *monitor_create (struct resource_ctx *ctx,
          * N.B. Initial up value will appear in 'restart' event posted
          * to resource.eventlog.
          */
-        if (!(monitor->up = idset_create (ctx->size, 0)))
+        if (!(monitor->up = idset_create (ctx->size, IDSET_FLAG_BITMAP)))
             goto error;
         if (monitor_force_up) {
             if (idset_range_set (monitor->up, 0, ctx->size - 1) < 0)
@@ -23,6 +23,7 @@
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/dirwalk.h"
 #include "src/common/libutil/read_all.h"
+#include "src/common/libutil/blobref.h"
 
 #include "rutil.h"
 
@@ -32,15 +33,8 @@ int rutil_idset_sub (struct idset *ids1, const struct idset *ids2)
         errno = EINVAL;
         return -1;
     }
-    if (ids2) {
-        unsigned int id;
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (idset_clear (ids1, id) < 0)
-                return -1;
-            id = idset_next (ids2, id);
-        }
-    }
+    if (ids2)
+        return idset_subtract (ids1, ids2);
     return 0;
 }
 
@@ -50,15 +44,8 @@ int rutil_idset_add (struct idset *ids1, const struct idset *ids2)
         errno = EINVAL;
         return -1;
     }
-    if (ids2) {
-        unsigned int id;
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (idset_set (ids1, id) < 0)
-                return -1;
-            id = idset_next (ids2, id);
-        }
-    }
+    if (ids2)
+        return idset_add (ids1, ids2);
     return 0;
 }
 
@@ -69,34 +56,25 @@ int rutil_idset_diff (const struct idset *ids1,
 {
     struct idset *add = NULL;
     struct idset *sub = NULL;
-    unsigned int id;
 
     if (!addp || !subp) {
         errno = EINVAL;
         return -1;
     }
     if (ids1) { // find ids in ids1 but not in ids2, and add to 'sub'
-        id = idset_first (ids1);
-        while (id != IDSET_INVALID_ID) {
-            if (!ids2 || !idset_test (ids2, id)) {
-                if (!sub && !(sub = idset_create (0, IDSET_FLAG_AUTOGROW)))
-                    goto error;
-                if (idset_set (sub, id) < 0)
-                    goto error;
-            }
-            id = idset_next (ids1, id);
+        if (!(sub = ids2 ? idset_difference (ids1, ids2) : idset_copy (ids1)))
+            goto error;
+        if (idset_count (sub) == 0) {
+            idset_destroy (sub);
+            sub = NULL;
         }
     }
     if (ids2) { // find ids in ids2 but not in ids1, and add to 'add'
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (!ids1 || !idset_test (ids1, id)) {
-                if (!add && !(add = idset_create (0, IDSET_FLAG_AUTOGROW)))
-                    goto error;
-                if (idset_set (add, id) < 0)
-                    goto error;
-            }
-            id = idset_next (ids2, id);
+        if (!(add = ids1 ? idset_difference (ids2, ids1) : idset_copy (ids2)))
+            goto error;
+        if (idset_count (add) == 0) {
+            idset_destroy (add);
+            add = NULL;
         }
     }
     *addp = add;
@@ -300,37 +278,44 @@ json_t *rutil_load_xml_dir (const char *path, char *errbuf, int errbufsize)
     return o;
 }
 
-static int idkey_remove_id (json_t *obj, unsigned int id)
+/* Remove 'ids' from all keys of 'obj', dropping any keys left empty.
+ * Keys are decoded once each rather than once per id.
+ */
+static int idkey_remove_idset (json_t *obj, const struct idset *ids)
 {
     const char *key;
     json_t *val;
+    void *tmp;
 
-    json_object_foreach (obj, key, val) {
-        struct idset *ids;
+    json_object_foreach_safe (obj, tmp, key, val) {
+        struct idset *key_ids;
+        size_t count;
         char *new_key;
 
-        if (!(ids = idset_decode (key)))
+        if (!(key_ids = idset_decode (key)))
+            return -1;
+        count = idset_count (key_ids);
+        if (rutil_idset_sub (key_ids, ids) < 0) {
+            idset_destroy (key_ids);
             return -1;
-        if (idset_test (ids, id)) {
-            idset_clear (ids, id);
-            if (idset_count (ids) > 0) {
-                if (!(new_key = idset_encode (ids, IDSET_FLAG_RANGE))) {
-                    idset_destroy (ids);
+        }
+        if (idset_count (key_ids) != count) {
+            if (idset_count (key_ids) > 0) {
+                if (!(new_key = idset_encode (key_ids, IDSET_FLAG_RANGE))) {
+                    idset_destroy (key_ids);
                     return -1;
                 }
                 if (json_object_set (obj, new_key, val) < 0) {
                     free (new_key);
-                    idset_destroy (ids);
+                    idset_destroy (key_ids);
                     errno = ENOMEM;
                     return -1;
                 }
                 free (new_key);
             }
             (void)json_object_del (obj, key);
-            idset_destroy (ids);
-            break;
         }
-        idset_destroy (ids);
+        idset_destroy (key_ids);
     }
     return 0;
 }
@@ -348,14 +333,9 @@ int rutil_idkey_insert_idset (json_t *obj, struct idset *new_ids, json_t *val)
     bool found = false;
     struct idset *ids = NULL;
     char *key = NULL;
-    unsigned int id;
 
-    id = idset_first (new_ids);
-    while (id != IDSET_INVALID_ID) {
-        if (idkey_remove_id (obj, id) < 0)
-            return -1;
-        id = idset_next (new_ids, id);
-    }
+    if (idkey_remove_idset (obj, new_ids) < 0)
+        return -1;
     json_object_foreach (obj, orig_key, orig_val) {
         if (json_equal (orig_val, val)) {
             found = true;
@@ -452,6 +432,301 @@ int rutil_idkey_count (json_t *obj)
     return count;
 }
 
+#define HOSTNAME_ATTR "name=\"HostName\" value=\""
+
+/* Split 'xml' into a template with the HostName value removed and the
+ * hostname itself.  If there is no HostName, the template is the whole
+ * input and '*hostname' is set to NULL.  Caller must free both.
+ */
+static int xml_split_hostname (const char *xml, char **template, char **hostname)
+{
+    const char *start;
+    const char *end;
+    char *t;
+    char *hn = NULL;
+
+    if ((start = strstr (xml, HOSTNAME_ATTR))) {
+        start += strlen (HOSTNAME_ATTR);
+        if (!(end = strchr (start, '"')) || end == start)
+            start = NULL;
+    }
+    if (!start) {
+        if (!(t = strdup (xml)))
+            return -1;
+    }
+    else {
+        size_t prefix = start - xml;
+        if (!(hn = strndup (start, end - start))
+            || !(t = malloc (prefix + strlen (end) + 1))) {
+            ERRNO_SAFE_WRAP (free, hn);
+            return -1;
+        }
+        memcpy (t, xml, prefix);
+        strcpy (t + prefix, end);
+    }
+    *template = t;
+    *hostname = hn;
+    return 0;
+}
+
+/* Reverse xml_split_hostname().
+ */
+static char *xml_join_hostname (const char *template, const char *hostname)
+{
+    const char *start;
+    size_t prefix;
+    char *xml;
+
+    if (!hostname || !(start = strstr (template, HOSTNAME_ATTR)))
+        return strdup (template);
+    start += strlen (HOSTNAME_ATTR);
+    prefix = start - template;
+    if (!(xml = malloc (strlen (template) + strlen (hostname) + 1)))
+        return NULL;
+    memcpy (xml, template, prefix);
+    strcpy (xml + prefix, hostname);
+    strcat (xml + prefix, start);
+    return xml;
+}
+
+json_t *rutil_xmlset_create (void)
+{
+    json_t *xs;
+
+    if (!(xs = json_pack ("{s:{} s:{} s:{}}",
+                          "topo",
+                          "ranks",
+                          "hostname"))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return xs;
+}
+
+static int xmlset_unpack (json_t *xs,
+                          json_t **topo,
+                          json_t **ranks,
+                          json_t **hostname)
+{
+    if (!xs || json_unpack (xs,
+                            "{s:o s:o s:o}",
+                            "topo",
+                            topo,
+                            "ranks",
+                            ranks,
+                            "hostname",
+                            hostname) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Remove topology bodies no longer referenced by any rank, e.g. after
+ * a rank's XML was replaced.
+ */
+static int xmlset_sweep (json_t *topo, json_t *ranks)
+{
+    json_t *used;
+    const char *key;
+    json_t *val;
+    void *tmp;
+
+    if (!(used = json_object ()))
+        goto nomem;
+    json_object_foreach (ranks, key, val) {
+        const char *digest = json_string_value (val);
+        if (digest && json_object_set (used, digest, json_null ()) < 0)
+            goto nomem;
+    }
+    json_object_foreach_safe (topo, tmp, key, val) {
+        if (!json_object_get (used, key))
+            (void)json_object_del (topo, key);
+    }
+    json_decref (used);
+    return 0;
+nomem:
+    json_decref (used);
+    errno = ENOMEM;
+    return -1;
+}
+
+int rutil_xmlset_insert (json_t *xs, unsigned int id, const char *xml)
+{
+    json_t *topo, *ranks, *hostname;
+    char *template = NULL;
+    char *hn = NULL;
+    char digest[BLOBREF_MAX_STRING_SIZE];
+    char key[16];
+    json_t *o = NULL;
+    int rc = -1;
+
+    if (xmlset_unpack (xs, &topo, &ranks, &hostname) < 0)
+        return -1;
+    if (!xml) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (xml_split_hostname (xml, &template, &hn) < 0)
+        return -1;
+    if (blobref_hash ("sha1",
+                      template,
+                      strlen (template),
+                      digest,
+                      sizeof (digest)) < 0)
+        goto done;
+    if (!json_object_get (topo, digest)) {
+        if (!(o = json_string (template))
+            || json_object_set_new (topo, digest, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    if (!(o = json_string (digest)))
+        goto nomem;
+    if (rutil_idkey_insert_id (ranks, id, o) < 0) {
+        json_decref (o);
+        goto done;
+    }
+    json_decref (o);
+    snprintf (key, sizeof (key), "%u", id);
+    if (hn) {
+        if (!(o = json_string (hn))
+            || json_object_set_new (hostname, key, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    else
+        (void)json_object_del (hostname, key);
+    if (xmlset_sweep (topo, ranks) < 0)
+        goto done;
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (free, template);
+    ERRNO_SAFE_WRAP (free, hn);
+    return rc;
+nomem:
+    errno = ENOMEM;
+    goto done;
+}
+
+int rutil_xmlset_merge (json_t *xs1, json_t *xs2)
+{
+    json_t *topo1, *ranks1, *hostname1;
+    json_t *topo2, *ranks2, *hostname2;
+    const char *key;
+    json_t *val;
+
+    if (xmlset_unpack (xs1, &topo1, &ranks1, &hostname1) < 0
+        || xmlset_unpack (xs2, &topo2, &ranks2, &hostname2) < 0)
+        return -1;
+    json_object_foreach (ranks2, key, val) {
+        struct idset *ids;
+        int rc;
+
+        if (!json_object_get (topo2, json_string_value (val))) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (!(ids = idset_decode (key)))
+            return -1;
+        rc = rutil_idkey_insert_idset (ranks1, ids, val);
+        if (rc == 0) {
+            unsigned int id = idset_first (ids);
+            while (id != IDSET_INVALID_ID) {
+                char idstr[16];
+                snprintf (idstr, sizeof (idstr), "%u", id);
+                if (!json_object_get (hostname2, idstr))
+                    (void)json_object_del (hostname1, idstr);
+                id = idset_next (ids, id);
+            }
+        }
+        idset_destroy (ids);
+        if (rc < 0)
+            return -1;
+    }
+    /* Only bodies not already present are added, so a topology shared by
+     * many ranks is stored once.
+     */
+    json_object_foreach (topo2, key, val) {
+        if (!json_object_get (topo1, key)) {
+            if (json_object_set (topo1, key, val) < 0)
+                goto nomem;
+        }
+    }
+    if (json_object_update (hostname1, hostname2) < 0)
+        goto nomem;
+    return xmlset_sweep (topo1, ranks1);
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+int rutil_xmlset_count (json_t *xs)
+{
+    json_t *topo, *ranks, *hostname;
+
+    if (xmlset_unpack (xs, &topo, &ranks, &hostname) < 0)
+        return 0;
+    return rutil_idkey_count (ranks);
+}
+
+int rutil_xmlset_unique (json_t *xs)
+{
+    json_t *topo, *ranks, *hostname;
+
+    if (xmlset_unpack (xs, &topo, &ranks, &hostname) < 0)
+        return 0;
+    return json_object_size (topo);
+}
+
+int rutil_xmlset_map (json_t *xs, rutil_xmlset_map_f map, void *arg)
+{
+    json_t *topo, *ranks, *hostname;
+    const char *key;
+    json_t *val;
+
+    if (xmlset_unpack (xs, &topo, &ranks, &hostname) < 0)
+        return -1;
+    json_object_foreach (ranks, key, val) {
+        const char *template;
+        struct idset *ids;
+        unsigned int id;
+
+        if (!(template = json_string_value (json_object_get (topo,
+                                                json_string_value (val))))) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (!(ids = idset_decode (key)))
+            return -1;
+        id = idset_first (ids);
+        while (id != IDSET_INVALID_ID) {
+            char idstr[16];
+            const char *hn;
+            char *xml;
+            int rc;
+
+            snprintf (idstr, sizeof (idstr), "%u", id);
+            hn = json_string_value (json_object_get (hostname, idstr));
+            if (!(xml = xml_join_hostname (template, hn))) {
+                idset_destroy (ids);
+                return -1;
+            }
+            rc = map (id, xml, arg);
+            ERRNO_SAFE_WRAP (free, xml);
+            if (rc < 0) {
+                idset_destroy (ids);
+                return -1;
+            }
+            id = idset_next (ids, id);
+        }
+        idset_destroy (ids);
+    }
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -77,6 +77,22 @@ int rutil_idkey_merge (json_t *obj1, json_t *obj2);
  */
 int rutil_idkey_count (json_t *obj);
 
+/* Build a deduplicated set of per-rank hwloc XML.
+ * Each distinct topology is stored once under its digest, with the
+ * HostName info value cut out so that otherwise identical nodes match.
+ * The object has the form:
+ *   {"topo":{digest:xml}, "ranks":{idset:digest}, "hostname":{rank:name}}
+ * rutil_xmlset_map() calls 'map' with each rank's original XML.
+ */
+json_t *rutil_xmlset_create (void);
+int rutil_xmlset_insert (json_t *xs, unsigned int id, const char *xml);
+int rutil_xmlset_merge (json_t *xs1, json_t *xs2);
+int rutil_xmlset_count (json_t *xs);
+int rutil_xmlset_unique (json_t *xs);
+
+typedef int (*rutil_xmlset_map_f)(unsigned int id, const char *xml, void *arg);
+int rutil_xmlset_map (json_t *xs, rutil_xmlset_map_f map, void *arg);
+
 
 #endif /* !_FLUX_RESOURCE_RUTIL_H */
 
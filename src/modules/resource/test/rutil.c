@@ -564,6 +564,112 @@ void test_idkey (void)
     json_decref (obj);
 }
 
+static const char *xml_a1 =
+    "<topology><object type=\"Machine\">"
+    "<info name=\"HostName\" value=\"node1\"/>"
+    "</object></topology>";
+static const char *xml_a2 =
+    "<topology><object type=\"Machine\">"
+    "<info name=\"HostName\" value=\"node2\"/>"
+    "</object></topology>";
+static const char *xml_b =
+    "<topology><object type=\"Machine\">"
+    "<info name=\"HostName\" value=\"node3\"/>"
+    "<object type=\"Core\"/>"
+    "</object></topology>";
+static const char *xml_nohost =
+    "<topology><object type=\"Machine\"/></topology>";
+
+static int xmlset_mapit (unsigned int id, const char *xml, void *arg)
+{
+    json_t *o = arg;
+    char key[16];
+
+    snprintf (key, sizeof (key), "%u", id);
+    return json_object_set_new (o, key, json_string (xml));
+}
+
+static bool xmlset_check (json_t *xs, unsigned int id, const char *xml)
+{
+    json_t *o;
+    char key[16];
+    const char *s;
+    bool result = false;
+
+    if (!(o = json_object ()))
+        BAIL_OUT ("json_object failed");
+    snprintf (key, sizeof (key), "%u", id);
+    if (rutil_xmlset_map (xs, xmlset_mapit, o) == 0
+        && (s = json_string_value (json_object_get (o, key)))
+        && !strcmp (s, xml))
+        result = true;
+    json_decref (o);
+    return result;
+}
+
+void test_xmlset (void)
+{
+    json_t *xs;
+    json_t *xs2;
+
+    xs = rutil_xmlset_create ();
+    ok (xs != NULL,
+        "rutil_xmlset_create works");
+    ok (rutil_xmlset_count (xs) == 0 && rutil_xmlset_unique (xs) == 0,
+        "empty xmlset has no ranks");
+    ok (rutil_xmlset_insert (xs, 0, xml_a1) == 0
+        && rutil_xmlset_insert (xs, 1, xml_a2) == 0
+        && rutil_xmlset_insert (xs, 2, xml_nohost) == 0,
+        "rutil_xmlset_insert works");
+    ok (rutil_xmlset_count (xs) == 3,
+        "xmlset contains 3 ranks");
+    ok (rutil_xmlset_unique (xs) == 2,
+        "xmlset contains 2 unique topologies");
+    diag_obj ("xmlset", xs);
+    ok (xmlset_check (xs, 0, xml_a1)
+        && xmlset_check (xs, 1, xml_a2)
+        && xmlset_check (xs, 2, xml_nohost),
+        "rutil_xmlset_map reproduces the original XML");
+
+    xs2 = rutil_xmlset_create ();
+    if (!xs2)
+        BAIL_OUT ("rutil_xmlset_create failed");
+    ok (rutil_xmlset_insert (xs2, 3, xml_b) == 0
+        && rutil_xmlset_insert (xs2, 4, xml_a1) == 0
+        && rutil_xmlset_insert (xs2, 2, xml_a2) == 0,
+        "rutil_xmlset_insert works on second xmlset");
+    ok (rutil_xmlset_merge (xs, xs2) == 0,
+        "rutil_xmlset_merge works");
+    ok (rutil_xmlset_count (xs) == 5 && rutil_xmlset_unique (xs) == 2,
+        "merged xmlset contains 5 ranks and 2 unique topologies");
+    diag_obj ("xmlset", xs);
+    ok (xmlset_check (xs, 2, xml_a2)
+        && xmlset_check (xs, 3, xml_b)
+        && xmlset_check (xs, 4, xml_a1),
+        "merged rank replaces the original");
+    ok (rutil_xmlset_merge (xs, xs2) == 0
+        && rutil_xmlset_count (xs) == 5 && rutil_xmlset_unique (xs) == 2,
+        "rutil_xmlset_merge again has no effect");
+    ok (rutil_xmlset_insert (xs, 3, xml_a1) == 0
+        && rutil_xmlset_count (xs) == 5 && rutil_xmlset_unique (xs) == 1,
+        "replacing the only rank with a topology drops that topology");
+    ok (xmlset_check (xs, 3, xml_a1),
+        "rutil_xmlset_map reproduces the replacement XML");
+
+    errno = 0;
+    ok (rutil_xmlset_insert (xs, 0, NULL) < 0 && errno == EINVAL,
+        "rutil_xmlset_insert xml=NULL fails with EINVAL");
+    json_decref (xs2);
+    if (!(xs2 = json_object ()))
+        BAIL_OUT ("json_object failed");
+    errno = 0;
+    ok (rutil_xmlset_merge (xs, xs2) < 0 && errno == EINVAL,
+        "rutil_xmlset_merge fails with EINVAL on non-xmlset");
+
+    json_decref (xs2);
+    json_decref (xs);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -581,6 +687,7 @@ int main (int argc, char *argv[])
 
     test_idkey_basic ();
     test_idkey ();
+    test_xmlset ();
 
     done_testing ();
     return (0);
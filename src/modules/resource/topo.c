@@ -16,6 +16,9 @@
  * Reduce r_local + xml from each rank, leaving the result in
  * topo->reduce->rl and topo->reduce->xml on rank 0.  If resource are not
  * known, then this R is set in inventory.
+ *
+ * The xml is reduced as an xmlset (see rutil.h), so each distinct topology
+ * is sent upstream once per subtree, along with the ranks that share it.
  */
 
 #if HAVE_CONFIG_H
@@ -41,7 +44,7 @@ struct reduction {
     int count;          // number of ranks represented
     int descendants;    // number of TBON descendants
     struct rlist *rl;   // resources: self + descendants
-    json_t *xml;        // xml object: self + descendants
+    json_t *xml;        // xmlset object: self + descendants
 };
 
 struct topo {
@@ -204,7 +207,7 @@ static void topo_reduce_cb (flux_t *h,
             errno = ENOMEM;
             goto error;
         }
-        if (rutil_idkey_merge (topo->reduce.xml, xml) < 0)
+        if (rutil_xmlset_merge (topo->reduce.xml, xml) < 0)
             goto error;
 
         topo->reduce.count += count;
@@ -222,20 +225,6 @@ error:
     rlist_destroy (rl);
 }
 
-static int idkey_insert_id_string (json_t *obj, unsigned int id, const char *s)
-{
-    json_t *o;
-    int rc;
-
-    if (!(o = json_string (s))) {
-        errno = ENOMEM;
-        return -1;
-    }
-    rc = rutil_idkey_insert_id (obj, id, o);
-    ERRNO_SAFE_WRAP (json_decref, o);
-    return rc;
-}
-
 /* Set up for reduction of distributed topo->r_local to inventory.
  * Ranks with descendants wait for all of them to report in, then roll
  * up their own and their descendants' contributions into one object and
@@ -254,11 +243,11 @@ static int topo_reduce (struct topo *topo)
         return -1;
 
     topo->reduce.count = 1;
-    if (!(topo->reduce.xml = json_object ()))
-        goto nomem;
-    if (idkey_insert_id_string (topo->reduce.xml,
-                                topo->ctx->rank,
-                                topo->xml) < 0)
+    if (!(topo->reduce.xml = rutil_xmlset_create ()))
+        goto error;
+    if (rutil_xmlset_insert (topo->reduce.xml,
+                             topo->ctx->rank,
+                             topo->xml) < 0)
         goto error;
     if (!(topo->reduce.rl = rlist_copy_empty (topo->r_local)))
         goto nomem;
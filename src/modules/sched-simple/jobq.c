@@ -0,0 +1,534 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobq.c - sched-simple job queue and scheduling pass
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/librlist/rlist.h"
+#include "libjj.h"
+#include "jobq.h"
+
+/* Allocation of a running job, tracked for backfill reservations.
+ */
+struct jobrun {
+    flux_jobid_t id;
+    double expiration;      /* 0 = unknown (no duration) */
+    struct rlist *alloc;
+};
+
+/* Resources reserved for the first job blocked in a scheduling pass.
+ */
+struct reservation {
+    double start;           /* 0 = not known (depends on unlimited job) */
+    struct rlist *alloc;
+};
+
+struct jobq {
+    const struct jobq_ops *ops;
+    void *arg;
+
+    char *alloc_mode;       /* rlist_alloc() mode, NULL = default */
+    zlistx_t *queue;        /* job queue */
+    zhashx_t *jobs;         /* id => struct jobreq in queue */
+    bool changed;           /* queue changed since jobq_clear_changed() */
+
+    unsigned int pass_limit;  /* max jobs considered per pass, 0 = no limit */
+    double pass_timeout;      /* max seconds per pass, 0 = no limit */
+    zhashx_t *running;        /* id => struct jobrun, if backfill enabled */
+    flux_jobid_t resume_id;   /* backfill scan resumes here (0 = none) */
+};
+
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+void jobreq_destroy (struct jobreq *job)
+{
+    if (job) {
+        flux_msg_decref (job->msg);
+        ERRNO_SAFE_WRAP (free, job);
+    }
+}
+
+static void jobreq_destructor (void **x)
+{
+    jobreq_destroy (*x);
+}
+
+static void jobrun_destroy (struct jobrun *run)
+{
+    if (run) {
+        int saved_errno = errno;
+        rlist_destroy (run->alloc);
+        free (run);
+        errno = saved_errno;
+    }
+}
+
+static void jobrun_destructor (void **x)
+{
+    if (*x) {
+        jobrun_destroy (*x);
+        *x = NULL;
+    }
+}
+
+static size_t id_hasher (const void *key)
+{
+    const flux_jobid_t *id = key;
+    return *id;
+}
+
+static int id_key_cmp (const void *key1, const void *key2)
+{
+    const flux_jobid_t *id1 = key1;
+    const flux_jobid_t *id2 = key2;
+
+    return NUMCMP (*id1, *id2);
+}
+
+/* Sort running jobs by expiration, with unknown (0) expiration last.
+ */
+static int jobrun_cmp (const void *x, const void *y)
+{
+    const struct jobrun *r1 = x;
+    const struct jobrun *r2 = y;
+
+    if (r1->expiration == 0. || r2->expiration == 0.)
+        return NUMCMP (r1->expiration == 0., r2->expiration == 0.);
+    return NUMCMP (r1->expiration, r2->expiration);
+}
+
+/* Taken from modules/job-manager/job.c */
+static int jobreq_cmp (const void *x, const void *y)
+{
+    const struct jobreq *j1 = x;
+    const struct jobreq *j2 = y;
+    int rc;
+
+    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0)
+        rc = NUMCMP (j1->id, j2->id);
+    return rc;
+}
+
+int jobq_run_add (struct jobq *q, flux_jobid_t id, struct rlist *alloc)
+{
+    struct jobrun *run;
+
+    if (!q->running) {
+        rlist_destroy (alloc);
+        return 0;
+    }
+    if (!(run = calloc (1, sizeof (*run)))) {
+        rlist_destroy (alloc);
+        return -1;
+    }
+    run->id = id;
+    run->expiration = alloc->expiration;
+    run->alloc = alloc;
+    if (zhashx_insert (q->running, &run->id, run) < 0) {
+        jobrun_destroy (run);
+        errno = EEXIST;
+        return -1;
+    }
+    return 0;
+}
+
+void jobq_run_remove (struct jobq *q, flux_jobid_t id)
+{
+    if (q->running)
+        zhashx_delete (q->running, &id);
+}
+
+static void reservation_destroy (struct reservation *resv)
+{
+    if (resv) {
+        int saved_errno = errno;
+        rlist_destroy (resv->alloc);
+        free (resv);
+        errno = saved_errno;
+    }
+}
+
+/* Find the earliest time the blocked job 'job' could start in 'rl',
+ * assuming running jobs end at their expiration, and the resources it
+ * would get.  Returns a reservation with alloc == NULL if the job cannot
+ * start even after all running jobs end (e.g. resources are down).
+ */
+static struct reservation *reservation_create (struct jobq *q,
+                                               struct rlist *rl,
+                                               struct jobreq *job)
+{
+    struct reservation *resv;
+    struct rlist *cpy = NULL;
+    zlistx_t *l = NULL;
+    struct jobrun *run;
+    int need = job->jj.nslots * job->jj.slot_size;
+
+    if (!(resv = calloc (1, sizeof (*resv))))
+        return NULL;
+    if (!(cpy = rlist_copy (rl)) || !(l = zlistx_new ()))
+        goto error;
+    zlistx_set_comparator (l, jobrun_cmp);
+    run = zhashx_first (q->running);
+    while (run) {
+        if (!zlistx_add_end (l, run))
+            goto error;
+        run = zhashx_next (q->running);
+    }
+    zlistx_sort (l);
+    run = zlistx_first (l);
+    while (run) {
+        if (rlist_free (cpy, run->alloc) < 0)
+            goto error;
+        if (cpy->avail >= need) {
+            errno = 0;
+            resv->alloc = rlist_alloc (cpy,
+                                       q->alloc_mode,
+                                       job->jj.nnodes,
+                                       job->jj.nslots,
+                                       job->jj.slot_size);
+            if (resv->alloc) {
+                resv->start = run->expiration;
+                break;
+            }
+            if (errno != ENOSPC)
+                break;
+        }
+        run = zlistx_next (l);
+    }
+    zlistx_destroy (&l);
+    rlist_destroy (cpy);
+    return resv;
+error:
+    zlistx_destroy (&l);
+    rlist_destroy (cpy);
+    reservation_destroy (resv);
+    return NULL;
+}
+
+/* Return true if a job allocated 'alloc' now, with time limit 'duration',
+ * does not delay the reservation 'resv'.
+ */
+static bool reservation_allows (struct reservation *resv,
+                                struct rlist *alloc,
+                                double now,
+                                double duration)
+{
+    struct rlist *overlap;
+    bool result;
+
+    if (!resv || !resv->alloc)
+        return true;
+    if (duration > 0. && resv->start > 0. && now + duration <= resv->start)
+        return true;
+    if (!(overlap = rlist_intersect (resv->alloc, alloc)))
+        return false;
+    result = rlist_nnodes (overlap) == 0;
+    rlist_destroy (overlap);
+    return result;
+}
+
+struct jobreq *jobq_lookup (struct jobq *q, flux_jobid_t id)
+{
+    return zhashx_lookup (q->jobs, &id);
+}
+
+size_t jobq_size (struct jobq *q)
+{
+    return zlistx_size (q->queue);
+}
+
+struct jobreq *jobq_first (struct jobq *q)
+{
+    return zlistx_first (q->queue);
+}
+
+struct jobreq *jobq_next (struct jobq *q)
+{
+    return zlistx_next (q->queue);
+}
+
+int jobq_enqueue (struct jobq *q, struct jobreq *job)
+{
+    bool search_dir = job->priority > FLUX_JOB_URGENCY_DEFAULT;
+
+    if (zhashx_insert (q->jobs, &job->id, job) < 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!(job->handle = zlistx_insert (q->queue, job, search_dir))) {
+        zhashx_delete (q->jobs, &job->id);
+        errno = ENOMEM;
+        return -1;
+    }
+    q->changed = true;
+    return 0;
+}
+
+void jobq_dequeue (struct jobq *q, struct jobreq *job)
+{
+    zhashx_delete (q->jobs, &job->id);
+    zlistx_delete (q->queue, job->handle);
+    q->changed = true;
+}
+
+void jobq_reorder (struct jobq *q, struct jobreq *job)
+{
+    zlistx_reorder (q->queue, job->handle, true);
+    q->changed = true;
+}
+
+void jobq_sort (struct jobq *q)
+{
+    struct jobreq *job;
+
+    zlistx_sort (q->queue);
+
+    /*  zlistx handles are invalidated after a zlistx_sort(),
+     *   so reaquire them now
+     */
+    job = zlistx_first (q->queue);
+    while (job) {
+        job->handle = zlistx_cursor (q->queue);
+        job = zlistx_next (q->queue);
+    }
+    q->changed = true;
+}
+
+bool jobq_changed (struct jobq *q)
+{
+    return q->changed;
+}
+
+void jobq_clear_changed (struct jobq *q)
+{
+    q->changed = false;
+}
+
+bool jobq_backfill (struct jobq *q)
+{
+    return q->running != NULL;
+}
+
+static void alloc_set_timelimit (struct rlist *l, double now, double timelimit)
+{
+    if (timelimit > 0.) {
+        l->starttime = now;
+        l->expiration = now + timelimit;
+    }
+}
+
+/* Try to allocate resources from 'rl' to 'job'.  If the allocation
+ * conflicts with reservation 'resv' it is undone, as if resources were
+ * unavailable.  Return 0 if the job was allocated or denied and removed
+ * from the queue, or -1 with errno == ENOSPC if it remains queued.
+ */
+static int try_alloc (struct jobq *q,
+                      struct rlist *rl,
+                      struct jobreq *job,
+                      struct reservation *resv,
+                      double now)
+{
+    struct rlist *alloc = NULL;
+    struct jj_counts *jj = &job->jj;
+    bool fail_alloc = q->ops->fail ? q->ops->fail (q->arg) : false;
+
+    if (!fail_alloc) {
+        errno = 0;
+        alloc = rlist_alloc (rl, q->alloc_mode,
+                             jj->nnodes, jj->nslots, jj->slot_size);
+        if (alloc && !reservation_allows (resv, alloc, now, jj->duration)) {
+            (void)rlist_free (rl, alloc);
+            rlist_destroy (alloc);
+            errno = ENOSPC;
+            return -1;
+        }
+    }
+    if (!alloc) {
+        const char *note = "unable to allocate provided jobspec";
+        if (errno == ENOSPC)
+            return -1;
+        else if (errno == EOVERFLOW)
+            note = "unsatisfiable request";
+        else if (fail_alloc)
+            note = "DEBUG_FAIL_ALLOC";
+        q->ops->deny (job, note, q->arg);
+    }
+    else {
+        alloc_set_timelimit (alloc, now, jj->duration);
+        q->ops->alloc (job, alloc, q->arg);
+    }
+    jobq_dequeue (q, job);
+    return 0;
+}
+
+/* If the budget runs out during the backfill scan, the next pass skips
+ * ahead to where this one stopped, so every queued job is eventually
+ * considered.
+ */
+bool jobq_schedule (struct jobq *q, struct rlist *rl, double now,
+                    bool *blocked_out)
+{
+    struct reservation *resv = NULL;
+    struct jobreq *job;
+    struct jobreq *next;
+    unsigned int count = 0;
+    bool blocked = false;
+    bool resumed;
+    bool budget = false;
+    flux_jobid_t resume_id = 0;
+    struct timespec t0;
+
+    if (q->resume_id != 0 && jobq_lookup (q, q->resume_id))
+        resume_id = q->resume_id;
+    q->resume_id = 0;
+
+    monotime (&t0);
+    job = zlistx_first (q->queue);
+    while (job) {
+        /* N.B. get next job before try_alloc() may delete this one */
+        next = zlistx_next (q->queue);
+        /* Skip backfill candidates already considered by a previous
+         * pass that ran out of budget.  The job where that pass stopped
+         * is always considered, so each pass makes headway.
+         */
+        resumed = false;
+        if (blocked && resume_id != 0) {
+            if (job->id != resume_id) {
+                job = next;
+                continue;
+            }
+            resume_id = 0;
+            resumed = true;
+        }
+        if (!resumed
+            && ((q->pass_limit > 0 && count >= q->pass_limit)
+                || (q->pass_timeout > 0.
+                    && monotime_since (t0) / 1000. >= q->pass_timeout))) {
+            budget = true;
+            if (blocked)
+                q->resume_id = job->id;
+            break;
+        }
+        /* A job whose jobspec is still being decoded blocks the queue
+         * like one that does not fit, but gets no reservation.  Its
+         * decode completion starts the next pass.
+         */
+        if (job->parsing) {
+            if (!blocked)
+                break;
+            job = next;
+            continue;
+        }
+        count++;
+        if (try_alloc (q, rl, job, resv, now) < 0
+            && errno == ENOSPC
+            && !blocked) {
+            blocked = true;
+            if (!q->running)
+                break;
+            if (!(resv = reservation_create (q, rl, job)))
+                break;
+        }
+        job = next;
+    }
+    reservation_destroy (resv);
+    if (blocked_out)
+        *blocked_out = blocked;
+    return budget;
+}
+
+int jobq_set_alloc_mode (struct jobq *q, const char *mode)
+{
+    char *cpy = NULL;
+
+    if (mode && !(cpy = strdup (mode)))
+        return -1;
+    free (q->alloc_mode);
+    q->alloc_mode = cpy;
+    return 0;
+}
+
+void jobq_set_pass_limit (struct jobq *q, unsigned int limit)
+{
+    q->pass_limit = limit;
+}
+
+void jobq_set_pass_timeout (struct jobq *q, double timeout)
+{
+    q->pass_timeout = timeout;
+}
+
+void jobq_destroy (struct jobq *q)
+{
+    if (q) {
+        int saved_errno = errno;
+        zhashx_destroy (&q->jobs);
+        zlistx_destroy (&q->queue);
+        zhashx_destroy (&q->running);
+        free (q->alloc_mode);
+        free (q);
+        errno = saved_errno;
+    }
+}
+
+struct jobq *jobq_create (const struct jobq_ops *ops, void *arg, bool backfill)
+{
+    struct jobq *q;
+
+    if (!ops || !ops->alloc || !ops->deny) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(q = calloc (1, sizeof (*q))))
+        return NULL;
+    q->ops = ops;
+    q->arg = arg;
+
+    if (!(q->queue = zlistx_new ()))
+        goto nomem;
+    zlistx_set_comparator (q->queue, jobreq_cmp);
+    zlistx_set_destructor (q->queue, jobreq_destructor);
+
+    if (!(q->jobs = zhashx_new ()))
+        goto nomem;
+    zhashx_set_key_hasher (q->jobs, id_hasher);
+    zhashx_set_key_comparator (q->jobs, id_key_cmp);
+    zhashx_set_key_duplicator (q->jobs, NULL);
+    zhashx_set_key_destructor (q->jobs, NULL);
+
+    if (backfill) {
+        if (!(q->running = zhashx_new ()))
+            goto nomem;
+        zhashx_set_key_hasher (q->running, id_hasher);
+        zhashx_set_key_comparator (q->running, id_key_cmp);
+        zhashx_set_key_duplicator (q->running, NULL);
+        zhashx_set_key_destructor (q->running, NULL);
+        zhashx_set_destructor (q->running, jobrun_destructor);
+    }
+    return q;
+nomem:
+    jobq_destroy (q);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
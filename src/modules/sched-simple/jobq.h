@@ -0,0 +1,121 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef HAVE_SCHED_JOBQ_H
+#define HAVE_SCHED_JOBQ_H 1
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdbool.h>
+#include <flux/core.h>
+
+#include "src/common/librlist/rlist.h"
+#include "libjj.h"
+
+/* Queue of pending jobs in priority order, and the scheduling pass of
+ * sched-simple that allocates them from a struct rlist.  Allocations and
+ * denials are handed to callbacks, so the same policy can be driven by
+ * the module or by a simulation (t/sched-simple/sched-bench).
+ */
+
+struct jobreq {
+    void *handle;           /* handle in queue */
+    const flux_msg_t *msg;  /* alloc request, or NULL */
+    uint32_t uid;
+    unsigned int priority;
+    double t_submit;
+    flux_jobid_t id;
+    struct jj_counts jj;
+    int errnum;
+    int jobs_ahead;         /* last jobs_ahead annotation sent, -1 = none */
+    bool parsing;           /* jobspec is being decoded by a worker */
+};
+
+struct jobq_ops {
+    /* 'job' was allocated 'alloc', with its starttime and expiration
+     * set from the job's duration.  Takes ownership of 'alloc'.
+     * The job is removed from the queue and destroyed on return.
+     */
+    void (*alloc)(struct jobreq *job, struct rlist *alloc, void *arg);
+
+    /* 'job' cannot be allocated.  The job is removed from the queue
+     * and destroyed on return.
+     */
+    void (*deny)(struct jobreq *job, const char *note, void *arg);
+
+    /* Optional: return true to deny each job considered, for testing.
+     */
+    bool (*fail)(void *arg);
+};
+
+/* Create a job queue.  If 'backfill' is true, jobs are allocated around
+ * a reservation for the first job that does not fit, and running jobs
+ * must be tracked with jobq_run_add() and jobq_run_remove().
+ */
+struct jobq *jobq_create (const struct jobq_ops *ops, void *arg, bool backfill);
+void jobq_destroy (struct jobq *q);
+
+/* Set rlist_alloc() mode (NULL = default), and the maximum number of jobs
+ * considered or seconds spent per pass (0 = no limit, the default).
+ */
+int jobq_set_alloc_mode (struct jobq *q, const char *mode);
+void jobq_set_pass_limit (struct jobq *q, unsigned int limit);
+void jobq_set_pass_timeout (struct jobq *q, double timeout);
+
+bool jobq_backfill (struct jobq *q);
+
+void jobreq_destroy (struct jobreq *job);
+
+/* Add 'job' to the queue in priority order, taking ownership of it.
+ * Remove 'job' from the queue and destroy it.
+ */
+int jobq_enqueue (struct jobq *q, struct jobreq *job);
+void jobq_dequeue (struct jobq *q, struct jobreq *job);
+
+struct jobreq *jobq_lookup (struct jobq *q, flux_jobid_t id);
+size_t jobq_size (struct jobq *q);
+struct jobreq *jobq_first (struct jobq *q);
+struct jobreq *jobq_next (struct jobq *q);
+
+/* Move 'job' after its priority has changed, or re-sort the whole queue
+ * after many priorities have changed.
+ */
+void jobq_reorder (struct jobq *q, struct jobreq *job);
+void jobq_sort (struct jobq *q);
+
+/* Return true if the queue has changed since jobq_clear_changed().
+ */
+bool jobq_changed (struct jobq *q);
+void jobq_clear_changed (struct jobq *q);
+
+/* Track allocation 'alloc' of running job 'id' for backfill reservations,
+ * taking ownership of 'alloc', even on failure.  If backfill is not
+ * enabled, 'alloc' is destroyed.
+ */
+int jobq_run_add (struct jobq *q, flux_jobid_t id, struct rlist *alloc);
+void jobq_run_remove (struct jobq *q, flux_jobid_t id);
+
+/* Allocate queued jobs from 'rl' in priority order at time 'now', within
+ * the per-pass budget.  Without backfill, the pass ends at the first job
+ * that does not fit.  With backfill, that job gets a reservation and
+ * later jobs are allocated only if they do not delay it.  Set 'blocked'
+ * if a job did not fit.  Return true if the budget ran out, i.e. another
+ * pass should follow.
+ */
+bool jobq_schedule (struct jobq *q, struct rlist *rl, double now,
+                    bool *blocked);
+
+#endif /* !HAVE_SCHED_JOBQ_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -20,6 +20,8 @@
 #include "src/common/libjob/job.h"
 #include "src/common/librlist/rlist.h"
 #include "libjj.h"
+#include "jobq.h"
+#include "workpool.h"
 
 // e.g. flux module debug --setbit 0x1 sched-simple
 // e.g. flux module debug --clearbit 0x1 sched-simple
@@ -28,17 +30,6 @@ enum module_debug_flags {
     DEBUG_ANNOTATE_REASON_PENDING = 2, // add reason_pending annotation
 };
 
-struct jobreq {
-    void *handle;
-    const flux_msg_t *msg;
-    uint32_t uid;
-    unsigned int priority;
-    double t_submit;
-    flux_jobid_t id;
-    struct jj_counts jj;
-    int errnum;
-};
-
 struct simple_sched {
     flux_t *h;
     flux_future_t *acquire_f; /* resource.acquire future */
@@ -48,56 +39,29 @@ struct simple_sched {
     unsigned int alloc_limit; /* 0 = unlimited */
     int schedutil_flags;
     struct rlist *rlist;    /* list of resources */
-    zlistx_t *queue;        /* job queue */
+    struct jobq *q;         /* job queue */
     schedutil_t *util_ctx;
 
+    unsigned int pass_limit;  /* max jobs considered per pass, 0 = no limit */
+    double pass_timeout;      /* max seconds per pass, 0 = no limit */
+    bool backfill;            /* backfill around a reservation for head job */
+
+    /* If nworkers > 0, jobspec decoding and R encoding are done by
+     * worker threads, and only allocation runs on the reactor thread.
+     */
+    int nworkers;
+    struct workpool *workpool;
+
     flux_watcher_t *prep;
     flux_watcher_t *check;
     flux_watcher_t *idle;
 };
 
-static void jobreq_destroy (struct jobreq *job)
-{
-    if (job) {
-        flux_msg_decref (job->msg);
-        ERRNO_SAFE_WRAP (free, job);
-    }
-}
-
-static void jobreq_destructor (void **x)
-{
-    jobreq_destroy (*x);
-}
-
-#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
-
-/* Taken from modules/job-manager/job.c */
-static int jobreq_cmp (const void *x, const void *y)
-{
-    const struct jobreq *j1 = x;
-    const struct jobreq *j2 = y;
-    int rc;
-
-    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0)
-        rc = NUMCMP (j1->id, j2->id);
-    return rc;
-}
-
-static struct jobreq *
-jobreq_find (struct simple_sched *ss, flux_jobid_t id)
-{
-    struct jobreq *job;
-    job = zlistx_first (ss->queue);
-    while (job) {
-        if (job->id == id)
-            return job;
-        job = zlistx_next (ss->queue);
-    }
-    return NULL;
-}
-
+/* Create a job request from 'msg'.  If 'defer' is true, leave decoding
+ * of the jobspec to a worker and set job->parsing.
+ */
 static struct jobreq *
-jobreq_create (const flux_msg_t *msg)
+jobreq_create (const flux_msg_t *msg, bool defer)
 {
     struct jobreq *job = calloc (1, sizeof (*job));
     json_t *jobspec;
@@ -113,7 +77,10 @@ jobreq_create (const flux_msg_t *msg)
                          "jobspec", &jobspec) < 0)
         goto err;
     job->msg = flux_msg_incref (msg);
-    if (libjj_get_counts_json (jobspec, &job->jj) < 0)
+    job->jobs_ahead = -1;
+    if (defer)
+        job->parsing = true;
+    else if (libjj_get_counts_json (jobspec, &job->jj) < 0)
         job->errnum = errno;
     return job;
 err:
@@ -123,13 +90,21 @@ err:
 
 static void simple_sched_destroy (flux_t *h, struct simple_sched *ss)
 {
-    struct jobreq *job = zlistx_first (ss->queue);
-    while (job) {
-        flux_respond_error (h, job->msg, ENOSYS, "simple sched exiting");
-        job = zlistx_next (ss->queue);
+    struct jobreq *job;
+
+    /* Finish work in progress, which may respond to alloc requests.
+     */
+    workpool_destroy (ss->workpool);
+
+    if (ss->q) {
+        job = jobq_first (ss->q);
+        while (job) {
+            flux_respond_error (h, job->msg, ENOSYS, "simple sched exiting");
+            job = jobq_next (ss->q);
+        }
     }
     flux_future_destroy (ss->acquire_f);
-    zlistx_destroy (&ss->queue);
+    jobq_destroy (ss->q);
     flux_watcher_destroy (ss->prep);
     flux_watcher_destroy (ss->check);
     flux_watcher_destroy (ss->idle);
@@ -150,17 +125,14 @@ static struct simple_sched * simple_sched_create (void)
      * concurrency being excessively large.
      */
     ss->alloc_limit = 8;
+    ss->pass_timeout = 0.01;
     return ss;
 }
 
-static char *Rstring_create (struct rlist *l, double now, double timelimit)
+static char *Rstring_create (struct rlist *l)
 {
     char *s = NULL;
     json_t *R = NULL;
-    if (timelimit > 0.) {
-        l->starttime = now;
-        l->expiration = now + timelimit;
-    }
     if ((R = rlist_to_R (l))) {
         s = json_dumps (R, JSON_COMPACT);
         json_decref (R);
@@ -168,52 +140,29 @@ static char *Rstring_create (struct rlist *l, double now, double timelimit)
     return s;
 }
 
-static int try_alloc (flux_t *h, struct simple_sched *ss)
+/* Keep allocation 'alloc' of job 'id' to track the running job if
+ * backfill is enabled.  Takes ownership of 'alloc'.
+ */
+static void jobrun_track (struct simple_sched *ss,
+                          flux_jobid_t id,
+                          struct rlist *alloc)
 {
-    int rc = -1;
-    char *s = NULL;
-    struct rlist *alloc = NULL;
-    struct jj_counts *jj = NULL;
-    char *R = NULL;
-    struct jobreq *job = zlistx_first (ss->queue);
-    double now = flux_reactor_now (flux_get_reactor (h));
-    bool fail_alloc = flux_module_debug_test (h, DEBUG_FAIL_ALLOC, false);
-
-    if (!job)
-        return -1;
+    if (jobq_run_add (ss->q, id, alloc) < 0)
+        flux_log_error (ss->h, "alloc: %ju: jobq_run_add", (uintmax_t) id);
+}
 
-    jj = &job->jj;
-    if (!fail_alloc) {
-        errno = 0;
-        alloc = rlist_alloc (ss->rlist, ss->alloc_mode,
-                             jj->nnodes, jj->nslots, jj->slot_size);
-    }
-    if (!alloc || !(R = Rstring_create (alloc, now, jj->duration))) {
-        const char *note = "unable to allocate provided jobspec";
-        if (alloc != NULL) {
-            /*  unlikely: allocation succeeded but Rstring_create failed */
-            note = "internal scheduler error generating R";
-            flux_log (ss->h, LOG_ERR, "%s", note);
-            if (rlist_free (ss->rlist, alloc) < 0)
-                flux_log_error (h, "try_alloc: rlist_free");
-            rlist_destroy (alloc);
-            alloc = NULL;
-        } else if (errno == ENOSPC)
-            return rc;
-        else if (errno == EOVERFLOW)
-            note = "unsatisfiable request";
-        else if (fail_alloc)
-            note = "DEBUG_FAIL_ALLOC";
-        if (schedutil_alloc_respond_deny (ss->util_ctx,
-                                          job->msg,
-                                          note) < 0)
-            flux_log_error (h, "schedutil_alloc_respond_deny");
-        goto out;
-    }
-    s = rlist_dumps (alloc);
+/* Respond to alloc request 'msg' for job 'id' with R.
+ */
+static void alloc_respond_success (struct simple_sched *ss,
+                                   const flux_msg_t *msg,
+                                   flux_jobid_t id,
+                                   const char *R,
+                                   const char *s)
+{
+    flux_t *h = ss->h;
 
     if (schedutil_alloc_respond_success_pack (ss->util_ctx,
-                                              job->msg,
+                                              msg,
                                               R,
                                               "{ s:{s:s s:n s:n} }",
                                               "sched",
@@ -222,37 +171,201 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
                                               "jobs_ahead") < 0)
         flux_log_error (h, "schedutil_alloc_respond_success_pack");
 
-    flux_log (h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) job->id, s);
-    rc = 0;
+    flux_log (h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) id, s);
+}
 
-out:
-    zlistx_delete (ss->queue, job->handle);
+/* Undo allocation 'alloc' and deny alloc request 'msg'.
+ * Unlikely: allocation succeeded but Rstring_create failed.
+ */
+static void alloc_respond_R_error (struct simple_sched *ss,
+                                   const flux_msg_t *msg,
+                                   struct rlist *alloc)
+{
+    const char *note = "internal scheduler error generating R";
+
+    flux_log (ss->h, LOG_ERR, "%s", note);
+    if (rlist_free (ss->rlist, alloc) < 0)
+        flux_log_error (ss->h, "alloc: rlist_free");
     rlist_destroy (alloc);
+    if (schedutil_alloc_respond_deny (ss->util_ctx, msg, note) < 0)
+        flux_log_error (ss->h, "schedutil_alloc_respond_deny");
+}
+
+/* R encoding for an allocated job, done by a worker thread.
+ * The allocation is already tracked for backfill, if enabled.
+ */
+struct encode_work {
+    struct simple_sched *ss;
+    const flux_msg_t *msg;
+    flux_jobid_t id;
+    struct rlist *alloc;
+    char *R;
+    char *s;
+};
+
+static void encode_work_cb (void *arg)
+{
+    struct encode_work *ew = arg;
+
+    ew->R = Rstring_create (ew->alloc);
+    ew->s = rlist_dumps (ew->alloc);
+}
+
+static void encode_done_cb (void *arg)
+{
+    struct encode_work *ew = arg;
+
+    if (!ew->R) {
+        jobq_run_remove (ew->ss->q, ew->id);
+        alloc_respond_R_error (ew->ss, ew->msg, ew->alloc);
+    }
+    else {
+        alloc_respond_success (ew->ss, ew->msg, ew->id, ew->R, ew->s);
+        rlist_destroy (ew->alloc);
+    }
+    flux_msg_decref (ew->msg);
+    free (ew->R);
+    free (ew->s);
+    free (ew);
+}
+
+/* Hand off R encoding and the alloc response for 'job' to a worker.
+ * Takes ownership of 'alloc' on success.
+ */
+static int encode_submit (struct simple_sched *ss,
+                          struct jobreq *job,
+                          struct rlist *alloc)
+{
+    struct encode_work *ew;
+
+    /* The opaque scheduling key is shared by reference with ss->rlist.
+     * Give the worker its own copy, since jansson reference counting
+     * is not thread safe in all supported versions.
+     */
+    if (alloc->scheduling) {
+        json_t *cpy;
+        if (!(cpy = json_deep_copy (alloc->scheduling))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        json_decref (alloc->scheduling);
+        alloc->scheduling = cpy;
+    }
+    if (!(ew = calloc (1, sizeof (*ew))))
+        return -1;
+    ew->ss = ss;
+    ew->msg = flux_msg_incref (job->msg);
+    ew->id = job->id;
+    ew->alloc = alloc;
+    if (workpool_submit (ss->workpool,
+                         encode_work_cb,
+                         encode_done_cb,
+                         ew) < 0) {
+        flux_msg_decref (ew->msg);
+        ERRNO_SAFE_WRAP (free, ew);
+        return -1;
+    }
+    return 0;
+}
+
+/* jobq callback: respond to the alloc request of 'job' with allocation
+ * 'alloc', and track it for backfill.  Takes ownership of 'alloc'.
+ */
+static void alloc_job_cb (struct jobreq *job, struct rlist *alloc, void *arg)
+{
+    struct simple_sched *ss = arg;
+    char *R;
+    char *s;
+
+    if (ss->workpool) {
+        struct rlist *run = NULL;
+
+        /* Track the running job now rather than when R encoding is
+         * done, so a job considered later in this pass cannot be
+         * backfilled into resources needed by the reservation.
+         */
+        if (jobq_backfill (ss->q) && !(run = rlist_copy (alloc))) {
+            flux_log_error (ss->h, "alloc: rlist_copy");
+            alloc_respond_R_error (ss, job->msg, alloc);
+            return;
+        }
+        if (encode_submit (ss, job, alloc) < 0) {
+            flux_log_error (ss->h, "alloc: workpool_submit");
+            alloc_respond_R_error (ss, job->msg, alloc);
+            rlist_destroy (run);
+            return;
+        }
+        if (run)
+            jobrun_track (ss, job->id, run);
+        return;
+    }
+    if (!(R = Rstring_create (alloc))) {
+        alloc_respond_R_error (ss, job->msg, alloc);
+        return;
+    }
+    s = rlist_dumps (alloc);
+    alloc_respond_success (ss, job->msg, job->id, R, s);
+    jobrun_track (ss, job->id, alloc);
     free (R);
     free (s);
-    return rc;
 }
 
+/* jobq callback: deny the alloc request of 'job'.
+ */
+static void deny_job_cb (struct jobreq *job, const char *note, void *arg)
+{
+    struct simple_sched *ss = arg;
+
+    if (schedutil_alloc_respond_deny (ss->util_ctx, job->msg, note) < 0)
+        flux_log_error (ss->h, "schedutil_alloc_respond_deny");
+}
+
+static bool fail_alloc_cb (void *arg)
+{
+    struct simple_sched *ss = arg;
+
+    return flux_module_debug_test (ss->h, DEBUG_FAIL_ALLOC, false);
+}
+
+static const struct jobq_ops jobq_ops = {
+    .alloc = alloc_job_cb,
+    .deny = deny_job_cb,
+    .fail = fail_alloc_cb,
+};
+
+/* Annotate queued jobs with their position in the queue.  Only jobs whose
+ * jobs_ahead changed since the last annotation are sent a response, and
+ * nothing is done if the queue has not changed.
+ */
 static void annotate_reason_pending (struct simple_sched *ss)
 {
     int jobs_ahead = 0;
+    struct jobreq *job;
 
-    if (!flux_module_debug_test (ss->h, DEBUG_ANNOTATE_REASON_PENDING, false))
+    if (!flux_module_debug_test (ss->h, DEBUG_ANNOTATE_REASON_PENDING, false)
+        || !jobq_changed (ss->q))
         return;
 
-    struct jobreq *job = zlistx_first (ss->queue);
+    job = jobq_first (ss->q);
     while (job) {
-        if (schedutil_alloc_respond_annotate_pack (ss->util_ctx,
-                                                   job->msg,
-                                                   "{ s:{s:s s:i} }",
-                                                   "sched",
-                                                   "reason_pending",
+        if (job->jobs_ahead != jobs_ahead) {
+            if (schedutil_alloc_respond_annotate_pack (ss->util_ctx,
+                                                       job->msg,
+                                                       "{ s:{s:s s:i} }",
+                                                       "sched",
+                                                       "reason_pending",
                                                      "insufficient resources",
-                                                   "jobs_ahead",
-                                                     jobs_ahead++) < 0)
-            flux_log_error (ss->h, "schedutil_alloc_respond_annotate_pack");
-        job = zlistx_next (ss->queue);
+                                                       "jobs_ahead",
+                                                       jobs_ahead) < 0)
+                flux_log_error (ss->h,
+                                "schedutil_alloc_respond_annotate_pack");
+            else
+                job->jobs_ahead = jobs_ahead;
+        }
+        jobs_ahead++;
+        job = jobq_next (ss->q);
     }
+    jobq_clear_changed (ss->q);
 }
 
 static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -260,25 +373,42 @@ static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     struct simple_sched *ss = arg;
     /* if there is at least one job to schedule, start check and idle */
-    if (zlistx_size (ss->queue) > 0) {
+    if (jobq_size (ss->q) > 0) {
         /* If there's a new job to process, start idle watcher */
         flux_watcher_start (ss->check);
         flux_watcher_start (ss->idle);
     }
 }
 
+/* Run a scheduling pass over the queue (see jobq_schedule()).
+ * Return true if the budget ran out, i.e. another pass should follow
+ * on the next loop iteration.
+ */
+static bool schedule_pass (struct simple_sched *ss)
+{
+    flux_reactor_t *r = flux_get_reactor (ss->h);
+    bool blocked;
+    bool budget;
+
+    /* Refresh cached loop time used for R starttime/expiration */
+    flux_reactor_now_update (r);
+    budget = jobq_schedule (ss->q, ss->rlist, flux_reactor_now (r), &blocked);
+    if (blocked)
+        annotate_reason_pending (ss);
+    return budget;
+}
+
 static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
                       int revents, void *arg)
 {
     struct simple_sched *ss = arg;
     flux_watcher_stop (ss->idle);
 
-    /* See if we can fulfill alloc for a pending job
-     * If current head of queue can't be allocated, stop the prep
-     *  watcher, i.e. block. O/w, retry on next loop.
+    /* Run a scheduling pass.  Unless the pass ran out of budget,
+     *  stop the prep watcher, i.e. block until a free, new job, or
+     *  resource change restarts it.
      */
-    if (try_alloc (ss->h, ss) < 0 && errno == ENOSPC) {
-        annotate_reason_pending (ss);
+    if (!schedule_pass (ss)) {
         flux_watcher_stop (ss->prep);
         flux_watcher_stop (ss->check);
     }
@@ -306,6 +436,10 @@ static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
 void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
 {
     struct simple_sched *ss = arg;
+    flux_jobid_t id;
+
+    if (flux_msg_unpack (msg, "{s:I}", "id", &id) == 0)
+        jobq_run_remove (ss->q, id);
 
     if (!R) {
         flux_log (h, LOG_ERR, "free: R is NULL");
@@ -326,21 +460,95 @@ void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
     flux_watcher_start (ss->prep);
 }
 
+static void jobreq_log (flux_t *h, struct jobreq *job)
+{
+    flux_log (h, LOG_DEBUG, "req: %ju: spec={%d,%d,%d} duration=%.1f",
+                            (uintmax_t) job->id, job->jj.nnodes,
+                            job->jj.nslots, job->jj.slot_size,
+                            job->jj.duration);
+}
+
+/* Jobspec decoding for a queued job, done by a worker thread.
+ */
+struct parse_work {
+    struct simple_sched *ss;
+    flux_jobid_t id;
+    json_t *jobspec;
+    struct jj_counts jj;
+    int errnum;
+};
+
+static void parse_work_cb (void *arg)
+{
+    struct parse_work *pw = arg;
+
+    if (libjj_get_counts_json (pw->jobspec, &pw->jj) < 0)
+        pw->errnum = errno;
+}
+
+static void parse_done_cb (void *arg)
+{
+    struct parse_work *pw = arg;
+    struct simple_sched *ss = pw->ss;
+    struct jobreq *job;
+
+    /* N.B. the job may have been canceled in the meantime */
+    if ((job = jobq_lookup (ss->q, pw->id)) && job->parsing) {
+        job->jj = pw->jj;
+        job->parsing = false;
+        if (pw->errnum != 0) {
+            if (schedutil_alloc_respond_deny (ss->util_ctx,
+                                              job->msg,
+                                              job->jj.error) < 0)
+                flux_log_error (ss->h, "alloc_respond_deny");
+            jobq_dequeue (ss->q, job);
+        }
+        else {
+            jobreq_log (ss->h, job);
+            flux_watcher_start (ss->prep);
+        }
+    }
+    json_decref (pw->jobspec);
+    free (pw);
+}
+
+static int parse_submit (struct simple_sched *ss, struct jobreq *job)
+{
+    struct parse_work *pw;
+    json_t *jobspec;
+
+    if (flux_msg_unpack (job->msg, "{s:o}", "jobspec", &jobspec) < 0)
+        return -1;
+    if (!(pw = calloc (1, sizeof (*pw))))
+        return -1;
+    pw->ss = ss;
+    pw->id = job->id;
+    pw->jobspec = json_incref (jobspec);
+    if (workpool_submit (ss->workpool,
+                         parse_work_cb,
+                         parse_done_cb,
+                         pw) < 0) {
+        json_decref (pw->jobspec);
+        ERRNO_SAFE_WRAP (free, pw);
+        return -1;
+    }
+    return 0;
+}
+
 static void alloc_cb (flux_t *h, const flux_msg_t *msg, void *arg)
 {
     struct simple_sched *ss = arg;
     struct jobreq *job;
-    bool search_dir;
 
     if (ss->alloc_limit
-        && zlistx_size (ss->queue) >= ss->alloc_limit) {
+        && jobq_size (ss->q) >= ss->alloc_limit) {
         flux_log (h, LOG_ERR,
                   "alloc received above max concurrency: %d",
                   ss->alloc_limit);
         errno = EINVAL;
         goto err;
     }
-    if (!(job = jobreq_create (msg))) {
+    if (!(job = jobreq_create (msg, ss->workpool != NULL))) {
         flux_log_error (h, "alloc: jobreq_create");
         goto err;
     }
@@ -352,14 +560,18 @@ static void alloc_cb (flux_t *h, const flux_msg_t *msg, void *arg)
         jobreq_destroy (job);
         return;
     }
-    flux_log (h, LOG_DEBUG, "req: %ju: spec={%d,%d,%d} duration=%.1f",
-                            (uintmax_t) job->id, job->jj.nnodes,
-                            job->jj.nslots, job->jj.slot_size,
-                            job->jj.duration);
-    search_dir = job->priority > FLUX_JOB_URGENCY_DEFAULT;
-    job->handle = zlistx_insert (ss->queue,
-                                 job,
-                                 search_dir);
+    if (!job->parsing)
+        jobreq_log (h, job);
+    if (jobq_enqueue (ss->q, job) < 0) {
+        flux_log_error (h, "alloc: jobq_enqueue");
+        jobreq_destroy (job);
+        goto err;
+    }
+    if (job->parsing && parse_submit (ss, job) < 0) {
+        flux_log_error (h, "alloc: workpool_submit");
+        ERRNO_SAFE_WRAP (jobq_dequeue, ss->q, job);
+        goto err;
+    }
     flux_watcher_start (ss->prep);
     return;
 err:
@@ -384,13 +596,14 @@ static void cancel_cb (flux_t *h,
         return;
     }
 
-    if ((job = jobreq_find (ss, id))) {
+    if ((job = jobq_lookup (ss->q, id))) {
         if (schedutil_alloc_respond_cancel (ss->util_ctx, job->msg) < 0) {
             flux_log_error (h, "alloc_respond_cancel");
             return;
         }
-        zlistx_delete (ss->queue, job->handle);
-        annotate_reason_pending (ss);
+        jobq_dequeue (ss->q, job);
+        /* Let the next scheduling pass update annotations */
+        flux_watcher_start (ss->prep);
     }
 }
 
@@ -421,25 +634,15 @@ static void prioritize_cb (flux_t *h,
         if (json_unpack (arr, "[I,I]", &id, &priority) < 0)
             goto proto_error;
 
-        if ((job = jobreq_find (ss, id))) {
+        if ((job = jobq_lookup (ss->q, id))) {
             job->priority = priority;
             if (count < min_sort_size)
-                zlistx_reorder (ss->queue, job->handle, true);
+                jobq_reorder (ss->q, job);
         }
     }
-    if (count >= min_sort_size) {
-        zlistx_sort (ss->queue);
-
-        /*  zlistx handles are invalidated after a zlistx_sort(),
-         *   so reaquire them now
-         */
-        job = zlistx_first (ss->queue);
-        while (job) {
-            job->handle = zlistx_cursor (ss->queue);
-            job = zlistx_next (ss->queue);
-        }
-    }
-    annotate_reason_pending (ss);
+    if (count >= min_sort_size)
+        jobq_sort (ss->q);
+    flux_watcher_start (ss->prep);
     return;
 
 proto_error:
@@ -485,13 +688,68 @@ static int hello_cb (flux_t *h,
     s = rlist_dumps (alloc);
     if ((rc = rlist_set_allocated (ss->rlist, alloc)) < 0)
         flux_log_error (h, "hello: rlist_remove (%s)", s);
-    else
+    else {
         flux_log (h, LOG_DEBUG, "hello: alloc %s", s);
+        if (jobq_backfill (ss->q)) {
+            if (jobq_run_add (ss->q, id, alloc) < 0)
+                flux_log_error (h, "hello: jobq_run_add");
+            alloc = NULL;
+        }
+    }
     free (s);
     rlist_destroy (alloc);
     return 0;
 }
 
+/* Mark resources of all running jobs allocated in one step.
+ * R of each job is needed only to track running jobs for backfill.
+ */
+static int hello_snapshot_cb (flux_t *h,
+                              const flux_msg_t *msg,
+                              const char *R,
+                              void *arg)
+{
+    struct simple_sched *ss = arg;
+    struct rlist *alloc;
+    json_t *jobs;
+    json_t *entry;
+    size_t index;
+    char *s;
+    int rc;
+
+    if (flux_msg_unpack (msg, "{s:o}", "jobs", &jobs) < 0) {
+        flux_log_error (h, "hello: invalid snapshot payload");
+        return -1;
+    }
+    if (!(alloc = rlist_from_R (R))) {
+        flux_log_error (h, "hello: R=%s", R);
+        return -1;
+    }
+    s = rlist_dumps (alloc);
+    if ((rc = rlist_set_allocated (ss->rlist, alloc)) < 0)
+        flux_log_error (h, "hello: rlist_set_allocated (%s)", s);
+    else
+        flux_log (h, LOG_DEBUG, "hello: %zu jobs, alloc %s",
+                  json_array_size (jobs), s);
+    free (s);
+    rlist_destroy (alloc);
+    if (rc < 0 || !jobq_backfill (ss->q))
+        return 0;
+    json_array_foreach (jobs, index, entry) {
+        flux_jobid_t id;
+        const char *jobR;
+
+        if (json_unpack (entry, "{s:I s:s}", "id", &id, "R", &jobR) < 0
+            || !(alloc = rlist_from_R (jobR))) {
+            flux_log (h, LOG_ERR, "hello: invalid snapshot entry");
+            continue;
+        }
+        if (jobq_run_add (ss->q, id, alloc) < 0)
+            flux_log_error (h, "hello: jobq_run_add");
+    }
+    return 0;
+}
+
 static void status_cb (flux_t *h, flux_msg_handler_t *mh,
                        const flux_msg_t *msg, void *arg)
 {
@@ -591,7 +849,7 @@ static void acquire_continuation (flux_future_t *f, void *arg)
         return;
     }
     if (ss_resource_update (ss, f) == 0)
-        try_alloc (ss->h, ss);
+        flux_watcher_start (ss->prep);
 }
 
 /*  Synchronously acquire resources from resource module.
@@ -717,6 +975,7 @@ static struct schedutil_ops ops = {
     .free = free_cb,
     .cancel = cancel_cb,
     .prioritize = prioritize_cb,
+    .hello_snapshot = hello_snapshot_cb,
 };
 
 static int process_args (flux_t *h, struct simple_sched *ss,
@@ -731,6 +990,40 @@ static int process_args (flux_t *h, struct simple_sched *ss,
         else if (strncmp ("mode=", argv[i], 5) == 0) {
             set_mode (ss, argv[i]+5);
         }
+        else if (strncmp ("pass-limit=", argv[i], 11) == 0) {
+            char *endptr;
+            long n = strtol (argv[i]+11, &endptr, 10);
+            if (*endptr != '\0' || n < 0) {
+                flux_log (h, LOG_ERR, "invalid pass-limit: %s", argv[i]+11);
+                return -1;
+            }
+            ss->pass_limit = n;
+        }
+        else if (strncmp ("pass-timeout=", argv[i], 13) == 0) {
+            char *endptr;
+            double t = strtod (argv[i]+13, &endptr);
+            if (*endptr != '\0' || t < 0.) {
+                flux_log (h, LOG_ERR, "invalid pass-timeout: %s",
+                          argv[i]+13);
+                return -1;
+            }
+            ss->pass_timeout = t;
+        }
+        else if (strncmp ("workers=", argv[i], 8) == 0) {
+            char *endptr;
+            long n = strtol (argv[i]+8, &endptr, 10);
+            if (*endptr != '\0' || n < 0 || n > 64) {
+                flux_log (h, LOG_ERR, "invalid workers: %s", argv[i]+8);
+                return -1;
+            }
+            ss->nworkers = n;
+        }
+        else if (strcmp ("backfill", argv[i]) == 0) {
+            ss->backfill = true;
+        }
+        else if (strcmp ("batch", argv[i]) == 0) {
+            ss->schedutil_flags |= SCHEDUTIL_BATCH;
+        }
         else if (strcmp ("test-free-nolookup", argv[i]) == 0) {
             ss->schedutil_flags |= SCHEDUTIL_FREE_NOLOOKUP;
         }
@@ -777,10 +1070,20 @@ int mod_main (flux_t *h, int argc, char **argv)
     }
     flux_watcher_start (ss->prep);
 
-    if (!(ss->queue = zlistx_new ()))
+    if (ss->nworkers > 0) {
+        if (!(ss->workpool = workpool_create (r, ss->nworkers))) {
+            flux_log_error (h, "workpool_create");
+            goto done;
+        }
+    }
+
+    if (!(ss->q = jobq_create (&jobq_ops, ss, ss->backfill))
+        || jobq_set_alloc_mode (ss->q, ss->alloc_mode) < 0) {
+        flux_log_error (h, "jobq_create");
         goto done;
-    zlistx_set_comparator (ss->queue, jobreq_cmp);
-    zlistx_set_destructor (ss->queue, jobreq_destructor);
+    }
+    jobq_set_pass_limit (ss->q, ss->pass_limit);
+    jobq_set_pass_timeout (ss->q, ss->pass_timeout);
 
     /* Let `flux module load simple-sched` return before synchronous
      * initialization with resource and job-manager modules.
@@ -0,0 +1,220 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* workpool.c - worker threads with completions run in the reactor
+ *
+ * Workers take items from the input list and put them on the output
+ * list when done.  A worker that makes the output list non-empty writes
+ * a byte to a pipe, which wakes an fd watcher on the reactor thread to
+ * run 'done' callbacks for everything on the output list.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <flux/core.h>
+
+#include "workpool.h"
+
+struct work {
+    workpool_f work;
+    workpool_f done;
+    void *arg;
+    struct work *next;
+};
+
+struct workpool {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct work *in_head;
+    struct work *in_tail;
+    struct work *out_head;
+    struct work *out_tail;
+    bool shutdown;
+
+    pthread_t *threads;
+    int nthreads;
+
+    int fds[2];
+    flux_watcher_t *w;
+};
+
+static void list_append (struct work **head, struct work **tail, struct work *w)
+{
+    w->next = NULL;
+    if (*tail)
+        (*tail)->next = w;
+    else
+        *head = w;
+    *tail = w;
+}
+
+static void *worker (void *arg)
+{
+    struct workpool *wp = arg;
+    struct work *w;
+    bool wake;
+
+    for (;;) {
+        pthread_mutex_lock (&wp->lock);
+        while (!wp->in_head && !wp->shutdown)
+            pthread_cond_wait (&wp->cond, &wp->lock);
+        if (!(w = wp->in_head)) {
+            pthread_mutex_unlock (&wp->lock);
+            break;
+        }
+        if (!(wp->in_head = w->next))
+            wp->in_tail = NULL;
+        pthread_mutex_unlock (&wp->lock);
+
+        w->work (w->arg);
+
+        pthread_mutex_lock (&wp->lock);
+        wake = (wp->out_head == NULL);
+        list_append (&wp->out_head, &wp->out_tail, w);
+        pthread_mutex_unlock (&wp->lock);
+        if (wake) {
+            char c = 0;
+            while (write (wp->fds[1], &c, 1) < 0 && errno == EINTR)
+                ;
+        }
+    }
+    return NULL;
+}
+
+static void run_completions (struct workpool *wp)
+{
+    struct work *w;
+
+    pthread_mutex_lock (&wp->lock);
+    w = wp->out_head;
+    wp->out_head = wp->out_tail = NULL;
+    pthread_mutex_unlock (&wp->lock);
+
+    while (w) {
+        struct work *next = w->next;
+        w->done (w->arg);
+        free (w);
+        w = next;
+    }
+}
+
+static void completion_cb (flux_reactor_t *r,
+                           flux_watcher_t *watcher,
+                           int revents,
+                           void *arg)
+{
+    struct workpool *wp = arg;
+    char buf[64];
+
+    while (read (wp->fds[0], buf, sizeof (buf)) > 0)
+        ;
+    run_completions (wp);
+}
+
+int workpool_submit (struct workpool *wp,
+                     workpool_f work,
+                     workpool_f done,
+                     void *arg)
+{
+    struct work *w;
+
+    if (!wp || !work || !done) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(w = calloc (1, sizeof (*w))))
+        return -1;
+    w->work = work;
+    w->done = done;
+    w->arg = arg;
+    pthread_mutex_lock (&wp->lock);
+    list_append (&wp->in_head, &wp->in_tail, w);
+    pthread_cond_signal (&wp->cond);
+    pthread_mutex_unlock (&wp->lock);
+    return 0;
+}
+
+void workpool_destroy (struct workpool *wp)
+{
+    if (wp) {
+        int saved_errno = errno;
+        int i;
+
+        pthread_mutex_lock (&wp->lock);
+        wp->shutdown = true;
+        pthread_cond_broadcast (&wp->cond);
+        pthread_mutex_unlock (&wp->lock);
+        for (i = 0; i < wp->nthreads; i++)
+            pthread_join (wp->threads[i], NULL);
+        run_completions (wp);
+
+        flux_watcher_destroy (wp->w);
+        if (wp->fds[0] >= 0)
+            close (wp->fds[0]);
+        if (wp->fds[1] >= 0)
+            close (wp->fds[1]);
+        pthread_cond_destroy (&wp->cond);
+        pthread_mutex_destroy (&wp->lock);
+        free (wp->threads);
+        free (wp);
+        errno = saved_errno;
+    }
+}
+
+struct workpool *workpool_create (flux_reactor_t *r, int nthreads)
+{
+    struct workpool *wp;
+    int e;
+
+    if (!r || nthreads < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(wp = calloc (1, sizeof (*wp))))
+        return NULL;
+    wp->fds[0] = wp->fds[1] = -1;
+    pthread_mutex_init (&wp->lock, NULL);
+    pthread_cond_init (&wp->cond, NULL);
+    if (!(wp->threads = calloc (nthreads, sizeof (wp->threads[0]))))
+        goto error;
+    if (pipe2 (wp->fds, O_CLOEXEC | O_NONBLOCK) < 0)
+        goto error;
+    if (!(wp->w = flux_fd_watcher_create (r,
+                                          wp->fds[0],
+                                          FLUX_POLLIN,
+                                          completion_cb,
+                                          wp)))
+        goto error;
+    flux_watcher_start (wp->w);
+    for (; wp->nthreads < nthreads; wp->nthreads++) {
+        if ((e = pthread_create (&wp->threads[wp->nthreads],
+                                 NULL,
+                                 worker,
+                                 wp))) {
+            errno = e;
+            goto error;
+        }
+    }
+    return wp;
+error:
+    workpool_destroy (wp);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,39 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef HAVE_SCHED_WORKPOOL_H
+#define HAVE_SCHED_WORKPOOL_H 1
+
+#include <flux/core.h>
+
+/* A small pool of worker threads for CPU-bound work that does not
+ * touch shared state.  'work' runs on a worker thread, then 'done'
+ * runs on the reactor thread with the same argument.  'done' callbacks
+ * run in the order work completes, not the order it was submitted.
+ */
+typedef void (*workpool_f)(void *arg);
+
+struct workpool *workpool_create (flux_reactor_t *r, int nthreads);
+
+/* Finish all submitted work and run its 'done' callbacks before
+ * returning.
+ */
+void workpool_destroy (struct workpool *wp);
+
+int workpool_submit (struct workpool *wp,
+                     workpool_f work,
+                     workpool_f done,
+                     void *arg);
+
+#endif /* !HAVE_SCHED_WORKPOOL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
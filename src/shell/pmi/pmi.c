@@ -43,6 +43,17 @@
  * shell_pmi_task_ready() logs read errors, EOF, and finalization to stderr
  * in a compatible format.
  *
+ * If pmi.kvs=dist is specified, the fence exchanges only an index mapping
+ * each key to the shell rank that owns it.  Values stay on the owning shell
+ * and are fetched on demand with a pmi-kvs-get RPC, then cached locally.
+ * Concurrent gets of the same key by local tasks share one RPC.
+ *
+ * If pmi.shm is specified, the shell publishes a read-only snapshot of
+ * the dictionary to a memory-backed file after each exchange, before the
+ * barrier is released.  Its path is passed to tasks in PMI_SHM_KVS so that
+ * the libpmi client can answer gets locally, falling back to the wire
+ * protocol for keys not found there.
+ *
  * Caveats:
  * - PMI kvsname parameter is ignored
  * - 64-bit Flux job id's are assigned to integer-typed PMI appnum
@@ -63,6 +74,7 @@
 
 #include "src/common/libpmi/simple_server.h"
 #include "src/common/libpmi/clique.h"
+#include "src/common/libpmi/shm_kvs.h"
 #include "src/common/libutil/errno_safe.h"
 
 #include "builtins.h"
@@ -77,6 +89,11 @@ struct shell_pmi {
     json_t *pending;// pending to be exchanged
     json_t *locals;  // never exchanged
     struct pmi_exchange *exchange;
+    json_t *index;  // key => owning shell rank (kvs=dist only)
+    json_t *cache;  // values fetched from other shells (kvs=dist only)
+    zhashx_t *lookups; // key => in-flight pmi-kvs-get future (kvs=dist only)
+    struct shm_kvs_writer *shm; // node-local snapshot (pmi.shm only)
+    char *shm_path;
 };
 
 /* pmi_simple_ops->abort() signature */
@@ -92,6 +109,19 @@ static void shell_pmi_abort (void *arg,
                msg ? msg : "");
 }
 
+static void zlist_destroy_wrap (zlist_t *l)
+{
+    zlist_destroy (&l);
+}
+
+static void future_destroy_wrap (void **item)
+{
+    if (item) {
+        flux_future_destroy (*item);
+        *item = NULL;
+    }
+}
+
 static int put_dict (json_t *dict, const char *key, const char *val)
 {
     json_t *o;
@@ -108,6 +138,43 @@ nomem:
     return -1;
 }
 
+static int shm_put_dict (struct shm_kvs_writer *w, json_t *dict)
+{
+    const char *key;
+    json_t *val;
+
+    if (dict) {
+        json_object_foreach (dict, key, val) {
+            if (shm_kvs_writer_put (w, key, json_string_value (val)) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/* Publish the node-local snapshot of all values known to this shell.
+ * A later put replaces an earlier one, so dictionaries are added in
+ * reverse order of the precedence used by kvs_get (locals > pending >
+ * global > cache).  On failure, remove the snapshot so clients use the
+ * wire protocol.
+ */
+static void shm_publish (struct shell_pmi *pmi)
+{
+    if (!pmi->shm)
+        return;
+    shm_kvs_writer_clear (pmi->shm);
+    if (shm_put_dict (pmi->shm, pmi->cache) < 0
+        || shm_put_dict (pmi->shm, pmi->global) < 0
+        || shm_put_dict (pmi->shm, pmi->pending) < 0
+        || shm_put_dict (pmi->shm, pmi->locals) < 0
+        || shm_kvs_writer_commit (pmi->shm, pmi->shm_path) < 0) {
+        shell_warn ("%s: %s", pmi->shm_path, flux_strerror (errno));
+        (void)unlink (pmi->shm_path);
+        shm_kvs_writer_destroy (pmi->shm);
+        pmi->shm = NULL;
+    }
+}
+
 /**
  ** ops for using native Flux KVS for PMI KVS
  ** This is used if pmi.kvs=native option is provided.
@@ -258,6 +325,7 @@ static void exchange_cb (struct pmi_exchange *pex, void *arg)
         goto done;
     }
     json_object_clear (pmi->pending);
+    shm_publish (pmi);
     rc = 0;
 done:
     pmi_simple_server_barrier_complete (pmi->server, rc);
@@ -289,6 +357,7 @@ static int exchange_barrier_enter (void *arg)
     struct shell_pmi *pmi = arg;
 
     if (pmi->shell->info->shell_size == 1) {
+        shm_publish (pmi);
         pmi_simple_server_barrier_complete (pmi->server, 0);
         return 0;
     }
@@ -313,6 +382,217 @@ static int exchange_kvs_put (void *arg,
     return put_dict (pmi->pending, key, val);
 }
 
+/**
+ ** ops for using a distributed key index for PMI KVS
+ ** This is used if pmi.kvs=dist option is provided.
+ **/
+
+static void dist_exchange_cb (struct pmi_exchange *pex, void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    json_t *dict;
+    const char *key;
+    json_t *val;
+    int rc = -1;
+
+    if (pmi_exchange_has_error (pex)) {
+        shell_warn ("exchange failed");
+        goto done;
+    }
+    dict = pmi_exchange_get_dict (pex);
+    /* Keys put during this epoch may have a new owner, so drop any
+     * stale copies from the cache before updating the index.
+     */
+    json_object_foreach (dict, key, val)
+        (void)json_object_del (pmi->cache, key);
+    if (json_object_update (pmi->index, dict) < 0
+        || json_object_update (pmi->global, pmi->pending) < 0) {
+        shell_warn ("failed to update dict after successful exchange");
+        goto done;
+    }
+    json_object_clear (pmi->pending);
+    shm_publish (pmi);
+    rc = 0;
+done:
+    pmi_simple_server_barrier_complete (pmi->server, rc);
+}
+
+/* pmi_simple_ops->barrier_enter() signature */
+static int dist_barrier_enter (void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    int shell_rank = pmi->shell->info->shell_rank;
+    json_t *dict;
+    const char *key;
+    json_t *val;
+    int rc = -1;
+
+    if (pmi->shell->info->shell_size == 1) {
+        if (json_object_update (pmi->global, pmi->pending) < 0)
+            return -1; // PMI_FAIL
+        json_object_clear (pmi->pending);
+        shm_publish (pmi);
+        pmi_simple_server_barrier_complete (pmi->server, 0);
+        return 0;
+    }
+    if (!(dict = json_object ()))
+        goto nomem;
+    json_object_foreach (pmi->pending, key, val) {
+        json_t *o;
+        if (!(o = json_integer (shell_rank))
+            || json_object_set_new (dict, key, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    if (pmi_exchange (pmi->exchange, dict, dist_exchange_cb, pmi) < 0) {
+        shell_warn ("pmi_exchange %s", flux_strerror (errno));
+        goto out;
+    }
+    rc = 0;
+out:
+    json_decref (dict);
+    return rc; // PMI_FAIL on -1
+nomem:
+    errno = ENOMEM;
+    goto out;
+}
+
+static void dist_lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    const char *key = flux_future_aux_get (f, "pmi_key");
+    zlist_t *clients = flux_future_aux_get (f, "pmi_clients");
+    const char *val = NULL;
+    void *cli;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "value", &val) < 0) {
+        shell_warn ("pmi-kvs-get %s: %s", key, future_strerror (f, errno));
+        val = NULL;
+    }
+    else
+        (void)put_dict (pmi->cache, key, val);
+    while ((cli = zlist_pop (clients)))
+        pmi_simple_server_kvs_get_complete (pmi->server, cli, val);
+    zhashx_delete (pmi->lookups, key); // destroys f
+}
+
+static int dist_lookup (struct shell_pmi *pmi,
+                        const char *key,
+                        int owner,
+                        void *cli)
+{
+    flux_future_t *f;
+    zlist_t *clients;
+    char *cpy;
+
+    if ((f = zhashx_lookup (pmi->lookups, key))) {
+        clients = flux_future_aux_get (f, "pmi_clients");
+        if (zlist_append (clients, cli) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        return 0;
+    }
+    if (!(f = flux_shell_rpc_pack (pmi->shell,
+                                   "pmi-kvs-get",
+                                   owner,
+                                   0,
+                                   "{s:s}",
+                                   "key", key)))
+        return -1;
+    if (!(clients = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_future_aux_set (f,
+                             "pmi_clients",
+                             clients,
+                             (flux_free_f)zlist_destroy_wrap) < 0) {
+        zlist_destroy (&clients);
+        goto error;
+    }
+    if (!(cpy = strdup (key))
+        || flux_future_aux_set (f, "pmi_key", cpy, free) < 0) {
+        ERRNO_SAFE_WRAP (free, cpy);
+        goto error;
+    }
+    if (zlist_append (clients, cli) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_future_then (f, -1, dist_lookup_continuation, pmi) < 0)
+        goto error;
+    if (zhashx_insert (pmi->lookups, key, f) < 0) {
+        errno = EEXIST;
+        goto error;
+    }
+    return 0;
+error:
+    flux_future_destroy (f);
+    return -1;
+}
+
+/* pmi_simple_ops->kvs_get() signature */
+static int dist_kvs_get (void *arg,
+                         void *cli,
+                         const char *kvsname,
+                         const char *key)
+{
+    struct shell_pmi *pmi = arg;
+    json_t *o;
+    int owner;
+
+    if ((o = json_object_get (pmi->locals, key))
+            || (o = json_object_get (pmi->pending, key))
+            || (o = json_object_get (pmi->global, key))
+            || (o = json_object_get (pmi->cache, key))) {
+        pmi_simple_server_kvs_get_complete (pmi->server,
+                                            cli,
+                                            json_string_value (o));
+        return 0;
+    }
+    if (!(o = json_object_get (pmi->index, key))
+        || (owner = json_integer_value (o)) == pmi->shell->info->shell_rank)
+        return -1; // PMI_ERR_INVALID_KEY
+    if (dist_lookup (pmi, key, owner, cli) < 0) {
+        shell_warn ("pmi-kvs-get %s: %s", key, flux_strerror (errno));
+        return -1;
+    }
+    return 0; // response deferred
+}
+
+/* Another shell requests the value of a key owned by this shell.
+ * The exchange may complete on the requesting shell before this one,
+ * so a key put in the last epoch may still be pending here.
+ */
+static void dist_kvs_get_cb (flux_t *h,
+                             flux_msg_handler_t *mh,
+                             const flux_msg_t *msg,
+                             void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    const char *key;
+    json_t *o;
+
+    if (flux_request_unpack (msg, NULL, "{s:s}", "key", &key) < 0)
+        goto error;
+    if (!(o = json_object_get (pmi->locals, key))
+        && !(o = json_object_get (pmi->pending, key))
+        && !(o = json_object_get (pmi->global, key))) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "{s:O}", "value", o) < 0)
+        shell_warn ("error responding to pmi-kvs-get request: %s",
+                    flux_strerror (errno));
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        shell_warn ("error responding to pmi-kvs-get request: %s",
+                    flux_strerror (errno));
+}
+
 /**
  ** end of KVS implementations
  **/
@@ -442,12 +722,42 @@ out:
     return rc;
 }
 
+/* Place the snapshot on /dev/shm if available so that it is memory-backed.
+ * Include the shell rank since shells of one job may share a node.
+ */
+static int init_shm (struct shell_pmi *pmi, const char *kvsname)
+{
+    const char *dir = "/dev/shm";
+
+    if (access (dir, W_OK) < 0 && !(dir = getenv ("TMPDIR")))
+        dir = "/tmp";
+    if (asprintf (&pmi->shm_path,
+                  "%s/flux-pmi-%ju-%d",
+                  dir,
+                  (uintmax_t)pmi->shell->jobid,
+                  pmi->shell->info->shell_rank) < 0) {
+        pmi->shm_path = NULL;
+        return -1;
+    }
+    if (!(pmi->shm = shm_kvs_writer_create (kvsname)))
+        return -1;
+    return 0;
+}
+
 static void pmi_destroy (struct shell_pmi *pmi)
 {
     if (pmi) {
         int saved_errno = errno;
         pmi_simple_server_destroy (pmi->server);
+        if (pmi->shm_path) {
+            (void)unlink (pmi->shm_path);
+            free (pmi->shm_path);
+        }
+        shm_kvs_writer_destroy (pmi->shm);
+        zhashx_destroy (&pmi->lookups);
         pmi_exchange_destroy (pmi->exchange);
+        json_decref (pmi->index);
+        json_decref (pmi->cache);
         json_decref (pmi->global);
         json_decref (pmi->pending);
         json_decref (pmi->locals);
@@ -462,15 +772,20 @@ static struct pmi_simple_ops shell_pmi_ops = {
     .abort          = shell_pmi_abort,
 };
 
-static int parse_args (flux_shell_t *shell, int *exchange_k, const char **kvs)
+static int parse_args (flux_shell_t *shell,
+                       int *exchange_k,
+                       const char **kvs,
+                       int *shm)
 {
     if (flux_shell_getopt_unpack (shell,
                                   "pmi",
-                                  "{s?s s?{s?i}}",
+                                  "{s?s s?{s?i} s?i}",
                                   "kvs",
                                   kvs,
                                   "exchange",
-                                    "k", exchange_k) < 0)
+                                    "k", exchange_k,
+                                  "shm",
+                                  shm) < 0)
         return -1;
     return 0;
 }
@@ -483,12 +798,13 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
     char kvsname[32];
     const char *kvs = "exchange";
     int exchange_k = 0; // 0=use default tree fanout
+    int shm = 0;
 
     if (!(pmi = calloc (1, sizeof (*pmi))))
         return NULL;
     pmi->shell = shell;
 
-    if (parse_args (shell, &exchange_k, &kvs) < 0)
+    if (parse_args (shell, &exchange_k, &kvs, &shm) < 0)
         goto error;
     if (!strcmp (kvs, "native")) {
         shell_pmi_ops.kvs_put = native_kvs_put;
@@ -504,6 +820,27 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
         if (!(pmi->exchange = pmi_exchange_create (shell, exchange_k)))
             goto error;
     }
+    else if (!strcmp (kvs, "dist")) {
+        shell_pmi_ops.kvs_put = exchange_kvs_put;
+        shell_pmi_ops.kvs_get = dist_kvs_get;
+        shell_pmi_ops.barrier_enter = dist_barrier_enter;
+        if (!(pmi->exchange = pmi_exchange_create (shell, exchange_k)))
+            goto error;
+        if (!(pmi->index = json_object ())
+            || !(pmi->cache = json_object ())
+            || !(pmi->lookups = zhashx_new ())) {
+            errno = ENOMEM;
+            goto error;
+        }
+        zhashx_set_destructor (pmi->lookups, future_destroy_wrap);
+        if (flux_shell_service_register (shell,
+                                         "pmi-kvs-get",
+                                         dist_kvs_get_cb,
+                                         pmi) < 0)
+            goto error;
+        if (shell->info->shell_rank == 0)
+            shell_warn ("using distributed kvs implementation");
+    }
     else {
         shell_log_error ("Unknown kvs implementation %s", kvs);
         errno = EINVAL;
@@ -540,6 +877,11 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
         if (set_flux_instance_level (pmi) < 0)
             goto error;
     }
+    if (shm) {
+        if (init_shm (pmi, kvsname) < 0)
+            goto error;
+        shm_publish (pmi);
+    }
     return pmi;
 error:
     pmi_destroy (pmi);
@@ -584,6 +926,10 @@ static int shell_pmi_task_init (flux_plugin_t *p,
         return -1;
     if (flux_cmd_setenvf (cmd, 1, "PMI_SIZE", "%d", task->size) < 0)
         return -1;
+    if (pmi->shm) {
+        if (flux_cmd_setenvf (cmd, 1, "PMI_SHM_KVS", "%s", pmi->shm_path) < 0)
+            return -1;
+    }
     if (flux_shell_task_channel_subscribe (task, "PMI_FD", pmi_fd_cb, pmi) < 0)
         return -1;
     return 0;
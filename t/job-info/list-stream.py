@@ -0,0 +1,44 @@
+###############################################################
+# Copyright 2021 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+###############################################################
+
+# Usage: flux python list-stream.py PAGE_SIZE [STATES] [CANCEL_AFTER]
+#
+#  List all jobs of the current user with a streaming job-info.list
+#  request, printing one jobid per line and the number of pages
+#  received on stderr.  If CANCEL_AFTER is given, cancel the stream
+#  after that many pages (0 = right after sending the request), then
+#  keep reading until the server terminates the stream.
+
+import sys
+
+import flux
+from flux.job import job_list_stream
+
+h = flux.Flux()
+page_size = int(sys.argv[1])
+states = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+cancel_after = int(sys.argv[3]) if len(sys.argv) > 3 else -1
+
+rpc = job_list_stream(h, max_entries=0, states=states, page_size=page_size)
+pages = 0
+if cancel_after == 0:
+    rpc.cancel()
+page = rpc.get_page()
+while page is not None:
+    pages += 1
+    for job in page:
+        print(job["id"])
+    if pages == cancel_after:
+        rpc.cancel()
+    page = rpc.get_page()
+print(f"pages={pages}", file=sys.stderr)
+
+
+# vim: tabstop=4 shiftwidth=4 expandtab
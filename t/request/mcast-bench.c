@@ -0,0 +1,235 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* mcast-bench - measure event multicast rate over a ROUTER socket
+ *
+ * For each fanout in --fanout, connect that many DEALER sockets to a
+ * ROUTER socket over inproc, as the broker overlay does with its TBON
+ * children, then multicast --count events carrying a --size byte payload
+ * to all of them.  Two methods are timed:
+ *
+ *  copy:  copy the event and push the child route onto each copy
+ *  route: send the event with flux_msg_sendzsock_route()
+ *
+ * Events are sent in batches, and each batch is received by all
+ * children before the next one is sent.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <czmq.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+#define BATCH_SIZE 64
+
+struct bench {
+    int count;
+    int fanout;
+    zsock_t *router;
+    zsock_t **child;
+    char **uuid;
+    flux_msg_t *msg;
+};
+
+static const char *usage_msg = "[OPTIONS]";
+static struct optparse_option opts[] = {
+    { .name = "count", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Send N events at each fanout (default 10000)",
+    },
+    { .name = "size", .key = 's', .has_arg = 1, .arginfo = "BYTES",
+      .usage = "Set event payload size in bytes (default 1024)",
+    },
+    { .name = "fanout", .key = 'f', .has_arg = 1, .arginfo = "N,...",
+      .usage = "Comma-separated list of fanouts (default 2,16,64)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static void send_copy (struct bench *b, int i)
+{
+    flux_msg_t *cpy;
+
+    if (!(cpy = flux_msg_copy (b->msg, true))
+        || flux_msg_enable_route (cpy) < 0
+        || flux_msg_push_route (cpy, b->uuid[i]) < 0
+        || flux_msg_sendzsock (b->router, cpy) < 0)
+        log_err_exit ("error sending copy");
+    flux_msg_destroy (cpy);
+}
+
+static void send_route (struct bench *b, int i)
+{
+    if (flux_msg_sendzsock_route (b->router, b->msg, b->uuid[i], false) < 0)
+        log_err_exit ("flux_msg_sendzsock_route");
+}
+
+static void bench_run (struct bench *b,
+                       const char *name,
+                       void (*send)(struct bench *, int))
+{
+    struct timespec t0;
+    double ms;
+    int sent = 0;
+    int batch;
+    int i, j;
+
+    monotime (&t0);
+    while (sent < b->count) {
+        batch = b->count - sent;
+        if (batch > BATCH_SIZE)
+            batch = BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            for (i = 0; i < b->fanout; i++)
+                send (b, i);
+        }
+        for (i = 0; i < b->fanout; i++) {
+            for (j = 0; j < batch; j++) {
+                flux_msg_t *msg;
+                if (!(msg = flux_msg_recvzsock (b->child[i])))
+                    log_err_exit ("flux_msg_recvzsock");
+                flux_msg_destroy (msg);
+            }
+        }
+        sent += batch;
+    }
+    ms = monotime_since (t0);
+    printf ("fanout=%d %-6s %10.1f events/sec\n",
+            b->fanout,
+            name,
+            ms > 0. ? b->count / (ms / 1000.) : 0.);
+}
+
+static void bench_setup (struct bench *b, int fanout)
+{
+    const char *uri = "inproc://mcast-bench";
+    int i;
+
+    b->fanout = fanout;
+    if (!(b->child = calloc (fanout, sizeof (b->child[0])))
+        || !(b->uuid = calloc (fanout, sizeof (b->uuid[0]))))
+        log_err_exit ("calloc");
+    if (!(b->router = zsock_new_router (NULL)))
+        log_err_exit ("zsock_new_router");
+    zsock_set_router_mandatory (b->router, 1);
+    if (zsock_bind (b->router, "%s", uri) < 0)
+        log_err_exit ("zsock_bind %s", uri);
+    for (i = 0; i < fanout; i++) {
+        if (asprintf (&b->uuid[i], "child%d", i) < 0)
+            log_err_exit ("asprintf");
+        if (!(b->child[i] = zsock_new_dealer (NULL)))
+            log_err_exit ("zsock_new_dealer");
+        zsock_set_identity (b->child[i], b->uuid[i]);
+        if (zsock_connect (b->child[i], "%s", uri) < 0)
+            log_err_exit ("zsock_connect %s", uri);
+    }
+    /* Wait for a hello from each child so the router knows its peers.
+     */
+    for (i = 0; i < fanout; i++) {
+        if (zstr_send (b->child[i], "hello") < 0)
+            log_err_exit ("zstr_send");
+    }
+    for (i = 0; i < fanout; i++) {
+        zmsg_t *zmsg;
+        if (!(zmsg = zmsg_recv (b->router)))
+            log_err_exit ("zmsg_recv");
+        zmsg_destroy (&zmsg);
+    }
+}
+
+static void bench_teardown (struct bench *b)
+{
+    int i;
+
+    for (i = 0; i < b->fanout; i++) {
+        zsock_destroy (&b->child[i]);
+        free (b->uuid[i]);
+    }
+    zsock_destroy (&b->router);
+    free (b->child);
+    free (b->uuid);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    struct bench b;
+    const char *fanouts;
+    char *cpy, *tok, *saveptr = NULL, *endptr;
+    char *payload;
+    int size;
+    int fanout;
+
+    log_init ("mcast-bench");
+
+    if (!(p = optparse_create ("mcast-bench")))
+        log_msg_exit ("optparse_create");
+    if (optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_add_option_table() failed");
+    if (optparse_set (p, OPTPARSE_USAGE, usage_msg) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_set (USAGE)");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    memset (&b, 0, sizeof (b));
+    b.count = optparse_get_int (p, "count", 10000);
+    size = optparse_get_int (p, "size", 1024);
+    fanouts = optparse_get_str (p, "fanout", "2,16,64");
+    if (b.count < 1 || size < 0)
+        log_msg_exit ("invalid argument");
+
+    zsys_init ();
+    zsys_set_logstream (stderr);
+    zsys_handler_set (NULL);
+    zsys_set_linger (5);
+
+    if (!(payload = malloc (size + 1)))
+        log_err_exit ("malloc");
+    memset (payload, 'x', size);
+    if (!(b.msg = flux_event_encode_raw ("bench.event", payload, size))
+        || flux_msg_set_seq (b.msg, 1) < 0)
+        log_err_exit ("error creating event");
+
+    printf ("payload: %d bytes\n", size);
+    if (!(cpy = strdup (fanouts)))
+        log_err_exit ("strdup");
+    tok = strtok_r (cpy, ",", &saveptr);
+    while (tok) {
+        errno = 0;
+        fanout = strtol (tok, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || fanout < 1)
+            log_msg_exit ("invalid fanout: %s", tok);
+        bench_setup (&b, fanout);
+        bench_run (&b, "copy:", send_copy);
+        bench_run (&b, "route:", send_route);
+        bench_teardown (&b);
+        tok = strtok_r (NULL, ",", &saveptr);
+    }
+
+    free (cpy);
+    free (payload);
+    flux_msg_destroy (b.msg);
+    zsys_shutdown ();
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,223 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* msg-bench - measure flux_msg_t create/encode/decode/copy/dispatch rates
+ *
+ * Each phase is repeated --count times on a request message carrying
+ * a topic, a route stack of --hops routes, and a --size byte payload.
+ * The "dispatch" phase performs the accessor calls made when a message
+ * is matched against a set of message handlers: type, topic glob and
+ * matchtag comparisons, plus credential and route count checks.
+ *
+ * Run against two builds to compare message implementations.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+#define HANDLER_COUNT 16
+
+struct bench {
+    int count;
+    int hops;
+    int size;
+    char *payload;
+    flux_msg_t *msg;
+    void *buf;
+    size_t bufsize;
+    struct flux_match match[HANDLER_COUNT];
+    char topic[HANDLER_COUNT][32];
+};
+
+static const char *usage_msg = "[OPTIONS]";
+static struct optparse_option opts[] = {
+    { .name = "count", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Repeat each operation N times (default 100000)",
+    },
+    { .name = "size", .key = 's', .has_arg = 1, .arginfo = "BYTES",
+      .usage = "Set payload size in bytes (default 1024)",
+    },
+    { .name = "hops", .key = 'H', .has_arg = 1, .arginfo = "N",
+      .usage = "Push N routes onto the message (default 2)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static flux_msg_t *msg_create (struct bench *b)
+{
+    flux_msg_t *msg;
+    char id[16];
+    int i;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_set_topic (msg, "bench.handler15") < 0
+        || flux_msg_set_matchtag (msg, 42) < 0
+        || flux_msg_set_userid (msg, 100) < 0
+        || flux_msg_set_rolemask (msg, FLUX_ROLE_USER) < 0
+        || flux_msg_set_payload (msg, b->payload, b->size) < 0
+        || flux_msg_enable_route (msg) < 0)
+        log_err_exit ("error creating message");
+    for (i = 0; i < b->hops; i++) {
+        snprintf (id, sizeof (id), "%d", i);
+        if (flux_msg_push_route (msg, id) < 0)
+            log_err_exit ("flux_msg_push_route");
+    }
+    return msg;
+}
+
+static void bench_create (struct bench *b)
+{
+    int i;
+
+    for (i = 0; i < b->count; i++)
+        flux_msg_destroy (msg_create (b));
+}
+
+static void bench_encode (struct bench *b)
+{
+    int i;
+
+    for (i = 0; i < b->count; i++) {
+        if (flux_msg_encode (b->msg, b->buf, b->bufsize) < 0)
+            log_err_exit ("flux_msg_encode");
+    }
+}
+
+static void bench_decode (struct bench *b)
+{
+    flux_msg_t *msg;
+    int i;
+
+    for (i = 0; i < b->count; i++) {
+        if (!(msg = flux_msg_decode (b->buf, b->bufsize)))
+            log_err_exit ("flux_msg_decode");
+        flux_msg_destroy (msg);
+    }
+}
+
+/* Copy and forward one hop, as the broker does when routing a message.
+ */
+static void bench_copy (struct bench *b)
+{
+    flux_msg_t *msg;
+    int i;
+
+    for (i = 0; i < b->count; i++) {
+        if (!(msg = flux_msg_copy (b->msg, true))
+            || flux_msg_push_route (msg, "broker") < 0)
+            log_err_exit ("flux_msg_copy");
+        flux_msg_destroy (msg);
+    }
+}
+
+static void bench_dispatch (struct bench *b)
+{
+    struct flux_msg_cred cred;
+    uint32_t matchtag;
+    int matched = 0;
+    int i, j;
+
+    for (i = 0; i < b->count; i++) {
+        for (j = 0; j < HANDLER_COUNT; j++) {
+            if (flux_msg_cmp (b->msg, b->match[j]))
+                break;
+        }
+        if (j < HANDLER_COUNT
+            && flux_msg_get_cred (b->msg, &cred) == 0
+            && flux_msg_cred_authorize (cred, 100) == 0
+            && flux_msg_get_route_count (b->msg) == b->hops
+            && flux_msg_get_matchtag (b->msg, &matchtag) == 0)
+            matched++;
+    }
+    if (matched != b->count)
+        log_msg_exit ("dispatch matched %d of %d messages", matched, b->count);
+}
+
+static void run (struct bench *b, const char *name, void (*fn)(struct bench *))
+{
+    struct timespec t0;
+    double ms;
+
+    monotime (&t0);
+    fn (b);
+    ms = monotime_since (t0);
+    printf ("%-9s %10.1f msgs/sec\n",
+            name,
+            ms > 0. ? b->count / (ms / 1000.) : 0.);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    struct bench b;
+    int i;
+
+    log_init ("msg-bench");
+
+    if (!(p = optparse_create ("msg-bench")))
+        log_msg_exit ("optparse_create");
+    if (optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_add_option_table() failed");
+    if (optparse_set (p, OPTPARSE_USAGE, usage_msg) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_set (USAGE)");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    memset (&b, 0, sizeof (b));
+    b.count = optparse_get_int (p, "count", 100000);
+    b.size = optparse_get_int (p, "size", 1024);
+    b.hops = optparse_get_int (p, "hops", 2);
+    if (b.count < 1 || b.size < 0 || b.hops < 0)
+        log_msg_exit ("invalid argument");
+
+    if (!(b.payload = malloc (b.size + 1)))
+        log_err_exit ("malloc");
+    memset (b.payload, 'x', b.size);
+    for (i = 0; i < HANDLER_COUNT; i++) {
+        snprintf (b.topic[i], sizeof (b.topic[i]), "bench.handler%d%s",
+                  i, i == HANDLER_COUNT - 1 ? "" : ".*");
+        b.match[i] = FLUX_MATCH_REQUEST;
+        b.match[i].topic_glob = b.topic[i];
+    }
+    b.msg = msg_create (&b);
+    b.bufsize = flux_msg_encode_size (b.msg);
+    if (!(b.buf = malloc (b.bufsize)))
+        log_err_exit ("malloc");
+
+    printf ("payload:   %d bytes\n", b.size);
+    printf ("hops:      %d\n", b.hops);
+    printf ("encoded:   %zu bytes\n", b.bufsize);
+    run (&b, "create:", bench_create);
+    run (&b, "encode:", bench_encode);
+    run (&b, "decode:", bench_decode);
+    run (&b, "copy:", bench_copy);
+    run (&b, "dispatch:", bench_dispatch);
+
+    free (b.buf);
+    free (b.payload);
+    flux_msg_destroy (b.msg);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
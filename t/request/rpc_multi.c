@@ -0,0 +1,107 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rpc_multi - send a request to a set of ranks with flux_rpc_multi()
+ *
+ * Usage: rpc_multi [--cancel] topic ranks <payload
+ *
+ * Prints one line per rank: "rank: payload" on success, or
+ * "rank: error message" on failure.  Lines are printed in the order
+ * responses arrive, so callers should sort the output.
+ *
+ * With --cancel, send "mrpc.cancel" after the first response, then
+ * continue printing responses until the stream is terminated.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/read_all.h"
+#include "src/common/libutil/log.h"
+
+int main (int argc, char *argv[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    const char *topic;
+    const char *ranks;
+    ssize_t inlen;
+    void *inbuf;
+    const char *out;
+    uint32_t rank;
+    int errors = 0;
+    int optindex = 1;
+    bool cancel = false;
+
+    if (argc > 1 && !strcmp (argv[1], "--cancel")) {
+        cancel = true;
+        optindex++;
+    }
+    if (argc - optindex != 2) {
+        fprintf (stderr, "Usage: rpc_multi [--cancel] topic ranks <payload\n");
+        exit (1);
+    }
+    topic = argv[optindex];
+    ranks = argv[optindex + 1];
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    if ((inlen = read_all (STDIN_FILENO, &inbuf)) < 0)
+        log_err_exit ("read from stdin");
+
+    if (!(f = flux_rpc_multi (h, topic, inlen > 0 ? inbuf : NULL, ranks, 0)))
+        log_err_exit ("flux_rpc_multi %s", topic);
+    for (;;) {
+        if (flux_rpc_get (f, &out) < 0) {
+            if (errno == ENODATA)
+                break;
+            if (flux_rpc_multi_get_rank (f, &rank) < 0)
+                log_msg_exit ("%s: %s", topic, future_strerror (f, errno));
+            printf ("%" PRIu32 ": %s\n", rank, future_strerror (f, errno));
+            errors++;
+        }
+        else {
+            if (flux_rpc_multi_get_rank (f, &rank) < 0)
+                log_err_exit ("flux_rpc_multi_get_rank");
+            printf ("%" PRIu32 ": %s\n", rank, out ? out : "");
+        }
+        fflush (stdout);
+        flux_future_reset (f);
+        if (cancel) {
+            flux_future_t *f2;
+            if (!(f2 = flux_rpc_pack (h,
+                                      "mrpc.cancel",
+                                      0,
+                                      FLUX_RPC_NORESPONSE,
+                                      "{s:i}",
+                                      "matchtag",
+                                      (int)flux_rpc_get_matchtag (f))))
+                log_err_exit ("mrpc.cancel");
+            flux_future_destroy (f2);
+            cancel = false;
+        }
+    }
+    flux_future_destroy (f);
+    free (inbuf);
+    flux_close (h);
+    return errors > 0 ? 1 : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
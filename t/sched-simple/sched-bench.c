@@ -0,0 +1,547 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sched-bench - simulate sched-simple on a synthetic or recorded workload
+ *
+ * Jobs are queued and allocated from a struct rlist by the queue and
+ * scheduling pass of sched-simple (see src/modules/sched-simple/jobq.h),
+ * in priority order, optionally with backfill and a per-pass job limit.
+ * Time is simulated: the clock jumps to the next job submission or
+ * completion, so a workload spanning days runs in the time it takes
+ * to run the scheduling passes and rlist_free() calls, which is what is
+ * measured for allocations/sec.
+ *
+ * A recorded workload is read from a file with one JSON object per line:
+ *   {"t_submit":f, "runtime":f, "priority":i, "jobspec":o}
+ * where "runtime" defaults to the jobspec duration, and "priority"
+ * defaults to 16.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <math.h>
+#include <jansson.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/librlist/rlist.h"
+#include "src/modules/sched-simple/libjj.h"
+#include "src/modules/sched-simple/jobq.h"
+
+struct simjob {
+    int id;
+    double t_submit;
+    double runtime;
+    unsigned int priority;
+    struct jj_counts counts;
+
+    bool started;
+    double t_start;
+    double t_end;
+    struct rlist *alloc;
+};
+
+struct sim {
+    struct rlist *rl;
+    const char *mode;
+    struct jobq *q;
+
+    struct simjob *jobs;
+    int njobs;
+
+    struct simjob **running;    /* min-heap ordered by t_end */
+    int nrunning;
+
+    double now;
+    int nalloc;                 /* successful allocations */
+    int nreject;                /* jobs that can never fit */
+    int npass;                  /* scheduling passes */
+    int nbudget;                /* passes that ran out of budget */
+    double alloc_ms;            /* wall clock time in passes and frees */
+    double core_seconds;        /* sum of ncores * runtime */
+};
+
+static const char *usage_msg = "[OPTIONS]";
+static struct optparse_option opts[] = {
+    { .name = "nodes", .key = 'N', .has_arg = 1, .arginfo = "N",
+      .usage = "Simulate N nodes (default 16)",
+    },
+    { .name = "cores", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Simulate N cores per node (default 8)",
+    },
+    { .name = "R", .key = 'R', .has_arg = 1, .arginfo = "FILE",
+      .usage = "Read resources from R in FILE instead of --nodes/--cores",
+    },
+    { .name = "jobs", .key = 'j', .has_arg = 1, .arginfo = "N",
+      .usage = "Generate N synthetic jobs (default 1000)",
+    },
+    { .name = "max-slots", .key = 's', .has_arg = 1, .arginfo = "N",
+      .usage = "Synthetic jobs request 1-N cores (default 4)",
+    },
+    { .name = "max-runtime", .key = 't', .has_arg = 1, .arginfo = "SEC",
+      .usage = "Synthetic jobs run 1-SEC seconds (default 100)",
+    },
+    { .name = "interval", .key = 'i', .has_arg = 1, .arginfo = "SEC",
+      .usage = "Mean time between synthetic job submissions (default 1)",
+    },
+    { .name = "seed", .key = 'S', .has_arg = 1, .arginfo = "N",
+      .usage = "Seed for the synthetic workload (default 1)",
+    },
+    { .name = "workload", .key = 'w', .has_arg = 1, .arginfo = "FILE",
+      .usage = "Read a recorded workload from FILE instead",
+    },
+    { .name = "priorities", .key = 'p', .has_arg = 1, .arginfo = "N",
+      .usage = "Synthetic jobs get one of N priorities (default 1)",
+    },
+    { .name = "mode", .key = 'm', .has_arg = 1, .arginfo = "MODE",
+      .usage = "Allocation mode: worst-fit, best-fit, first-fit",
+    },
+    { .name = "backfill", .key = 'b', .has_arg = 0,
+      .usage = "Backfill around a reservation for the first blocked job",
+    },
+    { .name = "pass-limit", .key = 'l', .has_arg = 1, .arginfo = "N",
+      .usage = "Consider at most N jobs per scheduling pass (default 0,"
+               " no limit)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static void heap_swap (struct sim *sim, int i, int j)
+{
+    struct simjob *tmp = sim->running[i];
+    sim->running[i] = sim->running[j];
+    sim->running[j] = tmp;
+}
+
+static void heap_push (struct sim *sim, struct simjob *job)
+{
+    int i = sim->nrunning++;
+
+    sim->running[i] = job;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (sim->running[parent]->t_end <= sim->running[i]->t_end)
+            break;
+        heap_swap (sim, i, parent);
+        i = parent;
+    }
+}
+
+static struct simjob *heap_pop (struct sim *sim)
+{
+    struct simjob *top = sim->running[0];
+    int i = 0;
+
+    sim->running[0] = sim->running[--sim->nrunning];
+    for (;;) {
+        int l = 2 * i + 1;
+        int r = l + 1;
+        int min = i;
+        if (l < sim->nrunning
+            && sim->running[l]->t_end < sim->running[min]->t_end)
+            min = l;
+        if (r < sim->nrunning
+            && sim->running[r]->t_end < sim->running[min]->t_end)
+            min = r;
+        if (min == i)
+            break;
+        heap_swap (sim, i, min);
+        i = min;
+    }
+    return top;
+}
+
+static struct rlist *resources_create (optparse_t *p)
+{
+    struct rlist *rl;
+    const char *path;
+
+    if ((path = optparse_get_str (p, "R", NULL))) {
+        FILE *fp;
+        json_t *o;
+        json_error_t error;
+
+        if (!(fp = fopen (path, "r")))
+            log_err_exit ("%s", path);
+        if (!(o = json_loadf (fp, 0, &error)))
+            log_msg_exit ("%s:%d: %s", path, error.line, error.text);
+        fclose (fp);
+        if (!(rl = rlist_from_json (o, &error)))
+            log_msg_exit ("%s: %s", path, error.text);
+        json_decref (o);
+    }
+    else {
+        int nodes = optparse_get_int (p, "nodes", 16);
+        int cores = optparse_get_int (p, "cores", 8);
+        char ids[32];
+        char host[64];
+        int i;
+
+        if (nodes < 1 || cores < 1)
+            log_msg_exit ("--nodes and --cores must be at least 1");
+        if (cores > 1)
+            snprintf (ids, sizeof (ids), "0-%d", cores - 1);
+        else
+            snprintf (ids, sizeof (ids), "0");
+        if (!(rl = rlist_create ()))
+            log_err_exit ("rlist_create");
+        for (i = 0; i < nodes; i++) {
+            snprintf (host, sizeof (host), "node%d", i);
+            if (rlist_append_rank_cores (rl, host, i, ids) < 0)
+                log_err_exit ("rlist_append_rank_cores");
+        }
+    }
+    return rl;
+}
+
+static void workload_generate (struct sim *sim, optparse_t *p)
+{
+    int njobs = optparse_get_int (p, "jobs", 1000);
+    int max_slots = optparse_get_int (p, "max-slots", 4);
+    double max_runtime = optparse_get_double (p, "max-runtime", 100.);
+    double interval = optparse_get_double (p, "interval", 1.);
+    int npriorities = optparse_get_int (p, "priorities", 1);
+    double t = 0.;
+    int i;
+
+    if (njobs < 1 || max_slots < 1 || max_runtime < 1. || interval < 0.
+        || npriorities < 1)
+        log_msg_exit ("invalid synthetic workload parameters");
+    srand (optparse_get_int (p, "seed", 1));
+    if (!(sim->jobs = calloc (njobs, sizeof (sim->jobs[0]))))
+        log_err_exit ("calloc");
+    for (i = 0; i < njobs; i++) {
+        struct simjob *job = &sim->jobs[i];
+        double u = (rand () + 1.) / (RAND_MAX + 2.);
+
+        /* Exponentially distributed interarrival times (Poisson arrivals).
+         */
+        t += -interval * log (u);
+        job->id = i;
+        job->t_submit = t;
+        job->runtime = 1. + (max_runtime - 1.) * rand () / RAND_MAX;
+        job->priority = npriorities > 1 ? rand () % npriorities
+                                        : FLUX_JOB_URGENCY_DEFAULT;
+        job->counts.nnodes = 0;
+        job->counts.nslots = 1 + rand () % max_slots;
+        job->counts.slot_size = 1;
+        job->counts.duration = job->runtime;
+    }
+    sim->njobs = njobs;
+}
+
+static int simjob_cmp (const void *a, const void *b)
+{
+    const struct simjob *j1 = a;
+    const struct simjob *j2 = b;
+
+    if (j1->t_submit != j2->t_submit)
+        return j1->t_submit < j2->t_submit ? -1 : 1;
+    return j1->id - j2->id;
+}
+
+static void workload_read (struct sim *sim, const char *path)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t size = 0;
+    int lineno = 0;
+    int alloc = 0;
+
+    if (!(fp = fopen (path, "r")))
+        log_err_exit ("%s", path);
+    while (getline (&line, &size, fp) > 0) {
+        struct simjob *job;
+        json_t *o;
+        json_t *jobspec;
+        json_error_t error;
+        double runtime = -1.;
+        int priority = FLUX_JOB_URGENCY_DEFAULT;
+
+        lineno++;
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        if (sim->njobs == alloc) {
+            alloc = alloc ? alloc * 2 : 1024;
+            if (!(sim->jobs = realloc (sim->jobs, alloc * sizeof (*job))))
+                log_err_exit ("realloc");
+        }
+        job = &sim->jobs[sim->njobs];
+        memset (job, 0, sizeof (*job));
+        if (!(o = json_loads (line, 0, &error)))
+            log_msg_exit ("%s:%d: %s", path, lineno, error.text);
+        if (json_unpack_ex (o, &error, 0, "{s:F s?:F s?:i s:o}",
+                            "t_submit", &job->t_submit,
+                            "runtime", &runtime,
+                            "priority", &priority,
+                            "jobspec", &jobspec) < 0)
+            log_msg_exit ("%s:%d: %s", path, lineno, error.text);
+        if (priority < FLUX_JOB_PRIORITY_MIN)
+            log_msg_exit ("%s:%d: invalid priority", path, lineno);
+        job->priority = priority;
+        if (libjj_get_counts_json (jobspec, &job->counts) < 0)
+            log_msg_exit ("%s:%d: %s", path, lineno, job->counts.error);
+        json_decref (o);
+        job->runtime = runtime >= 0. ? runtime : job->counts.duration;
+        if (job->runtime <= 0.)
+            log_msg_exit ("%s:%d: no runtime or duration", path, lineno);
+        job->id = sim->njobs++;
+    }
+    free (line);
+    fclose (fp);
+    if (sim->njobs == 0)
+        log_msg_exit ("%s: no jobs", path);
+    qsort (sim->jobs, sim->njobs, sizeof (sim->jobs[0]), simjob_cmp);
+}
+
+static void sim_free (struct sim *sim, struct simjob *job)
+{
+    struct timespec t0;
+
+    monotime (&t0);
+    if (rlist_free (sim->rl, job->alloc) < 0)
+        log_err_exit ("rlist_free job %d", job->id);
+    jobq_run_remove (sim->q, job->id + 1);
+    sim->alloc_ms += monotime_since (t0);
+    rlist_destroy (job->alloc);
+    job->alloc = NULL;
+}
+
+/* jobq callback: start 'req' with allocation 'alloc'.
+ */
+static void sim_alloc_cb (struct jobreq *req, struct rlist *alloc, void *arg)
+{
+    struct sim *sim = arg;
+    struct simjob *job = &sim->jobs[req->id - 1];
+
+    if (jobq_backfill (sim->q)) {
+        struct rlist *cpy;
+        if (!(cpy = rlist_copy (alloc))
+            || jobq_run_add (sim->q, req->id, cpy) < 0)
+            log_err_exit ("jobq_run_add job %d", job->id);
+    }
+    job->alloc = alloc;
+    job->started = true;
+    job->t_start = sim->now;
+    job->t_end = sim->now + job->runtime;
+    sim->core_seconds += job->runtime * rlist_count (alloc, "core");
+    sim->nalloc++;
+    heap_push (sim, job);
+}
+
+/* jobq callback: 'req' can never be allocated.
+ */
+static void sim_deny_cb (struct jobreq *req, const char *note, void *arg)
+{
+    struct sim *sim = arg;
+
+    sim->nreject++;
+}
+
+static const struct jobq_ops sim_ops = {
+    .alloc = sim_alloc_cb,
+    .deny = sim_deny_cb,
+};
+
+/* Queue 'job' upon its submission.  Job IDs are offset by one, since
+ * jobq uses 0 to mean no job.
+ */
+static void sim_submit (struct sim *sim, struct simjob *job)
+{
+    struct jobreq *req;
+
+    if (!(req = calloc (1, sizeof (*req))))
+        log_err_exit ("calloc");
+    req->id = job->id + 1;
+    req->priority = job->priority;
+    req->t_submit = job->t_submit;
+    req->jj = job->counts;
+    req->jobs_ahead = -1;
+    if (jobq_enqueue (sim->q, req) < 0)
+        log_err_exit ("jobq_enqueue job %d", job->id);
+}
+
+/* Run scheduling passes until one completes within its budget, as
+ * sched-simple does over successive reactor loop iterations.
+ */
+static void sim_schedule (struct sim *sim)
+{
+    struct timespec t0;
+    bool budget;
+
+    do {
+        monotime (&t0);
+        budget = jobq_schedule (sim->q, sim->rl, sim->now, NULL);
+        sim->alloc_ms += monotime_since (t0);
+        sim->npass++;
+        if (budget)
+            sim->nbudget++;
+    } while (budget);
+}
+
+static void sim_run (struct sim *sim)
+{
+    int arrived = 0;
+
+    if (!(sim->running = calloc (sim->njobs, sizeof (sim->running[0]))))
+        log_err_exit ("calloc");
+    while (arrived < sim->njobs || sim->nrunning > 0) {
+        double next = INFINITY;
+
+        if (arrived < sim->njobs)
+            next = sim->jobs[arrived].t_submit;
+        if (sim->nrunning > 0 && sim->running[0]->t_end < next)
+            next = sim->running[0]->t_end;
+        /* Stop at the last finite event, so the makespan is capped at
+         * the end of the simulation, e.g. if a job has no time limit.
+         */
+        if (isinf (next))
+            break;
+        sim->now = next;
+
+        while (sim->nrunning > 0 && sim->running[0]->t_end <= sim->now)
+            sim_free (sim, heap_pop (sim));
+        while (arrived < sim->njobs
+               && sim->jobs[arrived].t_submit <= sim->now)
+            sim_submit (sim, &sim->jobs[arrived++]);
+        sim_schedule (sim);
+    }
+}
+
+static int double_cmp (const void *a, const void *b)
+{
+    double d1 = *(const double *)a;
+    double d2 = *(const double *)b;
+
+    return d1 < d2 ? -1 : d1 > d2 ? 1 : 0;
+}
+
+static double percentile (double *v, int n, double pct)
+{
+    int i = (int)ceil (pct / 100. * n) - 1;
+
+    if (i < 0)
+        i = 0;
+    return v[i];
+}
+
+static void sim_report (struct sim *sim)
+{
+    double *wait;
+    double mean = 0.;
+    double t_first = sim->jobs[0].t_submit;
+    double makespan = sim->now - t_first;
+    int ncores = rlist_count (sim->rl, "core");
+    int unstarted = 0;
+    int n = 0;
+    int i;
+
+    if (!(wait = calloc (sim->njobs, sizeof (wait[0]))))
+        log_err_exit ("calloc");
+    for (i = 0; i < sim->njobs; i++) {
+        struct simjob *job = &sim->jobs[i];
+        if (job->started) {
+            wait[n] = job->t_start - job->t_submit;
+            mean += wait[n++];
+        }
+        else
+            unstarted++;
+    }
+    /* Rejected jobs never start.  Others that did not start were still
+     * queued when the simulation ended, and are excluded from the wait
+     * statistics.
+     */
+    unstarted -= sim->nreject;
+    printf ("resources:       %zu nodes, %d cores\n",
+            rlist_nnodes (sim->rl), ncores);
+    printf ("mode:            %s\n", sim->mode ? sim->mode : "worst-fit");
+    printf ("queue:           %s\n",
+            jobq_backfill (sim->q) ? "backfill" : "fcfs");
+    printf ("jobs:            %d (%d rejected, %d not started)\n",
+            sim->njobs, sim->nreject, unstarted);
+    printf ("passes:          %d (%d ran out of budget)\n",
+            sim->npass, sim->nbudget);
+    printf ("alloc time:      %.3fs\n", sim->alloc_ms / 1000.);
+    printf ("allocs/sec:      %.1f\n",
+            sim->alloc_ms > 0. ? sim->nalloc / (sim->alloc_ms / 1000.) : 0.);
+    printf ("makespan:        %.1fs (simulated)\n", makespan);
+    printf ("utilization:     %.1f%%\n",
+            makespan > 0. ? 100. * sim->core_seconds / (ncores * makespan)
+                          : 0.);
+    if (n > 0) {
+        qsort (wait, n, sizeof (wait[0]), double_cmp);
+        printf ("wait mean:       %.1fs\n", mean / n);
+        printf ("wait p50:        %.1fs\n", percentile (wait, n, 50.));
+        printf ("wait p90:        %.1fs\n", percentile (wait, n, 90.));
+        printf ("wait p99:        %.1fs\n", percentile (wait, n, 99.));
+        printf ("wait max:        %.1fs\n", wait[n - 1]);
+    }
+    free (wait);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    struct sim sim;
+    const char *workload;
+    int pass_limit;
+    int i;
+
+    log_init ("sched-bench");
+
+    if (!(p = optparse_create ("sched-bench")))
+        log_msg_exit ("optparse_create");
+    if (optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_add_option_table() failed");
+    if (optparse_set (p, OPTPARSE_USAGE, usage_msg) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_set (USAGE)");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    memset (&sim, 0, sizeof (sim));
+    sim.mode = optparse_get_str (p, "mode", NULL);
+    sim.rl = resources_create (p);
+    if (!(sim.q = jobq_create (&sim_ops,
+                               &sim,
+                               optparse_hasopt (p, "backfill")))
+        || jobq_set_alloc_mode (sim.q, sim.mode) < 0)
+        log_err_exit ("jobq_create");
+    if ((pass_limit = optparse_get_int (p, "pass-limit", 0)) < 0)
+        log_msg_exit ("--pass-limit must be at least 0");
+    jobq_set_pass_limit (sim.q, pass_limit);
+    if ((workload = optparse_get_str (p, "workload", NULL)))
+        workload_read (&sim, workload);
+    else
+        workload_generate (&sim, p);
+
+    sim_run (&sim);
+    sim_report (&sim);
+
+    jobq_destroy (sim.q);
+    for (i = 0; i < sim.njobs; i++)
+        rlist_destroy (sim.jobs[i].alloc);
+    free (sim.jobs);
+    free (sim.running);
+    rlist_destroy (sim.rl);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
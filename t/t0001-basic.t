@@ -71,6 +71,35 @@ test_expect_success 'flux-start in subprocess/pmi mode works (size 1)' "
 test_expect_success 'flux-start in subprocess/pmi mode works (size 2)' "
 	flux start ${ARGS} --size=2 flux getattr size | grep -x 2
 "
+test_expect_success 'tbon.zmq_io_threads defaults to 1' "
+	flux start ${ARGS} flux getattr tbon.zmq_io_threads | grep -x 1
+"
+test_expect_success 'tbon.zmq_io_threads can be set on the command line' "
+	flux start ${ARGS} --size=2 -o,-Stbon.zmq_io_threads=4 \
+		flux getattr tbon.zmq_io_threads | grep -x 4
+"
+test_expect_success 'tbon.zmq_io_threads cannot be changed at runtime' "
+	test_must_fail flux start ${ARGS} \
+		flux setattr tbon.zmq_io_threads 2
+"
+test_expect_success 'broker fails with invalid tbon.zmq_io_threads' "
+	test_must_fail flux start ${ARGS} -o,-Stbon.zmq_io_threads=0 \
+		/bin/true 2>iothreads.err &&
+	grep 'Error parsing tbon.zmq_io_threads attribute' iothreads.err
+"
+test_expect_success 'tbon.compress_threshold defaults to 0' "
+	flux start ${ARGS} flux getattr tbon.compress_threshold | grep -x 0
+"
+test_expect_success 'large messages pass through compressed overlay' '
+	flux start ${ARGS} --size=2 -o,-Stbon.compress_threshold=256 \
+		flux exec -r 1 printf "%08192d" 0 >compress.out &&
+	test $(wc -c <compress.out) -eq 8192
+'
+test_expect_success 'broker fails with invalid tbon.compress_threshold' "
+	test_must_fail flux start ${ARGS} -o,-Stbon.compress_threshold=-1 \
+		/bin/true 2>compress.err &&
+	grep 'Error parsing tbon.compress_threshold attribute' compress.err
+"
 test_expect_success 'flux-start with size 1 has no peers' '
 	flux start ${ARGS} --size=1 \
 		flux python -c "import flux; print(flux.Flux().rpc(\"overlay.lspeer\").get())" >idle.out &&
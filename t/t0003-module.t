@@ -40,6 +40,32 @@ test_expect_success 'module: lsmod does not show test module' '
 	! flux module list | grep parent
 '
 
+test_expect_success 'module: load test module with --hwm' '
+	flux module load --hwm=100 --hwm-policy=drop \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so
+'
+
+test_expect_success 'module: lsmod shows Queue column' '
+	flux module list >queue.out &&
+	head -1 queue.out | grep Queue &&
+	grep parent queue.out
+'
+
+test_expect_success 'module: unload test module loaded with --hwm' '
+	flux module remove parent
+'
+
+test_expect_success 'module: load fails with invalid --hwm-policy' '
+	test_must_fail flux module load --hwm=100 --hwm-policy=block \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so
+'
+
+test_expect_success 'module: load fails with negative --hwm' '
+	test_must_fail flux module load --hwm=-1 \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so 2>hwm.err &&
+	grep "must be >= 0" hwm.err
+'
+
 test_expect_success 'module API: load test module' '
 	flux module load \
 		${FLUX_BUILD_DIR}/t/module/.libs/parent.so
@@ -111,6 +137,14 @@ test_expect_success "module: there are size=$SIZE lines of output due to unique
 	test $(wc -l < child.lsmod.out) -eq $SIZE
 '
 
+# etc/rc1 looks up the scheduler module by its service name in field 7
+test_expect_success 'module: lsmod Service column is field 7' '
+	flux module list parent >fields.out &&
+	test "$(head -1 fields.out | awk "{ print \$7 }")" = "Service" &&
+	test "$(awk "\$7 == \"rank0,test1,test2\" { print \$1 }" fields.out)" \
+		= "parent.child"
+'
+
 test_expect_success 'module: unload submodule (all ranks)' '
 	flux exec -r all flux module remove parent.child
 '
@@ -188,7 +222,8 @@ test_expect_success 'flux module stats gets comms statistics' '
 	grep -q "#event (tx)" comms.stats &&
 	grep -q "#event (rx)" comms.stats &&
 	grep -q "#keepalive (tx)" comms.stats &&
-	grep -q "#keepalive (rx)" comms.stats
+	grep -q "#keepalive (rx)" comms.stats &&
+	grep -q "#matchtag (outstanding)" comms.stats
 '
 
 test_expect_success 'flux module stats --parse "#event (tx)" counts events' '
@@ -0,0 +1,58 @@
+#!/bin/sh
+
+test_description='Test message microbenchmarks'
+
+. `dirname $0`/sharness.sh
+
+bench=${FLUX_BUILD_DIR}/t/request/msg-bench
+mcast=${FLUX_BUILD_DIR}/t/request/mcast-bench
+tagpool=${FLUX_BUILD_DIR}/src/common/libflux/test_tagpool.t
+
+test_expect_success 'msg-bench: all phases run' '
+	$bench --count=1000 >bench.out &&
+	test_debug "cat bench.out" &&
+	grep "^create: .* msgs/sec" bench.out &&
+	grep "^encode: .* msgs/sec" bench.out &&
+	grep "^decode: .* msgs/sec" bench.out &&
+	grep "^copy: .* msgs/sec" bench.out &&
+	grep "^dispatch: .* msgs/sec" bench.out
+'
+test_expect_success 'msg-bench: works with no payload or routes' '
+	$bench --count=100 --size=0 --hops=0 >empty.out &&
+	grep "^payload: *0 bytes" empty.out &&
+	grep "^hops: *0" empty.out
+'
+test_expect_success 'msg-bench: works with large payload' '
+	$bench --count=10 --size=1048576 >large.out &&
+	grep "^payload: *1048576 bytes" large.out
+'
+test_expect_success 'msg-bench: invalid count fails' '
+	test_must_fail $bench --count=0
+'
+test_expect_success 'mcast-bench: both methods run at each fanout' '
+	$mcast --count=500 --fanout=1,4,32 >mcast.out &&
+	test_debug "cat mcast.out" &&
+	for n in 1 4 32; do
+		grep "^fanout=$n copy: .* events/sec" mcast.out &&
+		grep "^fanout=$n route: .* events/sec" mcast.out || return 1
+	done
+'
+test_expect_success 'mcast-bench: works with no payload' '
+	$mcast --count=10 --size=0 --fanout=2 >mcast-empty.out &&
+	grep "^payload: 0 bytes" mcast-empty.out
+'
+test_expect_success 'mcast-bench: invalid fanout fails' '
+	test_must_fail $mcast --count=10 --fanout=0 &&
+	test_must_fail $mcast --count=10 --fanout=foo
+'
+test_expect_success 'tagpool bench: runs at each window size' '
+	$tagpool --bench 10000 >tagpool.out 2>&1 &&
+	test_debug "cat tagpool.out" &&
+	for n in 1 1000 100000; do
+		grep "window=$n: .* ns per alloc/free pair" tagpool.out || return 1
+	done
+'
+test_expect_success 'tagpool bench: invalid iteration count fails' '
+	test_must_fail $tagpool --bench 0
+'
+test_done
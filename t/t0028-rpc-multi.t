@@ -0,0 +1,87 @@
+#!/bin/sh
+
+test_description='Test multi-rank RPC via broker mrpc service'
+
+. `dirname $0`/sharness.sh
+
+test_under_flux 4
+
+MRPC=${FLUX_BUILD_DIR}/t/request/rpc_multi
+
+test_expect_success 'rpc_multi to all ranks gets one response per rank' '
+	echo "{\"name\":\"rank\"}" | $MRPC attr.get all >all.out &&
+	test_debug "cat all.out" &&
+	sort -n all.out | sed -e "s/ {.*\"value\":\"\([0-9]*\)\".*/ \1/" >all.sorted &&
+	cat >all.exp <<-EOT &&
+	0: 0
+	1: 1
+	2: 2
+	3: 3
+	EOT
+	test_cmp all.exp all.sorted
+'
+test_expect_success 'rpc_multi to a subset of ranks' '
+	echo "{\"name\":\"rank\"}" | $MRPC attr.get 1,3 >subset.out &&
+	test_debug "cat subset.out" &&
+	test $(wc -l <subset.out) -eq 2 &&
+	grep "^1: " subset.out &&
+	grep "^3: " subset.out
+'
+test_expect_success 'rpc_multi to a single leaf rank' '
+	echo "{\"name\":\"rank\"}" | $MRPC attr.get 3 >leaf.out &&
+	test $(wc -l <leaf.out) -eq 1 &&
+	grep "^3: " leaf.out
+'
+test_expect_success 'rpc_multi reports per-rank errors' '
+	echo "{\"name\":\"nonexistent\"}" \
+		| test_must_fail $MRPC attr.get all >err.out &&
+	test_debug "cat err.out" &&
+	test $(wc -l <err.out) -eq 4 &&
+	test $(grep -c "No such file or directory" err.out) -eq 4
+'
+test_expect_success 'rpc_multi to unknown service fails on each rank' '
+	echo "{}" | test_must_fail $MRPC nosuchservice.foo 0-3 >nosys.out &&
+	test $(grep -c "Function not implemented" nosys.out) -eq 4
+'
+test_expect_success 'rpc_multi with out of range rank fails' '
+	echo "{}" | test_must_fail $MRPC attr.get 0-7
+'
+test_expect_success 'rpc_multi with invalid rank set fails' '
+	echo "{}" | test_must_fail $MRPC attr.get foo
+'
+test_expect_success 'rpc_multi results from a grandchild subtree are relayed' '
+	echo "{\"name\":\"rank\"}" | $MRPC attr.get 1-3 >deep.out &&
+	test $(wc -l <deep.out) -eq 3 &&
+	grep "^3: " deep.out
+'
+test_expect_success 'rpc_multi can be canceled after the first response' '
+	echo "{\"name\":\"rank\"}" | $MRPC --cancel attr.get all >cancel.out &&
+	test_debug "cat cancel.out" &&
+	test $(wc -l <cancel.out) -ge 1 &&
+	test $(wc -l <cancel.out) -le 4
+'
+test_expect_success 'mrpc service is still functional after cancel' '
+	echo "{\"name\":\"rank\"}" | $MRPC attr.get all >after.out &&
+	test $(wc -l <after.out) -eq 4
+'
+# kvs.sync with a future rootseq stalls until the broker is killed.
+test_expect_success 'create script that kills rank 1 during rpc_multi' '
+	cat >killchild.sh <<-EOT &&
+	#!/bin/sh
+	pid=\$(flux exec -r 1 flux getattr broker.pid)
+	echo "{\\"rootseq\\":1000000,\\"namespace\\":\\"primary\\"}" \\
+		| $MRPC kvs.sync 1 >killchild.out &
+	sleep 1
+	kill -9 \$pid
+	wait
+	EOT
+	chmod +x killchild.sh
+'
+test_expect_success 'rpc_multi fails ranks of a killed child broker' '
+	test_might_fail run_timeout 60 flux start -s2 --killer-timeout=0.2 \
+		./killchild.sh &&
+	test_debug "cat killchild.out" &&
+	egrep "^1: (lost connection to broker rank 1|No route to host)" \
+		killchild.out
+'
+test_done
@@ -256,6 +256,21 @@ test_expect_success HAVE_JQ 'flux job list only completed jobs' '
         test_cmp completed.ids list_result_completed.out
 '
 
+test_expect_success HAVE_JQ 'flux job list canceled and failed jobs of all users in completed order' '
+        state=`${JOB_CONV} strtostate INACTIVE` &&
+        canceled=`${JOB_CONV} strtoresult CANCELED` &&
+        failed=`${JOB_CONV} strtoresult FAILED` &&
+        $jq -j -c -n  "{max_entries:1000, userid:4294967295, states:${state}, results:$((canceled|failed)), attrs:[]}" \
+          | $RPC job-info.list | $jq .jobs | $jq -c '.[]' | $jq .id > list_result_canceled_failed.out &&
+        cat canceled.ids failed.ids > list_result_canceled_failed.exp &&
+        test_cmp list_result_canceled_failed.exp list_result_canceled_failed.out
+'
+
+test_expect_success HAVE_JQ 'flux job list returns no jobs for unknown userid' '
+        $jq -j -c -n  "{max_entries:1000, userid:4242, states:0, results:0, attrs:[]}" \
+          | $RPC job-info.list | $jq -e ".jobs == []"
+'
+
 # Note: "pending" = "depend" | "sched", we also test just "sched"
 # state since we happen to know all these jobs are in the "sched"
 # state given checks above
@@ -359,6 +374,56 @@ test_expect_success 'flux job list --user=all works' '
         test $count = $(state_count active)
 '
 
+test_expect_success HAVE_JQ 'streaming job-info.list returns all jobs in pages' '
+        flux job list -s active,inactive | jq .id > list_all_ids.exp &&
+        flux python ${FLUX_SOURCE_DIR}/t/job-info/list-stream.py 5 \
+            > list_stream.out 2> list_stream.err &&
+        test_cmp list_all_ids.exp list_stream.out &&
+        count=$(wc -l < list_stream.out) &&
+        test "$(cat list_stream.err)" = "pages=$(((count+4)/5))"
+'
+
+test_expect_success HAVE_JQ 'canceled streaming job-info.list sends no more pages' '
+        count=$(wc -l < list_all_ids.exp) &&
+        flux python ${FLUX_SOURCE_DIR}/t/job-info/list-stream.py 1 0 0 \
+            > list_cancel0.out 2> list_cancel0.err &&
+        pages=$(sed -n "s/^pages=//p" list_cancel0.err) &&
+        test_debug "echo got $pages of $count pages" &&
+        test $pages -lt $count &&
+        head -n $pages list_all_ids.exp > list_cancel0.exp &&
+        test_cmp list_cancel0.exp list_cancel0.out
+'
+
+test_expect_success HAVE_JQ 'streaming job-info.list can be canceled mid-way' '
+        flux python ${FLUX_SOURCE_DIR}/t/job-info/list-stream.py 1 0 1 \
+            > list_cancel1.out 2> list_cancel1.err &&
+        count=$(wc -l < list_all_ids.exp) &&
+        pages=$(sed -n "s/^pages=//p" list_cancel1.err) &&
+        test_debug "echo got $pages of $count pages" &&
+        test $pages -ge 1 && test $pages -lt $count &&
+        head -n $pages list_all_ids.exp > list_cancel1.exp &&
+        test_cmp list_cancel1.exp list_cancel1.out
+'
+
+test_expect_success HAVE_JQ 'job-info.list resumes from cursor' '
+        id=$(id -u) &&
+        $jq -j -c -n  "{max_entries:7, userid:${id}, states:0, results:0, attrs:[]}" \
+          | $RPC job-info.list > list_page1.json &&
+        cursor=$($jq -c .cursor < list_page1.json) &&
+        $jq -j -c -n  "{max_entries:0, userid:${id}, states:0, results:0, attrs:[], cursor:${cursor}}" \
+          | $RPC job-info.list > list_page2.json &&
+        $jq .jobs[].id list_page1.json > list_pages.out &&
+        $jq .jobs[].id list_page2.json >> list_pages.out &&
+        test_cmp list_all_ids.exp list_pages.out
+'
+
+test_expect_success 'job-info.list fails with malformed cursor' '
+        id=$(id -u) &&
+        $jq -j -c -n  "{max_entries:0, userid:${id}, states:0, results:0, attrs:[], cursor:{state:3}}" \
+          | $listRPC > list_bad_cursor.out &&
+        grep "errno 71" list_bad_cursor.out
+'
+
 # we hard count numbers here b/c its a --count test
 test_expect_success HAVE_JQ 'flux job list --count works' '
         flux job list -s active,inactive --count=12 | jq .id > list_count.out &&
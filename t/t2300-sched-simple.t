@@ -263,6 +263,114 @@ test_expect_success 'sched-simple: there are no outstanding sched requests' '
 	grep "0 free requests pending to scheduler" queue_status.out
 '
 
+test_expect_success 'sched-simple: load sched-simple with backfill' '
+	flux module load sched-simple mode=unlimited backfill pass-limit=16
+'
+test_expect_success 'sched-simple: running job with time limit' '
+	flux mini submit -n1 -t 100 hostname >bf1.id &&
+	flux job wait-event --timeout=5.0 $(cat bf1.id) alloc
+'
+test_expect_success 'sched-simple: short job is backfilled around blocked job' '
+	flux mini submit -n4 hostname >bf2.id &&
+	flux mini submit -n1 -t 10 hostname >bf3.id &&
+	flux mini submit -n1 hostname >bf4.id &&
+	flux job wait-event --timeout=5.0 $(cat bf3.id) alloc
+'
+test_expect_success 'sched-simple: blocked job and unlimited job remain pending' '
+	test_must_fail flux job wait-event --timeout=0.5 $(cat bf2.id) alloc &&
+	test_must_fail flux job wait-event --timeout=0.5 $(cat bf4.id) alloc
+'
+test_expect_success 'sched-simple: blocked job runs when resources are freed' '
+	flux job cancel $(cat bf1.id) &&
+	flux job cancel $(cat bf3.id) &&
+	flux job wait-event --timeout=5.0 $(cat bf2.id) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
+test_expect_success 'sched-simple: load sched-simple with backfill pass-limit=2' '
+	flux module load sched-simple mode=unlimited backfill pass-limit=2
+'
+test_expect_success 'sched-simple: backfill scan continues past pass-limit' '
+	flux mini submit -n1 -t 100 hostname >bf5.id &&
+	flux job wait-event --timeout=5.0 $(cat bf5.id) alloc &&
+	flux mini submit -n4 hostname >bf6.id &&
+	flux mini submit --cc=1-4 -n1 hostname >bf7.ids &&
+	flux mini submit -n1 -t 10 hostname >bf8.id &&
+	flux job wait-event --timeout=5.0 $(cat bf8.id) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
+
+test_expect_success 'sched-simple: load sched-simple with batch' '
+	flux module load sched-simple mode=unlimited batch &&
+	flux dmesg | grep "scheduler: ready unlimited batch"
+'
+test_expect_success 'sched-simple: batched jobs are allocated' '
+	flux mini submit --cc=1-4 -n1 hostname >batch.ids &&
+	for id in $(cat batch.ids); do
+		flux job wait-event --timeout=5.0 $id alloc || return 1
+	done
+'
+test_expect_success 'sched-simple: batched jobs are freed' '
+	for id in $(cat batch.ids); do
+		flux job cancel $id || return 1
+	done &&
+	for id in $(cat batch.ids); do
+		flux job wait-event --timeout=5.0 $id free || return 1
+	done
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
+
+test_expect_success 'sched-simple: load sched-simple with workers' '
+	flux module load sched-simple mode=unlimited workers=2 &&
+	run_timeout 30 flux queue drain
+'
+test_expect_success 'sched-simple: jobs are allocated with workers' '
+	flux mini submit --cc=1-4 -n1 hostname >workers.ids &&
+	for id in $(cat workers.ids); do
+		flux job wait-event --timeout=5.0 $id alloc || return 1
+	done
+'
+test_expect_success 'sched-simple: unsatisfiable job is denied with workers' '
+	flux mini submit -n 9 hostname >workers.bad &&
+	flux job wait-event --timeout=5.0 $(cat workers.bad) exception
+'
+test_expect_success 'sched-simple: pending job is allocated after free' '
+	flux mini submit -n1 hostname >workers.pending &&
+	test_must_fail flux job wait-event --timeout=0.5 \
+		$(cat workers.pending) alloc &&
+	flux job cancel $(head -1 workers.ids) &&
+	flux job wait-event --timeout=5.0 $(cat workers.pending) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
+test_expect_success 'sched-simple: workers=-1 is rejected' '
+	test_must_fail flux module load sched-simple workers=-1
+'
+
+test_expect_success 'sched-simple: reload with allocated job uses snapshot' '
+	flux module load sched-simple &&
+	run_timeout 30 flux queue drain &&
+	flux mini submit -n1 hostname >snap.id &&
+	flux job wait-event --timeout=5.0 $(cat snap.id) alloc &&
+	flux module reload sched-simple &&
+	$dmesg_grep -t 10 "scheduler: snapshot \(1 jobs" &&
+	test "$(flux resource list --state=free -no {ncores})" = "3"
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
+
 test_expect_success 'sched-simple: load sched-simple and wait for queue drain' '
 	flux module load sched-simple &&
 	run_timeout 30 flux queue drain
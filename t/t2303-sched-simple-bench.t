@@ -0,0 +1,118 @@
+#!/bin/sh
+
+test_description='Test sched-simple simulation benchmark'
+
+. `dirname $0`/sharness.sh
+
+bench=${FLUX_BUILD_DIR}/t/sched-simple/sched-bench
+
+test_expect_success 'sched-bench: synthetic workload runs all jobs' '
+	$bench --nodes=4 --cores=4 --jobs=100 >synthetic.out &&
+	test_debug "cat synthetic.out" &&
+	grep "^jobs: *100 (0 rejected, 0 not started)" synthetic.out &&
+	grep "^queue: *fcfs" synthetic.out &&
+	grep "^allocs/sec:" synthetic.out &&
+	grep "^wait p99:" synthetic.out
+'
+test_expect_success 'sched-bench: simulated results depend only on seed' '
+	$bench --jobs=100 --seed=42 | grep -v "^alloc" >seed1.out &&
+	$bench --jobs=100 --seed=42 | grep -v "^alloc" >seed2.out &&
+	test_cmp seed1.out seed2.out
+'
+test_expect_success 'sched-bench: all allocation modes work' '
+	for mode in worst-fit best-fit first-fit; do
+		$bench --jobs=100 --mode=$mode >mode.out &&
+		grep "^mode: *$mode" mode.out || return 1
+	done
+'
+test_expect_success 'sched-bench: resources can be read from R' '
+	flux R encode -r0-1 -c0-3 >R.json &&
+	$bench --R=R.json --jobs=10 >R.out &&
+	grep "^resources: *2 nodes, 8 cores" R.out
+'
+test_expect_success 'sched-bench: recorded workload gets expected schedule' '
+	spec=$(flux jobspec srun -n2 hostname) &&
+	for t in 0 1 2 3; do
+		echo "{\"t_submit\":$t,\"runtime\":10,\"jobspec\":$spec}" \
+			|| return 1
+	done >workload.json &&
+	$bench --nodes=1 --cores=4 --workload=workload.json >recorded.out &&
+	test_debug "cat recorded.out" &&
+	grep "^jobs: *4 (0 rejected, 0 not started)" recorded.out &&
+	grep "^makespan: *21.0s" recorded.out &&
+	grep "^wait max: *8.0s" recorded.out
+'
+test_expect_success 'sched-bench: job that can never fit is rejected' '
+	spec=$(flux jobspec srun -n8 hostname) &&
+	echo "{\"t_submit\":0,\"runtime\":10,\"jobspec\":$spec}" \
+		>>workload.json &&
+	$bench --nodes=1 --cores=4 --workload=workload.json >reject.out &&
+	grep "^jobs: *5 (1 rejected, 0 not started)" reject.out
+'
+test_expect_success 'sched-bench: recorded workload without runtime fails' '
+	spec=$(flux jobspec srun -n1 hostname) &&
+	echo "{\"t_submit\":0,\"jobspec\":$spec}" >noruntime.json &&
+	test_must_fail $bench --workload=noruntime.json
+'
+test_expect_success 'sched-bench: queue is ordered by priority' '
+	spec=$(flux jobspec srun -n4 hostname) &&
+	cat >priority.json <<-EOF &&
+	{"t_submit":0,"runtime":10,"priority":16,"jobspec":$spec}
+	{"t_submit":1,"runtime":10,"priority":10,"jobspec":$spec}
+	{"t_submit":2,"runtime":10,"priority":20,"jobspec":$spec}
+	EOF
+	$bench --nodes=1 --cores=4 --workload=priority.json >priority.out &&
+	test_debug "cat priority.out" &&
+	grep "^makespan: *30.0s" priority.out &&
+	grep "^wait max: *19.0s" priority.out
+'
+test_expect_success 'sched-bench: create workload where backfill helps' '
+	spec1=$(flux jobspec srun -n2 -t 0:10 hostname) &&
+	spec2=$(flux jobspec srun -n4 -t 0:10 hostname) &&
+	spec3=$(flux jobspec srun -n2 -t 0:05 hostname) &&
+	cat >backfill.json <<-EOF
+	{"t_submit":0,"runtime":10,"jobspec":$spec1}
+	{"t_submit":1,"runtime":10,"jobspec":$spec2}
+	{"t_submit":2,"runtime":5,"jobspec":$spec3}
+	EOF
+'
+test_expect_success 'sched-bench: fcfs queue does not start jobs out of order' '
+	$bench --nodes=1 --cores=4 --workload=backfill.json >fcfs.out &&
+	test_debug "cat fcfs.out" &&
+	grep "^makespan: *25.0s" fcfs.out &&
+	grep "^wait max: *18.0s" fcfs.out
+'
+test_expect_success 'sched-bench: --backfill starts short job ahead of reservation' '
+	$bench --nodes=1 --cores=4 --workload=backfill.json --backfill \
+		>backfill.out &&
+	test_debug "cat backfill.out" &&
+	grep "^queue: *backfill" backfill.out &&
+	grep "^makespan: *20.0s" backfill.out &&
+	grep "^wait max: *9.0s" backfill.out
+'
+test_expect_success 'sched-bench: --backfill does not delay the reservation' '
+	spec=$(flux jobspec srun -n2 -t 0:10 hostname) &&
+	cp backfill.json delay.json &&
+	echo "{\"t_submit\":3,\"runtime\":10,\"jobspec\":$spec}" \
+		>>delay.json &&
+	$bench --nodes=1 --cores=4 --workload=delay.json --backfill \
+		>delay.out &&
+	test_debug "cat delay.out" &&
+	grep "^makespan: *30.0s" delay.out &&
+	grep "^wait max: *17.0s" delay.out
+'
+test_expect_success 'sched-bench: --pass-limit splits passes, same schedule' '
+	$bench --jobs=200 --pass-limit=1 >limit.out &&
+	test_debug "cat limit.out" &&
+	grep "^passes: .*([1-9][0-9]* ran out of budget)" limit.out &&
+	$bench --jobs=200 | grep -v "^alloc\|^passes" >nolimit.out &&
+	grep -v "^alloc\|^passes" limit.out >limit.filtered &&
+	test_cmp nolimit.out limit.filtered
+'
+test_expect_success 'sched-bench: --pass-limit with --backfill runs all jobs' '
+	$bench --jobs=200 --priorities=4 --backfill --pass-limit=2 \
+		>limit-backfill.out &&
+	test_debug "cat limit-backfill.out" &&
+	grep "^jobs: *200 (0 rejected, 0 not started)" limit-backfill.out
+'
+test_done
@@ -1063,6 +1063,14 @@ test_expect_success HAVE_JQ 'flux jobs works on job with illegal R' '
         test_cmp list_illegal_R.out list_illegal_R.exp
 '
 
+test_expect_success 'flux jobs prints no header if the first page fails' '
+        flux module remove job-info &&
+        test_when_finished "flux module load job-info" &&
+        test_must_fail flux jobs >nojobinfo.out 2>nojobinfo.err &&
+        test_debug "cat nojobinfo.err" &&
+        test_must_be_empty nojobinfo.out
+'
+
 #
 # leave job cleanup to rc3
 #
@@ -55,9 +55,61 @@ test_expect_success 'kvstest -N8 works with -o pmi.kvs=native' '
 	flux mini run -n${SIZE} -N${SIZE} -o pmi.kvs=native ${kvstest} -N8
 '
 
+test_expect_success 'kvstest works with -o pmi.kvs=dist' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.kvs=dist ${kvstest}
+'
+
+test_expect_success 'kvstest -N8 works with -o pmi.kvs=dist' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.kvs=dist ${kvstest} -N8
+'
+
+test_expect_success 'kvstest works with -o pmi.kvs=dist -o pmi.exchange.k=1' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.kvs=dist \
+		-o pmi.exchange.k=1 ${kvstest}
+'
+
+test_expect_success 'kvstest --n-squared works with -o pmi.kvs=dist -o pmi.exchange.k=1' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.kvs=dist \
+		-o pmi.exchange.k=1 ${kvstest} --n-squared
+'
+
+test_expect_success 'kvstest works with -o pmi.shm' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.shm ${kvstest}
+'
+
+test_expect_success 'kvstest -N8 works with -o pmi.shm' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.shm ${kvstest} -N8
+'
+
+test_expect_success 'kvstest works with -o pmi.shm -o pmi.kvs=dist' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.shm -o pmi.kvs=dist ${kvstest}
+'
+
+test_expect_success 'pmi_info --clique works with -o pmi.shm' '
+	flux mini run -n${SIZE} -N${SIZE} -o pmi.shm \
+		${pmi_info} --clique >clique_shm.out &&
+	sort clique.out >clique.sorted &&
+	sort clique_shm.out >clique_shm.sorted &&
+	test_cmp clique.sorted clique_shm.sorted
+'
+
 test_expect_success 'verbose=2 shell option enables PMI server side tracing' '
 	flux mini run -n${SIZE} -N${SIZE} -o verbose=2 ${kvstest} 2>trace.out &&
 	grep "cmd=finalize_ack" trace.out
 '
+test_expect_success 'kvstest gets go over the wire without pmi.shm' '
+	grep "cmd=get kvsname=" trace.out
+'
+test_expect_success 'kvstest gets are served from snapshot with pmi.shm' '
+	flux mini run -n${SIZE} -N${SIZE} -o verbose=2 -o pmi.shm \
+		${kvstest} 2>trace_shm.out &&
+	grep "cmd=finalize_ack" trace_shm.out &&
+	test_must_fail grep "cmd=get kvsname=" trace_shm.out
+'
+test_expect_success 'kvstest -N8 gets are served from snapshot with pmi.shm' '
+	flux mini run -n${SIZE} -N${SIZE} -o verbose=2 -o pmi.shm \
+		${kvstest} -N8 2>trace_shm8.out &&
+	test_must_fail grep "cmd=get kvsname=" trace_shm8.out
+'
 
 test_done